@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#else
+#include <atomic>
+#endif
+
+// Пул блоков одного размера.
+// Вся память пула выделяется одним куском в конструкторе и до разрушения пула в кучу не возвращается,
+// поэтому частые выделения и освобождения через пул не фрагментируют общую кучу. Свободные блоки связаны
+// в список через собственное содержимое: выделение и освобождение - O(1) под коротким спин-локом
+// (допустимы и из прерываний). Занятость блоков ведется битовой картой: повторное и чужое освобождение
+// обнаруживается и учитывается в статистике, а не портит список.
+//
+// Все пулы регистрируются в общем списке, их статистика доступна через getAllStats().
+class BlockPool
+{
+public:
+    struct Config
+    {
+        const char* name = "pool";      // Имя в статистике
+        size_t blockSize = 64;          // Размер блока, байт (округляется вверх до выравнивания)
+        size_t blocksCount = 16;        // Количество блоков
+        uint32_t caps = 0;              // Флаги heap_caps_malloc() (0 - MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+    };
+
+    struct Stats
+    {
+        const char* name = nullptr;
+        uint32_t blockSize = 0;         // Размер блока, байт
+        uint32_t blocksCount = 0;       // Всего блоков (0 - память пула не выделена)
+        uint32_t used = 0;              // Занято блоков
+        uint32_t peakUsed = 0;          // Максимум занятых блоков
+        uint32_t allocs = 0;            // Успешных выделений
+        uint32_t failures = 0;          // Отказов (пул исчерпан или блок мал)
+        uint32_t invalidFrees = 0;      // Освобождений чужих или уже свободных блоков
+    };
+
+    // Удаление объекта из пула для std::unique_ptr
+    template<typename T>
+    struct Deleter
+    {
+        BlockPool* pool = nullptr;
+
+        void operator()(T* ptr) const
+        {
+            ptr->~T();
+            pool->release(ptr);
+        }
+    };
+
+    template<typename T>
+    using Ptr = std::unique_ptr<T, Deleter<T>>;
+    using Buffer = Ptr<uint8_t>;
+
+    explicit BlockPool(const Config& config);
+    ~BlockPool();
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    /**
+     * @brief Метод для проверки, выделена ли память пула
+     * @return true если пул готов к работе
+     */
+    bool isValid() const { return m_arena != nullptr; }
+
+    /**
+     * @brief Метод для выделения блока
+     * @param size: Требуемый размер, байт (больше размера блока - отказ)
+     * @return Блок или nullptr, если свободных блоков нет
+     */
+    void* allocate(size_t size = 0);
+
+    /**
+     * @brief Метод для возврата блока в пул
+     * @param ptr: Блок, полученный из allocate() этого пула (nullptr игнорируется)
+     */
+    void release(void* ptr);
+
+    /**
+     * @brief Метод для проверки принадлежности указателя пулу
+     * @param ptr: Указатель
+     * @return true если указатель - начало блока этого пула
+     */
+    bool owns(const void* ptr) const;
+
+    /**
+     * @brief Метод для создания объекта в блоке пула
+     * @param args: Аргументы конструктора
+     * @return Владеющий указатель (пустой, если пул исчерпан)
+     */
+    template<typename T, typename... Args>
+    Ptr<T> make(Args&&... args)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "BlockPool blocks are aligned to max_align_t");
+        void* block = allocate(sizeof(T));
+        if (!block)
+            return Ptr<T>(nullptr, Deleter<T>{this});
+        return Ptr<T>(new (block) T(std::forward<Args>(args)...), Deleter<T>{this});
+    }
+
+    /**
+     * @brief Метод для выделения неинициализированного буфера размером в блок
+     * @return Владеющий указатель (пустой, если пул исчерпан)
+     */
+    Buffer allocBuffer()
+    {
+        return Buffer(static_cast<uint8_t*>(allocate()), Deleter<uint8_t>{this});
+    }
+
+    /**
+     * @brief Метод для получения размера блока
+     * @return Размер блока, байт
+     */
+    size_t getBlockSize() const { return m_blockSize; }
+
+    /**
+     * @brief Метод для получения статистики пула
+     * @return Статистика
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief Метод для получения статистики всех существующих пулов
+     * @param stats: Массив для статистики
+     * @param maxCount: Размер массива
+     * @return Количество пулов (может быть больше maxCount - тогда заполнены первые maxCount)
+     */
+    static size_t getAllStats(Stats* stats, size_t maxCount);
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    /* Индекс блока по указателю (-1 - не блок пула) */
+    ptrdiff_t indexOf(const void* ptr) const;
+
+    void lock() const;
+    void unlock() const;
+    static void lockRegistry();
+    static void unlockRegistry();
+
+private:
+    const char* m_name;
+    size_t m_blockSize = 0;
+    size_t m_blocksCount = 0;
+    uint8_t* m_arena = nullptr;             // Память блоков
+    uint32_t* m_usedMap = nullptr;          // Битовая карта занятых блоков
+    FreeBlock* m_freeList = nullptr;        // Список свободных блоков
+
+    Stats m_stats;                          // Счетчики (name/blockSize/blocksCount заполняются при чтении)
+
+#ifdef ESP_PLATFORM
+    mutable portMUX_TYPE m_lock = portMUX_INITIALIZER_UNLOCKED;
+#else
+    mutable std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+#endif
+
+    BlockPool* m_next = nullptr;            // Следующий пул в общем списке
+    static BlockPool* s_first;
+};
@@ -0,0 +1,228 @@
+#include "BlockPool.h"
+#include <cstdlib>
+#include <cstring>
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#endif
+
+namespace
+{
+#ifdef ESP_PLATFORM
+    const char* LOG = "BlockPool";      // Канал лога
+
+    portMUX_TYPE s_registryLock = portMUX_INITIALIZER_UNLOCKED;
+#else
+    std::atomic_flag s_registryLock = ATOMIC_FLAG_INIT;
+#endif
+
+    const size_t BLOCK_ALIGN = alignof(std::max_align_t);
+
+    void* allocMemory(size_t size, uint32_t caps)
+    {
+#ifdef ESP_PLATFORM
+        return heap_caps_malloc(size, caps ? caps : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        (void)caps;
+        return malloc(size);
+#endif
+    }
+
+    void freeMemory(void* ptr)
+    {
+#ifdef ESP_PLATFORM
+        heap_caps_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+}
+
+BlockPool* BlockPool::s_first = nullptr;
+
+BlockPool::BlockPool(const Config& config):
+    m_name(config.name)
+{
+    m_stats.name = config.name;
+
+    // Блок вмещает и данные, и указатель списка свободных блоков
+    size_t blockSize = config.blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : config.blockSize;
+    blockSize = (blockSize + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN;
+
+    const size_t mapWords = (config.blocksCount + 31) / 32;
+    if (config.blocksCount > 0)
+    {
+        m_arena = static_cast<uint8_t*>(allocMemory(blockSize * config.blocksCount, config.caps));
+        // Карта занятости проверяется на каждой операции - всегда во внутренней памяти
+        m_usedMap = static_cast<uint32_t*>(allocMemory(mapWords * sizeof(uint32_t), 0));
+    }
+    if (!m_arena || !m_usedMap)
+    {
+        freeMemory(m_arena);
+        freeMemory(m_usedMap);
+        m_arena = nullptr;
+        m_usedMap = nullptr;
+#ifdef ESP_PLATFORM
+        ESP_LOGE(LOG, "Pool \"%s\": no memory for %u x %u bytes", config.name,
+                 static_cast<unsigned>(config.blocksCount), static_cast<unsigned>(blockSize));
+#endif
+    }
+    else
+    {
+        m_blockSize = blockSize;
+        m_blocksCount = config.blocksCount;
+        memset(m_usedMap, 0, mapWords * sizeof(uint32_t));
+
+        // Список в порядке адресов: первые выделения идут с начала пула
+        for (size_t i = m_blocksCount; i-- > 0; )
+        {
+            auto* block = reinterpret_cast<FreeBlock*>(m_arena + i * m_blockSize);
+            block->next = m_freeList;
+            m_freeList = block;
+        }
+    }
+
+    lockRegistry();
+    m_next = s_first;
+    s_first = this;
+    unlockRegistry();
+}
+
+BlockPool::~BlockPool()
+{
+    lockRegistry();
+    for (BlockPool** pool = &s_first; *pool; pool = &(*pool)->m_next)
+    {
+        if (*pool == this)
+        {
+            *pool = m_next;
+            break;
+        }
+    }
+    unlockRegistry();
+
+#ifdef ESP_PLATFORM
+    if (m_stats.used != 0)
+        ESP_LOGE(LOG, "Pool \"%s\" destroyed with %lu blocks in use", m_name, static_cast<unsigned long>(m_stats.used));
+#endif
+    freeMemory(m_arena);
+    freeMemory(m_usedMap);
+}
+
+void* BlockPool::allocate(size_t size)
+{
+    lock();
+    FreeBlock* block = size <= m_blockSize ? m_freeList : nullptr;
+    if (block)
+    {
+        m_freeList = block->next;
+        const size_t index = (reinterpret_cast<uint8_t*>(block) - m_arena) / m_blockSize;
+        m_usedMap[index / 32] |= 1u << (index % 32);
+        ++m_stats.allocs;
+        if (++m_stats.used > m_stats.peakUsed)
+            m_stats.peakUsed = m_stats.used;
+    }
+    else
+    {
+        ++m_stats.failures;
+    }
+    unlock();
+    return block;
+}
+
+void BlockPool::release(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    const ptrdiff_t index = indexOf(ptr);
+    lock();
+    const uint32_t bit = index >= 0 ? 1u << (index % 32) : 0;
+    if (index < 0 || !(m_usedMap[index / 32] & bit))
+    {
+        ++m_stats.invalidFrees;
+        unlock();
+        return;
+    }
+    m_usedMap[index / 32] &= ~bit;
+    auto* block = static_cast<FreeBlock*>(ptr);
+    block->next = m_freeList;
+    m_freeList = block;
+    --m_stats.used;
+    unlock();
+}
+
+bool BlockPool::owns(const void* ptr) const
+{
+    return indexOf(ptr) >= 0;
+}
+
+BlockPool::Stats BlockPool::getStats() const
+{
+    lock();
+    Stats stats = m_stats;
+    unlock();
+    stats.blockSize = m_blockSize;
+    stats.blocksCount = m_blocksCount;
+    return stats;
+}
+
+size_t BlockPool::getAllStats(Stats* stats, size_t maxCount)
+{
+    size_t count = 0;
+    lockRegistry();
+    for (const BlockPool* pool = s_first; pool; pool = pool->m_next, ++count)
+    {
+        if (count < maxCount)
+            stats[count] = pool->getStats();
+    }
+    unlockRegistry();
+    return count;
+}
+
+ptrdiff_t BlockPool::indexOf(const void* ptr) const
+{
+    const auto* p = static_cast<const uint8_t*>(ptr);
+    if (!m_arena || p < m_arena || p >= m_arena + m_blockSize * m_blocksCount)
+        return -1;
+    const size_t offset = p - m_arena;
+    return offset % m_blockSize == 0 ? static_cast<ptrdiff_t>(offset / m_blockSize) : -1;
+}
+
+void BlockPool::lock() const
+{
+#ifdef ESP_PLATFORM
+    portENTER_CRITICAL_SAFE(&m_lock);
+#else
+    while (m_lock.test_and_set(std::memory_order_acquire))
+        ;
+#endif
+}
+
+void BlockPool::unlock() const
+{
+#ifdef ESP_PLATFORM
+    portEXIT_CRITICAL_SAFE(&m_lock);
+#else
+    m_lock.clear(std::memory_order_release);
+#endif
+}
+
+void BlockPool::lockRegistry()
+{
+#ifdef ESP_PLATFORM
+    portENTER_CRITICAL_SAFE(&s_registryLock);
+#else
+    while (s_registryLock.test_and_set(std::memory_order_acquire))
+        ;
+#endif
+}
+
+void BlockPool::unlockRegistry()
+{
+#ifdef ESP_PLATFORM
+    portEXIT_CRITICAL_SAFE(&s_registryLock);
+#else
+    s_registryLock.clear(std::memory_order_release);
+#endif
+}
@@ -9,6 +9,7 @@
 #include "esp_err.h"
 #include "led_strip_rmt.h"
 #include "led_strip_spi.h"
+#include "led_strip_group.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -82,6 +83,69 @@ esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint
  */
 esp_err_t led_strip_set_pixel_hsv_16(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint16_t saturation, uint16_t value);
 
+/**
+ * @brief Set a range of pixels from a packed framebuffer
+ *
+ * @note Much faster than calling `led_strip_set_pixel` for every pixel: the range is checked once and
+ *       the source layout is converted to the strip layout with a swizzle computed once per call.
+ * @note Multi-byte color components in the source are MSB first. If the source has no white component,
+ *       white is set to zero; if the strip has no white component, the source white is ignored.
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param pixels: source buffer holding `count` packed pixels
+ * @param src_format: layout of the source pixels, e.g. `LED_STRIP_COLOR_COMPONENT_FMT_RGB` for a RGB888 framebuffer
+ *
+ * @return
+ *      - ESP_OK: Set pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Set pixels failed because of invalid parameters (e.g. range out of the strip)
+ *      - ESP_FAIL: Set pixels failed because other error occurred
+ */
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *pixels, led_color_component_format_t src_format);
+
+/**
+ * @brief Set HSV colors for a range of pixels
+ *
+ * @note The whole array is converted in one pass with a shared fixed-point, division-free kernel and uploaded
+ *       with `led_strip_set_pixels`, much faster than calling `led_strip_set_pixel_hsv` for every pixel.
+ * @note With `LED_STRIP_HUE_360` the colors are exactly the ones of `led_strip_set_pixel_hsv`.
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param pixels: HSV colors, `count` entries
+ * @param hue_scale: scale of the hue in `pixels`
+ *
+ * @return
+ *      - ESP_OK: Set HSV colors successfully
+ *      - ESP_ERR_INVALID_ARG: Set HSV colors failed because of invalid argument (e.g. the range exceeds the strip)
+ *      - ESP_FAIL: Set HSV colors failed because other error occurred
+ */
+esp_err_t led_strip_set_pixels_hsv(led_strip_handle_t strip, uint32_t start, uint32_t count, const led_color_hsv_t *pixels, led_strip_hue_scale_t hue_scale);
+
+/**
+ * @brief Set the output transform of the strip: global brightness, gamma curve and white balance
+ *
+ * @note The transform is precomputed into one LUT per color component (8-bit or 16-bit) and applied while the pixels are encoded,
+ *       so `led_strip_set_pixel` stays cheap and a brightness change only needs `led_strip_refresh`, not a new frame.
+ * @note With `flags.temporal_dither`, the fraction lost when rounding to the output resolution is spread over successive frames
+ *       (useful at low brightness, e.g. for the 16-bit LED_MODEL_WS2816).
+ * @note Supported by the RMT backend with IDF v5.3 or later, and by the SPI backend. From the first call on, the SPI backend
+ *       keeps the pixels unencoded in an extra buffer (a third of the size of its SPI buffer, none with `pixel_buf_in_psram`)
+ *       and encodes them at refresh.
+ *
+ * @param strip: LED strip
+ * @param config: Transform configuration, NULL to disable the transform
+ *
+ * @return
+ *      - ESP_OK: Set the transform successfully
+ *      - ESP_ERR_INVALID_ARG: Set the transform failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: Set the transform failed because of out of memory
+ *      - ESP_ERR_NOT_SUPPORTED: The backend doesn't support the output transform
+ */
+esp_err_t led_strip_set_transform(led_strip_handle_t strip, const led_strip_transform_config_t *config);
+
 /**
  * @brief Refresh memory colors to LEDs
  *
@@ -96,6 +160,36 @@ esp_err_t led_strip_set_pixel_hsv_16(led_strip_handle_t strip, uint32_t index, u
  */
 esp_err_t led_strip_refresh(led_strip_handle_t strip);
 
+/**
+ * @brief Start refreshing memory colors to LEDs and return without waiting for the transmission
+ *
+ * @note With a double-buffered backend (e.g. RMT with `flags.double_buffer`) the pixel buffer is swapped and copied,
+ *       so the next frame can be rendered with `led_strip_set_pixel` while the current one is on the wire.
+ *       If the previous frame is still being sent, this function waits for it first.
+ * @note The SPI backend has a single buffer: setting pixels first waits until the pending transmission is done.
+ * @note Backends without asynchronous support perform a blocking refresh.
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Refresh started successfully
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ */
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip);
+
+/**
+ * @brief Wait until the refresh started by `led_strip_refresh_async` is finished
+ *
+ * @param strip: LED strip
+ * @param timeout_ms: timeout value, -1 means wait forever
+ *
+ * @return
+ *      - ESP_OK: Refresh is finished
+ *      - ESP_ERR_TIMEOUT: Refresh is still in progress after `timeout_ms`
+ *      - ESP_FAIL: Wait failed because some other error occurred
+ */
+esp_err_t led_strip_wait_refresh_done(led_strip_handle_t strip, int32_t timeout_ms);
+
 /**
  * @brief Clear LED strip (turn off all LEDs)
  *
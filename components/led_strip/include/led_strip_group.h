@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of strips in one group
+ */
+#define LED_STRIP_GROUP_MAX_STRIPS 8
+
+/**
+ * @brief Type of LED strip group handle
+ */
+typedef struct led_strip_group_t *led_strip_group_handle_t;
+
+/**
+ * @brief Create a group of LED strips that are refreshed together
+ *
+ * @note Every strip must support asynchronous refresh: RMT strips need `flags.double_buffer`, SPI strips on different hosts are supported.
+ * @note Two or more RMT strips are started at the same time by the RMT sync manager on the targets that support it.
+ *       Otherwise the transmissions are started one after another, and only overlap.
+ * @note While a strip belongs to a group, refresh it only through the group.
+ *
+ * @param strips Array of LED strips, the transmissions are started in this order
+ * @param num_strips Number of strips in the array, up to `LED_STRIP_GROUP_MAX_STRIPS`
+ * @param ret_group Returned group handle
+ * @return
+ *      - ESP_OK: Create group successfully
+ *      - ESP_ERR_INVALID_ARG: Create group failed because of invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: Create group failed because a strip doesn't support asynchronous refresh
+ *      - ESP_ERR_NO_MEM: Create group failed because of out of memory
+ *      - ESP_FAIL: Create group failed because some other error occurred
+ */
+esp_err_t led_strip_new_group(const led_strip_handle_t *strips, size_t num_strips, led_strip_group_handle_t *ret_group);
+
+/**
+ * @brief Start refreshing all the strips of the group and return without waiting for the transmissions
+ *
+ * @note If the previous group refresh is still in progress, this function waits for it first.
+ *
+ * @param group Strip group
+ * @return
+ *      - ESP_OK: Refresh started successfully
+ *      - ESP_ERR_INVALID_ARG: Refresh failed because of invalid argument
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ */
+esp_err_t led_strip_group_refresh_async(led_strip_group_handle_t group);
+
+/**
+ * @brief Wait until every strip of the group finished the refresh started by `led_strip_group_refresh_async`
+ *
+ * @param group Strip group
+ * @param timeout_ms Timeout value, -1 means wait forever. The timeout applies to each strip in turn
+ * @return
+ *      - ESP_OK: Refresh is finished
+ *      - ESP_ERR_TIMEOUT: Refresh of some strip is still in progress, the function can be called again
+ *      - ESP_FAIL: Wait failed because some other error occurred
+ */
+esp_err_t led_strip_group_wait_refresh_done(led_strip_group_handle_t group, int32_t timeout_ms);
+
+/**
+ * @brief Refresh all the strips of the group and wait for the transmissions to finish
+ *
+ * @note The wire time is the one of the longest strip, not the sum of all strips.
+ *
+ * @param group Strip group
+ * @return
+ *      - ESP_OK: Refresh successfully
+ *      - ESP_ERR_INVALID_ARG: Refresh failed because of invalid argument
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ */
+esp_err_t led_strip_group_refresh(led_strip_group_handle_t group);
+
+/**
+ * @brief Delete the group, the strips themselves are not deleted
+ *
+ * @param group Strip group
+ * @return
+ *      - ESP_OK: Delete group successfully
+ *      - ESP_ERR_INVALID_ARG: Delete group failed because of invalid argument
+ *      - ESP_FAIL: Delete group failed because some other error occurred
+ */
+esp_err_t led_strip_del_group(led_strip_group_handle_t group);
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,6 +15,18 @@
 extern "C" {
 #endif
 
+/**
+ * @brief LED bit timing
+ * @note Lets a new chip model be driven without code changes. The durations are converted to RMT ticks with integer math.
+ */
+typedef struct {
+    uint32_t t0h_ns;   /*!< High time of a 0 bit, in ns */
+    uint32_t t0l_ns;   /*!< Low time of a 0 bit, in ns */
+    uint32_t t1h_ns;   /*!< High time of a 1 bit, in ns */
+    uint32_t t1l_ns;   /*!< Low time of a 1 bit, in ns */
+    uint32_t reset_us; /*!< Low time after the last bit that latches the data, in us */
+} led_strip_rmt_timing_t;
+
 /**
  * @brief LED Strip RMT specific configuration
  */
@@ -22,9 +34,13 @@ typedef struct {
     rmt_clock_source_t clk_src; /*!< RMT clock source */
     uint32_t resolution_hz;     /*!< RMT tick resolution, if set to zero, a default resolution (10MHz) will be applied */
     size_t mem_block_symbols;   /*!< How many RMT symbols can one RMT channel hold at one time. Set to 0 will fallback to use the default size. */
+    led_strip_rmt_timing_t timing; /*!< Custom bit timing, overrides the timing of `led_model`. Leave it zeroed to use the model timing */
     /*!< Extra RMT specific driver flags */
     struct led_strip_rmt_extra_config {
         uint32_t with_dma: 1;   /*!< Use DMA to transmit data */
+        uint32_t double_buffer: 1; /*!< Keep two pixel buffers and the RMT channel enabled, so that `led_strip_refresh_async`
+                                        returns right after starting the transmission and the next frame can be rendered meanwhile.
+                                        Doubles the pixel buffer memory */
     } flags;                    /*!< Extra driver flags */
 } led_strip_rmt_config_t;
 
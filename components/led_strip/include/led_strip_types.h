@@ -68,9 +68,49 @@ typedef struct {
     /*!< LED strip extra driver flags */
     struct led_strip_extra_flags {
         uint32_t invert_out: 1; /*!< Invert output signal */
+        uint32_t partial_refresh: 1; /*!< Refresh skips the frame when no pixel was set since the last refresh, and sends only the
+                                          pixels up to the last modified one. The LEDs after it keep their latched colors, which holds
+                                          for the supported shift-register chains (WS2812 family) */
+        uint32_t pixel_buf_in_psram: 1; /*!< Place the pixel buffer in PSRAM, the peripheral is fed from a small internal RAM buffer
+                                             that is encoded chunk by chunk during the transmission. Requires `CONFIG_SPIRAM`
+                                             (the allocation fails with `ESP_ERR_NO_MEM` otherwise) and `with_dma` for SPI */
     } flags; /*!< Extra driver flags */
 } led_strip_config_t;
 
+/**
+ * @brief HSV color of one pixel
+ */
+typedef struct {
+    uint16_t hue;        /*!< Hue, its range depends on `led_strip_hue_scale_t` */
+    uint8_t saturation;  /*!< Saturation: 0~255 */
+    uint8_t value;       /*!< Value (brightness): 0~255 */
+} led_color_hsv_t;
+
+/**
+ * @brief Scale of the hue
+ */
+typedef enum {
+    LED_STRIP_HUE_360,  /*!< Hue in degrees: 0~359, same result as `led_strip_set_pixel_hsv` */
+    LED_STRIP_HUE_1536, /*!< Hue in 1/256 of a 60 degrees sector: 0~1535, smoother gradients and cheaper conversion */
+} led_strip_hue_scale_t;
+
+/**
+ * @brief LED strip output transform configuration
+ * @note The transform is applied to the pixel values while they are encoded, the pixel buffer keeps the values as set.
+ */
+typedef struct {
+    uint8_t brightness;       /*!< Global brightness: 0~255, 255 is the full brightness */
+    float gamma;              /*!< Exponent of the gamma curve (e.g. 2.2). If set to 0, it will fallback to 1 (linear) */
+    uint8_t r_scale;          /*!< White balance scale of the red component: 1~255. If set to 0, it will fallback to 255 */
+    uint8_t g_scale;          /*!< White balance scale of the green component: 1~255. If set to 0, it will fallback to 255 */
+    uint8_t b_scale;          /*!< White balance scale of the blue component: 1~255. If set to 0, it will fallback to 255 */
+    uint8_t w_scale;          /*!< White balance scale of the white component: 1~255. If set to 0, it will fallback to 255 */
+    /*!< Extra transform flags */
+    struct led_strip_transform_flags {
+        uint32_t temporal_dither: 1; /*!< Spread the fraction lost by the output rounding over successive frames */
+    } flags; /*!< Extra transform flags */
+} led_strip_transform_config_t;
+
 #ifdef __cplusplus
 }
 #endif
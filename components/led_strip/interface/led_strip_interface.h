@@ -6,7 +6,10 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
+#include "driver/rmt_types.h"
+#include "led_strip_types.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -88,6 +91,82 @@ struct led_strip_t {
      *      - ESP_FAIL: Free resources failed because error occurred
      */
     esp_err_t (*del)(led_strip_t *strip);
+
+    /**
+     * @brief Set a range of pixels from a packed source buffer
+     *
+     * @note Optional. If a backend leaves it NULL, `led_strip_set_pixels` falls back to calling `set_pixel`/`set_pixel_rgbw` per pixel.
+     *
+     * @param strip: LED strip
+     * @param start: index of the first pixel to set
+     * @param count: number of pixels to set
+     * @param pixels: source pixels, `count` pixels packed in `src_format` layout
+     * @param src_format: layout of the source pixels (already validated and normalized)
+     *
+     * @return
+     *      - ESP_OK: Set pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Set pixels failed because of invalid parameters
+     *      - ESP_FAIL: Set pixels failed because other error occurred
+     */
+    esp_err_t (*set_pixels)(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *pixels, led_color_component_format_t src_format);
+
+    /**
+     * @brief Start flushing memory colors to LEDs without waiting for the transmission to finish
+     *
+     * @note Optional. If a backend leaves it NULL, `led_strip_refresh_async` falls back to the blocking `refresh`.
+     *
+     * @param strip: LED strip
+     *
+     * @return
+     *      - ESP_OK: Refresh started successfully
+     *      - ESP_FAIL: Refresh failed because some other error occurred
+     */
+    esp_err_t (*refresh_async)(led_strip_t *strip);
+
+    /**
+     * @brief Wait until the refresh started by `refresh_async` is finished
+     *
+     * @note Optional. If a backend leaves it NULL, there is nothing to wait for.
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value, -1 means wait forever
+     *
+     * @return
+     *      - ESP_OK: Refresh is finished
+     *      - ESP_ERR_TIMEOUT: Refresh is still in progress
+     */
+    esp_err_t (*wait_refresh_done)(led_strip_t *strip, int32_t timeout_ms);
+
+    /**
+     * @brief Join or leave a group of RMT channels that are started together by the RMT sync manager
+     *
+     * @note Optional, only implemented by the RMT backend. A joined strip never skips a frame,
+     *       because the sync manager only starts the transmission when every channel of the group got one.
+     *
+     * @param strip: LED strip
+     * @param join: true to join the group, false to leave it
+     * @param ret_chan: returned RMT TX channel that drives the strip, can be NULL
+     *
+     * @return
+     *      - ESP_OK: Joined (left) successfully
+     *      - ESP_ERR_INVALID_STATE: The channel is not kept enabled between refreshes
+     */
+    esp_err_t (*rmt_sync_join)(led_strip_t *strip, bool join, rmt_channel_handle_t *ret_chan);
+
+    /**
+     * @brief Set the output transform (brightness, gamma, white balance) applied while encoding the pixels
+     *
+     * @note Optional. If a backend leaves it NULL, `led_strip_set_transform` returns ESP_ERR_NOT_SUPPORTED.
+     *
+     * @param strip: LED strip
+     * @param config: transform configuration, NULL to disable the transform
+     *
+     * @return
+     *      - ESP_OK: Set the transform successfully
+     *      - ESP_ERR_NO_MEM: Set the transform failed because of out of memory
+     *      - ESP_ERR_NOT_SUPPORTED: The backend can't apply the transform
+     */
+    esp_err_t (*set_transform)(led_strip_t *strip, const led_strip_transform_config_t *config);
 };
 
 #ifdef __cplusplus
@@ -3,13 +3,17 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+#include <inttypes.h>
 #include "esp_log.h"
 #include "esp_check.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
+#include "led_strip_common.h"
 
 static const char *TAG = "led_strip";
 
+#define LED_STRIP_HSV_CHUNK_PIXELS 32 // pixels converted per bulk upload by `led_strip_set_pixels_hsv`
+
 esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
@@ -19,113 +23,111 @@ esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t
 esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint8_t saturation, uint8_t value)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
-
-    uint32_t red = 0;
-    uint32_t green = 0;
-    uint32_t blue = 0;
-
-    uint32_t rgb_max = value;
-    uint32_t rgb_min = rgb_max * (255 - saturation) / 255;
-
-    uint32_t i = hue / 60;
-    uint32_t diff = hue % 60;
-
-    // RGB adjustment amount by hue
-    uint32_t rgb_adj = (rgb_max - rgb_min) * diff / 60;
-
-    switch (i) {
-    case 0:
-        red = rgb_max;
-        green = rgb_min + rgb_adj;
-        blue = rgb_min;
-        break;
-    case 1:
-        red = rgb_max - rgb_adj;
-        green = rgb_max;
-        blue = rgb_min;
-        break;
-    case 2:
-        red = rgb_min;
-        green = rgb_max;
-        blue = rgb_min + rgb_adj;
-        break;
-    case 3:
-        red = rgb_min;
-        green = rgb_max - rgb_adj;
-        blue = rgb_max;
-        break;
-    case 4:
-        red = rgb_min + rgb_adj;
-        green = rgb_min;
-        blue = rgb_max;
-        break;
-    default:
-        red = rgb_max;
-        green = rgb_min;
-        blue = rgb_max - rgb_adj;
-        break;
-    }
-
-    return strip->set_pixel(strip, index, red, green, blue);
+    uint32_t rgb[3];
+    led_strip_hsv_to_rgb(hue, saturation, value, rgb);
+    return strip->set_pixel(strip, index, rgb[0], rgb[1], rgb[2]);
 }
 
 esp_err_t led_strip_set_pixel_hsv_16(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint16_t saturation, uint16_t value)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint32_t rgb[3];
+    led_strip_hsv_to_rgb_16(hue, saturation, value, rgb);
+    return strip->set_pixel(strip, index, rgb[0], rgb[1], rgb[2]);
+}
+
+esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->set_pixel_rgbw(strip, index, red, green, blue, white);
+}
 
-    uint32_t red = 0;
-    uint32_t green = 0;
-    uint32_t blue = 0;
-
-    uint32_t rgb_max = value;
-    uint32_t rgb_min = rgb_max * (65535 - saturation) / 65535;
-
-    uint32_t i = hue / 60;
-    uint32_t diff = hue % 60;
-
-    // RGB adjustment amount by hue
-    uint32_t rgb_adj = (rgb_max - rgb_min) * diff / 60;
-
-    switch (i) {
-    case 0:
-        red = rgb_max;
-        green = rgb_min + rgb_adj;
-        blue = rgb_min;
-        break;
-    case 1:
-        red = rgb_max - rgb_adj;
-        green = rgb_max;
-        blue = rgb_min;
-        break;
-    case 2:
-        red = rgb_min;
-        green = rgb_max;
-        blue = rgb_min + rgb_adj;
-        break;
-    case 3:
-        red = rgb_min;
-        green = rgb_max - rgb_adj;
-        blue = rgb_max;
-        break;
-    case 4:
-        red = rgb_min + rgb_adj;
-        green = rgb_min;
-        blue = rgb_max;
-        break;
-    default:
-        red = rgb_max;
-        green = rgb_min;
-        blue = rgb_max - rgb_adj;
-        break;
+// generic fallback for backends without the `set_pixels` hook
+static esp_err_t led_strip_set_pixels_generic(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *pixels, led_color_component_format_t src_format)
+{
+    struct format_layout format = src_format.format;
+    uint8_t bytes_per_color = format.bytes_per_color;
+    uint8_t bytes_per_pixel = format.num_components * bytes_per_color;
+    bool with_white = format.num_components > 3;
+
+    for (uint32_t n = 0; n < count; n++) {
+        const uint8_t *src = pixels + n * bytes_per_pixel;
+        uint32_t color[4] = {0};
+        const uint8_t pos[4] = {format.r_pos, format.g_pos, format.b_pos, format.w_pos};
+        for (uint8_t c = 0; c < format.num_components; c++) {
+            for (uint8_t i = 0; i < bytes_per_color; i++) {
+                color[c] = (color[c] << 8) | src[pos[c] * bytes_per_color + i];
+            }
+        }
+        esp_err_t ret = ESP_ERR_INVALID_ARG;
+        if (with_white) {
+            ret = strip->set_pixel_rgbw(strip, start + n, color[0], color[1], color[2], color[3]);
+            // the strip has no white component: drop the white byte, `set_pixel` still reports a bad index
+            with_white = ret != ESP_ERR_INVALID_ARG;
+        }
+        if (!with_white) {
+            ret = strip->set_pixel(strip, start + n, color[0], color[1], color[2]);
+        }
+        ESP_RETURN_ON_ERROR(ret, TAG, "set pixel %"PRIu32" failed", start + n);
     }
+    return ESP_OK;
+}
 
-    return strip->set_pixel(strip, index, red, green, blue);
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *pixels, led_color_component_format_t src_format)
+{
+    ESP_RETURN_ON_FALSE(strip && (pixels || count == 0), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(led_strip_normalize_format(&src_format) == ESP_OK, ESP_ERR_INVALID_ARG, TAG, "invalid source format");
+    if (count == 0) {
+        return ESP_OK;
+    }
+    if (strip->set_pixels) {
+        return strip->set_pixels(strip, start, count, pixels, src_format);
+    }
+    return led_strip_set_pixels_generic(strip, start, count, pixels, src_format);
 }
 
-esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+esp_err_t led_strip_set_transform(led_strip_handle_t strip, const led_strip_transform_config_t *config)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
-    return strip->set_pixel_rgbw(strip, index, red, green, blue, white);
+    ESP_RETURN_ON_FALSE(!config || config->gamma >= 0, ESP_ERR_INVALID_ARG, TAG, "invalid gamma");
+    ESP_RETURN_ON_FALSE(strip->set_transform, ESP_ERR_NOT_SUPPORTED, TAG, "output transform not supported");
+    return strip->set_transform(strip, config);
+}
+
+esp_err_t led_strip_set_pixels_hsv(led_strip_handle_t strip, uint32_t start, uint32_t count, const led_color_hsv_t *pixels, led_strip_hue_scale_t hue_scale)
+{
+    ESP_RETURN_ON_FALSE(strip && pixels, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(hue_scale == LED_STRIP_HUE_360 || hue_scale == LED_STRIP_HUE_1536, ESP_ERR_INVALID_ARG, TAG, "invalid hue scale");
+
+    // convert a chunk at a time into a small RGB888 buffer, then upload it with the bulk path of the backend
+    uint8_t rgb_buf[LED_STRIP_HSV_CHUNK_PIXELS * 3];
+    while (count) {
+        uint32_t chunk = count < LED_STRIP_HSV_CHUNK_PIXELS ? count : LED_STRIP_HSV_CHUNK_PIXELS;
+        uint8_t *dst = rgb_buf;
+        uint32_t rgb[3];
+        if (hue_scale == LED_STRIP_HUE_1536) {
+            for (uint32_t i = 0; i < chunk; i++) {
+                led_strip_hsv1536_to_rgb(pixels[i].hue, pixels[i].saturation, pixels[i].value, rgb);
+                dst[0] = rgb[0];
+                dst[1] = rgb[1];
+                dst[2] = rgb[2];
+                dst += 3;
+            }
+        } else {
+            for (uint32_t i = 0; i < chunk; i++) {
+                led_strip_hsv_to_rgb(pixels[i].hue, pixels[i].saturation, pixels[i].value, rgb);
+                dst[0] = rgb[0];
+                dst[1] = rgb[1];
+                dst[2] = rgb[2];
+                dst += 3;
+            }
+        }
+        ESP_RETURN_ON_ERROR(led_strip_set_pixels(strip, start, chunk, rgb_buf, LED_STRIP_COLOR_COMPONENT_FMT_RGB), TAG, "set pixels failed");
+        start += chunk;
+        pixels += chunk;
+        count -= chunk;
+    }
+    return ESP_OK;
 }
 
 esp_err_t led_strip_refresh(led_strip_handle_t strip)
@@ -134,6 +136,24 @@ esp_err_t led_strip_refresh(led_strip_handle_t strip)
     return strip->refresh(strip);
 }
 
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->refresh_async) {
+        return strip->refresh_async(strip);
+    }
+    return strip->refresh(strip);
+}
+
+esp_err_t led_strip_wait_refresh_done(led_strip_handle_t strip, int32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->wait_refresh_done) {
+        return strip->wait_refresh_done(strip, timeout_ms);
+    }
+    return ESP_OK;
+}
+
 esp_err_t led_strip_clear(led_strip_handle_t strip)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
@@ -0,0 +1,194 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bit_defs.h"
+#include "esp_heap_caps.h"
+#include "led_strip_common.h"
+
+esp_err_t led_strip_normalize_format(led_color_component_format_t *fmt)
+{
+    // If R/G/B order is not specified, set default GRB order as fallback
+    if (fmt->format_id == 0) {
+        *fmt = LED_STRIP_COLOR_COMPONENT_FMT_GRB;
+    }
+    if (fmt->format.bytes_per_color == 0) {
+        fmt->format.bytes_per_color = 1;
+    }
+    if (fmt->format.bytes_per_color > 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t mask = BIT(fmt->format.r_pos) | BIT(fmt->format.g_pos) | BIT(fmt->format.b_pos);
+    if (fmt->format.num_components == 3) {
+        return mask == 0x07 ? ESP_OK : ESP_ERR_INVALID_ARG;
+    } else if (fmt->format.num_components == 4) {
+        mask |= BIT(fmt->format.w_pos);
+        return mask == 0x0F ? ESP_OK : ESP_ERR_INVALID_ARG;
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+void led_strip_build_swizzle(led_color_component_format_t src_fmt, led_color_component_format_t dst_fmt, led_strip_swizzle_t *swizzle)
+{
+    struct format_layout src = src_fmt.format;
+    struct format_layout dst = dst_fmt.format;
+    const uint8_t src_pos[4] = {src.r_pos, src.g_pos, src.b_pos, src.w_pos};
+    const uint8_t dst_pos[4] = {dst.r_pos, dst.g_pos, dst.b_pos, dst.w_pos};
+
+    swizzle->src_bytes_per_pixel = src.num_components * src.bytes_per_color;
+    swizzle->dst_bytes_per_pixel = dst.num_components * dst.bytes_per_color;
+    swizzle->identity = (swizzle->src_bytes_per_pixel == swizzle->dst_bytes_per_pixel);
+    swizzle->complete = true;
+
+    for (int i = 0; i < LED_STRIP_MAX_BYTES_PER_PIXEL; i++) {
+        swizzle->src_byte[i] = -1;
+    }
+    for (int c = 0; c < dst.num_components; c++) {
+        for (int i = 0; i < dst.bytes_per_color; i++) {
+            int dst_index = dst_pos[c] * dst.bytes_per_color + i;
+            // byte `i` of the destination carries bits [8 * k, 8 * k + 7] of the value, k counted from the LSB
+            int k = dst.bytes_per_color - 1 - i;
+            int src_index = -1;
+            if (c < src.num_components && k < src.bytes_per_color) {
+                src_index = src_pos[c] * src.bytes_per_color + (src.bytes_per_color - 1 - k);
+            }
+            swizzle->src_byte[dst_index] = src_index;
+            if (src_index < 0) {
+                swizzle->complete = false;
+            }
+            if (src_index != dst_index) {
+                swizzle->identity = false;
+            }
+        }
+    }
+}
+
+void led_strip_pack_pixels(uint8_t *dst, const uint8_t *src, uint32_t count, const led_strip_swizzle_t *swizzle)
+{
+    const int8_t *map = swizzle->src_byte;
+
+    if (swizzle->identity) {
+        memcpy(dst, src, count * swizzle->dst_bytes_per_pixel);
+    } else if (swizzle->complete && swizzle->dst_bytes_per_pixel == 3) {
+        // e.g. RGB888 framebuffer to a GRB strip
+        for (uint32_t n = 0; n < count; n++) {
+            dst[0] = src[map[0]];
+            dst[1] = src[map[1]];
+            dst[2] = src[map[2]];
+            dst += 3;
+            src += swizzle->src_bytes_per_pixel;
+        }
+    } else if (swizzle->complete && swizzle->dst_bytes_per_pixel == 4) {
+        for (uint32_t n = 0; n < count; n++) {
+            dst[0] = src[map[0]];
+            dst[1] = src[map[1]];
+            dst[2] = src[map[2]];
+            dst[3] = src[map[3]];
+            dst += 4;
+            src += swizzle->src_bytes_per_pixel;
+        }
+    } else {
+        for (uint32_t n = 0; n < count; n++) {
+            for (uint8_t i = 0; i < swizzle->dst_bytes_per_pixel; i++) {
+                dst[i] = map[i] < 0 ? 0 : src[map[i]];
+            }
+            dst += swizzle->dst_bytes_per_pixel;
+            src += swizzle->src_bytes_per_pixel;
+        }
+    }
+}
+
+void led_strip_build_transform_lut(const led_strip_transform_config_t *config, uint8_t scale, uint8_t bytes_per_color, uint32_t *lut)
+{
+    float gamma = config->gamma > 0 ? config->gamma : 1.0f;
+    // full scale of the output level, in LUT units
+    float full_scale = bytes_per_color > 1 ? (float)(0xFFFFu << 8) : (float)(0xFFu << 16);
+    float gain = full_scale * config->brightness / 255.0f * scale / 255.0f;
+    size_t size = led_strip_transform_lut_size(bytes_per_color);
+    // 8-bit: entry i is the input i / 255. 16-bit: entry i is the input (i << 8) / 65535
+    float step = bytes_per_color > 1 ? 256.0f / 65535.0f : 1.0f / 255.0f;
+    for (size_t i = 0; i < size; i++) {
+        // the 16-bit end point is just past the full scale input, so that the top segment interpolates like the others
+        float x = i * step;
+        float y = gamma == 1.0f ? x : powf(x, gamma);
+        uint32_t value = (uint32_t)(y * gain + 0.5f);
+        // keep the LUT monotonic and within the full scale (except the 16-bit end point), whatever the float rounding
+        if (i < 256 && value > (uint32_t)full_scale) {
+            value = (uint32_t)full_scale;
+        }
+        if (i > 0 && value < lut[i - 1]) {
+            value = lut[i - 1];
+        }
+        lut[i] = value;
+    }
+}
+
+esp_err_t led_strip_transform_set(led_strip_transform_t *transform, led_color_component_format_t fmt, const led_strip_transform_config_t *config)
+{
+    if (!config) {
+        transform->enabled = false;
+        return ESP_OK;
+    }
+
+    struct format_layout format = fmt.format;
+    size_t lut_size = led_strip_transform_lut_size(format.bytes_per_color);
+    if (!transform->luts) {
+        transform->luts = heap_caps_malloc(LED_STRIP_MAX_COMPONENTS * lut_size * sizeof(uint32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!transform->luts) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    const uint8_t scales[LED_STRIP_MAX_COMPONENTS] = {config->r_scale, config->g_scale, config->b_scale, config->w_scale};
+    const uint8_t positions[LED_STRIP_MAX_COMPONENTS] = {format.r_pos, format.g_pos, format.b_pos, format.w_pos};
+    for (int c = 0; c < format.num_components; c++) {
+        uint32_t *lut = transform->luts + c * lut_size;
+        led_strip_build_transform_lut(config, scales[c] ? scales[c] : 255, format.bytes_per_color, lut);
+        transform->slot_lut[positions[c]] = lut;
+    }
+    transform->dither = config->flags.temporal_dither;
+    transform->enabled = true;
+    return ESP_OK;
+}
+
+void led_strip_transform_free(led_strip_transform_t *transform)
+{
+    free(transform->luts);
+    transform->luts = NULL;
+    transform->enabled = false;
+}
+
+void led_strip_transform_apply(const led_strip_transform_t *transform, led_color_component_format_t fmt, const uint8_t *pixels,
+                               size_t pos, size_t len, uint8_t *dst)
+{
+    struct format_layout format = fmt.format;
+    uint8_t bytes_per_color = format.bytes_per_color;
+    uint32_t bytes_per_pixel = format.num_components * bytes_per_color;
+    uint32_t pixel = pos / bytes_per_pixel;
+    uint32_t slot = (pos / bytes_per_color) % format.num_components;
+    // round to the nearest level, unless the fraction is dithered
+    uint32_t offset = transform->dither ? led_strip_transform_dither_offset(transform->frame, pixel) : 0x80;
+    const uint8_t *src = pixels + pos;
+
+    for (size_t n = 0; n < len; n += bytes_per_color) {
+        uint32_t level = led_strip_transform_level(transform->slot_lut[slot], src, bytes_per_color, offset);
+        if (bytes_per_color == 1) {
+            dst[0] = level;
+        } else {
+            dst[0] = level >> 8;
+            dst[1] = level & 0xFF;
+        }
+        src += bytes_per_color;
+        dst += bytes_per_color;
+        if (++slot == format.num_components) {
+            slot = 0;
+            pixel++;
+            if (transform->dither) {
+                offset = led_strip_transform_dither_offset(transform->frame, pixel);
+            }
+        }
+    }
+}
@@ -0,0 +1,303 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of bytes in one pixel (4 components, 2 bytes per color)
+ */
+#define LED_STRIP_MAX_BYTES_PER_PIXEL 8
+
+/**
+ * @brief Byte level swizzle from a source pixel layout to the strip pixel layout
+ */
+typedef struct {
+    int8_t src_byte[LED_STRIP_MAX_BYTES_PER_PIXEL]; /*!< For each destination byte, the index of the source byte, or -1 to write zero */
+    uint8_t src_bytes_per_pixel;                    /*!< Size of one source pixel, in bytes */
+    uint8_t dst_bytes_per_pixel;                    /*!< Size of one destination pixel, in bytes */
+    bool identity;                                  /*!< Source and destination layouts are the same, a plain copy is enough */
+    bool complete;                                  /*!< Every destination byte has a source byte (no zero filling) */
+} led_strip_swizzle_t;
+
+/**
+ * @brief Extend the dirty prefix of a strip so that it covers the pixels before `end`
+ *
+ * @note The chained LEDs shift the data through, so a partial refresh can only skip the tail of the strip:
+ *       the dirty state is kept as the number of leading pixels that must be sent on the next refresh.
+ *
+ * @param[in,out] dirty_len Number of leading pixels to send
+ * @param[in] end One past the index of the last modified pixel
+ */
+static inline void led_strip_mark_dirty(uint32_t *dirty_len, uint32_t end)
+{
+    if (end > *dirty_len) {
+        *dirty_len = end;
+    }
+}
+
+/**
+ * @brief Number of hue steps of the 1536-step hue wheel (6 sectors of 256 steps)
+ */
+#define LED_STRIP_HUE_WHEEL_STEPS 1536
+
+/**
+ * @brief Pick the RGB components of a hue sector
+ *
+ * @note Branch-light: the sector selects from a table which of the four candidate levels goes to each component.
+ *
+ * @param sector Hue sector: 0~5, larger values are treated as 5
+ * @param rgb_max Level of the dominant component (the value)
+ * @param rgb_min Level of the weakest component
+ * @param rgb_adj Position in the sector, between 0 and `rgb_max - rgb_min`
+ * @param[out] rgb Red, green and blue levels
+ */
+static inline void led_strip_hsv_sector_to_rgb(uint32_t sector, uint32_t rgb_max, uint32_t rgb_min, uint32_t rgb_adj, uint32_t rgb[3])
+{
+    // candidate levels: 0 - max, 1 - min, 2 - rising edge, 3 - falling edge
+    static const uint8_t s_sector_map[6][3] = {
+        {0, 2, 1}, {3, 0, 1}, {1, 0, 2}, {1, 3, 0}, {2, 1, 0}, {0, 1, 3},
+    };
+    const uint32_t levels[4] = {rgb_max, rgb_min, rgb_min + rgb_adj, rgb_max - rgb_adj};
+    const uint8_t *map = s_sector_map[sector < 5 ? sector : 5];
+    rgb[0] = levels[map[0]];
+    rgb[1] = levels[map[1]];
+    rgb[2] = levels[map[2]];
+}
+
+/**
+ * @brief Division by 60 with a multiplication, exact for any 32-bit value
+ */
+static inline uint32_t led_strip_div60(uint32_t x)
+{
+    return (uint32_t)(((uint64_t)x * 0x88888889u) >> 37);
+}
+
+/**
+ * @brief Convert an 8-bit HSV color with the hue in degrees to RGB, without division
+ *
+ * @note Gives exactly the same result as the per-pixel `led_strip_set_pixel_hsv` always did.
+ */
+static inline void led_strip_hsv_to_rgb(uint32_t hue, uint32_t saturation, uint32_t value, uint32_t rgb[3])
+{
+    uint32_t rgb_min = (value * (255 - saturation) * 0x8081u) >> 23; // x / 255 for x <= 255 * 255
+    uint32_t sector = led_strip_div60(hue);
+    uint32_t diff = hue - sector * 60;
+    led_strip_hsv_sector_to_rgb(sector, value, rgb_min, led_strip_div60((value - rgb_min) * diff), rgb);
+}
+
+/**
+ * @brief Convert a 16-bit HSV color with the hue in degrees to RGB, without division
+ *
+ * @note Gives exactly the same result as the per-pixel `led_strip_set_pixel_hsv_16` always did.
+ */
+static inline void led_strip_hsv_to_rgb_16(uint32_t hue, uint32_t saturation, uint32_t value, uint32_t rgb[3])
+{
+    uint32_t x = value * (65535 - saturation);
+    uint32_t rgb_min = (x + (x >> 16) + 1) >> 16; // x / 65535 for x <= 65535 * 65535
+    uint32_t sector = led_strip_div60(hue);
+    uint32_t diff = hue - sector * 60;
+    led_strip_hsv_sector_to_rgb(sector, value, rgb_min, led_strip_div60((value - rgb_min) * diff), rgb);
+}
+
+/**
+ * @brief Convert an 8-bit HSV color with the hue on the 1536-step wheel to RGB
+ *
+ * @note The sector and the position in it are taken from the hue bits, hues past the wheel are wrapped around.
+ */
+static inline void led_strip_hsv1536_to_rgb(uint32_t hue, uint32_t saturation, uint32_t value, uint32_t rgb[3])
+{
+    if (hue >= LED_STRIP_HUE_WHEEL_STEPS) {
+        hue %= LED_STRIP_HUE_WHEEL_STEPS;
+    }
+    uint32_t rgb_min = (value * (255 - saturation) * 0x8081u) >> 23;
+    led_strip_hsv_sector_to_rgb(hue >> 8, value, rgb_min, ((value - rgb_min) * (hue & 0xFF)) >> 8, rgb);
+}
+
+/**
+ * @brief Output transform LUT entries are in 1/2^24 of the full scale of a color component
+ */
+#define LED_STRIP_TRANSFORM_LUT_BITS 24
+
+/**
+ * @brief Get the number of entries in the output transform LUT of one color component
+ *
+ * @note 8-bit components: one entry per value. 16-bit components: one entry per high byte plus the end point,
+ *       the low byte interpolates between two neighbour entries.
+ *
+ * @param bytes_per_color Bytes per color component: 1 or 2
+ * @return Number of LUT entries
+ */
+static inline size_t led_strip_transform_lut_size(uint8_t bytes_per_color)
+{
+    return bytes_per_color > 1 ? 257 : 256;
+}
+
+/**
+ * @brief Build the output transform LUT of one color component
+ *
+ * @note The LUT is monotonic and its entries for the inputs up to the full scale are at most the full scale,
+ *       so adding a rounding (or dither) offset below one output step never overflows an 8-bit component.
+ *       The 16-bit interpolation can slightly exceed the full scale at the top and must saturate.
+ *
+ * @param[in] config Transform configuration
+ * @param[in] scale White balance scale of the component, 1~255
+ * @param[in] bytes_per_color Bytes per color component: 1 or 2
+ * @param[out] lut LUT with `led_strip_transform_lut_size()` entries
+ */
+void led_strip_build_transform_lut(const led_strip_transform_config_t *config, uint8_t scale, uint8_t bytes_per_color, uint32_t *lut);
+
+/**
+ * @brief Maximum number of color components in one pixel
+ */
+#define LED_STRIP_MAX_COMPONENTS 4
+
+/**
+ * @brief Output transform state of a strip, shared by the backends
+ */
+typedef struct {
+    bool enabled;        /*!< Output transform enabled */
+    bool dither;         /*!< Temporal dithering enabled */
+    uint8_t frame;       /*!< Frame counter, drives the dither offset */
+    uint32_t *luts;      /*!< Memory of the LUTs, one per color component */
+    const uint32_t *slot_lut[LED_STRIP_MAX_COMPONENTS]; /*!< LUT of the component at each position of the pixel */
+} led_strip_transform_t;
+
+/**
+ * @brief Set up (or disable) the output transform of a strip
+ *
+ * @note The LUTs are allocated on first use in internal RAM, as the RMT encoder reads them from the ISR, and kept until
+ *       `led_strip_transform_free`, so changing the brightness doesn't allocate.
+ *
+ * @param[in,out] transform Transform state
+ * @param[in] fmt Pixel layout of the strip (normalized)
+ * @param[in] config Transform configuration, NULL to disable the transform
+ * @return
+ *      - ESP_OK: Set the transform successfully
+ *      - ESP_ERR_NO_MEM: No memory for the LUTs
+ */
+esp_err_t led_strip_transform_set(led_strip_transform_t *transform, led_color_component_format_t fmt, const led_strip_transform_config_t *config);
+
+/**
+ * @brief Free the LUTs of the output transform
+ */
+void led_strip_transform_free(led_strip_transform_t *transform);
+
+/**
+ * @brief Dither offset of a pixel in the current frame, in 1/256 of an output step
+ *
+ * @note Bit reversed frame counter: consecutive frames use offsets far apart, every 256 frames each offset is used once.
+ */
+FORCE_INLINE_ATTR uint32_t led_strip_transform_dither_offset(uint8_t frame, uint32_t pixel)
+{
+    uint8_t n = frame + pixel * 37; // shift the sequence per pixel, so the strip doesn't flicker as a whole
+    n = (n & 0xF0) >> 4 | (n & 0x0F) << 4;
+    n = (n & 0xCC) >> 2 | (n & 0x33) << 2;
+    n = (n & 0xAA) >> 1 | (n & 0x55) << 1;
+    return n;
+}
+
+/**
+ * @brief Output level of one color component through its LUT
+ *
+ * @param lut LUT of the component
+ * @param src Color component, MSB first
+ * @param bytes_per_color Bytes per color component: 1 or 2
+ * @param offset Rounding offset in 1/256 of an output step: 0x80 rounds to the nearest level, or the dither offset
+ * @return Output level, 0~0xFF or 0~0xFFFF
+ */
+FORCE_INLINE_ATTR uint32_t led_strip_transform_level(const uint32_t *lut, const uint8_t *src, uint8_t bytes_per_color, uint32_t offset)
+{
+    if (bytes_per_color == 1) {
+        return (lut[src[0]] + (offset << 8)) >> 16;
+    }
+    uint32_t base = lut[src[0]];
+    uint32_t level = (base + (((lut[src[0] + 1] - base) * src[1]) >> 8) + offset) >> 8;
+    return level > 0xFFFF ? 0xFFFF : level;
+}
+
+/**
+ * @brief Apply the output transform to whole color components of a raw pixel buffer
+ *
+ * @param[in] transform Transform state (enabled)
+ * @param[in] fmt Pixel layout of the strip (normalized)
+ * @param[in] pixels Raw pixel buffer of the strip, the component positions and the dither follow from the byte offset in it
+ * @param[in] pos Byte offset of the first component, a multiple of the bytes per color
+ * @param[in] len Number of bytes, a multiple of the bytes per color
+ * @param[out] dst Transformed color bytes, in the same layout
+ */
+void led_strip_transform_apply(const led_strip_transform_t *transform, led_color_component_format_t fmt, const uint8_t *pixels,
+                               size_t pos, size_t len, uint8_t *dst);
+
+/**
+ * @brief Write one pixel into a raw pixel buffer (one byte per color byte, MSB first)
+ *
+ * @param[out] dst First byte of the pixel
+ * @param[in] fmt Strip pixel format
+ * @param[in] red Red component
+ * @param[in] green Green component
+ * @param[in] blue Blue component
+ * @param[in] white White component, ignored by 3-component layouts
+ */
+static inline void led_strip_pack_pixel(uint8_t *dst, led_color_component_format_t fmt, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    uint8_t pos_bytes = fmt.format.bytes_per_color;
+    for (uint8_t i = 0; i < fmt.format.bytes_per_color; i++) {
+        uint8_t color_shift = 8 * (fmt.format.bytes_per_color - 1 - i);
+        dst[fmt.format.r_pos * pos_bytes + i] = (red >> color_shift) & 0xFF;
+        dst[fmt.format.g_pos * pos_bytes + i] = (green >> color_shift) & 0xFF;
+        dst[fmt.format.b_pos * pos_bytes + i] = (blue >> color_shift) & 0xFF;
+        if (fmt.format.num_components > 3) {
+            dst[fmt.format.w_pos * pos_bytes + i] = (white >> color_shift) & 0xFF;
+        }
+    }
+}
+
+/**
+ * @brief Convert pixels through a swizzle into a raw pixel buffer
+ *
+ * @param[out] dst First byte of the first destination pixel
+ * @param[in] src First byte of the first source pixel
+ * @param[in] count Number of pixels
+ * @param[in] swizzle Swizzle from the source layout to the strip layout
+ */
+void led_strip_pack_pixels(uint8_t *dst, const uint8_t *src, uint32_t count, const led_strip_swizzle_t *swizzle);
+
+/**
+ * @brief Normalize and validate a color component format (fill in the default values for zero fields)
+ *
+ * @param[in,out] fmt Color component format
+ * @return
+ *      - ESP_OK: The format is valid
+ *      - ESP_ERR_INVALID_ARG: The format is invalid
+ */
+esp_err_t led_strip_normalize_format(led_color_component_format_t *fmt);
+
+/**
+ * @brief Build the byte swizzle between two (normalized) color component formats
+ *
+ * @note Multi-byte color components are stored MSB first in both layouts, like `led_strip_set_pixel` does.
+ *       When the widths differ, the value is kept (e.g. 8-bit source 0xAB becomes 0x00AB in a 16-bit strip).
+ *       A missing white component is written as zero, an extra one is dropped.
+ *
+ * @param[in] src_fmt Source pixel format
+ * @param[in] dst_fmt Destination (strip) pixel format
+ * @param[out] swizzle Returned swizzle
+ */
+void led_strip_build_swizzle(led_color_component_format_t src_fmt, led_color_component_format_t dst_fmt, led_strip_swizzle_t *swizzle);
+
+#ifdef __cplusplus
+}
+#endif
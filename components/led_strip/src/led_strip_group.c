@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "soc/soc_caps.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+#include "driver/rmt_tx.h"
+#endif
+
+static const char *TAG = "led_strip_group";
+
+typedef struct led_strip_group_t {
+    size_t num_strips;
+    led_strip_handle_t strips[LED_STRIP_GROUP_MAX_STRIPS];
+    bool in_flight;  // a group refresh was started and not waited for yet
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    rmt_sync_manager_handle_t rmt_sync; // starts the RMT channels of the group at the same time, NULL if less than 2 channels
+#endif
+} led_strip_group_t;
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+static esp_err_t led_strip_group_rmt_sync_install(led_strip_group_t *group)
+{
+    rmt_channel_handle_t channels[LED_STRIP_GROUP_MAX_STRIPS];
+    size_t num_channels = 0;
+    for (size_t i = 0; i < group->num_strips; i++) {
+        if (group->strips[i]->rmt_sync_join) {
+            num_channels++;
+        }
+    }
+    if (num_channels < 2) {
+        // nothing to synchronize
+        return ESP_OK;
+    }
+
+    num_channels = 0;
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < group->num_strips; i++) {
+        led_strip_t *strip = group->strips[i];
+        if (strip->rmt_sync_join) {
+            ESP_GOTO_ON_ERROR(strip->rmt_sync_join(strip, true, &channels[num_channels]), err, TAG, "strip %zu can't join RMT sync", i);
+            num_channels++;
+        }
+    }
+    rmt_sync_manager_config_t sync_config = {
+        .tx_channel_array = channels,
+        .array_size = num_channels,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_sync_manager(&sync_config, &group->rmt_sync), err, TAG, "create RMT sync manager failed");
+    return ESP_OK;
+err:
+    for (size_t i = 0; i < group->num_strips; i++) {
+        led_strip_t *strip = group->strips[i];
+        if (strip->rmt_sync_join) {
+            strip->rmt_sync_join(strip, false, NULL);
+        }
+    }
+    return ret;
+}
+
+static void led_strip_group_rmt_sync_uninstall(led_strip_group_t *group)
+{
+    if (!group->rmt_sync) {
+        return;
+    }
+    rmt_del_sync_manager(group->rmt_sync);
+    group->rmt_sync = NULL;
+    for (size_t i = 0; i < group->num_strips; i++) {
+        led_strip_t *strip = group->strips[i];
+        if (strip->rmt_sync_join) {
+            strip->rmt_sync_join(strip, false, NULL);
+        }
+    }
+}
+#endif
+
+esp_err_t led_strip_new_group(const led_strip_handle_t *strips, size_t num_strips, led_strip_group_handle_t *ret_group)
+{
+    ESP_RETURN_ON_FALSE(strips && ret_group && num_strips > 0 && num_strips <= LED_STRIP_GROUP_MAX_STRIPS,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    for (size_t i = 0; i < num_strips; i++) {
+        ESP_RETURN_ON_FALSE(strips[i], ESP_ERR_INVALID_ARG, TAG, "strip %zu is NULL", i);
+        // a blocking refresh would serialize the group
+        ESP_RETURN_ON_FALSE(strips[i]->refresh_async, ESP_ERR_NOT_SUPPORTED, TAG, "strip %zu doesn't support asynchronous refresh", i);
+        for (size_t j = 0; j < i; j++) {
+            ESP_RETURN_ON_FALSE(strips[i] != strips[j], ESP_ERR_INVALID_ARG, TAG, "strip %zu is duplicated", i);
+        }
+    }
+
+    led_strip_group_t *group = calloc(1, sizeof(led_strip_group_t));
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_NO_MEM, TAG, "no mem for strip group");
+    group->num_strips = num_strips;
+    for (size_t i = 0; i < num_strips; i++) {
+        group->strips[i] = strips[i];
+    }
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    esp_err_t ret = led_strip_group_rmt_sync_install(group);
+    if (ret != ESP_OK) {
+        free(group);
+        return ret;
+    }
+#endif
+    *ret_group = group;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_group_wait_refresh_done(led_strip_group_handle_t group, int32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (!group->in_flight) {
+        return ESP_OK;
+    }
+    for (size_t i = 0; i < group->num_strips; i++) {
+        esp_err_t ret = led_strip_wait_refresh_done(group->strips[i], timeout_ms);
+        if (ret == ESP_ERR_TIMEOUT) {
+            return ret;
+        }
+        ESP_RETURN_ON_ERROR(ret, TAG, "wait strip %zu failed", i);
+    }
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    if (group->rmt_sync) {
+        // all the channels are idle, arm the sync manager for the next round
+        ESP_RETURN_ON_ERROR(rmt_sync_reset(group->rmt_sync), TAG, "reset RMT sync manager failed");
+    }
+#endif
+    group->in_flight = false;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_group_refresh_async(led_strip_group_handle_t group)
+{
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_ERROR(led_strip_group_wait_refresh_done(group, -1), TAG, "wait previous refresh failed");
+    // mark the group busy first, so that a partially started round is still waited for
+    group->in_flight = true;
+    for (size_t i = 0; i < group->num_strips; i++) {
+        ESP_RETURN_ON_ERROR(led_strip_refresh_async(group->strips[i]), TAG, "refresh strip %zu failed", i);
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_group_refresh(led_strip_group_handle_t group)
+{
+    ESP_RETURN_ON_ERROR(led_strip_group_refresh_async(group), TAG, "refresh failed");
+    return led_strip_group_wait_refresh_done(group, -1);
+}
+
+esp_err_t led_strip_del_group(led_strip_group_handle_t group)
+{
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_ERROR(led_strip_group_wait_refresh_done(group, -1), TAG, "wait refresh failed");
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    led_strip_group_rmt_sync_uninstall(group);
+#endif
+    free(group);
+    return ESP_OK;
+}
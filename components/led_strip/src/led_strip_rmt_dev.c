@@ -9,9 +9,11 @@
 #include "esp_log.h"
 #include "esp_check.h"
 #include "driver/rmt_tx.h"
+#include "esp_heap_caps.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
 #include "led_strip_rmt_encoder.h"
+#include "led_strip_common.h"
 
 #define LED_STRIP_RMT_DEFAULT_RESOLUTION 10000000 // 10MHz resolution
 #define LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE 4
@@ -31,7 +33,13 @@ typedef struct {
     uint32_t strip_len;
     uint8_t bytes_per_pixel;
     led_color_component_format_t component_fmt;
-    uint8_t pixel_buf[];
+    bool partial_refresh; // send only the dirty prefix of the strip, skip the frame when nothing changed
+    uint32_t dirty_len;   // number of leading pixels modified since the last refresh
+    bool synced;          // the channel is started by the RMT sync manager of a strip group
+    bool double_buffer;  // channel stays enabled, `back_buf` is transmitted while `pixel_buf` is being rendered
+    uint8_t *pixel_buf;  // buffer that set_pixel writes to
+    uint8_t *back_buf;   // buffer handed to the RMT driver (double buffer mode only)
+    uint8_t *pixel_mem;  // memory of the pixel buffers, in PSRAM with `flags.pixel_buf_in_psram`
 } led_strip_rmt_obj;
 
 static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
@@ -39,20 +47,8 @@ static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uin
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
     ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
 
-    struct format_layout format = rmt_strip->component_fmt.format;
-    uint32_t start = index * rmt_strip->bytes_per_pixel;
-    uint8_t *pixel_buf = rmt_strip->pixel_buf;
-    uint8_t pos_bytes = format.bytes_per_color;
-
-    for (uint8_t i = 0; i < format.bytes_per_color; i++) {
-        uint8_t color_shift = 8 * (format.bytes_per_color - 1 - i);
-        pixel_buf[start + format.r_pos * pos_bytes + i] = (red >> color_shift) & 0xFF;
-        pixel_buf[start + format.g_pos * pos_bytes + i] = (green >> color_shift) & 0xFF;
-        pixel_buf[start + format.b_pos * pos_bytes + i] = (blue >> color_shift) & 0xFF;
-        if (format.num_components > 3) {
-            pixel_buf[start + format.w_pos * pos_bytes + i] = 0;
-        }
-    }
+    led_strip_pack_pixel(rmt_strip->pixel_buf + index * rmt_strip->bytes_per_pixel, rmt_strip->component_fmt, red, green, blue, 0);
+    led_strip_mark_dirty(&rmt_strip->dirty_len, index + 1);
     return ESP_OK;
 }
 
@@ -63,17 +59,91 @@ static esp_err_t led_strip_rmt_set_pixel_rgbw(led_strip_t *strip, uint32_t index
     ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
     ESP_RETURN_ON_FALSE(format.num_components == 4, ESP_ERR_INVALID_ARG, TAG, "led doesn't have 4 components");
 
-    uint32_t start = index * rmt_strip->bytes_per_pixel;
-    uint8_t *pixel_buf = rmt_strip->pixel_buf;
-    uint8_t pos_bytes = format.bytes_per_color;
+    led_strip_pack_pixel(rmt_strip->pixel_buf + index * rmt_strip->bytes_per_pixel, rmt_strip->component_fmt, red, green, blue, white);
+    led_strip_mark_dirty(&rmt_strip->dirty_len, index + 1);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *pixels, led_color_component_format_t src_format)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(start < rmt_strip->strip_len && count <= rmt_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "pixel range out of maximum number of LEDs");
+
+    led_strip_swizzle_t swizzle;
+    led_strip_build_swizzle(src_format, rmt_strip->component_fmt, &swizzle);
+    led_strip_pack_pixels(rmt_strip->pixel_buf + start * rmt_strip->bytes_per_pixel, pixels, count, &swizzle);
+    led_strip_mark_dirty(&rmt_strip->dirty_len, start + count);
+    return ESP_OK;
+}
 
-    for (uint8_t i = 0; i < format.bytes_per_color; i++) {
-        uint8_t color_shift = 8 * (format.bytes_per_color - 1 - i);
-        pixel_buf[start + format.r_pos * pos_bytes + i] = (red >> color_shift) & 0xFF;
-        pixel_buf[start + format.g_pos * pos_bytes + i] = (green >> color_shift) & 0xFF;
-        pixel_buf[start + format.b_pos * pos_bytes + i] = (blue >> color_shift) & 0xFF;
-        pixel_buf[start + format.w_pos * pos_bytes + i] = (white >> color_shift) & 0xFF;
+// number of bytes to send on the next refresh, 0 means the frame can be skipped
+static size_t led_strip_rmt_tx_size(led_strip_rmt_obj *rmt_strip)
+{
+    uint32_t len = rmt_strip->partial_refresh ? rmt_strip->dirty_len : rmt_strip->strip_len;
+    if (rmt_strip->synced && len == 0) {
+        // the sync manager waits for every channel, resend the first pixel (its content didn't change)
+        len = 1;
     }
+    return len * rmt_strip->bytes_per_pixel;
+}
+
+static esp_err_t led_strip_rmt_refresh_async(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    rmt_transmit_config_t tx_conf = {
+        .loop_count = 0,
+    };
+    size_t tx_size = led_strip_rmt_tx_size(rmt_strip);
+    if (tx_size == 0) {
+        return ESP_OK;
+    }
+
+    // the previous frame is still read from `back_buf`, it must be fully sent before the buffers are swapped
+    ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+    uint8_t *tx_buf = rmt_strip->pixel_buf;
+    rmt_strip->pixel_buf = rmt_strip->back_buf;
+    rmt_strip->back_buf = tx_buf;
+    ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, tx_buf, tx_size, &tx_conf),
+                        TAG, "transmit pixels by RMT failed");
+    // keep the rendered content, so that callers can keep updating only part of the pixels (overlaps with the transmission)
+    // both buffers only differ in the dirty prefix
+    memcpy(rmt_strip->pixel_buf, tx_buf, rmt_strip->dirty_len * rmt_strip->bytes_per_pixel);
+    rmt_strip->dirty_len = 0;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_wait_refresh_done(led_strip_t *strip, int32_t timeout_ms)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (!rmt_strip->double_buffer) {
+        // single buffer refresh is blocking, nothing is in flight
+        return ESP_OK;
+    }
+    return rmt_tx_wait_all_done(rmt_strip->rmt_chan, timeout_ms);
+}
+
+static esp_err_t led_strip_rmt_sync_join(led_strip_t *strip, bool join, rmt_channel_handle_t *ret_chan)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    // the sync manager requires the channel to stay enabled
+    ESP_RETURN_ON_FALSE(rmt_strip->double_buffer, ESP_ERR_INVALID_STATE, TAG, "strip is not double buffered");
+    rmt_strip->synced = join;
+    if (ret_chan) {
+        *ret_chan = rmt_strip->rmt_chan;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_transform(led_strip_t *strip, const led_strip_transform_config_t *config)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (rmt_strip->double_buffer) {
+        // the LUTs are read by the encoder while a frame is on the wire
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+    }
+    ESP_RETURN_ON_ERROR(rmt_led_strip_encoder_set_transform(rmt_strip->strip_encoder, config), TAG, "set transform failed");
+    // every LED shows a different color now, even if no pixel was set
+    rmt_strip->dirty_len = rmt_strip->strip_len;
     return ESP_OK;
 }
 
@@ -84,11 +154,21 @@ static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
         .loop_count = 0,
     };
 
+    if (rmt_strip->double_buffer) {
+        ESP_RETURN_ON_ERROR(led_strip_rmt_refresh_async(strip), TAG, "refresh failed");
+        return led_strip_rmt_wait_refresh_done(strip, -1);
+    }
+
+    size_t tx_size = led_strip_rmt_tx_size(rmt_strip);
+    if (tx_size == 0) {
+        return ESP_OK;
+    }
     ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
     ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->pixel_buf,
-                                     rmt_strip->strip_len * rmt_strip->bytes_per_pixel, &tx_conf), TAG, "transmit pixels by RMT failed");
+                                     tx_size, &tx_conf), TAG, "transmit pixels by RMT failed");
     ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
     ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    rmt_strip->dirty_len = 0;
     return ESP_OK;
 }
 
@@ -97,14 +177,20 @@ static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
     // Write zero to turn off all leds
     memset(rmt_strip->pixel_buf, 0, rmt_strip->strip_len * rmt_strip->bytes_per_pixel);
+    rmt_strip->dirty_len = rmt_strip->strip_len;
     return led_strip_rmt_refresh(strip);
 }
 
 static esp_err_t led_strip_rmt_del(led_strip_t *strip)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (rmt_strip->double_buffer) {
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+        ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    }
     ESP_RETURN_ON_ERROR(rmt_del_channel(rmt_strip->rmt_chan), TAG, "delete RMT channel failed");
     ESP_RETURN_ON_ERROR(rmt_del_encoder(rmt_strip->strip_encoder), TAG, "delete strip encoder failed");
+    free(rmt_strip->pixel_mem);
     free(rmt_strip);
     return ESP_OK;
 }
@@ -142,8 +228,24 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     if (component_fmt.format.bytes_per_color > 1) {
         bytes_per_pixel *= component_fmt.format.bytes_per_color;
     }
-    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + led_config->max_leds * bytes_per_pixel);
+    size_t frame_size = led_config->max_leds * bytes_per_pixel;
+    bool double_buffer = rmt_config->flags.double_buffer;
+#if CONFIG_RMT_ISR_IRAM_SAFE
+    // the encoder reads the pixels from the RMT ISR, which may run while the cache (and so the PSRAM) is disabled
+    ESP_GOTO_ON_FALSE(!led_config->flags.pixel_buf_in_psram, ESP_ERR_NOT_SUPPORTED, err, TAG, "PSRAM pixel buffer is not allowed with CONFIG_RMT_ISR_IRAM_SAFE");
+#endif
+    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj));
     ESP_GOTO_ON_FALSE(rmt_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for rmt strip");
+    // only the pixel buffers go to PSRAM: the RMT symbols are always produced in the channel memory (or its internal DMA buffer)
+    uint32_t pixel_caps = led_config->flags.pixel_buf_in_psram ? MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT : MALLOC_CAP_DEFAULT;
+    rmt_strip->pixel_mem = heap_caps_calloc(1, frame_size * (double_buffer ? 2 : 1), pixel_caps);
+    ESP_GOTO_ON_FALSE(rmt_strip->pixel_mem, ESP_ERR_NO_MEM, err, TAG, "no mem for pixel buffer");
+    rmt_strip->double_buffer = double_buffer;
+    rmt_strip->partial_refresh = led_config->flags.partial_refresh;
+    // the LEDs state is unknown until the first full frame
+    rmt_strip->dirty_len = led_config->max_leds;
+    rmt_strip->pixel_buf = rmt_strip->pixel_mem;
+    rmt_strip->back_buf = double_buffer ? rmt_strip->pixel_mem + frame_size : rmt_strip->pixel_mem;
     uint32_t resolution = rmt_config->resolution_hz ? rmt_config->resolution_hz : LED_STRIP_RMT_DEFAULT_RESOLUTION;
 
     // for backward compatibility, if the user does not set the clk_src, use the default value
@@ -169,16 +271,27 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
 
     led_strip_encoder_config_t strip_encoder_conf = {
         .resolution = resolution,
-        .led_model = led_config->led_model
+        .led_model = led_config->led_model,
+        .timing = rmt_config->timing,
+        .component_fmt = component_fmt,
     };
     ESP_GOTO_ON_ERROR(rmt_new_led_strip_encoder(&strip_encoder_conf, &rmt_strip->strip_encoder), err, TAG, "create LED strip encoder failed");
+    if (double_buffer) {
+        // the channel is kept enabled for the whole life of the strip, so refresh doesn't pay for enable/disable
+        ESP_GOTO_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), err, TAG, "enable RMT channel failed");
+    }
 
     rmt_strip->component_fmt = component_fmt;
     rmt_strip->bytes_per_pixel = bytes_per_pixel;
     rmt_strip->strip_len = led_config->max_leds;
     rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
     rmt_strip->base.set_pixel_rgbw = led_strip_rmt_set_pixel_rgbw;
+    rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
     rmt_strip->base.refresh = led_strip_rmt_refresh;
+    rmt_strip->base.refresh_async = double_buffer ? led_strip_rmt_refresh_async : NULL;
+    rmt_strip->base.wait_refresh_done = led_strip_rmt_wait_refresh_done;
+    rmt_strip->base.rmt_sync_join = led_strip_rmt_sync_join;
+    rmt_strip->base.set_transform = led_strip_rmt_set_transform;
     rmt_strip->base.clear = led_strip_rmt_clear;
     rmt_strip->base.del = led_strip_rmt_del;
 
@@ -187,11 +300,15 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
 err:
     if (rmt_strip) {
         if (rmt_strip->rmt_chan) {
+            if (rmt_strip->double_buffer) {
+                rmt_disable(rmt_strip->rmt_chan);
+            }
             rmt_del_channel(rmt_strip->rmt_chan);
         }
         if (rmt_strip->strip_encoder) {
             rmt_del_encoder(rmt_strip->strip_encoder);
         }
+        free(rmt_strip->pixel_mem);
         free(rmt_strip);
     }
     return ret;
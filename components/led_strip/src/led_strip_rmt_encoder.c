@@ -1,14 +1,17 @@
 /*
- * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2022-2024 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <string.h>
 #include "sdkconfig.h"
 #include "esp_idf_version.h"
 #include "esp_check.h"
 #include "esp_attr.h"
+#include "esp_heap_caps.h"
 #include "led_strip_rmt_encoder.h"
+#include "led_strip_common.h"
 
 static const char *TAG = "led_rmt_encoder";
 
@@ -20,14 +23,198 @@ static const char *TAG = "led_rmt_encoder";
 #endif // CONFIG_RMT_ISR_IRAM_SAFE
 #endif // ESP_IDF_VERSION
 
+// The simple encoder (IDF v5.3+) lets the callback write symbols straight into the channel memory,
+// so pixels are encoded in a single pass from a per-byte symbol table
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+#define LED_STRIP_RMT_SINGLE_PASS_ENCODER 1
+#else
+#define LED_STRIP_RMT_SINGLE_PASS_ENCODER 0
+#endif
+
+#define LED_STRIP_RMT_SYMBOLS_PER_BYTE 8
+#define LED_STRIP_RMT_MAX_DURATION 0x7FFF // durations are 15-bit fields of the RMT symbol
+
+// Timing of the supported models
+static const led_strip_rmt_timing_t s_led_model_timing[LED_MODEL_INVALID] = {
+    // different led strip might have its own timing requirements
+    [LED_MODEL_WS2812] = {.t0h_ns = 300, .t0l_ns = 900, .t1h_ns = 900, .t1l_ns = 300, .reset_us = 280}, // 280us to accommodate WS2812B-V5
+    [LED_MODEL_SK6812] = {.t0h_ns = 300, .t0l_ns = 900, .t1h_ns = 600, .t1l_ns = 600, .reset_us = 280},
+    [LED_MODEL_WS2811] = {.t0h_ns = 500, .t0l_ns = 2000, .t1h_ns = 1200, .t1l_ns = 1300, .reset_us = 50},
+    [LED_MODEL_WS2816] = {.t0h_ns = 300, .t0l_ns = 950, .t1h_ns = 750, .t1l_ns = 500, .reset_us = 280},
+};
+
 typedef struct {
     rmt_encoder_t base;
+#if LED_STRIP_RMT_SINGLE_PASS_ENCODER
+    rmt_encoder_t *simple_encoder;
+    uint32_t (*byte_symbols)[LED_STRIP_RMT_SYMBOLS_PER_BYTE]; // symbols of every byte value, MSB first
+    led_color_component_format_t component_fmt;
+    uint8_t bytes_per_pixel;
+    led_strip_transform_t transform;
+#else
     rmt_encoder_t *bytes_encoder;
     rmt_encoder_t *copy_encoder;
     int state;
+#endif
     rmt_symbol_word_t reset_code;
 } rmt_led_strip_encoder_t;
 
+static inline uint32_t led_strip_ns_to_ticks(uint32_t resolution, uint32_t ns)
+{
+    return (uint32_t)((uint64_t)resolution * ns / 1000000000);
+}
+
+#if LED_STRIP_RMT_SINGLE_PASS_ENCODER
+// The encoding progress is derived from `symbols_written`: every data byte takes 8 symbols, followed by one reset symbol
+RMT_ENCODER_FUNC_ATTR
+static inline void rmt_led_strip_put_byte(const rmt_led_strip_encoder_t *led_encoder, uint8_t value, uint32_t *dst)
+{
+    const uint32_t *sym = led_encoder->byte_symbols[value];
+    dst[0] = sym[0];
+    dst[1] = sym[1];
+    dst[2] = sym[2];
+    dst[3] = sym[3];
+    dst[4] = sym[4];
+    dst[5] = sym[5];
+    dst[6] = sym[6];
+    dst[7] = sym[7];
+}
+
+// Encode whole color components starting at byte `pos`, through the output transform LUTs
+RMT_ENCODER_FUNC_ATTR
+static size_t rmt_encode_led_strip_transform(rmt_led_strip_encoder_t *led_encoder, const uint8_t *data, size_t data_size,
+                                             size_t pos, size_t symbols_free, uint32_t *dst)
+{
+    struct format_layout format = led_encoder->component_fmt.format;
+    uint8_t bytes_per_color = format.bytes_per_color;
+    size_t num_colors = symbols_free / LED_STRIP_RMT_SYMBOLS_PER_BYTE / bytes_per_color;
+    if (num_colors > (data_size - pos) / bytes_per_color) {
+        num_colors = (data_size - pos) / bytes_per_color;
+    }
+    const led_strip_transform_t *transform = &led_encoder->transform;
+    uint32_t pixel = pos / led_encoder->bytes_per_pixel;
+    uint32_t slot = (pos / bytes_per_color) % format.num_components;
+    // round to the nearest level, unless the fraction is dithered
+    uint32_t offset = transform->dither ? led_strip_transform_dither_offset(transform->frame, pixel) : 0x80;
+    const uint8_t *src = data + pos;
+
+    for (size_t n = 0; n < num_colors; n++) {
+        uint32_t level = led_strip_transform_level(transform->slot_lut[slot], src, bytes_per_color, offset);
+        if (bytes_per_color == 1) {
+            rmt_led_strip_put_byte(led_encoder, level, dst);
+        } else {
+            rmt_led_strip_put_byte(led_encoder, level >> 8, dst);
+            rmt_led_strip_put_byte(led_encoder, level & 0xFF, dst + LED_STRIP_RMT_SYMBOLS_PER_BYTE);
+        }
+        src += bytes_per_color;
+        dst += LED_STRIP_RMT_SYMBOLS_PER_BYTE * bytes_per_color;
+        if (++slot == format.num_components) {
+            slot = 0;
+            pixel++;
+            if (transform->dither) {
+                offset = led_strip_transform_dither_offset(transform->frame, pixel);
+            }
+        }
+    }
+    return num_colors * bytes_per_color * LED_STRIP_RMT_SYMBOLS_PER_BYTE;
+}
+
+RMT_ENCODER_FUNC_ATTR
+static size_t rmt_encode_led_strip_cb(const void *data, size_t data_size, size_t symbols_written, size_t symbols_free,
+                                      rmt_symbol_word_t *symbols, bool *done, void *arg)
+{
+    rmt_led_strip_encoder_t *led_encoder = (rmt_led_strip_encoder_t *)arg;
+    size_t pos = symbols_written / LED_STRIP_RMT_SYMBOLS_PER_BYTE;
+    if (pos < data_size && led_encoder->transform.enabled) {
+        return rmt_encode_led_strip_transform(led_encoder, data, data_size, pos, symbols_free, (uint32_t *)symbols);
+    }
+    if (pos < data_size) {
+        size_t num_bytes = symbols_free / LED_STRIP_RMT_SYMBOLS_PER_BYTE;
+        if (num_bytes > data_size - pos) {
+            num_bytes = data_size - pos;
+        }
+        const uint8_t *src = (const uint8_t *)data + pos;
+        uint32_t *dst = (uint32_t *)symbols;
+        for (size_t i = 0; i < num_bytes; i++) {
+            rmt_led_strip_put_byte(led_encoder, src[i], dst);
+            dst += LED_STRIP_RMT_SYMBOLS_PER_BYTE;
+        }
+        return num_bytes * LED_STRIP_RMT_SYMBOLS_PER_BYTE;
+    }
+    if (symbols_free < 1) {
+        return 0;
+    }
+    symbols[0] = led_encoder->reset_code;
+    *done = true;
+    led_encoder->transform.frame++;
+    return 1;
+}
+
+RMT_ENCODER_FUNC_ATTR
+static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_handle_t simple_encoder = led_encoder->simple_encoder;
+    return simple_encoder->encode(simple_encoder, channel, primary_data, data_size, ret_state);
+}
+
+static esp_err_t rmt_del_led_strip_encoder(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_del_encoder(led_encoder->simple_encoder);
+    free(led_encoder->byte_symbols);
+    led_strip_transform_free(&led_encoder->transform);
+    free(led_encoder);
+    return ESP_OK;
+}
+
+RMT_ENCODER_FUNC_ATTR
+static esp_err_t rmt_led_strip_encoder_reset(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_reset(led_encoder->simple_encoder);
+    return ESP_OK;
+}
+
+static esp_err_t rmt_led_strip_encoder_install(rmt_led_strip_encoder_t *led_encoder, rmt_symbol_word_t bit0, rmt_symbol_word_t bit1)
+{
+    // the table is read from the encoding ISR, so it must be in internal RAM
+    led_encoder->byte_symbols = heap_caps_malloc(256 * sizeof(led_encoder->byte_symbols[0]), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(led_encoder->byte_symbols, ESP_ERR_NO_MEM, TAG, "no mem for symbol table");
+    for (int value = 0; value < 256; value++) {
+        for (int bit = 0; bit < LED_STRIP_RMT_SYMBOLS_PER_BYTE; bit++) {
+            // MSB first: G7...G0R7...R0B7...B0(W7...W0)
+            led_encoder->byte_symbols[value][bit] = (value & (0x80 >> bit)) ? bit1.val : bit0.val;
+        }
+    }
+    rmt_simple_encoder_config_t simple_encoder_config = {
+        .callback = rmt_encode_led_strip_cb,
+        .arg = led_encoder,
+        // the transform encodes whole color components
+        .min_chunk_size = LED_STRIP_RMT_SYMBOLS_PER_BYTE * led_encoder->component_fmt.format.bytes_per_color,
+    };
+    ESP_RETURN_ON_ERROR(rmt_new_simple_encoder(&simple_encoder_config, &led_encoder->simple_encoder), TAG, "create simple encoder failed");
+    return ESP_OK;
+}
+
+static void rmt_led_strip_encoder_uninstall(rmt_led_strip_encoder_t *led_encoder)
+{
+    if (led_encoder->simple_encoder) {
+        rmt_del_encoder(led_encoder->simple_encoder);
+    }
+    free(led_encoder->byte_symbols);
+    led_strip_transform_free(&led_encoder->transform);
+}
+
+esp_err_t rmt_led_strip_encoder_set_transform(rmt_encoder_handle_t encoder, const led_strip_transform_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(encoder, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    // the LUTs are read from the encoding ISR, led_strip_transform_set keeps them in internal RAM
+    ESP_RETURN_ON_ERROR(led_strip_transform_set(&led_encoder->transform, led_encoder->component_fmt, config), TAG, "no mem for transform LUTs");
+    return ESP_OK;
+}
+#else
 RMT_ENCODER_FUNC_ATTR
 static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
 {
@@ -84,110 +271,100 @@ static esp_err_t rmt_led_strip_encoder_reset(rmt_encoder_t *encoder)
     return ESP_OK;
 }
 
+static esp_err_t rmt_led_strip_encoder_install(rmt_led_strip_encoder_t *led_encoder, rmt_symbol_word_t bit0, rmt_symbol_word_t bit1)
+{
+    rmt_bytes_encoder_config_t bytes_encoder_config = {
+        .bit0 = bit0,
+        .bit1 = bit1,
+        .flags.msb_first = 1 // transfer bit order: G7...G0R7...R0B7...B0(W7...W0)
+    };
+    ESP_RETURN_ON_ERROR(rmt_new_bytes_encoder(&bytes_encoder_config, &led_encoder->bytes_encoder), TAG, "create bytes encoder failed");
+    rmt_copy_encoder_config_t copy_encoder_config = {};
+    ESP_RETURN_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &led_encoder->copy_encoder), TAG, "create copy encoder failed");
+    return ESP_OK;
+}
+
+static void rmt_led_strip_encoder_uninstall(rmt_led_strip_encoder_t *led_encoder)
+{
+    if (led_encoder->bytes_encoder) {
+        rmt_del_encoder(led_encoder->bytes_encoder);
+    }
+    if (led_encoder->copy_encoder) {
+        rmt_del_encoder(led_encoder->copy_encoder);
+    }
+}
+
+esp_err_t rmt_led_strip_encoder_set_transform(rmt_encoder_handle_t encoder, const led_strip_transform_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(encoder, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    // the bytes encoder can't change the data on the fly
+    ESP_RETURN_ON_FALSE(!config, ESP_ERR_NOT_SUPPORTED, TAG, "output transform requires IDF v5.3 or later");
+    return ESP_OK;
+}
+#endif // LED_STRIP_RMT_SINGLE_PASS_ENCODER
+
 esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
 {
     esp_err_t ret = ESP_OK;
     rmt_led_strip_encoder_t *led_encoder = NULL;
     ESP_GOTO_ON_FALSE(config && ret_encoder, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
     ESP_GOTO_ON_FALSE(config->led_model < LED_MODEL_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led model");
+
+    led_strip_rmt_timing_t timing = config->timing;
+    const led_strip_rmt_timing_t *model_timing = &s_led_model_timing[config->led_model];
+    if (timing.t0h_ns == 0 && timing.t0l_ns == 0 && timing.t1h_ns == 0 && timing.t1l_ns == 0) {
+        timing = *model_timing;
+    }
+    if (timing.reset_us == 0) {
+        timing.reset_us = model_timing->reset_us;
+    }
+    uint32_t t0h = led_strip_ns_to_ticks(config->resolution, timing.t0h_ns);
+    uint32_t t0l = led_strip_ns_to_ticks(config->resolution, timing.t0l_ns);
+    uint32_t t1h = led_strip_ns_to_ticks(config->resolution, timing.t1h_ns);
+    uint32_t t1l = led_strip_ns_to_ticks(config->resolution, timing.t1l_ns);
+    ESP_GOTO_ON_FALSE(t0h && t0l && t1h && t1l, ESP_ERR_INVALID_ARG, err, TAG, "bit timing is shorter than one tick");
+    ESP_GOTO_ON_FALSE(t0h <= LED_STRIP_RMT_MAX_DURATION && t0l <= LED_STRIP_RMT_MAX_DURATION &&
+                      t1h <= LED_STRIP_RMT_MAX_DURATION && t1l <= LED_STRIP_RMT_MAX_DURATION,
+                      ESP_ERR_INVALID_ARG, err, TAG, "bit timing is too long for the resolution");
+    rmt_symbol_word_t bit0 = {
+        .level0 = 1,
+        .duration0 = t0h,
+        .level1 = 0,
+        .duration1 = t0l,
+    };
+    rmt_symbol_word_t bit1 = {
+        .level0 = 1,
+        .duration0 = t1h,
+        .level1 = 0,
+        .duration1 = t1l,
+    };
+    // the reset code is one symbol, its duration is split in two halves
+    uint32_t reset_ticks = config->resolution / 1000000 * timing.reset_us / 2;
+    ESP_GOTO_ON_FALSE(reset_ticks <= LED_STRIP_RMT_MAX_DURATION, ESP_ERR_INVALID_ARG, err, TAG, "reset time is too long for the resolution");
+
     led_encoder = calloc(1, sizeof(rmt_led_strip_encoder_t));
     ESP_GOTO_ON_FALSE(led_encoder, ESP_ERR_NO_MEM, err, TAG, "no mem for led strip encoder");
     led_encoder->base.encode = rmt_encode_led_strip;
     led_encoder->base.del = rmt_del_led_strip_encoder;
     led_encoder->base.reset = rmt_led_strip_encoder_reset;
-    rmt_bytes_encoder_config_t bytes_encoder_config;
-    uint32_t reset_ticks = config->resolution / 1000000 * 280 / 2; // reset code duration defaults to 280us to accommodate WS2812B-V5
-    if (config->led_model == LED_MODEL_SK6812) {
-        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
-            .bit0 = {
-                .level0 = 1,
-                .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
-                .level1 = 0,
-                .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
-            },
-            .bit1 = {
-                .level0 = 1,
-                .duration0 = 0.6 * config->resolution / 1000000, // T1H=0.6us
-                .level1 = 0,
-                .duration1 = 0.6 * config->resolution / 1000000, // T1L=0.6us
-            },
-            .flags.msb_first = 1 // SK6812 transfer bit order: G7...G0R7...R0B7...B0(W7...W0)
-        };
-    } else if (config->led_model == LED_MODEL_WS2812) {
-        // different led strip might have its own timing requirements, following parameter is for WS2812
-        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
-            .bit0 = {
-                .level0 = 1,
-                .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
-                .level1 = 0,
-                .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
-            },
-            .bit1 = {
-                .level0 = 1,
-                .duration0 = 0.9 * config->resolution / 1000000, // T1H=0.9us
-                .level1 = 0,
-                .duration1 = 0.3 * config->resolution / 1000000, // T1L=0.3us
-            },
-            .flags.msb_first = 1 // WS2812 transfer bit order: G7...G0R7...R0B7...B0
-        };
-    } else if (config->led_model == LED_MODEL_WS2811) {
-        // different led strip might have its own timing requirements, following parameter is for WS2811
-        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
-            .bit0 = {
-                .level0 = 1,
-                .duration0 = 0.5 * config->resolution / 1000000., // T0H=0.5us
-                .level1 = 0,
-                .duration1 = 2.0 * config->resolution / 1000000., // T0L=2.0us
-            },
-            .bit1 = {
-                .level0 = 1,
-                .duration0 = 1.2 * config->resolution / 1000000., // T1H=1.2us
-                .level1 = 0,
-                .duration1 = 1.3 * config->resolution / 1000000., // T1L=1.3us
-            },
-            .flags.msb_first = 1
-        };
-        reset_ticks = config->resolution / 1000000 * 50 / 2; // divide by 2... signal is sent twice
-    } else if (config->led_model == LED_MODEL_WS2816) {
-        // different led strip might have its own timing requirements, following parameter is for WS2816
-        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
-            .bit0 = {
-                .level0 = 1,
-                .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
-                .level1 = 0,
-                .duration1 = 0.95 * config->resolution / 1000000, // T0L=0.95us
-            },
-            .bit1 = {
-                .level0 = 1,
-                .duration0 = 0.75 * config->resolution / 1000000, // T1H=0.75us
-                .level1 = 0,
-                .duration1 = 0.5 * config->resolution / 1000000, // T1L=0.5us
-            },
-            .flags.msb_first = 1
-        };
-    } else {
-        assert(false);
-    }
-    ESP_GOTO_ON_ERROR(rmt_new_bytes_encoder(&bytes_encoder_config, &led_encoder->bytes_encoder), err, TAG, "create bytes encoder failed");
-    rmt_copy_encoder_config_t copy_encoder_config = {};
-    ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &led_encoder->copy_encoder), err, TAG, "create copy encoder failed");
-
+#if LED_STRIP_RMT_SINGLE_PASS_ENCODER
+    led_encoder->component_fmt = config->component_fmt;
+    ESP_GOTO_ON_ERROR(led_strip_normalize_format(&led_encoder->component_fmt), err, TAG, "invalid color component format");
+    led_encoder->bytes_per_pixel = config->component_fmt.format.num_components * config->component_fmt.format.bytes_per_color;
+#endif
     led_encoder->reset_code = (rmt_symbol_word_t) {
         .level0 = 0,
         .duration0 = reset_ticks,
         .level1 = 0,
         .duration1 = reset_ticks,
     };
+    ESP_GOTO_ON_ERROR(rmt_led_strip_encoder_install(led_encoder, bit0, bit1), err, TAG, "install led strip encoder failed");
+
     *ret_encoder = &led_encoder->base;
     return ESP_OK;
 err:
     if (led_encoder) {
-        if (led_encoder->bytes_encoder) {
-            rmt_del_encoder(led_encoder->bytes_encoder);
-        }
-        if (led_encoder->copy_encoder) {
-            rmt_del_encoder(led_encoder->copy_encoder);
-        }
+        rmt_led_strip_encoder_uninstall(led_encoder);
         free(led_encoder);
     }
     return ret;
@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include "driver/rmt_encoder.h"
 #include "led_strip_types.h"
+#include "led_strip_rmt.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,6 +20,8 @@ extern "C" {
 typedef struct {
     uint32_t resolution;   /*!< Encoder resolution, in Hz */
     led_model_t led_model; /*!< LED model */
+    led_strip_rmt_timing_t timing; /*!< Custom bit timing, all zero to use the timing of `led_model` */
+    led_color_component_format_t component_fmt; /*!< Pixel layout of the encoded data (normalized), used by the output transform */
 } led_strip_encoder_config_t;
 
 /**
@@ -33,6 +36,20 @@ typedef struct {
  */
 esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder);
 
+/**
+ * @brief Set the output transform applied to the pixel data while encoding
+ *
+ * @note Must not be called while the encoder is in use by a transmission.
+ *
+ * @param[in] encoder Encoder created by `rmt_new_led_strip_encoder`
+ * @param[in] config Transform configuration, NULL to disable the transform
+ * @return
+ *      - ESP_ERR_NO_MEM out of memory when allocating the LUTs
+ *      - ESP_ERR_NOT_SUPPORTED the encoder doesn't support the transform (IDF before v5.3)
+ *      - ESP_OK if setting the transform successfully
+ */
+esp_err_t rmt_led_strip_encoder_set_transform(rmt_encoder_handle_t encoder, const led_strip_transform_config_t *config);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,7 +12,10 @@
 #include "soc/spi_periph.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
+#include "led_strip_common.h"
 #include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
 
 #define LED_STRIP_SPI_DEFAULT_RESOLUTION (2.5 * 1000 * 1000) // 2.5MHz resolution
 #define LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE 4
@@ -20,6 +23,10 @@
 #define SPI_BYTES_PER_COLOR_BYTE 3
 #define SPI_BITS_PER_COLOR_BYTE (SPI_BYTES_PER_COLOR_BYTE * 8)
 
+// PSRAM pixel buffer: color bytes encoded per chunk into one of the internal DMA bounce buffers
+#define LED_STRIP_SPI_PSRAM_CHUNK_BYTES 512
+#define LED_STRIP_SPI_PSRAM_BOUNCE_NUM 2
+
 static const char *TAG = "led_strip_spi";
 
 typedef struct {
@@ -29,34 +36,130 @@ typedef struct {
     uint32_t strip_len;
     uint8_t bytes_per_pixel;
     led_color_component_format_t component_fmt;
+    bool partial_refresh; // send only the dirty prefix of the strip, skip the frame when nothing changed
+    uint32_t dirty_len;   // number of leading pixels modified since the last refresh
+    bool trans_pending;   // `trans` is queued and its result is not taken yet
+    spi_transaction_t trans; // transaction of the asynchronous refresh, must live until it's done
+    uint8_t *raw_buf;     // unencoded color bytes: in PSRAM with `flags.pixel_buf_in_psram` (`pixel_buf` holds the bounce buffers then),
+                          // or next to `pixel_buf` once an output transform is set, the encoding is done at refresh
+    led_strip_transform_t transform;
+    spi_transaction_t chunk_trans[LED_STRIP_SPI_PSRAM_BOUNCE_NUM]; // transactions of the bounce buffers
     uint8_t pixel_buf[];
 } led_strip_spi_obj;
 
-// please make sure to zero-initialize the buf before calling this function
-static void __led_strip_spi_bit(uint8_t data, uint8_t *buf)
+// Each color of 1 bit is represented by 3 bits of SPI, low_level:100 ,high_level:110
+// So a color byte occupies 3 bytes of SPI: bit k of the color byte lands on bit (3 * k + 1) of a 24-bit word
+// whose fixed "1x0" frame is 0x924924. The expansion is precomputed for every byte value.
+#define LED_STRIP_SPI_EXPAND(d) (0x924924 | (((d) & 0x01) << 1) | (((d) & 0x02) << 3) | (((d) & 0x04) << 5) | (((d) & 0x08) << 7) | \
+                                 (((d) & 0x10) << 9) | (((d) & 0x20) << 11) | (((d) & 0x40) << 13) | (((d) & 0x80) << 15))
+// The table keeps the 3 bytes in transmission order from the least significant one, so that on the little-endian CPU
+// they can be merged into 32-bit stores
+#define LED_STRIP_SPI_EXPAND_LE(d) (((LED_STRIP_SPI_EXPAND(d) >> 16) & 0xFF) | (LED_STRIP_SPI_EXPAND(d) & 0xFF00) | ((LED_STRIP_SPI_EXPAND(d) & 0xFF) << 16))
+#define LED_STRIP_SPI_EXPAND_4(d) LED_STRIP_SPI_EXPAND_LE(d), LED_STRIP_SPI_EXPAND_LE((d) + 1), LED_STRIP_SPI_EXPAND_LE((d) + 2), LED_STRIP_SPI_EXPAND_LE((d) + 3)
+#define LED_STRIP_SPI_EXPAND_16(d) LED_STRIP_SPI_EXPAND_4(d), LED_STRIP_SPI_EXPAND_4((d) + 4), LED_STRIP_SPI_EXPAND_4((d) + 8), LED_STRIP_SPI_EXPAND_4((d) + 12)
+#define LED_STRIP_SPI_EXPAND_64(d) LED_STRIP_SPI_EXPAND_16(d), LED_STRIP_SPI_EXPAND_16((d) + 16), LED_STRIP_SPI_EXPAND_16((d) + 32), LED_STRIP_SPI_EXPAND_16((d) + 48)
+
+// placed in DRAM so that the lookup never goes through the flash cache
+DRAM_ATTR static const uint32_t s_led_strip_spi_bit_lut[256] = {
+    LED_STRIP_SPI_EXPAND_64(0), LED_STRIP_SPI_EXPAND_64(64), LED_STRIP_SPI_EXPAND_64(128), LED_STRIP_SPI_EXPAND_64(192),
+};
+
+// the whole 3-byte group is overwritten, no need to zero-initialize the buf before calling this function
+static inline void __led_strip_spi_bit(uint8_t data, uint8_t *buf)
+{
+    uint32_t bits = s_led_strip_spi_bit_lut[data];
+    buf[0] = bits;
+    buf[1] = bits >> 8;
+    buf[2] = bits >> 16;
+}
+
+// Encode `len` consecutive color bytes into `dst`. Once the destination is word aligned, every 4 color bytes
+// (12 SPI bytes) are written as 3 words.
+static void led_strip_spi_encode(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    // 3 bytes per color byte, so at most 3 color bytes are needed to reach the alignment
+    while (len && ((uintptr_t)dst & 0x03)) {
+        __led_strip_spi_bit(*src++, dst);
+        dst += SPI_BYTES_PER_COLOR_BYTE;
+        len--;
+    }
+    uint32_t *word_dst = (uint32_t *)dst;
+    while (len >= 4) {
+        uint32_t b0 = s_led_strip_spi_bit_lut[src[0]];
+        uint32_t b1 = s_led_strip_spi_bit_lut[src[1]];
+        uint32_t b2 = s_led_strip_spi_bit_lut[src[2]];
+        uint32_t b3 = s_led_strip_spi_bit_lut[src[3]];
+        word_dst[0] = b0 | (b1 << 24);
+        word_dst[1] = (b1 >> 8) | (b2 << 16);
+        word_dst[2] = (b2 >> 16) | (b3 << 8);
+        word_dst += 3;
+        src += 4;
+        len -= 4;
+    }
+    dst = (uint8_t *)word_dst;
+    while (len--) {
+        __led_strip_spi_bit(*src++, dst);
+        dst += SPI_BYTES_PER_COLOR_BYTE;
+    }
+}
+
+// Encode `len` bytes of the raw pixel buffer starting at byte `offset`, through the output transform if it's enabled
+static void led_strip_spi_encode_raw(led_strip_spi_obj *spi_strip, uint8_t *dst, size_t offset, size_t len)
 {
-    // Each color of 1 bit is represented by 3 bits of SPI, low_level:100 ,high_level:110
-    // So a color byte occupies 3 bytes of SPI.
-    *(buf + 2) |= data & BIT(0) ? BIT(2) | BIT(1) : BIT(2);
-    *(buf + 2) |= data & BIT(1) ? BIT(5) | BIT(4) : BIT(5);
-    *(buf + 2) |= data & BIT(2) ? BIT(7) : 0x00;
-    *(buf + 1) |= BIT(0);
-    *(buf + 1) |= data & BIT(3) ? BIT(3) | BIT(2) : BIT(3);
-    *(buf + 1) |= data & BIT(4) ? BIT(6) | BIT(5) : BIT(6);
-    *(buf + 0) |= data & BIT(5) ? BIT(1) | BIT(0) : BIT(1);
-    *(buf + 0) |= data & BIT(6) ? BIT(4) | BIT(3) : BIT(4);
-    *(buf + 0) |= data & BIT(7) ? BIT(7) | BIT(6) : BIT(7);
+    if (!spi_strip->transform.enabled) {
+        led_strip_spi_encode(dst, spi_strip->raw_buf + offset, len);
+        return;
+    }
+    // a multiple of the 4 byte step of the word stores and of the bytes per color
+    uint8_t levels[64];
+    while (len) {
+        size_t block_len = len < sizeof(levels) ? len : sizeof(levels);
+        led_strip_transform_apply(&spi_strip->transform, spi_strip->component_fmt, spi_strip->raw_buf, offset, block_len, levels);
+        led_strip_spi_encode(dst, levels, block_len);
+        dst += block_len * SPI_BYTES_PER_COLOR_BYTE;
+        offset += block_len;
+        len -= block_len;
+    }
+}
+
+// Recover a color byte from its 3 SPI bytes: bit k of the color byte is bit (3 * k + 1) of the 24-bit word
+static uint8_t led_strip_spi_decode(const uint8_t *buf)
+{
+    uint32_t bits = (buf[0] << 16) | (buf[1] << 8) | buf[2];
+    uint8_t value = 0;
+    for (int k = 0; k < 8; k++) {
+        value |= ((bits >> (3 * k + 1)) & 0x01) << k;
+    }
+    return value;
+}
+
+static esp_err_t led_strip_spi_wait_refresh_done(led_strip_t *strip, int32_t timeout_ms)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    if (!spi_strip->trans_pending) {
+        return ESP_OK;
+    }
+    spi_transaction_t *ret_trans = NULL;
+    TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    esp_err_t ret = spi_device_get_trans_result(spi_strip->spi_device, &ret_trans, ticks);
+    if (ret == ESP_ERR_TIMEOUT) {
+        return ret;
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "get SPI transaction result failed");
+    spi_strip->trans_pending = false;
+    return ESP_OK;
 }
 
 static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
 {
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
     ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    // the pixel buffer is read by the DMA until the pending refresh is done
+    ESP_RETURN_ON_ERROR(led_strip_spi_wait_refresh_done(strip, -1), TAG, "wait previous refresh failed");
     // 3 pixels take 72bits(9bytes)
     uint32_t start = index * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
     uint8_t *pixel_buf = spi_strip->pixel_buf;
     struct format_layout format = spi_strip->component_fmt.format;
-    memset(pixel_buf + start, 0, spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
 
     uint8_t pos_bytes = format.bytes_per_color;
     for (uint8_t i = 0; i < format.bytes_per_color; i++) {
@@ -68,6 +171,7 @@ static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uin
             __led_strip_spi_bit(0, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * (format.w_pos * pos_bytes + i)]);
         }
     }
+    led_strip_mark_dirty(&spi_strip->dirty_len, index + 1);
     return ESP_OK;
 }
 
@@ -77,11 +181,11 @@ static esp_err_t led_strip_spi_set_pixel_rgbw(led_strip_t *strip, uint32_t index
     struct format_layout format = spi_strip->component_fmt.format;
     ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
     ESP_RETURN_ON_FALSE(format.num_components == 4, ESP_ERR_INVALID_ARG, TAG, "led doesn't have 4 components");
+    ESP_RETURN_ON_ERROR(led_strip_spi_wait_refresh_done(strip, -1), TAG, "wait previous refresh failed");
 
     // LED_PIXEL_FORMAT_GRBW takes 96bits(12bytes)
     uint32_t start = index * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
     uint8_t *pixel_buf = spi_strip->pixel_buf;
-    memset(pixel_buf + start, 0, spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
 
     uint8_t pos_bytes = format.bytes_per_color;
     for (uint8_t i = 0; i < format.bytes_per_color; i++) {
@@ -91,44 +195,235 @@ static esp_err_t led_strip_spi_set_pixel_rgbw(led_strip_t *strip, uint32_t index
         __led_strip_spi_bit((blue >> color_shift) & 0xFF, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * (format.b_pos * pos_bytes + i)]);
         __led_strip_spi_bit((white >> color_shift) & 0xFF, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * (format.w_pos * pos_bytes + i)]);
     }
+    led_strip_mark_dirty(&spi_strip->dirty_len, index + 1);
     return ESP_OK;
 }
 
-static esp_err_t led_strip_spi_refresh(led_strip_t *strip)
+static esp_err_t led_strip_spi_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *pixels, led_color_component_format_t src_format)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(start < spi_strip->strip_len && count <= spi_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "pixel range out of maximum number of LEDs");
+    ESP_RETURN_ON_ERROR(led_strip_spi_wait_refresh_done(strip, -1), TAG, "wait previous refresh failed");
+
+    led_strip_swizzle_t swizzle;
+    led_strip_build_swizzle(src_format, spi_strip->component_fmt, &swizzle);
+    uint8_t *dst = spi_strip->pixel_buf + start * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    const uint8_t *src = pixels;
+    const int8_t *map = swizzle.src_byte;
+
+    if (swizzle.identity) {
+        // same layout: every source byte expands to the next 3 SPI bytes
+        led_strip_spi_encode(dst, src, count * swizzle.dst_bytes_per_pixel);
+    } else if (swizzle.complete && swizzle.dst_bytes_per_pixel == 3) {
+        // e.g. RGB888 framebuffer to a GRB strip
+        for (uint32_t n = 0; n < count; n++) {
+            __led_strip_spi_bit(src[map[0]], dst);
+            __led_strip_spi_bit(src[map[1]], dst + SPI_BYTES_PER_COLOR_BYTE);
+            __led_strip_spi_bit(src[map[2]], dst + 2 * SPI_BYTES_PER_COLOR_BYTE);
+            dst += 3 * SPI_BYTES_PER_COLOR_BYTE;
+            src += swizzle.src_bytes_per_pixel;
+        }
+    } else {
+        for (uint32_t n = 0; n < count; n++) {
+            for (uint8_t i = 0; i < swizzle.dst_bytes_per_pixel; i++) {
+                __led_strip_spi_bit(map[i] < 0 ? 0 : src[map[i]], dst);
+                dst += SPI_BYTES_PER_COLOR_BYTE;
+            }
+            src += swizzle.src_bytes_per_pixel;
+        }
+    }
+    led_strip_mark_dirty(&spi_strip->dirty_len, start + count);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixel_raw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+
+    led_strip_pack_pixel(spi_strip->raw_buf + index * spi_strip->bytes_per_pixel, spi_strip->component_fmt, red, green, blue, 0);
+    led_strip_mark_dirty(&spi_strip->dirty_len, index + 1);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixel_rgbw_raw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    struct format_layout format = spi_strip->component_fmt.format;
+    ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(format.num_components == 4, ESP_ERR_INVALID_ARG, TAG, "led doesn't have 4 components");
+
+    led_strip_pack_pixel(spi_strip->raw_buf + index * spi_strip->bytes_per_pixel, spi_strip->component_fmt, red, green, blue, white);
+    led_strip_mark_dirty(&spi_strip->dirty_len, index + 1);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixels_raw(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *pixels, led_color_component_format_t src_format)
 {
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
-    spi_transaction_t tx_conf;
-    memset(&tx_conf, 0, sizeof(tx_conf));
+    ESP_RETURN_ON_FALSE(start < spi_strip->strip_len && count <= spi_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "pixel range out of maximum number of LEDs");
 
-    tx_conf.length = spi_strip->strip_len * spi_strip->bytes_per_pixel * SPI_BITS_PER_COLOR_BYTE;
-    tx_conf.tx_buffer = spi_strip->pixel_buf;
-    tx_conf.rx_buffer = NULL;
-    ESP_RETURN_ON_ERROR(spi_device_transmit(spi_strip->spi_device, &tx_conf), TAG, "transmit pixels by SPI failed");
+    led_strip_swizzle_t swizzle;
+    led_strip_build_swizzle(src_format, spi_strip->component_fmt, &swizzle);
+    led_strip_pack_pixels(spi_strip->raw_buf + start * spi_strip->bytes_per_pixel, pixels, count, &swizzle);
+    led_strip_mark_dirty(&spi_strip->dirty_len, start + count);
+    return ESP_OK;
+}
+
+// Refresh from the PSRAM pixel buffer. Two bounce buffers are kept queued, the next chunk is encoded while the previous
+// one is transmitted, so the SPI driver starts it right after the current one. The line idles low between the transactions,
+// the short gap only stretches the low time of the last bit of the chunk and doesn't reach the reset (latch) time.
+static esp_err_t led_strip_spi_refresh_chunked(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    uint32_t tx_len = spi_strip->partial_refresh ? spi_strip->dirty_len : spi_strip->strip_len;
+    size_t raw_len = tx_len * spi_strip->bytes_per_pixel;
+    size_t offset = 0;
+    uint32_t queued = 0;
+    uint32_t slot = 0;
+    esp_err_t ret = ESP_OK;
 
+    while (offset < raw_len) {
+        if (queued == LED_STRIP_SPI_PSRAM_BOUNCE_NUM) {
+            // the oldest transaction is done first, its bounce buffer is the one in `slot`
+            spi_transaction_t *ret_trans = NULL;
+            ret = spi_device_get_trans_result(spi_strip->spi_device, &ret_trans, portMAX_DELAY);
+            if (ret != ESP_OK) {
+                break;
+            }
+            queued--;
+        }
+        size_t chunk_len = raw_len - offset;
+        if (chunk_len > LED_STRIP_SPI_PSRAM_CHUNK_BYTES) {
+            chunk_len = LED_STRIP_SPI_PSRAM_CHUNK_BYTES;
+        }
+        uint8_t *bounce = spi_strip->pixel_buf + slot * LED_STRIP_SPI_PSRAM_CHUNK_BYTES * SPI_BYTES_PER_COLOR_BYTE;
+        led_strip_spi_encode_raw(spi_strip, bounce, offset, chunk_len);
+        spi_transaction_t *tx_conf = &spi_strip->chunk_trans[slot];
+        memset(tx_conf, 0, sizeof(spi_transaction_t));
+        tx_conf->length = chunk_len * SPI_BITS_PER_COLOR_BYTE;
+        tx_conf->tx_buffer = bounce;
+        ret = spi_device_queue_trans(spi_strip->spi_device, tx_conf, portMAX_DELAY);
+        if (ret != ESP_OK) {
+            break;
+        }
+        queued++;
+        offset += chunk_len;
+        slot = (slot + 1) % LED_STRIP_SPI_PSRAM_BOUNCE_NUM;
+    }
+    // the bounce buffers must not be touched until all the queued chunks are out, also on error
+    while (queued) {
+        spi_transaction_t *ret_trans = NULL;
+        esp_err_t wait_ret = spi_device_get_trans_result(spi_strip->spi_device, &ret_trans, portMAX_DELAY);
+        if (ret == ESP_OK) {
+            ret = wait_ret;
+        }
+        queued--;
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "transmit pixels by SPI failed");
+    spi_strip->dirty_len = 0;
+    spi_strip->transform.frame++;
     return ESP_OK;
 }
 
+static esp_err_t led_strip_spi_clear_raw(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    memset(spi_strip->raw_buf, 0, spi_strip->strip_len * spi_strip->bytes_per_pixel);
+    spi_strip->dirty_len = spi_strip->strip_len;
+
+    return led_strip_spi_refresh_chunked(strip);
+}
+
+static esp_err_t led_strip_spi_refresh_async(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_ERROR(led_strip_spi_wait_refresh_done(strip, -1), TAG, "wait previous refresh failed");
+
+    uint32_t tx_len = spi_strip->partial_refresh ? spi_strip->dirty_len : spi_strip->strip_len;
+    if (tx_len == 0) {
+        // nothing changed since the last refresh
+        return ESP_OK;
+    }
+    if (spi_strip->raw_buf) {
+        // the DMA is done with the pixel buffer, the raw one can be set meanwhile
+        led_strip_spi_encode_raw(spi_strip, spi_strip->pixel_buf, 0, tx_len * spi_strip->bytes_per_pixel);
+        spi_strip->transform.frame++;
+    }
+    spi_transaction_t *tx_conf = &spi_strip->trans;
+    memset(tx_conf, 0, sizeof(spi_transaction_t));
+    tx_conf->length = tx_len * spi_strip->bytes_per_pixel * SPI_BITS_PER_COLOR_BYTE;
+    tx_conf->tx_buffer = spi_strip->pixel_buf;
+    tx_conf->rx_buffer = NULL;
+    ESP_RETURN_ON_ERROR(spi_device_queue_trans(spi_strip->spi_device, tx_conf, portMAX_DELAY), TAG, "transmit pixels by SPI failed");
+    spi_strip->trans_pending = true;
+    spi_strip->dirty_len = 0;
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_refresh(led_strip_t *strip)
+{
+    ESP_RETURN_ON_ERROR(led_strip_spi_refresh_async(strip), TAG, "refresh failed");
+    return led_strip_spi_wait_refresh_done(strip, -1);
+}
+
 static esp_err_t led_strip_spi_clear(led_strip_t *strip)
 {
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    // the pixel buffer is read by the DMA until the pending refresh is done
+    ESP_RETURN_ON_ERROR(led_strip_spi_wait_refresh_done(strip, -1), TAG, "wait previous refresh failed");
     //Write zero to turn off all leds
-    memset(spi_strip->pixel_buf, 0, spi_strip->strip_len * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
-    uint8_t *buf = spi_strip->pixel_buf;
-    for (int index = 0; index < spi_strip->strip_len * spi_strip->bytes_per_pixel; index++) {
-        __led_strip_spi_bit(0, buf);
-        buf += SPI_BYTES_PER_COLOR_BYTE;
+    static const uint8_t zeros[64] = {0};
+    size_t len = spi_strip->strip_len * spi_strip->bytes_per_pixel;
+    if (spi_strip->raw_buf) {
+        // encoded by the refresh
+        memset(spi_strip->raw_buf, 0, len);
+        len = 0;
     }
+    for (size_t offset = 0; offset < len; offset += sizeof(zeros)) {
+        size_t block_len = len - offset < sizeof(zeros) ? len - offset : sizeof(zeros);
+        led_strip_spi_encode(spi_strip->pixel_buf + offset * SPI_BYTES_PER_COLOR_BYTE, zeros, block_len);
+    }
+    spi_strip->dirty_len = spi_strip->strip_len;
 
     return led_strip_spi_refresh(strip);
 }
 
+static esp_err_t led_strip_spi_set_transform(led_strip_t *strip, const led_strip_transform_config_t *config)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    if (config && !spi_strip->raw_buf) {
+        // the transform is applied while encoding, so from now on the pixels are kept unencoded and encoded at refresh,
+        // a brightness change then only needs a refresh, like on the RMT backend
+        size_t raw_len = spi_strip->strip_len * spi_strip->bytes_per_pixel;
+        uint8_t *raw_buf = heap_caps_malloc(raw_len, MALLOC_CAP_DEFAULT);
+        ESP_RETURN_ON_FALSE(raw_buf, ESP_ERR_NO_MEM, TAG, "no mem for pixel buffer");
+        // the pending refresh only reads the encoded buffer
+        for (size_t i = 0; i < raw_len; i++) {
+            raw_buf[i] = led_strip_spi_decode(spi_strip->pixel_buf + i * SPI_BYTES_PER_COLOR_BYTE);
+        }
+        spi_strip->raw_buf = raw_buf;
+        spi_strip->base.set_pixel = led_strip_spi_set_pixel_raw;
+        spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw_raw;
+        spi_strip->base.set_pixels = led_strip_spi_set_pixels_raw;
+    }
+    ESP_RETURN_ON_ERROR(led_strip_transform_set(&spi_strip->transform, spi_strip->component_fmt, config), TAG, "no mem for transform LUTs");
+    // every LED shows a different color now, even if no pixel was set
+    spi_strip->dirty_len = spi_strip->strip_len;
+    return ESP_OK;
+}
+
 static esp_err_t led_strip_spi_del(led_strip_t *strip)
 {
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
 
+    ESP_RETURN_ON_ERROR(led_strip_spi_wait_refresh_done(strip, -1), TAG, "wait previous refresh failed");
     ESP_RETURN_ON_ERROR(spi_bus_remove_device(spi_strip->spi_device), TAG, "delete spi device failed");
     ESP_RETURN_ON_ERROR(spi_bus_free(spi_strip->spi_host), TAG, "free spi bus failed");
 
+    free(spi_strip->raw_buf);
+    led_strip_transform_free(&spi_strip->transform);
     free(spi_strip);
     return ESP_OK;
 }
@@ -165,14 +460,23 @@ esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const l
     if (component_fmt.format.bytes_per_color > 1) {
         bytes_per_pixel *= component_fmt.format.bytes_per_color;
     }
+    bool in_psram = led_config->flags.pixel_buf_in_psram;
+    // the GDMA can't take the encoded data straight from PSRAM on every target, so it always reads the internal bounce buffers
+    ESP_GOTO_ON_FALSE(!in_psram || spi_config->flags.with_dma, ESP_ERR_INVALID_ARG, err, TAG, "PSRAM pixel buffer requires DMA");
     uint32_t mem_caps = MALLOC_CAP_DEFAULT;
     if (spi_config->flags.with_dma) {
         // DMA buffer must be placed in internal SRAM
         mem_caps |= MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA;
     }
-    spi_strip = heap_caps_calloc(1, sizeof(led_strip_spi_obj) + led_config->max_leds * bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE, mem_caps);
+    size_t spi_buf_size = in_psram ? LED_STRIP_SPI_PSRAM_BOUNCE_NUM * LED_STRIP_SPI_PSRAM_CHUNK_BYTES * SPI_BYTES_PER_COLOR_BYTE
+                          : led_config->max_leds * bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    spi_strip = heap_caps_calloc(1, sizeof(led_strip_spi_obj) + spi_buf_size, mem_caps);
 
     ESP_GOTO_ON_FALSE(spi_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for spi strip");
+    if (in_psram) {
+        spi_strip->raw_buf = heap_caps_calloc(1, led_config->max_leds * bytes_per_pixel, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        ESP_GOTO_ON_FALSE(spi_strip->raw_buf, ESP_ERR_NO_MEM, err, TAG, "no mem for pixel buffer");
+    }
 
     spi_strip->spi_host = spi_config->spi_bus;
     // for backward compatibility, if the user does not set the clk_src, use the default value
@@ -188,7 +492,7 @@ esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const l
         .sclk_io_num = -1,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = led_config->max_leds * bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE,
+        .max_transfer_sz = in_psram ? LED_STRIP_SPI_PSRAM_CHUNK_BYTES * SPI_BYTES_PER_COLOR_BYTE : spi_buf_size,
     };
     ESP_GOTO_ON_ERROR(spi_bus_initialize(spi_strip->spi_host, &spi_bus_cfg, spi_config->flags.with_dma ? SPI_DMA_CH_AUTO : SPI_DMA_DISABLED), err, TAG, "create SPI bus failed");
 
@@ -226,10 +530,26 @@ esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const l
     spi_strip->component_fmt = component_fmt;
     spi_strip->bytes_per_pixel = bytes_per_pixel;
     spi_strip->strip_len = led_config->max_leds;
-    spi_strip->base.set_pixel = led_strip_spi_set_pixel;
-    spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw;
-    spi_strip->base.refresh = led_strip_spi_refresh;
-    spi_strip->base.clear = led_strip_spi_clear;
+    spi_strip->partial_refresh = led_config->flags.partial_refresh;
+    // the LEDs state is unknown until the first full frame
+    spi_strip->dirty_len = led_config->max_leds;
+    if (in_psram) {
+        // the bounce buffers are refilled during the transmission, so the refresh is always blocking
+        spi_strip->base.set_pixel = led_strip_spi_set_pixel_raw;
+        spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw_raw;
+        spi_strip->base.set_pixels = led_strip_spi_set_pixels_raw;
+        spi_strip->base.refresh = led_strip_spi_refresh_chunked;
+        spi_strip->base.clear = led_strip_spi_clear_raw;
+    } else {
+        spi_strip->base.set_pixel = led_strip_spi_set_pixel;
+        spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw;
+        spi_strip->base.set_pixels = led_strip_spi_set_pixels;
+        spi_strip->base.refresh = led_strip_spi_refresh;
+        spi_strip->base.refresh_async = led_strip_spi_refresh_async;
+        spi_strip->base.wait_refresh_done = led_strip_spi_wait_refresh_done;
+        spi_strip->base.clear = led_strip_spi_clear;
+    }
+    spi_strip->base.set_transform = led_strip_spi_set_transform;
     spi_strip->base.del = led_strip_spi_del;
 
     *ret_strip = &spi_strip->base;
@@ -242,6 +562,7 @@ err:
         if (spi_strip->spi_host) {
             spi_bus_free(spi_strip->spi_host);
         }
+        free(spi_strip->raw_buf);
         free(spi_strip);
     }
     return ret;
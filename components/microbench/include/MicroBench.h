@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#else
+#include <chrono>
+#endif
+
+// Микробенчмарки коротких операций.
+// Каждый замер - один или несколько (batch) вызовов операции между двумя чтениями счетчика тактов процессора
+// (на ПК - монотонных часов в нс). Первые warmup замеров отбрасываются (прогрев кэшей и ленивой инициализации),
+// из остальных за вычетом накладных расходов самого замера считаются минимум, перцентили, максимум и среднее
+// на один вызов. Результат печатается одной строкой "MICROBENCH {json}", чтобы его можно было выбрать
+// из лога порта и сравнить с предыдущим запуском (tools/bench_compare.py).
+//
+// Замеры должны выполняться в задаче, закрепленной за ядром: счетчики тактов ядер независимы.
+class MicroBench
+{
+public:
+    struct Config
+    {
+        uint32_t warmup = 32;           // Прогревочных замеров (не учитываются)
+        uint32_t samples = 1000;        // Учитываемых замеров
+        uint32_t batch = 1;             // Вызовов операции в одном замере (для операций короче самого замера)
+    };
+
+    // Статистика на один вызов операции, в единицах getUnit()
+    struct Result
+    {
+        uint32_t samples = 0;
+        uint32_t batch = 1;
+        float min = 0.f;
+        float p50 = 0.f;
+        float p90 = 0.f;
+        float p99 = 0.f;
+        float max = 0.f;
+        float mean = 0.f;
+    };
+
+    /**
+     * @brief Конструктор (измеряет накладные расходы пустого замера)
+     * @param suite: Имя набора в выводе
+     */
+    explicit MicroBench(const char* suite);
+    MicroBench(const char* suite, const Config& config);
+
+    /**
+     * @brief Метод для замера операции с параметрами по умолчанию
+     * @param name: Имя замера в выводе
+     * @param fn: Операция
+     * @return Статистика
+     */
+    template<typename Fn>
+    Result run(const char* name, Fn&& fn)
+    {
+        return run(name, m_config, fn);
+    }
+
+    /**
+     * @brief Метод для замера операции
+     * @param name: Имя замера в выводе
+     * @param config: Параметры замера
+     * @param fn: Операция
+     * @return Статистика
+     */
+    template<typename Fn>
+    Result run(const char* name, const Config& config, Fn&& fn)
+    {
+        m_ticks.clear();
+        m_ticks.reserve(config.samples);
+        for (uint32_t i = 0; i < config.warmup + config.samples; ++i)
+        {
+            const uint32_t start = now();
+            for (uint32_t j = 0; j < config.batch; ++j)
+                fn();
+            const uint32_t ticks = now() - start;
+            if (i >= config.warmup)
+                m_ticks.push_back(ticks);
+        }
+        return finish(name, config);
+    }
+
+    /**
+     * @brief Метод для вывода строки без замера (пропущенный замер, параметры окружения)
+     * @param name: Имя замера
+     * @param note: Пояснение
+     */
+    void skip(const char* name, const char* note) const;
+
+    /**
+     * @brief Метод для чтения счетчика
+     * @return Такты процессора (на ПК - нс), по модулю 2^32
+     */
+    static inline uint32_t now()
+    {
+#ifdef ESP_PLATFORM
+        return esp_cpu_get_cycle_count();
+#else
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    /**
+     * @brief Метод для получения единиц измерения
+     * @return "cycles" или "ns"
+     */
+    static const char* getUnit();
+
+    /**
+     * @brief Метод, не дающий компилятору выбросить вычисление результата
+     * @param value: Результат операции
+     */
+    template<typename T>
+    static inline void keep(const T& value)
+    {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+private:
+    /* Расчет статистики по m_ticks и вывод */
+    Result finish(const char* name, const Config& config);
+
+private:
+    const char* const m_suite;
+    const Config m_config;
+    uint32_t m_overhead = 0;            // Медиана пустого замера
+    std::vector<uint32_t> m_ticks;      // Замеры текущей операции
+};
@@ -0,0 +1,91 @@
+#include "MicroBench.h"
+#include <algorithm>
+#include <cstdio>
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+namespace
+{
+    // Перцентиль по ближайшему рангу из отсортированных замеров
+    uint32_t percentile(const std::vector<uint32_t>& sorted, uint32_t percent)
+    {
+        const size_t rank = (sorted.size() * percent + 99) / 100;
+        return sorted[rank ? rank - 1 : 0];
+    }
+}
+
+MicroBench::MicroBench(const char* suite):
+    MicroBench(suite, Config{})
+{}
+
+MicroBench::MicroBench(const char* suite, const Config& config):
+    m_suite(suite),
+    m_config(config)
+{
+    // Накладные расходы: пара чтений счетчика и пустой цикл
+    m_ticks.reserve(m_config.samples);
+    for (uint32_t i = 0; i < m_config.warmup + m_config.samples; ++i)
+    {
+        const uint32_t start = now();
+        const uint32_t ticks = now() - start;
+        if (i >= m_config.warmup)
+            m_ticks.push_back(ticks);
+    }
+    std::sort(m_ticks.begin(), m_ticks.end());
+    m_overhead = m_ticks.empty() ? 0 : percentile(m_ticks, 50);
+
+#ifdef ESP_PLATFORM
+    printf("MICROBENCH {\"suite\":\"%s\",\"env\":\"" CONFIG_IDF_TARGET "\",\"cpuMHz\":%d,\"unit\":\"%s\",\"overhead\":%lu}\n",
+           m_suite, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, getUnit(), static_cast<unsigned long>(m_overhead));
+#else
+    printf("MICROBENCH {\"suite\":\"%s\",\"env\":\"host\",\"unit\":\"%s\",\"overhead\":%lu}\n",
+           m_suite, getUnit(), static_cast<unsigned long>(m_overhead));
+#endif
+}
+
+void MicroBench::skip(const char* name, const char* note) const
+{
+    printf("MICROBENCH {\"suite\":\"%s\",\"name\":\"%s\",\"skipped\":\"%s\"}\n", m_suite, name, note);
+}
+
+const char* MicroBench::getUnit()
+{
+#ifdef ESP_PLATFORM
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+MicroBench::Result MicroBench::finish(const char* name, const Config& config)
+{
+    Result result;
+    result.samples = m_ticks.size();
+    result.batch = config.batch ? config.batch : 1;
+    if (m_ticks.empty())
+        return result;
+
+    // Вычитание накладных расходов замера (не ниже нуля) и пересчет на один вызов
+    uint64_t sum = 0;
+    for (uint32_t& ticks : m_ticks)
+    {
+        ticks = ticks > m_overhead ? ticks - m_overhead : 0;
+        sum += ticks;
+    }
+    std::sort(m_ticks.begin(), m_ticks.end());
+
+    const float scale = 1.f / result.batch;
+    result.min = m_ticks.front() * scale;
+    result.p50 = percentile(m_ticks, 50) * scale;
+    result.p90 = percentile(m_ticks, 90) * scale;
+    result.p99 = percentile(m_ticks, 99) * scale;
+    result.max = m_ticks.back() * scale;
+    result.mean = static_cast<float>(sum) / m_ticks.size() * scale;
+
+    printf("MICROBENCH {\"suite\":\"%s\",\"name\":\"%s\",\"unit\":\"%s\",\"batch\":%lu,\"samples\":%lu,"
+           "\"min\":%.1f,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"max\":%.1f,\"mean\":%.1f}\n",
+           m_suite, name, getUnit(), static_cast<unsigned long>(result.batch), static_cast<unsigned long>(result.samples),
+           result.min, result.p50, result.p90, result.p99, result.max, result.mean);
+    return result;
+}
@@ -0,0 +1,84 @@
+#include "Benchmarks.h"
+#include "Trajectory/TrajectoryFormat.h"
+// Внутренний заголовок компонента: ядра HSV без обращения к периферии
+#include "../../components/led_strip/src/led_strip_common.h"
+#include <vector>
+
+namespace
+{
+    const uint32_t PIXELS_COUNT = 256;      // Пикселей в одном замере HSV
+    const uint32_t SEGMENTS_COUNT = 256;    // Отрезков в одном замере кодека
+
+    // Отрезки, похожие на реальную траекторию: короткие шаги по положению, редкие смены скорости
+    std::vector<TrajectoryFormat::Segment> makeSegments()
+    {
+        std::vector<TrajectoryFormat::Segment> segments(SEGMENTS_COUNT);
+        double pos = 0.;
+        for (uint32_t i = 0; i < SEGMENTS_COUNT; ++i)
+        {
+            TrajectoryFormat::Segment& segment = segments[i];
+            pos += (i % 7) * 0.125 - 0.25;
+            segment.command = (i % 16) ? TrajectoryFormat::EnCommand::enPosition : TrajectoryFormat::EnCommand::enSpeed;
+            segment.dtMs = 20;
+            segment.targetPos = pos;
+            segment.targetSpeed = (i % 32 < 16) ? 90.f : 45.5f;
+            segment.acceleration = 500.f;
+            segment.deceleration = 500.f;
+        }
+        return segments;
+    }
+}
+
+namespace Benchmarks
+{
+    void runAlgorithms(MicroBench& bench)
+    {
+        MicroBench::Config pixels;
+        pixels.batch = PIXELS_COUNT;
+
+        uint32_t i = 0;
+        uint32_t rgb[3];
+        bench.run("hsv_to_rgb", pixels, [&]()
+        {
+            led_strip_hsv_to_rgb(i % 360, 255 - (i & 0x3F), 200, rgb);
+            MicroBench::keep(rgb);
+            ++i;
+        });
+        bench.run("hsv_to_rgb_16", pixels, [&]()
+        {
+            led_strip_hsv_to_rgb_16(i % 360, 65535 - (i & 0x3FFF), 50000, rgb);
+            MicroBench::keep(rgb);
+            ++i;
+        });
+        bench.run("hsv1536_to_rgb", pixels, [&]()
+        {
+            led_strip_hsv1536_to_rgb(i % LED_STRIP_HUE_WHEEL_STEPS, 255 - (i & 0x3F), 200, rgb);
+            MicroBench::keep(rgb);
+            ++i;
+        });
+
+        // Кодек траекторий: на отрезок
+        const std::vector<TrajectoryFormat::Segment> segments = makeSegments();
+        std::vector<uint8_t> encoded(SEGMENTS_COUNT * TrajectoryFormat::SEGMENT_MAX_SIZE);
+        size_t encodedSize = 0;
+
+        MicroBench::Config codec;
+        codec.samples = 200;
+        codec.batch = 1;
+        bench.run("trajectory_encode_256", codec, [&]()
+        {
+            TrajectoryFormat::Encoder encoder;
+            encodedSize = 0;
+            for (const TrajectoryFormat::Segment& segment : segments)
+                encodedSize += encoder.encode(segment, encoded.data() + encodedSize);
+            MicroBench::keep(encodedSize);
+        });
+        bench.run("trajectory_decode_256", codec, [&]()
+        {
+            TrajectoryFormat::Decoder decoder(encoded.data(), encodedSize);
+            TrajectoryFormat::Segment segment;
+            while (decoder.next(segment))
+                MicroBench::keep(segment);
+        });
+    }
+}
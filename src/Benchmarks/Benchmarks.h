@@ -0,0 +1,32 @@
+#pragma once
+
+#include "MicroBench.h"
+
+// Наборы микробенчмарков горячих путей.
+// runAlgorithms() не обращается к периферии. runHardware() работает с периферией: на плате - в сборке
+// env:benchmark, на ПК (tools/bench_host.cpp) - с заменителями драйверов из tools/host.
+namespace Benchmarks
+{
+    struct HardwareConfig
+    {
+        int stepPin = -1;               // Пин STEP для StepGenerator (-1 - пропустить)
+        int servoPin = -1;              // Пин импульсов для ServoControl и ServoBank (-1 - пропустить)
+        int rmtLedPin = -1;             // Пин ленты для RMT (-1 - пропустить)
+        int spiLedPin = -1;             // Пин ленты для SPI (-1 - пропустить)
+        uint32_t ledsCount = 60;        // Количество светодиодов лент
+    };
+
+    /**
+     * @brief Функция для замера алгоритмических путей (HSV, кодек траекторий)
+     * @param bench: Набор замеров
+     */
+    void runAlgorithms(MicroBench& bench);
+
+    /**
+     * @brief Функция для замера путей с периферией (StepGenerator, сервоприводы, ленты RMT/SPI) и дрожания
+     *        периода контура движения при нагрузке на ядре сети (до и после распределения по ядрам)
+     * @param bench: Набор замеров
+     * @param config: Пины и параметры
+     */
+    void runHardware(MicroBench& bench, const HardwareConfig& config);
+}
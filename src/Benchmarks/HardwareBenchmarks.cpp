@@ -0,0 +1,290 @@
+#include "Benchmarks.h"
+#include "StepMotor/StepGenerator.h"
+#include "Servo_pwm/ServoControl.h"
+#include "Servo_pwm/ServoBank.h"
+#include "Helpers/CorePlacement.h"
+#include "led_strip.h"
+#include <driver/gptimer.h>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_rom_sys.h>
+#include <atomic>
+#include <vector>
+
+namespace
+{
+    const char* LOG = "Benchmarks";     // Канал лога
+
+    // Замеры одной ленты: запись пикселей и передача (блокирующая - включает время на линии)
+    void runStrip(MicroBench& bench, led_strip_handle_t strip, uint32_t ledsCount, const char* setPixel,
+                  const char* setPixels, const char* setPixelsHsv, const char* refresh)
+    {
+        MicroBench::Config perPixel;
+        perPixel.samples = 200;
+        perPixel.batch = ledsCount;
+
+        uint32_t i = 0;
+        bench.run(setPixel, perPixel, [&]()
+        {
+            led_strip_set_pixel(strip, i % ledsCount, i & 0xFF, 0x40, 0x10);
+            ++i;
+        });
+
+        std::vector<uint8_t> rgb(ledsCount * 3);
+        for (size_t j = 0; j < rgb.size(); ++j)
+            rgb[j] = j * 7;
+        std::vector<led_color_hsv_t> hsv(ledsCount);
+        for (uint32_t j = 0; j < ledsCount; ++j)
+            hsv[j] = {static_cast<uint16_t>(j * 360 / ledsCount), 255, 64};
+
+        MicroBench::Config perStrip;
+        perStrip.samples = 200;
+        bench.run(setPixels, perStrip, [&]()
+        {
+            led_strip_set_pixels(strip, 0, ledsCount, rgb.data(), LED_STRIP_COLOR_COMPONENT_FMT_RGB);
+        });
+        bench.run(setPixelsHsv, perStrip, [&]()
+        {
+            led_strip_set_pixels_hsv(strip, 0, ledsCount, hsv.data(), LED_STRIP_HUE_360);
+        });
+
+        MicroBench::Config perRefresh;
+        perRefresh.warmup = 4;
+        perRefresh.samples = 100;
+        bench.run(refresh, perRefresh, [&]()
+        {
+            // Изменение последнего пикселя: и при частичном обновлении передается вся лента
+            led_strip_set_pixel(strip, ledsCount - 1, i++ & 0xFF, 0, 0);
+            led_strip_refresh(strip);
+        });
+    }
+
+    const uint32_t JITTER_PERIOD_US = 1000;                                 // Период контура в замере дрожания, мкс
+    const UBaseType_t JITTER_TASK_PRIORITY = 10;                            // Приоритет задачи контура
+    const UBaseType_t LOAD_TASK_PRIORITY = configMAX_PRIORITIES - 2;        // Приоритет нагрузки (как у задачи Wi-Fi)
+
+    // Нагрузка, похожая на сетевую: короткие участки с запретом прерываний и вытеснение задач ядра
+    struct NetworkLoad
+    {
+        std::atomic<bool> running{false};
+        TaskHandle_t task = nullptr;
+        portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    };
+
+    void networkLoadTask(void* arg)
+    {
+        auto* load = static_cast<NetworkLoad*>(arg);
+        while (load->running)
+        {
+            portENTER_CRITICAL(&load->lock);
+            esp_rom_delay_us(50);
+            portEXIT_CRITICAL(&load->lock);
+            esp_rom_delay_us(500);
+            vTaskDelay(1);
+        }
+        __atomic_store_n(&load->task, nullptr, __ATOMIC_RELEASE);
+        vTaskDelete(nullptr);
+    }
+
+    bool IRAM_ATTR jitterAlarmCallback(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event, void* arg)
+    {
+        BaseType_t taskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(static_cast<TaskHandle_t>(arg), &taskWoken);
+        return taskWoken == pdTRUE;
+    }
+
+    // Замер периода контура: задача ждет уведомления от прерывания таймера; разброс периода - дрожание
+    void runJitter(MicroBench& bench, const char* name, BaseType_t core, int intrPriority)
+    {
+        const esp_err_t ret = CorePlacement::runOnCore(core, [&]()
+        {
+            gptimer_config_t timerConfig = {
+                .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+                .direction = GPTIMER_COUNT_UP,
+                .resolution_hz = 1'000'000,
+                .intr_priority = intrPriority,
+                .flags = {},
+            };
+            gptimer_handle_t timer = nullptr;
+            if (gptimer_new_timer(&timerConfig, &timer) != ESP_OK)
+            {
+                bench.skip(name, "no free timer");
+                return;
+            }
+
+            // Прерывание назначается ядру этой задачи
+            gptimer_event_callbacks_t callbacks = {
+                .on_alarm = &jitterAlarmCallback,
+            };
+            gptimer_alarm_config_t alarm = {
+                .alarm_count = JITTER_PERIOD_US,
+                .reload_count = 0,
+                .flags = {
+                    .auto_reload_on_alarm = true,
+                },
+            };
+            if (gptimer_register_event_callbacks(timer, &callbacks, xTaskGetCurrentTaskHandle()) == ESP_OK
+                && gptimer_set_alarm_action(timer, &alarm) == ESP_OK && gptimer_enable(timer) == ESP_OK)
+            {
+                gptimer_start(timer);
+                MicroBench::Config periods;
+                periods.warmup = 16;
+                periods.samples = 2000;
+                bench.run(name, periods, [&]()
+                {
+                    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                });
+                gptimer_stop(timer);
+                gptimer_disable(timer);
+            }
+            else
+            {
+                bench.skip(name, "timer setup failed");
+            }
+            gptimer_del_timer(timer);
+        }, JITTER_TASK_PRIORITY);
+
+        if (ret != ESP_OK)
+            bench.skip(name, "task create failed");
+    }
+
+    led_strip_config_t stripConfig(int pin, uint32_t ledsCount)
+    {
+        led_strip_config_t config = {
+            .strip_gpio_num = pin,
+            .max_leds = ledsCount,
+            .led_model = LED_MODEL_WS2812,
+            .color_component_format = LED_STRIP_COLOR_COMPONENT_FMT_GRB,
+            .flags = {},
+        };
+        return config;
+    }
+}
+
+namespace Benchmarks
+{
+    void runHardware(MicroBench& bench, const HardwareConfig& config)
+    {
+        // Генератор шагов: смена частоты "на лету" (чередование двух частот)
+        if (config.stepPin >= 0)
+        {
+            StepGenerator stepGen(static_cast<gpio_num_t>(config.stepPin));
+            uint32_t i = 0;
+            bench.run("step_gen_set_freq", [&]()
+            {
+                stepGen.setFreq((i++ & 1) ? 1000 : 2000);
+            });
+            stepGen.stop();
+        }
+        else
+        {
+            bench.skip("step_gen_set_freq", "no step pin");
+        }
+
+        // Сервоприводы: одиночный канал и группа с синхронным защелкиванием
+        if (config.servoPin >= 0)
+        {
+            ServoControl servo(config.servoPin, LEDC_TIMER_3, LEDC_CHANNEL_7);
+            uint32_t i = 0;
+            bench.run("servo_control_set_speed", [&]()
+            {
+                servo.setSpeed((i++ & 1) ? 50.f : -50.f);
+            });
+            servo.setSpeed(0.f);
+
+            ServoBank::Config bankConfig;
+            bankConfig.timer = LEDC_TIMER_2;
+            bankConfig.firstChannel = LEDC_CHANNEL_6;
+            ServoBank bank(bankConfig);
+            bank.addServo(static_cast<gpio_num_t>(config.servoPin));
+            bench.run("servo_bank_set_speed_apply", [&]()
+            {
+                bank.setSpeed(0, (i++ & 1) ? 500 : -500);
+                bank.apply();
+            });
+            bank.setSpeed(0, 0);
+            bank.apply();
+        }
+        else
+        {
+            bench.skip("servo_control_set_speed", "no servo pin");
+            bench.skip("servo_bank_set_speed_apply", "no servo pin");
+        }
+
+        // Лента на RMT
+        if (config.rmtLedPin >= 0)
+        {
+            const led_strip_config_t strip_config = stripConfig(config.rmtLedPin, config.ledsCount);
+            led_strip_rmt_config_t rmt_config = {
+                .clk_src = RMT_CLK_SRC_DEFAULT,
+                .resolution_hz = 10000000, // 10MHz
+                .mem_block_symbols = 64,
+                .timing = {},
+                .flags = {},
+            };
+            led_strip_handle_t strip = nullptr;
+            if (led_strip_new_rmt_device(&strip_config, &rmt_config, &strip) == ESP_OK)
+            {
+                runStrip(bench, strip, config.ledsCount, "led_rmt_set_pixel", "led_rmt_set_pixels",
+                         "led_rmt_set_pixels_hsv", "led_rmt_refresh");
+                led_strip_clear(strip);
+                led_strip_del(strip);
+            }
+            else
+            {
+                ESP_LOGE(LOG, "RMT strip is not created");
+            }
+        }
+        else
+        {
+            bench.skip("led_rmt", "no RMT LED pin");
+        }
+
+        // Лента на SPI
+        if (config.spiLedPin >= 0)
+        {
+            const led_strip_config_t strip_config = stripConfig(config.spiLedPin, config.ledsCount);
+            led_strip_spi_config_t spi_config = {
+                .clk_src = SPI_CLK_SRC_DEFAULT,
+                .spi_bus = SPI2_HOST,
+                .flags = {
+                    .with_dma = true,
+                },
+            };
+            led_strip_handle_t strip = nullptr;
+            if (led_strip_new_spi_device(&strip_config, &spi_config, &strip) == ESP_OK)
+            {
+                runStrip(bench, strip, config.ledsCount, "led_spi_set_pixel", "led_spi_set_pixels",
+                         "led_spi_set_pixels_hsv", "led_spi_refresh");
+                led_strip_clear(strip);
+                led_strip_del(strip);
+            }
+            else
+            {
+                ESP_LOGE(LOG, "SPI strip is not created");
+            }
+        }
+        else
+        {
+            bench.skip("led_spi", "no SPI LED pin");
+        }
+
+        // Дрожание периода контура 1 кГц при нагрузке на ядре сети: прежнее размещение (таймер и задача на ядре
+        // сети, уровень прерывания 1) и размещение CorePlacement (ядро движения, уровень прерываний движения)
+        NetworkLoad load;
+        load.running = true;
+        if (xTaskCreatePinnedToCore(&networkLoadTask, "bench_load", 2048, &load, LOAD_TASK_PRIORITY, &load.task,
+                                    CorePlacement::NETWORK_CORE) != pdPASS)
+        {
+            load.running = false;
+            load.task = nullptr;
+            ESP_LOGE(LOG, "Load task is not created, jitter is measured without load");
+        }
+        runJitter(bench, "jitter_1khz_network_core", CorePlacement::NETWORK_CORE, 1);
+        runJitter(bench, "jitter_1khz_motion_core", CorePlacement::MOTION_CORE, CorePlacement::MOTION_INTR_PRIORITY);
+
+        load.running = false;
+        while (__atomic_load_n(&load.task, __ATOMIC_ACQUIRE) != nullptr)
+            vTaskDelay(1);
+    }
+}
@@ -0,0 +1,600 @@
+#include "ConfigStore.h"
+#include "Http/HttpServer.h"
+#include <driver/gpio.h>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <nvs_flash.h>
+#include <nvs.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    const char* LOG = "ConfigStore";    // Канал лога
+
+    const char* NVS_KEY_SCHEMA = "_schema";     // Ключ версии схемы
+
+    const uint32_t BOOT_GUARD_MAGIC = 0xC0F1A99D;   // Конфигурация загружена, но еще не применена
+
+    // Переживает программный сброс, паники и сторожевые таймеры, но не включение питания
+    RTC_NOINIT_ATTR uint32_t s_bootGuard;
+
+    const uint32_t ALL_PARAMS_MASK = (1ULL << static_cast<size_t>(ConfigStore::EnParam::enCount)) - 1;
+
+    // Параметры-пины, которые не должны совпадать
+    const ConfigStore::EnParam PIN_PARAMS[] =
+    {
+        ConfigStore::EnParam::enMotorEnPin,
+        ConfigStore::EnParam::enMotorDirPin,
+        ConfigStore::EnParam::enMotorStepPin,
+        ConfigStore::EnParam::enServoPin,
+    };
+
+    inline uint32_t floatToRaw(float value)
+    {
+        uint32_t raw;
+        memcpy(&raw, &value, sizeof(raw));
+        return raw;
+    }
+
+    inline float rawToFloat(uint32_t raw)
+    {
+        float value;
+        memcpy(&value, &raw, sizeof(value));
+        return value;
+    }
+
+    bool isPowerOfTwo(float value)
+    {
+        const uint32_t n = static_cast<uint32_t>(value);
+        return n != 0 && (n & (n - 1)) == 0;
+    }
+
+    bool isOutputPin(float value)
+    {
+        const int pin = static_cast<int>(value);
+        return pin >= 0 && GPIO_IS_VALID_OUTPUT_GPIO(pin);
+    }
+
+    bool isOutputPinOrNone(float value)
+    {
+        return value == GPIO_NUM_NC || isOutputPin(value);
+    }
+
+    // Сброс, после которого нельзя считать, что прошлая загрузка дошла до применения конфигурации
+    bool isCrashReset(esp_reset_reason_t reason)
+    {
+        return reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT;
+    }
+}
+
+// Схема параметров. Ключи NVS не длиннее 15 символов. При изменении смысла или типа существующего
+// ключа увеличивается SCHEMA_VERSION и добавляется миграция, новые ключи получают значение по умолчанию сами
+const ConfigStore::ParamDesc ConfigStore::PARAMS[static_cast<size_t>(EnParam::enCount)] =
+{
+    {"m_en_pin",    EnType::enInt,   15,     -1,     48,     &isOutputPinOrNone},
+    {"m_dir_pin",   EnType::enInt,   2,      0,      48,     &isOutputPin},
+    {"m_step_pin",  EnType::enInt,   4,      0,      48,     &isOutputPin},
+    {"m_step_mode", EnType::enInt,   1,      1,      32,     &isPowerOfTwo},
+    {"m_en_inv",    EnType::enBool,  0,      0,      1,      nullptr},
+    {"m_dir_inv",   EnType::enBool,  0,      0,      1,      nullptr},
+    {"m_accel",     EnType::enFloat, 500,    1,      100000, nullptr},
+    {"s_pin",       EnType::enInt,   -1,     -1,     48,     &isOutputPinOrNone},
+    {"s_stop_us",   EnType::enInt,   1500,   500,    2500,   nullptr},
+    {"s_delta_us",  EnType::enInt,   1000,   0,      1500,   nullptr},
+    {"s_deadband",  EnType::enInt,   0,      0,      999,    nullptr},
+    {"s_inv",       EnType::enBool,  0,      0,      1,      nullptr},
+    {"led_count",   EnType::enInt,   1,      1,      4096,   nullptr},
+    {"led_fps",     EnType::enInt,   50,     1,      200,    nullptr},
+};
+
+static_assert(static_cast<size_t>(ConfigStore::EnParam::enCount) <= 32, "Dirty mask holds up to 32 parameters");
+
+esp_err_t ConfigStore::initNvs()
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
+    {
+        ESP_LOGW(LOG, "NVS partition is erased (%s)", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    return ret;
+}
+
+ConfigStore::ConfigStore():
+    ConfigStore(Config{})
+{}
+
+ConfigStore::ConfigStore(const Config& config):
+    m_config(config)
+{
+    for (size_t i = 0; i < m_values.size(); ++i)
+        m_values[i] = defaultRaw(PARAMS[i]);
+
+    m_nvsLock = xSemaphoreCreateMutex();
+    m_setLock = xSemaphoreCreateMutex();
+}
+
+ConfigStore::~ConfigStore()
+{
+    if (m_running)
+    {
+        m_running = false;
+        xTaskNotifyGive(m_task);
+
+        // Задача записывает оставшиеся изменения, удаляет себя сама и обнуляет дескриптор
+        while (__atomic_load_n(&m_task, __ATOMIC_ACQUIRE) != nullptr)
+            vTaskDelay(1);
+    }
+    vSemaphoreDelete(m_setLock);
+    vSemaphoreDelete(m_nvsLock);
+}
+
+void ConfigStore::load(const Migration& migrate)
+{
+    nvs_handle_t handle;
+    uint16_t schema = 0;
+    bool hasSchema = false;
+    Values values{};
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = defaultRaw(PARAMS[i]);
+
+    // Прошлая загрузка упала между load() и markApplied(): вероятно, сохраненные значения ее и уронили
+    const esp_reset_reason_t reason = esp_reset_reason();
+    m_fallback = s_bootGuard == BOOT_GUARD_MAGIC && isCrashReset(reason);
+    if (m_fallback)
+        ESP_LOGE(LOG, "Previous boot failed before the config was applied (reset reason %d), using defaults", static_cast<int>(reason));
+
+    if (!m_fallback && nvs_open(m_config.nvsNamespace, NVS_READONLY, &handle) == ESP_OK)
+    {
+        hasSchema = nvs_get_u16(handle, NVS_KEY_SCHEMA, &schema) == ESP_OK;
+        for (size_t i = 0; i < m_values.size(); ++i)
+        {
+            const ParamDesc& desc = PARAMS[i];
+            // Отсутствующий ключ, другой тип или недопустимое значение - остается значение по умолчанию
+            if (desc.type == EnType::enFloat)
+            {
+                uint32_t raw = 0;
+                if (nvs_get_u32(handle, desc.key, &raw) == ESP_OK && isValid(desc, rawToFloat(raw)))
+                    values[i] = raw;
+            }
+            else
+            {
+                int32_t value = 0;
+                if (nvs_get_i32(handle, desc.key, &value) == ESP_OK && isValid(desc, static_cast<float>(value)))
+                    values[i] = static_cast<uint32_t>(value);
+            }
+        }
+        nvs_close(handle);
+
+        // Каждое значение допустимо, но вместе они могут конфликтовать (например, пины прошивки с другим набором)
+        if (!isConsistent(values))
+        {
+            ESP_LOGE(LOG, "Stored config has conflicting pins, using defaults");
+            m_fallback = true;
+            hasSchema = false;      // Миграция отброшенных значений не нужна, схема записывается заново
+            for (size_t i = 0; i < values.size(); ++i)
+                values[i] = defaultRaw(PARAMS[i]);
+        }
+    }
+
+    for (size_t i = 0; i < values.size(); ++i)
+        m_values[i] = values[i];
+
+    // Значения по умолчанию записываются поверх отброшенных, чтобы следующая загрузка не повторила сбой
+    if (m_fallback)
+    {
+        m_dirtyMask.fetch_or(ALL_PARAMS_MASK);
+        commit();
+    }
+
+    if (hasSchema && schema > SCHEMA_VERSION)
+        ESP_LOGW(LOG, "Stored schema %u is newer than %u, unknown keys are ignored", schema, SCHEMA_VERSION);
+    else if (hasSchema && schema < SCHEMA_VERSION && migrate)
+    {
+        ESP_LOGI(LOG, "Migrating schema %u -> %u", schema, SCHEMA_VERSION);
+        migrate(*this, schema);
+    }
+
+    if (!hasSchema || schema < SCHEMA_VERSION)
+    {
+        xSemaphoreTake(m_nvsLock, portMAX_DELAY);
+        if (nvs_open(m_config.nvsNamespace, NVS_READWRITE, &handle) == ESP_OK)
+        {
+            nvs_set_u16(handle, NVS_KEY_SCHEMA, SCHEMA_VERSION);
+            nvs_commit(handle);
+            nvs_close(handle);
+        }
+        xSemaphoreGive(m_nvsLock);
+    }
+
+    if (!m_running)
+    {
+        m_running = true;
+        if (xTaskCreate(&ConfigStore::commitTask, "config_commit", m_config.stackSize, this,
+                        m_config.priority, &m_task) != pdPASS)
+        {
+            ESP_LOGE(LOG, "Commit task create failed, changes are written on flush() only");
+            m_running = false;
+        }
+    }
+    s_bootGuard = BOOT_GUARD_MAGIC;
+    ESP_LOGI(LOG, "Loaded %u parameters, schema %u", static_cast<unsigned>(m_values.size()), SCHEMA_VERSION);
+}
+
+void ConfigStore::markApplied()
+{
+    s_bootGuard = 0;
+}
+
+bool ConfigStore::isFallback() const
+{
+    return m_fallback;
+}
+
+int32_t ConfigStore::getInt(EnParam param) const
+{
+    return static_cast<int32_t>(m_values[static_cast<size_t>(param)].load(std::memory_order_relaxed));
+}
+
+bool ConfigStore::getBool(EnParam param) const
+{
+    return m_values[static_cast<size_t>(param)].load(std::memory_order_relaxed) != 0;
+}
+
+float ConfigStore::getFloat(EnParam param) const
+{
+    return rawToFloat(m_values[static_cast<size_t>(param)].load(std::memory_order_relaxed));
+}
+
+bool ConfigStore::setInt(EnParam param, int32_t value)
+{
+    const ParamDesc& desc = PARAMS[static_cast<size_t>(param)];
+    if (desc.type == EnType::enFloat)
+        return setFloat(param, static_cast<float>(value));
+    if (!isValid(desc, static_cast<float>(value)))
+        return false;
+    Values values{};
+    values[static_cast<size_t>(param)] = static_cast<uint32_t>(value);
+    return apply(values, 1U << static_cast<size_t>(param));
+}
+
+bool ConfigStore::setBool(EnParam param, bool value)
+{
+    return setInt(param, value ? 1 : 0);
+}
+
+bool ConfigStore::setFloat(EnParam param, float value)
+{
+    const ParamDesc& desc = PARAMS[static_cast<size_t>(param)];
+    if (desc.type != EnType::enFloat)
+        return setInt(param, static_cast<int32_t>(value));
+    if (!isValid(desc, value))
+        return false;
+    Values values{};
+    values[static_cast<size_t>(param)] = floatToRaw(value);
+    return apply(values, 1U << static_cast<size_t>(param));
+}
+
+bool ConfigStore::setFromString(const char* key, const char* value)
+{
+    const int index = findParam(key);
+    Values values{};
+    if (index < 0 || !parse(PARAMS[index], value, values[index]))
+        return false;
+    return apply(values, 1U << index);
+}
+
+void ConfigStore::resetToDefaults()
+{
+    Values values{};
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = defaultRaw(PARAMS[i]);
+    apply(values, ALL_PARAMS_MASK);
+}
+
+esp_err_t ConfigStore::flush()
+{
+    return commit();
+}
+
+void ConfigStore::registerHttpHandlers(HttpServer& server)
+{
+    httpd_uri_t getUri =
+    {
+        .uri = "/config",
+        .method = HTTP_GET,
+        .handler = &ConfigStore::httpGetHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(getUri) != ESP_OK)
+        ESP_LOGE(LOG, "Register GET /config failed");
+
+    httpd_uri_t postUri =
+    {
+        .uri = "/config",
+        .method = HTTP_POST,
+        .handler = &ConfigStore::httpPostHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(postUri) != ESP_OK)
+        ESP_LOGE(LOG, "Register POST /config failed");
+}
+
+ConfigStore::Stats ConfigStore::getStats() const
+{
+    Stats stats;
+    stats.writes = m_writes;
+    stats.commits = m_commits;
+    stats.errors = m_errors;
+    stats.lastCommitUs = m_lastCommitUs;
+    return stats;
+}
+
+void ConfigStore::commitTask(void* arg)
+{
+    auto* self = static_cast<ConfigStore*>(arg);
+
+    while (self->m_running)
+    {
+        // Первое изменение после коммита
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Ждем паузы в изменениях, но не дольше maxCommitDelayMs
+        const int64_t firstUs = esp_timer_get_time();
+        while (self->m_running)
+        {
+            const int64_t leftMs = self->m_config.maxCommitDelayMs - (esp_timer_get_time() - firstUs) / 1000;
+            if (leftMs <= 0)
+                break;
+            const uint32_t waitMs = leftMs < self->m_config.commitDelayMs ? static_cast<uint32_t>(leftMs) : self->m_config.commitDelayMs;
+            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs)) == 0)
+                break;
+        }
+
+        if (self->m_dirtyMask)
+            self->commit();
+    }
+
+    __atomic_store_n(&self->m_task, nullptr, __ATOMIC_RELEASE);
+    vTaskDelete(nullptr);
+}
+
+esp_err_t ConfigStore::httpGetHandler(httpd_req_t* req)
+{
+    return static_cast<ConfigStore*>(req->user_ctx)->sendJson(req);
+}
+
+esp_err_t ConfigStore::httpPostHandler(httpd_req_t* req)
+{
+    auto* self = static_cast<ConfigStore*>(req->user_ctx);
+
+    // Тело: key=value&key=value (application/x-www-form-urlencoded)
+    char body[512];
+    if (req->content_len >= sizeof(body))
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body too long");
+
+    const esp_err_t ret = HttpServer::recvAll(req, body, req->content_len);
+    if (ret == ESP_ERR_TIMEOUT)
+        return httpd_resp_send_err(req, HTTPD_408_REQ_TIMEOUT, "Body timeout");
+    if (ret != ESP_OK)
+        return ESP_FAIL;
+    body[req->content_len] = '\0';
+
+    // Все пары разбираются и проверяются до применения: ошибка в любой не меняет ни одного параметра
+    Values values{};
+    uint32_t mask = 0;
+    bool flush = false;
+    char* save = nullptr;
+    for (char* pair = strtok_r(body, "&", &save); pair; pair = strtok_r(nullptr, "&", &save))
+    {
+        char* value = strchr(pair, '=');
+        if (!value)
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Expected key=value");
+        *value++ = '\0';
+
+        char message[64];
+        if (strcmp(pair, "flush") == 0)
+        {
+            flush = strcmp(value, "1") == 0;
+            continue;
+        }
+        const int index = findParam(pair);
+        if (index < 0)
+        {
+            snprintf(message, sizeof(message), "Unknown parameter %.32s", pair);
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, message);
+        }
+        if (!parse(PARAMS[index], value, values[index]))
+        {
+            snprintf(message, sizeof(message), "Invalid value of %s", PARAMS[index].key);
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, message);
+        }
+        mask |= 1U << index;
+    }
+    if (mask == 0)
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No parameters");
+    if (!self->apply(values, mask))
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Conflicting pins");
+
+    if (flush)
+        self->flush();
+
+    return self->sendJson(req);
+}
+
+void ConfigStore::store(EnParam param, uint32_t raw)
+{
+    const size_t index = static_cast<size_t>(param);
+    if (m_values[index].exchange(raw) == raw)
+        return;
+
+    m_dirtyMask.fetch_or(1U << index);
+    ++m_writes;
+    if (m_running)
+        xTaskNotifyGive(m_task);
+}
+
+bool ConfigStore::apply(const Values& values, uint32_t mask)
+{
+    xSemaphoreTake(m_setLock, portMAX_DELAY);
+    Values merged;
+    for (size_t i = 0; i < merged.size(); ++i)
+        merged[i] = (mask & (1U << i)) ? values[i] : m_values[i].load(std::memory_order_relaxed);
+
+    const bool consistent = isConsistent(merged);
+    if (consistent)
+    {
+        for (size_t i = 0; i < merged.size(); ++i)
+        {
+            if (mask & (1U << i))
+                store(static_cast<EnParam>(i), merged[i]);
+        }
+    }
+    xSemaphoreGive(m_setLock);
+    return consistent;
+}
+
+bool ConfigStore::isValid(const ParamDesc& desc, float value)
+{
+    // NaN не проходит сравнения
+    return value >= desc.minValue && value <= desc.maxValue && (!desc.check || desc.check(value));
+}
+
+bool ConfigStore::parse(const ParamDesc& desc, const char* value, uint32_t& raw)
+{
+    char* end = nullptr;
+    if (desc.type == EnType::enFloat)
+    {
+        const float parsed = strtof(value, &end);
+        if (end == value || *end != '\0' || !isValid(desc, parsed))
+            return false;
+        raw = floatToRaw(parsed);
+        return true;
+    }
+    if (desc.type == EnType::enBool && (strcmp(value, "true") == 0 || strcmp(value, "false") == 0))
+    {
+        raw = value[0] == 't';
+        return true;
+    }
+
+    const long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || !isValid(desc, static_cast<float>(parsed)))
+        return false;
+    raw = static_cast<uint32_t>(static_cast<int32_t>(parsed));
+    return true;
+}
+
+int ConfigStore::findParam(const char* key)
+{
+    for (size_t i = 0; i < static_cast<size_t>(EnParam::enCount); ++i)
+    {
+        if (strcmp(PARAMS[i].key, key) == 0)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool ConfigStore::isConsistent(const Values& values) const
+{
+    uint64_t used = m_config.reservedPins;
+    for (EnParam param : PIN_PARAMS)
+    {
+        const int32_t pin = static_cast<int32_t>(values[static_cast<size_t>(param)]);
+        if (pin == GPIO_NUM_NC)
+            continue;
+        if (used & (1ULL << pin))
+            return false;
+        used |= 1ULL << pin;
+    }
+    return true;
+}
+
+uint32_t ConfigStore::defaultRaw(const ParamDesc& desc)
+{
+    return desc.type == EnType::enFloat ? floatToRaw(desc.defaultValue) : static_cast<uint32_t>(static_cast<int32_t>(desc.defaultValue));
+}
+
+esp_err_t ConfigStore::commit()
+{
+    xSemaphoreTake(m_nvsLock, portMAX_DELAY);
+    const uint32_t mask = m_dirtyMask.exchange(0);
+    if (!mask)
+    {
+        xSemaphoreGive(m_nvsLock);
+        return ESP_OK;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(m_config.nvsNamespace, NVS_READWRITE, &handle);
+    if (err == ESP_OK)
+    {
+        for (size_t i = 0; i < m_values.size() && err == ESP_OK; ++i)
+        {
+            if (!(mask & (1U << i)))
+                continue;
+            const uint32_t raw = m_values[i];
+            err = PARAMS[i].type == EnType::enFloat ? nvs_set_u32(handle, PARAMS[i].key, raw)
+                                                    : nvs_set_i32(handle, PARAMS[i].key, static_cast<int32_t>(raw));
+        }
+        if (err == ESP_OK)
+            err = nvs_commit(handle);
+        nvs_close(handle);
+    }
+
+    if (err != ESP_OK)
+    {
+        // Изменения остаются незаписанными до следующего коммита
+        m_dirtyMask.fetch_or(mask);
+        ++m_errors;
+        ESP_LOGE(LOG, "Commit failed: %s", esp_err_to_name(err));
+    }
+    else
+    {
+        ++m_commits;
+        m_lastCommitUs = esp_timer_get_time();
+        ESP_LOGD(LOG, "Committed mask 0x%08lx", static_cast<unsigned long>(mask));
+    }
+    xSemaphoreGive(m_nvsLock);
+    return err;
+}
+
+esp_err_t ConfigStore::sendJson(httpd_req_t* req)
+{
+    char buf[96];
+
+    httpd_resp_set_type(req, "application/json");
+    snprintf(buf, sizeof(buf), "{\"schema\":%u,\"pending\":%s,\"fallback\":%s,\"values\":{", SCHEMA_VERSION,
+             m_dirtyMask ? "true" : "false", m_fallback ? "true" : "false");
+    httpd_resp_sendstr_chunk(req, buf);
+
+    for (size_t i = 0; i < m_values.size(); ++i)
+    {
+        const ParamDesc& desc = PARAMS[i];
+        const EnParam param = static_cast<EnParam>(i);
+        const char* separator = i ? "," : "";
+        switch (desc.type)
+        {
+        case EnType::enInt:
+            snprintf(buf, sizeof(buf), "%s\"%s\":%ld", separator, desc.key, static_cast<long>(getInt(param)));
+            break;
+        case EnType::enBool:
+            snprintf(buf, sizeof(buf), "%s\"%s\":%s", separator, desc.key, getBool(param) ? "true" : "false");
+            break;
+        case EnType::enFloat:
+            snprintf(buf, sizeof(buf), "%s\"%s\":%g", separator, desc.key, static_cast<double>(getFloat(param)));
+            break;
+        }
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+
+    const Stats stats = getStats();
+    snprintf(buf, sizeof(buf), "},\"writes\":%lu,\"commits\":%lu,\"errors\":%lu}",
+             static_cast<unsigned long>(stats.writes), static_cast<unsigned long>(stats.commits), static_cast<unsigned long>(stats.errors));
+    httpd_resp_sendstr_chunk(req, buf);
+    return httpd_resp_sendstr_chunk(req, nullptr);
+}
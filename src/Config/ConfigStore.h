@@ -0,0 +1,216 @@
+#pragma once
+
+#include <esp_err.h>
+#include <esp_http_server.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <array>
+#include <atomic>
+#include <functional>
+
+class HttpServer;
+
+// Хранилище типизированных параметров конфигурации.
+// Все параметры читаются из NVS один раз при загрузке в кэш в RAM, чтение - атомарная загрузка без блокировок.
+// Изменения сразу попадают в кэш, а в NVS записываются пачкой: коммит откладывается, пока изменения идут чаще
+// commitDelayMs, но не дольше maxCommitDelayMs от первого незаписанного изменения. Это ограничивает износ флеш-памяти
+// и не дает записи NVS блокировать вызывающие задачи.
+// Схема версионируется: при загрузке более старой схемы вызывается обработчик миграции.
+// Пины проверяются на допустимость для выхода и не должны совпадать между собой и с занятыми пинами; набор,
+// который не проходит проверку, не принимается целиком. Если прошлый запуск упал, не дойдя до markApplied(),
+// загрузка берет значения по умолчанию: сохраненная конфигурация не должна приводить к циклу перезагрузок.
+class ConfigStore
+{
+public:
+    static const uint16_t SCHEMA_VERSION = 1;           // Версия схемы параметров
+
+    enum class EnParam : uint8_t
+    {
+        enMotorEnPin,           // Пин ENABLE шагового двигателя
+        enMotorDirPin,          // Пин DIR шагового двигателя
+        enMotorStepPin,         // Пин STEP шагового двигателя
+        enMotorStepMode,        // Режим микрошага (1, 2, 4 ... 32)
+        enMotorEnableInverse,   // Инверсия ENABLE
+        enMotorDirInverse,      // Инверсия DIR
+        enMotorAccel,           // Ускорение по умолчанию, град/с²
+        enServoPin,             // Пин импульсов сервопривода (-1 - нет)
+        enServoStopUs,          // Импульс остановки сервопривода, мкс
+        enServoDeltaUs,         // Диапазон импульса сервопривода в одну из сторон, мкс
+        enServoDeadband,        // Зона нечувствительности сервопривода, промилле
+        enServoInverted,        // Инверсия направления сервопривода
+        enLedsCount,            // Количество светодиодов ленты
+        enLedFps,               // Частота кадров эффектов ленты
+        enCount
+    };
+
+    enum class EnType : uint8_t
+    {
+        enInt,
+        enBool,
+        enFloat,
+    };
+
+    struct Config
+    {
+        const char* nvsNamespace = "config";        // Пространство имен NVS
+        uint32_t commitDelayMs = 2000;              // Задержка коммита после последнего изменения, мс
+        uint32_t maxCommitDelayMs = 30000;          // Максимальная задержка коммита после первого изменения, мс
+        uint32_t stackSize = 3072;                  // Размер стека задачи записи, байт
+        UBaseType_t priority = 1;                   // Приоритет задачи записи
+        uint64_t reservedPins = 0;                  // Маска пинов, занятых вне конфигурации
+    };
+
+    struct Stats
+    {
+        uint32_t writes = 0;            // Изменений параметров
+        uint32_t commits = 0;           // Коммитов NVS
+        uint32_t errors = 0;            // Ошибок записи NVS
+        int64_t lastCommitUs = 0;       // Время последнего коммита, мкс
+    };
+
+    // Обработчик миграции: вызывается после загрузки значений, сохраненных схемой fromVersion
+    using Migration = std::function<void(ConfigStore& store, uint16_t fromVersion)>;
+
+    /**
+     * @brief Метод для инициализации раздела NVS (до любых обращений к NVS, в том числе до WiFiManager::connect())
+     * @return Результат инициализации
+     */
+    static esp_err_t initNvs();
+
+    ConfigStore();
+    explicit ConfigStore(const Config& config);
+    ~ConfigStore();
+
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+
+    /**
+     * @brief Метод для загрузки параметров из NVS в кэш и запуска задачи записи (после initNvs())
+     * @param migrate: Обработчик миграции со старых версий схемы (может быть пустым)
+     */
+    void load(const Migration& migrate = nullptr);
+
+    /**
+     * @brief Метод для отметки успешного применения конфигурации (после создания периферии по ней)
+     */
+    void markApplied();
+
+    /**
+     * @brief Метод для проверки, что вместо сохраненной конфигурации загружены значения по умолчанию
+     * @return true если сохраненная конфигурация отброшена
+     */
+    bool isFallback() const;
+
+    /**
+     * @brief Методы для чтения параметра из кэша
+     * @param param: Параметр
+     * @return Значение
+     */
+    int32_t getInt(EnParam param) const;
+    bool getBool(EnParam param) const;
+    float getFloat(EnParam param) const;
+
+    /**
+     * @brief Методы для изменения параметра (запись в NVS - отложенная)
+     * @param param: Параметр
+     * @param value: Значение
+     * @return true если значение допустимо, пины не конфликтуют и значение принято
+     */
+    bool setInt(EnParam param, int32_t value);
+    bool setBool(EnParam param, bool value);
+    bool setFloat(EnParam param, float value);
+
+    /**
+     * @brief Метод для изменения параметра по ключу и строковому значению
+     * @param key: Ключ параметра
+     * @param value: Значение
+     * @return true если ключ известен, значение допустимо и принято
+     */
+    bool setFromString(const char* key, const char* value);
+
+    /**
+     * @brief Метод для сброса всех параметров к значениям по умолчанию
+     */
+    void resetToDefaults();
+
+    /**
+     * @brief Метод для немедленной записи изменений в NVS
+     * @return Результат записи
+     */
+    esp_err_t flush();
+
+    /**
+     * @brief Метод для регистрации обработчиков /config (после HttpServer::start())
+     * @param server: HTTP-сервер
+     */
+    void registerHttpHandlers(HttpServer& server);
+
+    /**
+     * @brief Метод для получения статистики
+     * @return Статистика
+     */
+    Stats getStats() const;
+
+private:
+    using Values = std::array<uint32_t, static_cast<size_t>(EnParam::enCount)>;
+
+    struct ParamDesc
+    {
+        const char* key;        // Ключ NVS и HTTP
+        EnType type;
+        float defaultValue;
+        float minValue;
+        float maxValue;
+        bool (*check)(float value);     // Дополнительная проверка значения (может быть nullptr)
+    };
+
+    static const ParamDesc PARAMS[static_cast<size_t>(EnParam::enCount)];
+
+    static void commitTask(void* arg);
+    static esp_err_t httpGetHandler(httpd_req_t* req);
+    static esp_err_t httpPostHandler(httpd_req_t* req);
+
+    /* Запись значения в кэш с планированием коммита */
+    void store(EnParam param, uint32_t raw);
+
+    /* Запись параметров из маски в кэш, если набор вместе с остальными значениями согласован */
+    bool apply(const Values& values, uint32_t mask);
+
+    /* Проверка значения по описанию параметра */
+    static bool isValid(const ParamDesc& desc, float value);
+
+    /* Разбор строкового значения с проверкой по описанию параметра */
+    static bool parse(const ParamDesc& desc, const char* value, uint32_t& raw);
+
+    /* Поиск параметра по ключу */
+    static int findParam(const char* key);
+
+    /* Проверка набора значений: пины не совпадают между собой и с занятыми */
+    bool isConsistent(const Values& values) const;
+
+    /* Значение по умолчанию в представлении кэша */
+    static uint32_t defaultRaw(const ParamDesc& desc);
+
+    /* Запись измененных параметров в NVS одним коммитом */
+    esp_err_t commit();
+
+    /* Формирование JSON-ответа со всеми параметрами */
+    esp_err_t sendJson(httpd_req_t* req);
+
+private:
+    const Config m_config;
+
+    std::array<std::atomic<uint32_t>, static_cast<size_t>(EnParam::enCount)> m_values;   // Кэш (float - битовое представление)
+    std::atomic<uint32_t> m_dirtyMask{0};       // Параметры, не записанные в NVS
+    SemaphoreHandle_t m_nvsLock = nullptr;      // Сериализует коммиты
+    SemaphoreHandle_t m_setLock = nullptr;      // Сериализует изменения: проверка согласованности и запись в кэш
+    TaskHandle_t m_task = nullptr;
+    std::atomic<bool> m_running{false};
+    bool m_fallback = false;                    // Загружены значения по умолчанию вместо сохраненных
+
+    std::atomic<uint32_t> m_writes{0};
+    std::atomic<uint32_t> m_commits{0};
+    std::atomic<uint32_t> m_errors{0};
+    std::atomic<int64_t> m_lastCommitUs{0};
+};
@@ -0,0 +1,354 @@
+#include "UdpControl.h"
+#include <esp_log.h>
+#include <esp_random.h>
+
+namespace
+{
+    const char* LOG = "UdpControl";                 // Канал лога
+    const uint32_t RX_TIMEOUT_MS = 100;             // Таймаут recvfrom, чтобы задача могла корректно завершиться
+    const size_t SHA256_BLOCK_SIZE = 64;
+
+    static_assert(sizeof(UdpControl::SetpointPacket) == 60, "Wire format changed");
+    static_assert(sizeof(UdpControl::HelloPacket) == 28, "Wire format changed");
+    static_assert(sizeof(UdpControl::SessionPacket) == 32, "Wire format changed");
+}
+
+void UdpControl::SetpointSlot::write(const Setpoint& setpoint)
+{
+    const uint32_t version = m_version.load(std::memory_order_relaxed);
+    m_version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_data = setpoint;
+    m_version.store(version + 2, std::memory_order_release);
+}
+
+bool UdpControl::SetpointSlot::read(Setpoint& setpoint, uint32_t& version) const
+{
+    uint32_t before = 0;
+    uint32_t after = 0;
+    do
+    {
+        before = m_version.load(std::memory_order_acquire);
+        if (before & 1u)
+            continue;
+        setpoint = m_data;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_version.load(std::memory_order_relaxed);
+    } while ((before & 1u) || before != after);
+
+    version = before;
+    return before != 0;
+}
+
+UdpControl::UdpControl(const Config& config):
+    m_config(config)
+{
+    // HMAC: предвычисляем состояния SHA256 после блоков (key ^ ipad) и (key ^ opad),
+    // чтобы проверка пакета не требовала ни выделения памяти, ни повторной обработки ключа
+    uint8_t ipad[SHA256_BLOCK_SIZE];
+    uint8_t opad[SHA256_BLOCK_SIZE];
+    memset(ipad, 0x36, sizeof(ipad));
+    memset(opad, 0x5c, sizeof(opad));
+    for (size_t i = 0; i < KEY_SIZE; ++i)
+    {
+        ipad[i] ^= m_config.key[i];
+        opad[i] ^= m_config.key[i];
+    }
+
+    mbedtls_sha256_init(&m_innerCtx);
+    mbedtls_sha256_starts(&m_innerCtx, 0);
+    mbedtls_sha256_update(&m_innerCtx, ipad, sizeof(ipad));
+
+    mbedtls_sha256_init(&m_outerCtx);
+    mbedtls_sha256_starts(&m_outerCtx, 0);
+    mbedtls_sha256_update(&m_outerCtx, opad, sizeof(opad));
+}
+
+UdpControl::~UdpControl()
+{
+    stop();
+    mbedtls_sha256_free(&m_innerCtx);
+    mbedtls_sha256_free(&m_outerCtx);
+}
+
+bool UdpControl::start()
+{
+    if (m_running)
+        return true;
+
+    m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_socket < 0)
+    {
+        ESP_LOGE(LOG, "Socket create failed");
+        return false;
+    }
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_config.port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        ESP_LOGE(LOG, "Bind to port %u failed", m_config.port);
+        closesocket(m_socket);
+        m_socket = -1;
+        return false;
+    }
+
+    timeval timeout = {
+        .tv_sec = 0,
+        .tv_usec = RX_TIMEOUT_MS * 1000,
+    };
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    const esp_timer_create_args_t watchdogArgs = {
+        .callback = &UdpControl::watchdogCallback,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "udp_ctrl_wdt",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&watchdogArgs, &m_watchdog));
+    // Проверяем 4 раза за таймаут, чтобы реакция была не позже 1.25 * watchdogTimeoutMs
+    ESP_ERROR_CHECK(esp_timer_start_periodic(m_watchdog, m_config.watchdogTimeoutMs * 1000 / 4));
+
+    m_running = true;
+    if (xTaskCreatePinnedToCore(&UdpControl::rxTask, "udp_ctrl", m_config.stackSize, this,
+                                m_config.priority, &m_rxTask, m_config.coreId) != pdPASS)
+    {
+        ESP_LOGE(LOG, "Task create failed");
+        stop();
+        return false;
+    }
+
+    ESP_LOGI(LOG, "Listening on UDP port %u", m_config.port);
+    return true;
+}
+
+void UdpControl::stop()
+{
+    m_running = false;
+
+    // Задача завершится не позже чем через RX_TIMEOUT_MS и обнулит m_rxTask
+    while (__atomic_load_n(&m_rxTask, __ATOMIC_ACQUIRE) != nullptr)
+        vTaskDelay(pdMS_TO_TICKS(RX_TIMEOUT_MS / 4));
+
+    if (m_watchdog)
+    {
+        esp_timer_stop(m_watchdog);
+        esp_timer_delete(m_watchdog);
+        m_watchdog = nullptr;
+    }
+
+    if (m_socket >= 0)
+    {
+        closesocket(m_socket);
+        m_socket = -1;
+    }
+}
+
+bool UdpControl::takeSetpoint(Setpoint& setpoint)
+{
+    uint32_t version = 0;
+    if (!m_slot.read(setpoint, version) || version == m_readVersion)
+        return false;
+
+    m_readVersion = version;
+
+    const uint32_t latencyUs = static_cast<uint32_t>(esp_timer_get_time() - setpoint.rxTimeUs);
+    m_lastLatencyUs.store(latencyUs, std::memory_order_relaxed);
+    if (latencyUs > m_maxLatencyUs.load(std::memory_order_relaxed))
+        m_maxLatencyUs.store(latencyUs, std::memory_order_relaxed);
+    return true;
+}
+
+bool UdpControl::takeTimeout()
+{
+    return m_stopRequested.exchange(false, std::memory_order_relaxed);
+}
+
+bool UdpControl::isClientActive() const
+{
+    return !m_timedOut.load(std::memory_order_relaxed);
+}
+
+UdpControl::Stats UdpControl::getStats() const
+{
+    return {
+        .received = m_received.load(),
+        .accepted = m_accepted.load(),
+        .badSize = m_badSize.load(),
+        .badHeader = m_badHeader.load(),
+        .badMac = m_badMac.load(),
+        .stale = m_stale.load(),
+        .badSession = m_badSession.load(),
+        .sessions = m_sessions.load(),
+        .timeouts = m_timeouts.load(),
+        .lastLatencyUs = m_lastLatencyUs.load(),
+        .maxLatencyUs = m_maxLatencyUs.load(),
+    };
+}
+
+void UdpControl::rxTask(void* arg)
+{
+    auto* self = static_cast<UdpControl*>(arg);
+
+    while (self->m_running)
+    {
+        sockaddr_storage from = {};
+        socklen_t fromLen = sizeof(from);
+        const int len = recvfrom(self->m_socket, self->m_rxBuf, sizeof(self->m_rxBuf), 0,
+                                 reinterpret_cast<sockaddr*>(&from), &fromLen);
+        if (len < 0)
+            continue;   // Таймаут или ошибка - проверяем m_running и ждем дальше
+
+        self->handleDatagram(static_cast<size_t>(len), esp_timer_get_time(), reinterpret_cast<sockaddr*>(&from),
+                             fromLen);
+    }
+
+    __atomic_store_n(&self->m_rxTask, nullptr, __ATOMIC_RELEASE);
+    vTaskDelete(nullptr);
+}
+
+void UdpControl::watchdogCallback(void* arg)
+{
+    auto* self = static_cast<UdpControl*>(arg);
+    if (self->m_timedOut.load(std::memory_order_relaxed))
+        return;
+
+    const int64_t silenceUs = esp_timer_get_time() - self->m_lastRxUs.load(std::memory_order_relaxed);
+    if (silenceUs <= static_cast<int64_t>(self->m_config.watchdogTimeoutMs) * 1000)
+        return;
+
+    self->m_timedOut = true;
+    ++self->m_timeouts;
+    ESP_LOGW(LOG, "No setpoints for %lld ms, stopping", static_cast<long long>(silenceUs / 1000));
+    // Только запрос: контроллер вызывается из своего цикла, а не из задачи esp_timer
+    self->m_stopRequested.store(true, std::memory_order_relaxed);
+}
+
+void UdpControl::handleDatagram(size_t len, int64_t rxTimeUs, const sockaddr* from, socklen_t fromLen)
+{
+    ++m_received;
+
+    if (len == sizeof(HelloPacket))
+    {
+        handleHello(from, fromLen);
+        return;
+    }
+
+    if (len != sizeof(SetpointPacket))
+    {
+        ++m_badSize;
+        return;
+    }
+
+    const auto& packet = *reinterpret_cast<const SetpointPacket*>(m_rxBuf);
+    if (packet.magic != PACKET_MAGIC || packet.version != PACKET_VERSION || packet.reserved != 0
+        || packet.command > EnCommand::enHardStop)
+    {
+        ++m_badHeader;
+        return;
+    }
+
+    if (!verifyPacket(packet))
+    {
+        ++m_badMac;
+        return;
+    }
+
+    // Пакет другого сеанса (в том числе записанный до перезагрузки) - повтор или устаревший отправитель
+    if (m_session == 0 || packet.session != m_session)
+    {
+        ++m_badSession;
+        return;
+    }
+
+    // Побеждает последний записавший: пакет старше уже принятого отбрасывается. Проверка действует и после
+    // срабатывания сторожевого таймера - перезапущенный отправитель открывает новый сеанс
+    if (!isNewer(packet.seq, m_lastSeq) || packet.timestampUs < m_lastSenderTimestampUs)
+    {
+        ++m_stale;
+        return;
+    }
+
+    m_lastSeq = packet.seq;
+    m_lastSenderTimestampUs = packet.timestampUs;
+
+    const Setpoint setpoint = {
+        .command = packet.command,
+        .targetPos = packet.targetPos,
+        .targetSpeed = packet.targetSpeed,
+        .acceleration = packet.acceleration,
+        .deceleration = packet.deceleration,
+        .seq = packet.seq,
+        .senderTimestampUs = packet.timestampUs,
+        .rxTimeUs = rxTimeUs,
+    };
+    m_slot.write(setpoint);
+
+    m_lastRxUs.store(rxTimeUs, std::memory_order_relaxed);
+    m_timedOut.store(false, std::memory_order_relaxed);
+    ++m_accepted;
+}
+
+void UdpControl::handleHello(const sockaddr* from, socklen_t fromLen)
+{
+    const auto& hello = *reinterpret_cast<const HelloPacket*>(m_rxBuf);
+    if (hello.magic != HELLO_MAGIC || hello.version != PACKET_VERSION
+        || hello.reserved[0] != 0 || hello.reserved[1] != 0 || hello.reserved[2] != 0)
+    {
+        ++m_badHeader;
+        return;
+    }
+
+    if (!verifyPacket(hello))
+    {
+        ++m_badMac;
+        return;
+    }
+
+    // Каждый запрос открывает новый сеанс: повтор перехваченного запроса лишь обрывает текущий сеанс,
+    // а ответ с новым номером без ключа не подделать
+    uint32_t session = 0;
+    while (session == 0 || session == m_session)
+        session = esp_random();
+    m_session = session;
+    m_lastSeq = 0;
+    m_lastSenderTimestampUs = 0;
+    ++m_sessions;
+
+    SessionPacket reply = {
+        .magic = SESSION_MAGIC,
+        .version = PACKET_VERSION,
+        .reserved = {},
+        .clientNonce = hello.clientNonce,
+        .session = session,
+        .mac = {},
+    };
+    signPacket(reply);
+    if (sendto(m_socket, &reply, sizeof(reply), 0, from, fromLen) != sizeof(reply))
+        ESP_LOGW(LOG, "Session reply send failed");
+    ESP_LOGI(LOG, "Session %08lx opened", static_cast<unsigned long>(session));
+}
+
+void UdpControl::calcMac(const uint8_t* data, size_t len, uint8_t* out) const
+{
+    uint8_t innerHash[SHA256_SIZE];
+
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_clone(&ctx, &m_innerCtx);
+    mbedtls_sha256_update(&ctx, data, len);
+    mbedtls_sha256_finish(&ctx, innerHash);
+
+    mbedtls_sha256_clone(&ctx, &m_outerCtx);
+    mbedtls_sha256_update(&ctx, innerHash, sizeof(innerHash));
+    mbedtls_sha256_finish(&ctx, out);
+    mbedtls_sha256_free(&ctx);
+}
+
+bool UdpControl::isNewer(uint32_t seq, uint32_t lastSeq)
+{
+    return static_cast<int32_t>(seq - lastSeq) > 0;
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "Helpers/CorePlacement.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include <lwip/sockets.h>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+// Канал управления реального времени поверх UDP.
+// Пакеты фиксированного размера разбираются без выделения памяти прямо в заранее выделенный слот уставки,
+// который забирает контроллер движения. Устаревшие и пришедшие не по порядку пакеты отбрасываются
+// (побеждает последний записавший), подлинность проверяется по HMAC-SHA256 с общим ключом.
+//
+// Защита от повтора: уставки принимаются только в сеансе. Отправитель посылает подписанный HelloPacket со своим
+// случайным числом, устройство отвечает подписанным SessionPacket с новым случайным номером сеанса, который
+// отправитель вписывает в каждую уставку. Номера пакетов и метки времени внутри сеанса строго растут (в том числе
+// после срабатывания сторожевого таймера), новый сеанс начинается с seq = 1. Пакеты, записанные в прошлом сеансе
+// или до перезагрузки устройства, не проходят проверку номера сеанса.
+class UdpControl
+{
+public:
+    static const uint16_t DEFAULT_PORT = 3333;
+    static const size_t KEY_SIZE = 32;                  // Размер общего ключа, байт
+    static const size_t MAC_SIZE = 16;                  // Размер усеченного HMAC-SHA256 в пакете, байт
+
+    enum class EnCommand : uint8_t
+    {
+        enSpeed = 0,        // Управление по скорости
+        enPosition = 1,     // Управление по положению
+        enSoftStop = 2,     // Плавный останов
+        enHardStop = 3,     // Мгновенный останов
+    };
+
+    // Формат пакета уставки (little-endian)
+    struct __attribute__((packed)) SetpointPacket
+    {
+        uint32_t magic;                 // Сигнатура PACKET_MAGIC
+        uint8_t version;                // Версия формата PACKET_VERSION
+        EnCommand command;              // Команда
+        uint16_t reserved;              // Резерв, должен быть 0
+        uint32_t session;               // Номер сеанса из SessionPacket
+        uint32_t seq;                   // Порядковый номер пакета в сеансе (с 1)
+        uint64_t timestampUs;           // Метка времени отправителя, мкс
+        double targetPos;               // Целевое положение, град
+        float targetSpeed;              // Целевая скорость, град/с
+        float acceleration;             // Ускорение, град/с²
+        float deceleration;             // Замедление, град/с²
+        uint8_t mac[MAC_SIZE];          // HMAC-SHA256(key, все предыдущие поля), первые MAC_SIZE байт
+    };
+
+    // Запрос сеанса (little-endian)
+    struct __attribute__((packed)) HelloPacket
+    {
+        uint32_t magic;                 // Сигнатура HELLO_MAGIC
+        uint8_t version;                // Версия формата PACKET_VERSION
+        uint8_t reserved[3];            // Резерв, должен быть 0
+        uint32_t clientNonce;           // Случайное число отправителя, возвращается в ответе
+        uint8_t mac[MAC_SIZE];          // HMAC-SHA256(key, все предыдущие поля), первые MAC_SIZE байт
+    };
+
+    // Ответ с номером сеанса, отправляется на адрес запроса (little-endian)
+    struct __attribute__((packed)) SessionPacket
+    {
+        uint32_t magic;                 // Сигнатура SESSION_MAGIC
+        uint8_t version;                // Версия формата PACKET_VERSION
+        uint8_t reserved[3];            // Резерв, 0
+        uint32_t clientNonce;           // Число из запроса
+        uint32_t session;               // Номер сеанса
+        uint8_t mac[MAC_SIZE];          // HMAC-SHA256(key, все предыдущие поля), первые MAC_SIZE байт
+    };
+
+    static const uint32_t PACKET_MAGIC = 0x31435053;    // "SPC1"
+    static const uint32_t HELLO_MAGIC = 0x31485053;     // "SPH1"
+    static const uint32_t SESSION_MAGIC = 0x31535053;   // "SPS1"
+    static const uint8_t PACKET_VERSION = 2;
+
+    // Уставка, которую забирает контроллер
+    struct Setpoint
+    {
+        EnCommand command = EnCommand::enSoftStop;
+        double targetPos = 0.;
+        float targetSpeed = 0.f;
+        float acceleration = 0.f;
+        float deceleration = 0.f;
+        uint32_t seq = 0;               // Номер пакета, из которого получена уставка
+        uint64_t senderTimestampUs = 0; // Метка времени отправителя, мкс
+        int64_t rxTimeUs = 0;           // Метка времени приема, мкс (esp_timer_get_time)
+    };
+
+    struct Config
+    {
+        uint16_t port = DEFAULT_PORT;               // UDP порт
+        uint8_t key[KEY_SIZE] = {};                 // Общий ключ HMAC
+        uint32_t watchdogTimeoutMs = 200;           // Таймаут отсутствия пакетов, после которого выставляется останов
+        uint32_t stackSize = 4096;                  // Размер стека задачи приема, байт
+        UBaseType_t priority = 10;                  // Приоритет задачи приема
+        BaseType_t coreId = CorePlacement::NETWORK_CORE;    // Ядро задачи приема
+    };
+
+    struct Stats
+    {
+        uint32_t received = 0;          // Получено датаграмм
+        uint32_t accepted = 0;          // Принято уставок
+        uint32_t badSize = 0;           // Отброшено: неверный размер
+        uint32_t badHeader = 0;         // Отброшено: неверная сигнатура/версия
+        uint32_t badMac = 0;            // Отброшено: неверная подпись
+        uint32_t stale = 0;             // Отброшено: устаревшие/не по порядку
+        uint32_t badSession = 0;        // Отброшено: нет сеанса или чужой номер сеанса
+        uint32_t sessions = 0;          // Открыто сеансов
+        uint32_t timeouts = 0;          // Срабатываний сторожевого таймера
+        uint32_t lastLatencyUs = 0;     // Задержка пакет -> уставка у контроллера (последняя), мкс
+        uint32_t maxLatencyUs = 0;      // Задержка пакет -> уставка у контроллера (максимальная), мкс
+    };
+
+    /**
+     * @brief Конструктор
+     * @param config: Параметры канала
+     */
+    explicit UdpControl(const Config& config);
+    ~UdpControl();
+
+    UdpControl(const UdpControl&) = delete;
+    UdpControl& operator=(const UdpControl&) = delete;
+
+    /**
+     * @brief Метод для запуска приема пакетов
+     * @return true при успешном запуске
+     */
+    bool start();
+
+    /**
+     * @brief Метод для остановки приема пакетов
+     */
+    void stop();
+
+    /**
+     * @brief Метод для получения новой уставки (вызывается из цикла контроллера, без блокировок)
+     * @param setpoint: Уставка
+     * @return true если с момента предыдущего вызова пришла новая уставка
+     */
+    bool takeSetpoint(Setpoint& setpoint);
+
+    /**
+     * @brief Метод для получения запроса останова от сторожевого таймера (вызывается из цикла контроллера рядом с
+     *        takeSetpoint(); сам таймер контроллер не вызывает)
+     * @return true если с момента предыдущего вызова пакеты перестали приходить и ось нужно остановить
+     */
+    bool takeTimeout();
+
+    /**
+     * @brief Метод для получения признака активного клиента управления
+     * @return true если пакеты приходят и сторожевой таймер не сработал
+     */
+    bool isClientActive() const;
+
+    /**
+     * @brief Метод для получения статистики канала
+     * @return Статистика
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief Методы для подписи пакетов (используются отправителем и для проверки)
+     * @param packet: Пакет, поле mac заполняется
+     */
+    void sign(SetpointPacket& packet) const { signPacket(packet); }
+    void sign(HelloPacket& packet) const { signPacket(packet); }
+    void sign(SessionPacket& packet) const { signPacket(packet); }
+
+    /**
+     * @brief Метод для проверки подписи ответа с номером сеанса (используется отправителем)
+     * @param packet: Пакет
+     * @return true если подпись верна
+     */
+    bool verify(const SessionPacket& packet) const { return verifyPacket(packet); }
+
+private:
+    static const size_t SHA256_SIZE = 32;
+
+    // Слот уставки с одним писателем (задача приема) и одним читателем (контроллер), seqlock
+    class SetpointSlot
+    {
+    public:
+        void write(const Setpoint& setpoint);
+        bool read(Setpoint& setpoint, uint32_t& version) const;
+
+    private:
+        std::atomic<uint32_t> m_version{0};     // Нечетное значение - идет запись
+        Setpoint m_data;
+    };
+
+    static void rxTask(void* arg);
+    static void watchdogCallback(void* arg);
+
+    /* Разбор принятой датаграммы: уставка в слот или запрос сеанса */
+    void handleDatagram(size_t len, int64_t rxTimeUs, const sockaddr* from, socklen_t fromLen);
+
+    /* Открытие нового сеанса по запросу и отправка ответа */
+    void handleHello(const sockaddr* from, socklen_t fromLen);
+
+    /* Подпись пакета: HMAC всех полей перед mac */
+    template<typename Packet>
+    void signPacket(Packet& packet) const
+    {
+        uint8_t mac[SHA256_SIZE];
+        calcMac(reinterpret_cast<const uint8_t*>(&packet), offsetof(Packet, mac), mac);
+        memcpy(packet.mac, mac, MAC_SIZE);
+    }
+
+    /* Проверка подписи пакета (сравнение за постоянное время) */
+    template<typename Packet>
+    bool verifyPacket(const Packet& packet) const
+    {
+        uint8_t mac[SHA256_SIZE];
+        calcMac(reinterpret_cast<const uint8_t*>(&packet), offsetof(Packet, mac), mac);
+
+        uint8_t diff = 0;
+        for (size_t i = 0; i < MAC_SIZE; ++i)
+            diff |= mac[i] ^ packet.mac[i];
+        return diff == 0;
+    }
+
+    /* Расчет HMAC по предвычисленным внутреннему и внешнему состояниям */
+    void calcMac(const uint8_t* data, size_t len, uint8_t* out) const;
+
+    /* Сравнение номеров последовательности с учетом переполнения */
+    static bool isNewer(uint32_t seq, uint32_t lastSeq);
+
+private:
+    const Config m_config;
+
+    mbedtls_sha256_context m_innerCtx;          // SHA256 после (key ^ ipad)
+    mbedtls_sha256_context m_outerCtx;          // SHA256 после (key ^ opad)
+
+    int m_socket = -1;
+    TaskHandle_t m_rxTask = nullptr;
+    esp_timer_handle_t m_watchdog = nullptr;
+    std::atomic<bool> m_running{false};
+
+    alignas(8) uint8_t m_rxBuf[sizeof(SetpointPacket) + 1];    // +1 для обнаружения слишком длинных датаграмм
+    SetpointSlot m_slot;
+    uint32_t m_readVersion = 0;                 // Версия слота, прочитанная контроллером
+    uint32_t m_session = 0;                     // Номер текущего сеанса (0 - сеанса нет)
+    uint32_t m_lastSeq = 0;                     // Номер последнего принятого пакета
+    uint64_t m_lastSenderTimestampUs = 0;       // Метка времени отправителя последнего принятого пакета
+    std::atomic<int64_t> m_lastRxUs{0};         // Время приема последнего принятого пакета, мкс
+    std::atomic<bool> m_timedOut{true};         // Сторожевой таймер сработал и ждет новых пакетов
+    std::atomic<bool> m_stopRequested{false};   // Останов по таймауту, еще не забранный контроллером
+
+    std::atomic<uint32_t> m_received{0};
+    std::atomic<uint32_t> m_accepted{0};
+    std::atomic<uint32_t> m_badSize{0};
+    std::atomic<uint32_t> m_badHeader{0};
+    std::atomic<uint32_t> m_badMac{0};
+    std::atomic<uint32_t> m_stale{0};
+    std::atomic<uint32_t> m_badSession{0};
+    std::atomic<uint32_t> m_sessions{0};
+    std::atomic<uint32_t> m_timeouts{0};
+    std::atomic<uint32_t> m_lastLatencyUs{0};
+    std::atomic<uint32_t> m_maxLatencyUs{0};
+};
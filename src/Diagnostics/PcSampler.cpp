@@ -0,0 +1,477 @@
+#include "PcSampler.h"
+#include "Http/HttpServer.h"
+#include "Helpers/CorePlacement.h"
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+#include "xtensa_context.h"
+
+// Глубина вложенности прерываний ядра (порт FreeRTOS Xtensa, увеличивается при входе в обработчик)
+extern "C" unsigned port_interruptNesting[portNUM_PROCESSORS];
+#endif
+
+namespace
+{
+    const char* LOG = "PcSampler";      // Канал лога
+
+    const uint32_t TIMER_RESOLUTION_HZ = 1'000'000;     // Разрешение таймеров выборок, Гц
+    const size_t JSON_CHUNK_SIZE = 512;                 // Порция JSON-ответа, байт
+
+    bool isPowerOfTwo(size_t value)
+    {
+        return value != 0 && (value & (value - 1)) == 0;
+    }
+
+    // Чтение целого параметра строки запроса
+    bool getQueryInt(httpd_req_t* req, const char* key, long& value)
+    {
+        char query[64];
+        char text[16];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK
+            || httpd_query_key_value(query, key, text, sizeof(text)) != ESP_OK)
+            return false;
+
+        char* end = nullptr;
+        value = strtol(text, &end, 10);
+        return end != text && *end == '\0';
+    }
+
+    // Накопление JSON-ответа порциями: меньше вызовов отправки на тысячи элементов гистограммы
+    class ChunkWriter
+    {
+    public:
+        explicit ChunkWriter(httpd_req_t* req):
+            m_req(req)
+        {}
+
+        void append(const char* format, ...) __attribute__((format(printf, 2, 3)))
+        {
+            va_list args;
+            va_start(args, format);
+            char item[96];
+            const int len = vsnprintf(item, sizeof(item), format, args);
+            va_end(args);
+            if (len <= 0)
+                return;
+
+            const size_t size = std::min<size_t>(len, sizeof(item) - 1);
+            if (m_used + size > sizeof(m_buf))
+                flush();
+            memcpy(m_buf + m_used, item, size);
+            m_used += size;
+        }
+
+        esp_err_t finish()
+        {
+            flush();
+            return httpd_resp_send_chunk(m_req, nullptr, 0);
+        }
+
+    private:
+        void flush()
+        {
+            if (m_used > 0)
+                httpd_resp_send_chunk(m_req, m_buf, m_used);
+            m_used = 0;
+        }
+
+        httpd_req_t* m_req;
+        char m_buf[JSON_CHUNK_SIZE];
+        size_t m_used = 0;
+    };
+}
+
+PcSampler::PcSampler():
+    PcSampler(Config{})
+{}
+
+PcSampler::PcSampler(const Config& config):
+    m_config(config)
+{
+    m_mutex = xSemaphoreCreateMutex();
+}
+
+PcSampler::~PcSampler()
+{
+    stop();
+    for (CoreState& state : m_cores)
+    {
+        if (state.timer)
+            gptimer_del_timer(state.timer);
+        heap_caps_free(state.ring);
+    }
+    heap_caps_free(m_histogram);
+    vSemaphoreDelete(m_mutex);
+}
+
+esp_err_t PcSampler::start(uint32_t rateHz)
+{
+#if !CONFIG_IDF_TARGET_ARCH_XTENSA
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+    if (rateHz == 0)
+        rateHz = m_config.rateHz;
+    if (rateHz == 0 || rateHz > MAX_RATE_HZ)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    if (m_running || __atomic_load_n(&m_task, __ATOMIC_ACQUIRE) != nullptr)
+    {
+        xSemaphoreGive(m_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = m_histogram ? ESP_OK : init();
+    if (ret != ESP_OK)
+    {
+        xSemaphoreGive(m_mutex);
+        ESP_LOGE(LOG, "Init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Новый сеанс: таймеры остановлены, обработчики прерываний буферы не трогают
+    memset(m_histogram, 0, (m_histogramMask + 1) * sizeof(Entry));
+    m_histogramUsed = 0;
+    m_overflow = 0;
+    m_samples.fill(0);
+    for (CoreState& state : m_cores)
+    {
+        state.tail = state.head;
+        state.isrSamples = 0;
+        state.dropped = 0;
+    }
+
+    m_rateHz = rateHz;
+    m_running = true;
+    if (xTaskCreatePinnedToCore(&PcSampler::drainTask, "pc_sampler", m_config.stackSize, this,
+                                m_config.priority, &m_task, tskNO_AFFINITY) != pdPASS)
+    {
+        m_running = false;
+        m_task = nullptr;
+        xSemaphoreGive(m_mutex);
+        return ESP_ERR_NO_MEM;
+    }
+
+    gptimer_alarm_config_t alarm = {
+        .alarm_count = TIMER_RESOLUTION_HZ / rateHz,
+        .reload_count = 0,
+        .flags = {
+            .auto_reload_on_alarm = true,
+        },
+    };
+    for (size_t core = 0; core < CORES_COUNT && ret == ESP_OK; ++core)
+    {
+        CoreState& state = m_cores[core];
+        ret = gptimer_set_raw_count(state.timer, 0);
+        if (ret == ESP_OK)
+            ret = gptimer_set_alarm_action(state.timer, &alarm);
+        if (ret == ESP_OK)
+            ret = gptimer_enable(state.timer);
+        state.enabled = ret == ESP_OK;
+        if (ret == ESP_OK)
+            ret = gptimer_start(state.timer);
+    }
+
+    if (ret != ESP_OK)
+    {
+        stopTimers();
+        m_running = false;
+        xSemaphoreGive(m_mutex);
+        waitTask();
+        ESP_LOGE(LOG, "Timer start failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    xSemaphoreGive(m_mutex);
+
+    ESP_LOGI(LOG, "Sampling started at %lu Hz per core", static_cast<unsigned long>(rateHz));
+    return ESP_OK;
+}
+
+void PcSampler::stop()
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    const bool running = m_running;
+    stopTimers();
+    m_running = false;
+    xSemaphoreGive(m_mutex);
+
+    // Задача сливает остаток выборок, удаляет себя сама и обнуляет дескриптор
+    waitTask();
+    if (running)
+        ESP_LOGI(LOG, "Sampling stopped");
+}
+
+void PcSampler::registerHttpHandlers(HttpServer& server)
+{
+    httpd_uri_t dumpUri =
+    {
+        .uri = "/sampler",
+        .method = HTTP_GET,
+        .handler = &PcSampler::httpDumpHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(dumpUri) != ESP_OK)
+        ESP_LOGE(LOG, "Register GET /sampler failed");
+
+    httpd_uri_t startUri =
+    {
+        .uri = "/sampler/start",
+        .method = HTTP_POST,
+        .handler = &PcSampler::httpStartHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(startUri) != ESP_OK)
+        ESP_LOGE(LOG, "Register POST /sampler/start failed");
+
+    httpd_uri_t stopUri =
+    {
+        .uri = "/sampler/stop",
+        .method = HTTP_POST,
+        .handler = &PcSampler::httpStopHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(stopUri) != ESP_OK)
+        ESP_LOGE(LOG, "Register POST /sampler/stop failed");
+}
+
+bool IRAM_ATTR PcSampler::alarmCallback(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event, void* arg)
+{
+    auto* state = static_cast<CoreState*>(arg);
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+    // Сам обработчик уже учтен во вложенности (1); больше 1 - прерван другой обработчик
+    if (port_interruptNesting[xPortGetCoreID()] > 1)
+    {
+        ++state->isrSamples;
+        return false;
+    }
+
+    // При входе в невложенное прерывание порт FreeRTOS сохраняет указатель на кадр исключения с регистрами
+    // прерванной задачи в pxTopOfStack - первое поле TCB
+    const auto* frame = *reinterpret_cast<const XtExcFrame* const*>(xTaskGetCurrentTaskHandle());
+    const uint32_t head = state->head;
+    if (head - __atomic_load_n(&state->tail, __ATOMIC_ACQUIRE) > state->mask)
+    {
+        ++state->dropped;
+        return false;
+    }
+    state->ring[head & state->mask] = static_cast<uint32_t>(frame->pc);
+    __atomic_store_n(&state->head, head + 1, __ATOMIC_RELEASE);
+#endif
+    return false;
+}
+
+void PcSampler::drainTask(void* arg)
+{
+    auto* self = static_cast<PcSampler*>(arg);
+    while (self->m_running)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(self->m_config.drainPeriodMs));
+        self->drain();
+    }
+    self->drain();
+
+    __atomic_store_n(&self->m_task, nullptr, __ATOMIC_RELEASE);
+    vTaskDelete(nullptr);
+}
+
+esp_err_t PcSampler::init()
+{
+    if (!isPowerOfTwo(m_config.ringSize) || !isPowerOfTwo(m_config.histogramSize))
+        return ESP_ERR_INVALID_ARG;
+
+    // Буферы пишутся из прерывания - только во внутренней памяти
+    for (CoreState& state : m_cores)
+    {
+        if (!state.ring)
+            state.ring = static_cast<uint32_t*>(heap_caps_malloc(m_config.ringSize * sizeof(uint32_t),
+                                                                 MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        if (!state.ring)
+            return ESP_ERR_NO_MEM;
+        state.mask = m_config.ringSize - 1;
+    }
+
+    // Прерывание таймера назначается ядру, на котором регистрируется обработчик
+    for (size_t core = 0; core < CORES_COUNT; ++core)
+    {
+        if (m_cores[core].timer)
+            continue;
+        esp_err_t ret = ESP_OK;
+        const esp_err_t runRet = CorePlacement::runOnCore(core, [&]() { ret = createTimer(core); }, m_config.priority,
+                                                          m_config.stackSize);
+        if (runRet != ESP_OK)
+            return runRet;
+        if (ret != ESP_OK)
+            return ret;
+    }
+
+    m_histogram = static_cast<Entry*>(heap_caps_calloc(m_config.histogramSize, sizeof(Entry), MALLOC_CAP_DEFAULT));
+    if (!m_histogram)
+        return ESP_ERR_NO_MEM;
+    m_histogramMask = m_config.histogramSize - 1;
+    return ESP_OK;
+}
+
+esp_err_t PcSampler::createTimer(size_t core)
+{
+    gptimer_config_t timerConfig = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMER_RESOLUTION_HZ,
+        .intr_priority = m_config.intrPriority,
+        .flags = {},
+    };
+    gptimer_handle_t timer = nullptr;
+    esp_err_t ret = gptimer_new_timer(&timerConfig, &timer);
+    if (ret != ESP_OK)
+        return ret;
+
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = &PcSampler::alarmCallback,
+    };
+    ret = gptimer_register_event_callbacks(timer, &callbacks, &m_cores[core]);
+    if (ret != ESP_OK)
+    {
+        gptimer_del_timer(timer);
+        return ret;
+    }
+    m_cores[core].timer = timer;
+    return ESP_OK;
+}
+
+void PcSampler::stopTimers()
+{
+    for (CoreState& state : m_cores)
+    {
+        if (!state.enabled)
+            continue;
+        gptimer_stop(state.timer);
+        gptimer_disable(state.timer);
+        state.enabled = false;
+    }
+}
+
+void PcSampler::waitTask()
+{
+    TaskHandle_t task = __atomic_load_n(&m_task, __ATOMIC_ACQUIRE);
+    if (task == nullptr)
+        return;
+
+    xTaskNotifyGive(task);
+    while (__atomic_load_n(&m_task, __ATOMIC_ACQUIRE) != nullptr)
+        vTaskDelay(1);
+}
+
+void PcSampler::drain()
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    for (size_t core = 0; core < CORES_COUNT; ++core)
+    {
+        CoreState& state = m_cores[core];
+        const uint32_t head = __atomic_load_n(&state.head, __ATOMIC_ACQUIRE);
+        for (uint32_t tail = state.tail; tail != head; ++tail)
+            addSample(state.ring[tail & state.mask], core);
+        __atomic_store_n(&state.tail, head, __ATOMIC_RELEASE);
+    }
+    xSemaphoreGive(m_mutex);
+}
+
+void PcSampler::addSample(uint32_t pc, size_t core)
+{
+    // Открытая адресация с линейным пробированием; заполнение не выше 3/4 - поиск всегда завершается
+    uint32_t index = ((pc >> 1) * 2654435761u) & m_histogramMask;
+    for (;;)
+    {
+        Entry& entry = m_histogram[index];
+        if (entry.pc == pc)
+            break;
+        if (entry.pc == 0)
+        {
+            if (m_histogramUsed >= (m_histogramMask + 1) / 4 * 3)
+            {
+                ++m_overflow;
+                return;
+            }
+            entry.pc = pc;
+            ++m_histogramUsed;
+            break;
+        }
+        index = (index + 1) & m_histogramMask;
+    }
+    ++m_histogram[index].counts[core];
+    ++m_samples[core];
+}
+
+esp_err_t PcSampler::httpDumpHandler(httpd_req_t* req)
+{
+    return static_cast<PcSampler*>(req->user_ctx)->sendJson(req);
+}
+
+esp_err_t PcSampler::httpStartHandler(httpd_req_t* req)
+{
+    auto* self = static_cast<PcSampler*>(req->user_ctx);
+
+    // POST /sampler/start[?rate=Hz]
+    long rate = 0;
+    if (getQueryInt(req, "rate", rate) && (rate <= 0 || rate > static_cast<long>(MAX_RATE_HZ)))
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid rate");
+
+    const esp_err_t ret = self->start(static_cast<uint32_t>(rate));
+    switch (ret)
+    {
+    case ESP_OK:
+        return httpd_resp_sendstr(req, "OK");
+    case ESP_ERR_INVALID_STATE:
+        httpd_resp_set_status(req, "409 Conflict");
+        return httpd_resp_sendstr(req, "Already running");
+    default:
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(ret));
+    }
+}
+
+esp_err_t PcSampler::httpStopHandler(httpd_req_t* req)
+{
+    static_cast<PcSampler*>(req->user_ctx)->stop();
+    return httpd_resp_sendstr(req, "OK");
+}
+
+esp_err_t PcSampler::sendJson(httpd_req_t* req)
+{
+    // Гистограмма не меняется во время отправки: выборки копятся в кольцевых буферах
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    httpd_resp_set_type(req, "application/json");
+    ChunkWriter writer(req);
+    writer.append("{\"running\":%s,\"rateHz\":%lu,\"overflow\":%lu,\"cores\":[", m_running ? "true" : "false",
+                  static_cast<unsigned long>(m_rateHz), static_cast<unsigned long>(m_overflow));
+    for (size_t core = 0; core < CORES_COUNT; ++core)
+    {
+        writer.append("%s{\"samples\":%lu,\"isr\":%lu,\"dropped\":%lu}", core ? "," : "",
+                      static_cast<unsigned long>(m_samples[core]),
+                      static_cast<unsigned long>(m_cores[core].isrSamples),
+                      static_cast<unsigned long>(m_cores[core].dropped));
+    }
+
+    // Элемент гистограммы: ["адрес", попаданий на ядре 0, на ядре 1, ...]
+    writer.append("],\"pcs\":[");
+    bool first = true;
+    for (uint32_t i = 0; m_histogram && i <= m_histogramMask; ++i)
+    {
+        const Entry& entry = m_histogram[i];
+        if (entry.pc == 0)
+            continue;
+        writer.append("%s[\"0x%08lx\"", first ? "" : ",", static_cast<unsigned long>(entry.pc));
+        for (uint32_t count : entry.counts)
+            writer.append(",%lu", static_cast<unsigned long>(count));
+        writer.append("]");
+        first = false;
+    }
+    writer.append("]}");
+    const esp_err_t ret = writer.finish();
+    xSemaphoreGive(m_mutex);
+    return ret;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <esp_http_server.h>
+#include <driver/gptimer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <array>
+#include <atomic>
+
+class HttpServer;
+
+// Статистический профилировщик по адресам команд.
+// На каждом ядре свой аппаратный таймер (GPTimer) с повышенным приоритетом прерывания; обработчик прерывания
+// берет адрес прерванной команды (PC) задачи из кадра исключения и кладет его в кольцевой буфер ядра. Фоновая
+// задача сливает буферы в гистограмму "адрес -> количество попаданий по ядрам", которая отдается по HTTP
+// (/sampler) и символизируется на ПК по ELF-файлу прошивки (tools/pc_sampler_fold.py - вход для flame graph).
+//
+// Включается и выключается во время работы. В выключенном состоянии таймеры остановлены, задачи нет - накладных
+// расходов нет; память буферов выделяется при первом запуске.
+//
+// Адрес прерванной команды доступен только на Xtensa (ESP32, ESP32-S3). Попадания во время обработки другого
+// прерывания считаются отдельно (isr) - их PC в кадре задачи не отражает выполняемый код.
+class PcSampler
+{
+public:
+    static const size_t CORES_COUNT = portNUM_PROCESSORS;
+    static const uint32_t MAX_RATE_HZ = 10000;      // Максимальная частота выборок на ядро, Гц
+
+    struct Config
+    {
+        uint32_t rateHz = 1000;                     // Частота выборок на ядро по умолчанию, Гц
+        size_t ringSize = 1024;                     // Размер кольцевого буфера ядра, выборок (степень двойки)
+        size_t histogramSize = 2048;                // Размер гистограммы, различных адресов (степень двойки)
+        uint32_t drainPeriodMs = 50;                // Период слива буферов в гистограмму, мс
+        int intrPriority = 3;                       // Уровень прерывания таймеров (3 - наибольший для обработчиков на C)
+        uint32_t stackSize = 3072;                  // Размер стека задачи слива, байт
+        UBaseType_t priority = 2;                   // Приоритет задачи слива
+    };
+
+    PcSampler();
+    explicit PcSampler(const Config& config);
+    ~PcSampler();
+
+    PcSampler(const PcSampler&) = delete;
+    PcSampler& operator=(const PcSampler&) = delete;
+
+    /**
+     * @brief Метод для запуска выборок (гистограмма очищается)
+     * @param rateHz: Частота выборок на ядро, Гц (0 - из конфигурации)
+     * @return ESP_OK, ESP_ERR_INVALID_STATE если уже запущен, ESP_ERR_NOT_SUPPORTED на архитектуре без кадра
+     *         исключения, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM, ошибки таймера
+     */
+    esp_err_t start(uint32_t rateHz = 0);
+
+    /**
+     * @brief Метод для остановки выборок (гистограмма сохраняется до следующего запуска)
+     */
+    void stop();
+
+    /**
+     * @brief Метод для получения состояния выборок
+     * @return true если выборки идут
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Метод для регистрации обработчиков /sampler (после HttpServer::start())
+     * @param server: HTTP-сервер
+     */
+    void registerHttpHandlers(HttpServer& server);
+
+private:
+    struct CoreState
+    {
+        gptimer_handle_t timer = nullptr;
+        uint32_t* ring = nullptr;                   // Кольцевой буфер PC
+        uint32_t mask = 0;                          // Маска индекса буфера
+        uint32_t head = 0;                          // Запись - только обработчик прерывания
+        uint32_t tail = 0;                          // Чтение - только задача слива
+        bool enabled = false;                       // Таймер включен (gptimer_enable)
+        uint32_t isrSamples = 0;                    // Выборок во время обработки другого прерывания
+        uint32_t dropped = 0;                       // Потеряно из-за переполнения кольцевого буфера
+    };
+
+    struct Entry
+    {
+        uint32_t pc;                                // 0 - свободная ячейка
+        std::array<uint32_t, CORES_COUNT> counts;   // Попадания по ядрам
+    };
+
+    static bool alarmCallback(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event, void* arg);
+    static void drainTask(void* arg);
+    static esp_err_t httpDumpHandler(httpd_req_t* req);
+    static esp_err_t httpStartHandler(httpd_req_t* req);
+    static esp_err_t httpStopHandler(httpd_req_t* req);
+
+    /* Выделение буферов и создание таймеров при первом запуске */
+    esp_err_t init();
+
+    /* Создание таймера ядра (выполняется в задаче, закрепленной за этим ядром) */
+    esp_err_t createTimer(size_t core);
+
+    /* Остановка таймеров всех ядер (под m_mutex) */
+    void stopTimers();
+
+    /* Ожидание завершения задачи слива */
+    void waitTask();
+
+    /* Перенос выборок из кольцевых буферов в гистограмму */
+    void drain();
+
+    /* Учет выборки в гистограмме */
+    void addSample(uint32_t pc, size_t core);
+
+    /* Формирование JSON-ответа с гистограммой (по частям) */
+    esp_err_t sendJson(httpd_req_t* req);
+
+private:
+    const Config m_config;
+    SemaphoreHandle_t m_mutex = nullptr;            // Защищает гистограмму и запуск/остановку
+    TaskHandle_t m_task = nullptr;                  // Задача слива (существует только во время выборок)
+    std::atomic<bool> m_running{false};
+    uint32_t m_rateHz = 0;                          // Частота последнего запуска, Гц
+
+    std::array<CoreState, CORES_COUNT> m_cores = {};
+    std::array<uint32_t, CORES_COUNT> m_samples = {};   // Выборок в гистограмме по ядрам
+    Entry* m_histogram = nullptr;
+    uint32_t m_histogramMask = 0;
+    uint32_t m_histogramUsed = 0;                   // Занято ячеек гистограммы
+    uint32_t m_overflow = 0;                        // Выборки, не поместившиеся в гистограмму
+};
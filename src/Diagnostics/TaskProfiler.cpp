@@ -0,0 +1,364 @@
+#include "TaskProfiler.h"
+#include "Http/HttpServer.h"
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    const char* LOG = "TaskProfiler";   // Канал лога
+
+    const uint32_t STREAM_FRAMES_MAX = 3600;    // Максимум кадров в одном запросе /profiler/stream
+
+    struct HeapDesc
+    {
+        const char* name;
+        uint32_t caps;
+    };
+
+    // Описания куч в порядке TaskProfiler::EnHeap
+    const HeapDesc HEAPS[] =
+    {
+        {"internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT},
+        {"dma", MALLOC_CAP_DMA},
+        {"spiram", MALLOC_CAP_SPIRAM},
+        {"default", MALLOC_CAP_DEFAULT},
+    };
+    static_assert(sizeof(HEAPS) / sizeof(HEAPS[0]) == static_cast<size_t>(TaskProfiler::EnHeap::enCount), "HEAPS must match EnHeap");
+
+    const size_t FRAME_MAX_SIZE = sizeof(TaskProfiler::FrameHeader) + TaskProfiler::CORES_COUNT * sizeof(uint16_t)
+                                + TaskProfiler::TASKS_COUNT * sizeof(TaskProfiler::FrameTask)
+                                + static_cast<size_t>(TaskProfiler::EnHeap::enCount) * sizeof(TaskProfiler::FrameHeap);
+
+    inline uint16_t toPermille(uint64_t part, uint64_t total)
+    {
+        if (total == 0)
+            return 0;
+        const uint64_t permille = (part * 1000 + total / 2) / total;
+        return static_cast<uint16_t>(permille > 1000 ? 1000 : permille);
+    }
+
+    BlockPool::Config framePoolConfig(const TaskProfiler::Config& config)
+    {
+        BlockPool::Config poolConfig;
+        poolConfig.name = "profiler_frames";
+        poolConfig.blockSize = std::max(sizeof(TaskProfiler::Snapshot), FRAME_MAX_SIZE);
+        poolConfig.blocksCount = config.framesCount;
+        return poolConfig;
+    }
+}
+
+TaskProfiler::TaskProfiler():
+    TaskProfiler(Config{})
+{}
+
+TaskProfiler::TaskProfiler(const Config& config):
+    m_config(config),
+    m_framePool(framePoolConfig(config))
+{
+    m_mutex = xSemaphoreCreateMutex();
+}
+
+TaskProfiler::~TaskProfiler()
+{
+    if (m_sampleTimer)
+    {
+        esp_timer_stop(m_sampleTimer);
+        esp_timer_delete(m_sampleTimer);
+    }
+    vSemaphoreDelete(m_mutex);
+}
+
+void TaskProfiler::start()
+{
+#if !TASK_PROFILER_HAS_RUNTIME
+    ESP_LOGW(LOG, "CONFIG_FREERTOS_USE_TRACE_FACILITY/CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS are off, only heaps are sampled");
+#endif
+
+    // Первый снимок сразу: от него считаются доли в следующем
+    sample();
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = &TaskProfiler::sampleTimerCallback,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "task_profiler",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &m_sampleTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(m_sampleTimer, static_cast<uint64_t>(m_config.samplePeriodMs) * 1000));
+}
+
+void TaskProfiler::registerHttpHandlers(HttpServer& server)
+{
+    httpd_uri_t jsonUri =
+    {
+        .uri = "/profiler",
+        .method = HTTP_GET,
+        .handler = &TaskProfiler::httpJsonHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(jsonUri) != ESP_OK)
+        ESP_LOGE(LOG, "Register /profiler failed");
+
+    // Поток держит соединение долго - выполняется в пуле, не блокируя httpd
+    httpd_uri_t streamUri =
+    {
+        .uri = "/profiler/stream",
+        .method = HTTP_GET,
+        .handler = &TaskProfiler::httpStreamHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(streamUri, true) != ESP_OK)
+        ESP_LOGE(LOG, "Register /profiler/stream failed");
+}
+
+void TaskProfiler::getSnapshot(Snapshot& snapshot) const
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    snapshot = m_snapshot;
+    xSemaphoreGive(m_mutex);
+}
+
+void TaskProfiler::sampleTimerCallback(void* arg)
+{
+    static_cast<TaskProfiler*>(arg)->sample();
+}
+
+void TaskProfiler::sample()
+{
+    Snapshot& snapshot = m_work;
+    snapshot.seq = m_snapshot.seq + 1;
+    snapshot.timeUs = esp_timer_get_time();
+    snapshot.periodUs = 0;
+    snapshot.coreLoadPermille.fill(0);
+    snapshot.tasksCount = 0;
+    snapshot.tasksDropped = 0;
+
+#if TASK_PROFILER_HAS_RUNTIME
+    const UBaseType_t tasksTotal = uxTaskGetNumberOfTasks();
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    // При нехватке места uxTaskGetSystemState() не заполняет ничего
+    const UBaseType_t count = tasksTotal <= TASKS_COUNT ? uxTaskGetSystemState(m_status.data(), m_status.size(), &total) : 0;
+    if (count == 0)
+        snapshot.tasksDropped = tasksTotal > 0xFF ? 0xFF : tasksTotal;
+
+    // Счетчики - время esp_timer в мкс, одно на все ядра: разность total - емкость одного ядра за период
+    const configRUN_TIME_COUNTER_TYPE period = m_hasPrev ? total - m_prevTotal : 0;
+    snapshot.periodUs = static_cast<uint32_t>(period);
+
+    for (UBaseType_t i = 0; i < count; ++i)
+    {
+        const TaskStatus_t& status = m_status[i];
+        TaskInfo& info = snapshot.tasks[i];
+
+        strncpy(info.name, status.pcTaskName, NAME_SIZE - 1);
+        info.name[NAME_SIZE - 1] = '\0';
+        info.taskNumber = static_cast<uint16_t>(status.xTaskNumber);
+        info.priority = static_cast<uint8_t>(status.uxCurrentPriority);
+        const BaseType_t coreId = xTaskGetCoreID(status.xHandle);
+        info.coreId = coreId == tskNO_AFFINITY ? -1 : static_cast<int8_t>(coreId);
+        info.stackFreeBytes = status.usStackHighWaterMark;     // StackType_t в ESP-IDF - байт
+
+        // Доля по разности с предыдущим снимком (новые задачи - от нуля)
+        configRUN_TIME_COUNTER_TYPE prevRunTime = 0;
+        for (size_t j = 0; j < m_prevCount; ++j)
+        {
+            if (m_prevRunTime[j].taskNumber == status.xTaskNumber)
+            {
+                prevRunTime = m_prevRunTime[j].runTime;
+                break;
+            }
+        }
+        const configRUN_TIME_COUNTER_TYPE runTime = status.ulRunTimeCounter - prevRunTime;
+        info.cpuPermille = toPermille(runTime, period);
+
+        // Загрузка ядра - все, кроме его задачи IDLE
+        for (size_t core = 0; core < CORES_COUNT; ++core)
+        {
+            if (status.xHandle == xTaskGetIdleTaskHandleForCore(core))
+                snapshot.coreLoadPermille[core] = 1000 - toPermille(runTime, period);
+        }
+    }
+    if (period == 0)
+        snapshot.coreLoadPermille.fill(0);
+    snapshot.tasksCount = static_cast<uint8_t>(count);
+
+    for (UBaseType_t i = 0; i < count; ++i)
+        m_prevRunTime[i] = {m_status[i].xTaskNumber, m_status[i].ulRunTimeCounter};
+    m_prevCount = count;
+    m_prevTotal = total;
+    m_hasPrev = count > 0;
+#endif
+
+    sampleHeaps(snapshot);
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    m_snapshot = snapshot;
+    xSemaphoreGive(m_mutex);
+}
+
+void TaskProfiler::sampleHeaps(Snapshot& snapshot)
+{
+    for (size_t i = 0; i < snapshot.heaps.size(); ++i)
+    {
+        multi_heap_info_t info = {};
+        heap_caps_get_info(&info, HEAPS[i].caps);
+
+        HeapInfo& heap = snapshot.heaps[i];
+        heap.freeBytes = info.total_free_bytes;
+        heap.largestBlock = info.largest_free_block;
+        heap.minFreeBytes = info.minimum_free_bytes;
+        heap.totalBytes = info.total_free_bytes + info.total_allocated_bytes;
+    }
+}
+
+esp_err_t TaskProfiler::httpJsonHandler(httpd_req_t* req)
+{
+    return static_cast<TaskProfiler*>(req->user_ctx)->sendJson(req);
+}
+
+esp_err_t TaskProfiler::httpStreamHandler(httpd_req_t* req)
+{
+    auto* self = static_cast<TaskProfiler*>(req->user_ctx);
+
+    // GET /profiler/stream[?frames=N] - N кадров (по умолчанию 1), по одному на каждый новый снимок
+    uint32_t frames = 1;
+    char query[32];
+    char value[12];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK
+        && httpd_query_key_value(query, "frames", value, sizeof(value)) == ESP_OK)
+    {
+        frames = strtoul(value, nullptr, 10);
+        if (frames == 0 || frames > STREAM_FRAMES_MAX)
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid frames");
+    }
+
+    BlockPool::Ptr<Snapshot> snapshot = self->m_framePool.make<Snapshot>();
+    if (!snapshot)
+    {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_sendstr(req, "Too many profiler requests");
+    }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    uint32_t lastSeq = 0;
+    for (uint32_t sent = 0; sent < frames; )
+    {
+        self->getSnapshot(*snapshot);
+        if (snapshot->seq == lastSeq)
+        {
+            vTaskDelay(pdMS_TO_TICKS(self->m_config.samplePeriodMs / 4 + 1));
+            continue;
+        }
+        lastSeq = snapshot->seq;
+        if (self->sendFrame(req, *snapshot) != ESP_OK)
+            return ESP_FAIL;    // Клиент закрыл соединение или нет буфера кадра
+        ++sent;
+    }
+    return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+esp_err_t TaskProfiler::sendJson(httpd_req_t* req)
+{
+    BlockPool::Ptr<Snapshot> snapshot = m_framePool.make<Snapshot>();
+    if (!snapshot)
+    {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_sendstr(req, "Too many profiler requests");
+    }
+    getSnapshot(*snapshot);
+
+    char buf[160];
+    httpd_resp_set_type(req, "application/json");
+    snprintf(buf, sizeof(buf), "{\"seq\":%lu,\"timeUs\":%lld,\"periodUs\":%lu,\"runtime\":%s,\"tasksDropped\":%u,\"cores\":[",
+             static_cast<unsigned long>(snapshot->seq), static_cast<long long>(snapshot->timeUs),
+             static_cast<unsigned long>(snapshot->periodUs), TASK_PROFILER_HAS_RUNTIME ? "true" : "false",
+             snapshot->tasksDropped);
+    httpd_resp_sendstr_chunk(req, buf);
+
+    for (size_t i = 0; i < CORES_COUNT; ++i)
+    {
+        snprintf(buf, sizeof(buf), "%s%.1f", i ? "," : "", snapshot->coreLoadPermille[i] / 10.);
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+
+    httpd_resp_sendstr_chunk(req, "],\"tasks\":[");
+    for (size_t i = 0; i < snapshot->tasksCount; ++i)
+    {
+        const TaskInfo& task = snapshot->tasks[i];
+        snprintf(buf, sizeof(buf), "%s{\"name\":\"%s\",\"num\":%u,\"prio\":%u,\"core\":%d,\"cpu\":%.1f,\"stackFree\":%lu}",
+                 i ? "," : "", task.name, task.taskNumber, task.priority, task.coreId, task.cpuPermille / 10.,
+                 static_cast<unsigned long>(task.stackFreeBytes));
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+
+    httpd_resp_sendstr_chunk(req, "],\"heaps\":{");
+    for (size_t i = 0; i < snapshot->heaps.size(); ++i)
+    {
+        const HeapInfo& heap = snapshot->heaps[i];
+        snprintf(buf, sizeof(buf), "%s\"%s\":{\"free\":%lu,\"largest\":%lu,\"minFree\":%lu,\"total\":%lu}",
+                 i ? "," : "", HEAPS[i].name, static_cast<unsigned long>(heap.freeBytes),
+                 static_cast<unsigned long>(heap.largestBlock), static_cast<unsigned long>(heap.minFreeBytes),
+                 static_cast<unsigned long>(heap.totalBytes));
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+
+    httpd_resp_sendstr_chunk(req, "}}");
+    return httpd_resp_sendstr_chunk(req, nullptr);
+}
+
+esp_err_t TaskProfiler::sendFrame(httpd_req_t* req, const Snapshot& snapshot)
+{
+    BlockPool::Buffer frame = m_framePool.allocBuffer();
+    if (!frame)
+        return ESP_ERR_NO_MEM;
+
+    FrameHeader header = {
+        .magic = FRAME_MAGIC,
+        .version = FRAME_VERSION,
+        .coresCount = static_cast<uint8_t>(CORES_COUNT),
+        .tasksCount = snapshot.tasksCount,
+        .heapsCount = static_cast<uint8_t>(snapshot.heaps.size()),
+        .seq = snapshot.seq,
+        .timeUs = snapshot.timeUs,
+        .periodUs = snapshot.periodUs,
+    };
+    uint8_t* pos = frame.get();
+    memcpy(pos, &header, sizeof(header));
+    pos += sizeof(header);
+
+    memcpy(pos, snapshot.coreLoadPermille.data(), CORES_COUNT * sizeof(uint16_t));
+    pos += CORES_COUNT * sizeof(uint16_t);
+
+    for (size_t i = 0; i < snapshot.tasksCount; ++i)
+    {
+        const TaskInfo& info = snapshot.tasks[i];
+        FrameTask task = {};
+        memcpy(task.name, info.name, NAME_SIZE);
+        task.taskNumber = info.taskNumber;
+        task.priority = info.priority;
+        task.coreId = info.coreId;
+        task.cpuPermille = info.cpuPermille;
+        task.stackFreeBytes = info.stackFreeBytes;
+        memcpy(pos, &task, sizeof(task));
+        pos += sizeof(task);
+    }
+
+    for (const HeapInfo& info : snapshot.heaps)
+    {
+        const FrameHeap heap = {
+            .freeBytes = info.freeBytes,
+            .largestBlock = info.largestBlock,
+            .minFreeBytes = info.minFreeBytes,
+            .totalBytes = info.totalBytes,
+        };
+        memcpy(pos, &heap, sizeof(heap));
+        pos += sizeof(heap);
+    }
+
+    return httpd_resp_send_chunk(req, reinterpret_cast<const char*>(frame.get()), pos - frame.get());
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <esp_timer.h>
+#include <esp_http_server.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include "BlockPool.h"
+#include <array>
+
+class HttpServer;
+
+// Профилирование загрузки процессора по задачам.
+// Периодически снимает счетчики времени выполнения задач (uxTaskGetSystemState) и по разности с предыдущим
+// снимком считает долю времени ядра, занятую каждой задачей, и загрузку каждого ядра (по задачам IDLE).
+// Заодно снимает минимальный запас стека задач и состояние куч по типам памяти, включая наибольший свободный блок
+// (признак фрагментации). Последний снимок отдается по HTTP в JSON (/profiler) и в компактном двоичном виде
+// потоком кадров (/profiler/stream).
+//
+// Требует CONFIG_FREERTOS_USE_TRACE_FACILITY и CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, без них снимаются только кучи.
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#define TASK_PROFILER_HAS_RUNTIME 1
+#else
+#define TASK_PROFILER_HAS_RUNTIME 0
+#endif
+
+class TaskProfiler
+{
+public:
+    static const size_t TASKS_COUNT = 48;           // Максимальное количество задач в снимке
+    static const size_t NAME_SIZE = 16;             // Размер имени задачи в снимке (с завершающим нулем)
+    static const size_t CORES_COUNT = portNUM_PROCESSORS;
+
+    static const uint32_t FRAME_MAGIC = 0x31465250; // "PRF1"
+    static const uint8_t FRAME_VERSION = 1;
+
+    enum class EnHeap : uint8_t
+    {
+        enInternal,     // Внутренняя память (8-битный доступ)
+        enDma,          // Память, доступная DMA
+        enSpiram,       // Внешняя PSRAM
+        enDefault,      // Память malloc()
+        enCount
+    };
+
+    struct Config
+    {
+        uint32_t samplePeriodMs = 1000;             // Период снимков, мс
+        uint8_t framesCount = 4;                    // Буферов копий снимков и кадров для HTTP (2 на поток, 1 на JSON)
+    };
+
+    struct TaskInfo
+    {
+        char name[NAME_SIZE] = {};
+        uint16_t taskNumber = 0;        // Уникальный номер задачи FreeRTOS
+        uint8_t priority = 0;           // Текущий приоритет
+        int8_t coreId = -1;             // Закрепление за ядром (-1 - не закреплена)
+        uint16_t cpuPermille = 0;       // Доля времени одного ядра за период, промилле
+        uint32_t stackFreeBytes = 0;    // Минимальный запас стека за все время, байт
+    };
+
+    struct HeapInfo
+    {
+        uint32_t freeBytes = 0;         // Свободно, байт
+        uint32_t largestBlock = 0;      // Наибольший свободный блок, байт
+        uint32_t minFreeBytes = 0;      // Минимум свободной памяти за все время, байт
+        uint32_t totalBytes = 0;        // Всего, байт
+    };
+
+    struct Snapshot
+    {
+        uint32_t seq = 0;               // Номер снимка
+        int64_t timeUs = 0;             // Время снимка, мкс
+        uint32_t periodUs = 0;          // Длительность периода, по которому считаны доли, мкс
+        std::array<uint16_t, CORES_COUNT> coreLoadPermille = {};    // Загрузка ядер (кроме IDLE), промилле
+        std::array<TaskInfo, TASKS_COUNT> tasks = {};
+        uint8_t tasksCount = 0;
+        uint8_t tasksDropped = 0;       // Задачи, не поместившиеся в снимок (тогда tasksCount = 0)
+        std::array<HeapInfo, static_cast<size_t>(EnHeap::enCount)> heaps = {};
+    };
+
+    // Двоичный кадр /profiler/stream (little-endian): FrameHeader, coresCount x uint16_t загрузки ядер,
+    // tasksCount x FrameTask, heapsCount x FrameHeap
+    struct __attribute__((packed)) FrameHeader
+    {
+        uint32_t magic;                 // Сигнатура FRAME_MAGIC
+        uint8_t version;                // Версия формата FRAME_VERSION
+        uint8_t coresCount;
+        uint8_t tasksCount;
+        uint8_t heapsCount;
+        uint32_t seq;
+        int64_t timeUs;
+        uint32_t periodUs;
+    };
+
+    struct __attribute__((packed)) FrameTask
+    {
+        char name[NAME_SIZE];
+        uint16_t taskNumber;
+        uint8_t priority;
+        int8_t coreId;
+        uint16_t cpuPermille;
+        uint32_t stackFreeBytes;
+    };
+
+    struct __attribute__((packed)) FrameHeap
+    {
+        uint32_t freeBytes;
+        uint32_t largestBlock;
+        uint32_t minFreeBytes;
+        uint32_t totalBytes;
+    };
+
+    TaskProfiler();
+    explicit TaskProfiler(const Config& config);
+    ~TaskProfiler();
+
+    TaskProfiler(const TaskProfiler&) = delete;
+    TaskProfiler& operator=(const TaskProfiler&) = delete;
+
+    /**
+     * @brief Метод для запуска периодических снимков
+     */
+    void start();
+
+    /**
+     * @brief Метод для регистрации обработчиков /profiler (после HttpServer::start())
+     * @param server: HTTP-сервер
+     */
+    void registerHttpHandlers(HttpServer& server);
+
+    /**
+     * @brief Метод для получения последнего снимка (снимок велик - копируется в память вызывающего, не на стек)
+     * @param snapshot: Снимок
+     */
+    void getSnapshot(Snapshot& snapshot) const;
+
+private:
+#if TASK_PROFILER_HAS_RUNTIME
+    // Счетчик времени выполнения задачи в предыдущем снимке
+    struct RunTime
+    {
+        UBaseType_t taskNumber;
+        configRUN_TIME_COUNTER_TYPE runTime;
+    };
+#endif
+
+    static void sampleTimerCallback(void* arg);
+    static esp_err_t httpJsonHandler(httpd_req_t* req);
+    static esp_err_t httpStreamHandler(httpd_req_t* req);
+
+    /* Снятие снимка */
+    void sample();
+
+    /* Снятие состояния куч */
+    static void sampleHeaps(Snapshot& snapshot);
+
+    /* Формирование JSON-ответа (по частям) */
+    esp_err_t sendJson(httpd_req_t* req);
+
+    /* Отправка снимка одним двоичным кадром */
+    esp_err_t sendFrame(httpd_req_t* req, const Snapshot& snapshot);
+
+private:
+    const Config m_config;
+    esp_timer_handle_t m_sampleTimer = nullptr;
+    SemaphoreHandle_t m_mutex = nullptr;        // Защищает m_snapshot
+
+    Snapshot m_snapshot;                        // Последний снимок
+    Snapshot m_work;                            // Снимок в процессе снятия (только в задаче esp_timer)
+    BlockPool m_framePool;                      // Копии снимков и двоичные кадры для HTTP-ответов
+#if TASK_PROFILER_HAS_RUNTIME
+    std::array<TaskStatus_t, TASKS_COUNT> m_status = {};
+    std::array<RunTime, TASKS_COUNT> m_prevRunTime = {};
+    size_t m_prevCount = 0;
+    configRUN_TIME_COUNTER_TYPE m_prevTotal = 0;
+    bool m_hasPrev = false;
+#endif
+};
@@ -0,0 +1,43 @@
+#include "CorePlacement.h"
+#include "freertos/semphr.h"
+
+namespace CorePlacement
+{
+    esp_err_t runFunctionOnCore(BaseType_t core, void (*fn)(void*), void* arg, UBaseType_t priority, uint32_t stackSize)
+    {
+        // Уже на нужном ядре и без смены приоритета - вызов на месте
+        if (priority == 0 && xTaskGetCoreID(nullptr) == core)
+        {
+            fn(arg);
+            return ESP_OK;
+        }
+
+        struct Call
+        {
+            void (*fn)(void*);
+            void* arg;
+            SemaphoreHandle_t done;
+        };
+        Call call = {fn, arg, xSemaphoreCreateBinary()};
+        if (!call.done)
+            return ESP_ERR_NO_MEM;
+
+        if (priority == 0)
+            priority = uxTaskPriorityGet(nullptr);
+        if (xTaskCreatePinnedToCore([](void* param)
+            {
+                auto* call = static_cast<Call*>(param);
+                call->fn(call->arg);
+                xSemaphoreGive(call->done);
+                vTaskDelete(nullptr);
+            }, "on_core", stackSize, &call, priority, nullptr, core) != pdPASS)
+        {
+            vSemaphoreDelete(call.done);
+            return ESP_ERR_NO_MEM;
+        }
+
+        xSemaphoreTake(call.done, portMAX_DELAY);
+        vSemaphoreDelete(call.done);
+        return ESP_OK;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <esp_err.h>
+#include <esp_intr_alloc.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <type_traits>
+
+// Распределение задач и прерываний по ядрам.
+// Wi-Fi (CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_0), стек TCP/IP, httpd и световые эффекты работают на ядре сети,
+// задачи движения и прерывания периферии движения - на другом ядре, чтобы всплески сетевой нагрузки не сдвигали
+// импульсы и периоды управления. На одноядерных кристаллах оба ядра совпадают.
+//
+// Прерывание периферии ESP-IDF назначается ядру, на котором выполнялась регистрация обработчика (создание
+// объекта драйвера или регистрация обратных вызовов), поэтому периферия движения создается через runOnCore().
+namespace CorePlacement
+{
+    const BaseType_t NETWORK_CORE = 0;                                  // Ядро Wi-Fi, httpd, эффектов
+    const BaseType_t MOTION_CORE = portNUM_PROCESSORS > 1 ? 1 : 0;      // Ядро задач и прерываний движения
+
+    const int MOTION_INTR_PRIORITY = 3;     // Уровень прерываний движения (3 - наибольший для обработчиков на C)
+    const int MOTION_INTR_FLAGS = ESP_INTR_FLAG_LEVEL3 | ESP_INTR_FLAG_IRAM;    // То же для esp_intr_alloc()
+
+    /**
+     * @brief Функция для выполнения функции в задаче, закрепленной за ядром (с ожиданием завершения)
+     * @param core: Ядро
+     * @param fn: Функция
+     * @param arg: Аргумент функции
+     * @param priority: Приоритет задачи (0 - приоритет вызывающей задачи)
+     * @param stackSize: Размер стека задачи, байт
+     * @return ESP_OK или ESP_ERR_NO_MEM, если задачу не удалось создать
+     */
+    esp_err_t runFunctionOnCore(BaseType_t core, void (*fn)(void*), void* arg, UBaseType_t priority = 0,
+                                uint32_t stackSize = 4096);
+
+    /**
+     * @brief Функция для выполнения функционального объекта в задаче, закрепленной за ядром (с ожиданием завершения)
+     * @param core: Ядро
+     * @param fn: Функциональный объект (может ссылаться на локальные переменные вызывающего)
+     * @param priority: Приоритет задачи (0 - приоритет вызывающей задачи)
+     * @param stackSize: Размер стека задачи, байт
+     * @return ESP_OK или ESP_ERR_NO_MEM, если задачу не удалось создать
+     */
+    template<typename Fn>
+    esp_err_t runOnCore(BaseType_t core, Fn&& fn, UBaseType_t priority = 0, uint32_t stackSize = 4096)
+    {
+        using Callable = std::remove_reference_t<Fn>;
+        return runFunctionOnCore(core, [](void* arg) { (*static_cast<Callable*>(arg))(); },
+                                 const_cast<void*>(static_cast<const void*>(&fn)), priority, stackSize);
+    }
+}
@@ -0,0 +1,321 @@
+#include "LedEffectEngine.h"
+#include <esp_log.h>
+#include <cstring>
+
+namespace
+{
+    const char* LOG = "LedEffectEngine";    // Канал лога
+
+    // Деление на 255 с округлением для x <= 255 * 255 (без инструкции деления)
+    inline uint32_t div255(uint32_t x)
+    {
+        return ((x + 128) * 257) >> 16;
+    }
+
+    inline LedEffectEngine::Rgb scale(LedEffectEngine::Rgb color, uint32_t level)
+    {
+        return {static_cast<uint8_t>(div255(color.r * level)),
+                static_cast<uint8_t>(div255(color.g * level)),
+                static_cast<uint8_t>(div255(color.b * level))};
+    }
+
+    inline LedEffectEngine::Rgb mix(LedEffectEngine::Rgb from, LedEffectEngine::Rgb to, uint32_t level)
+    {
+        return {static_cast<uint8_t>(div255(from.r * (255 - level) + to.r * level)),
+                static_cast<uint8_t>(div255(from.g * (255 - level) + to.g * level)),
+                static_cast<uint8_t>(div255(from.b * (255 - level) + to.b * level))};
+    }
+}
+
+LedEffectEngine::LedEffectEngine(led_strip_handle_t strip, const Config& config):
+    m_strip(strip),
+    m_config(config),
+    m_frame(static_cast<size_t>(config.ledsCount) * 3, 0)
+{
+    const esp_timer_create_args_t timerArgs = {
+        .callback = &LedEffectEngine::frameTimerCallback,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "led_frame",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &m_frameTimer));
+}
+
+LedEffectEngine::~LedEffectEngine()
+{
+    stop();
+    esp_timer_delete(m_frameTimer);
+}
+
+bool LedEffectEngine::start()
+{
+    if (m_running)
+        return true;
+
+    m_running = true;
+    if (xTaskCreatePinnedToCore(&LedEffectEngine::renderTask, "led_effects", m_config.stackSize, this,
+                                m_config.priority, &m_task, m_config.coreId) != pdPASS)
+    {
+        ESP_LOGE(LOG, "Render task create failed");
+        m_running = false;
+        return false;
+    }
+
+    esp_timer_start_periodic(m_frameTimer, framePeriodUs());
+    ESP_LOGI(LOG, "Started: %u LEDs, %u fps", m_config.ledsCount, m_config.fps ? m_config.fps : 1);
+    return true;
+}
+
+void LedEffectEngine::stop()
+{
+    if (!m_running)
+        return;
+
+    esp_timer_stop(m_frameTimer);
+    m_running = false;
+    xTaskNotifyGive(m_task);
+
+    // Задача удаляет себя сама и обнуляет дескриптор
+    while (__atomic_load_n(&m_task, __ATOMIC_ACQUIRE) != nullptr)
+        vTaskDelay(1);
+}
+
+void LedEffectEngine::setLayer(uint8_t layer, const Effect& effect)
+{
+    if (layer >= LAYERS_COUNT)
+        return;
+
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&m_lock);
+    m_layers[layer].effect = effect;
+    m_layers[layer].startUs = now;
+    portEXIT_CRITICAL(&m_lock);
+}
+
+void LedEffectEngine::clearLayer(uint8_t layer)
+{
+    setLayer(layer, Effect{});
+}
+
+void LedEffectEngine::setProgress(uint8_t layer, uint16_t progress)
+{
+    if (layer >= LAYERS_COUNT)
+        return;
+
+    portENTER_CRITICAL(&m_lock);
+    m_layers[layer].effect.progress = progress > 1000 ? 1000 : progress;
+    portEXIT_CRITICAL(&m_lock);
+}
+
+LedEffectEngine::Stats LedEffectEngine::getStats() const
+{
+    Stats stats;
+    stats.frames = m_frames;
+    stats.dropped = m_dropped;
+    stats.lastRenderUs = m_lastRenderUs;
+    stats.maxRenderUs = m_maxRenderUs;
+    stats.lastTransmitUs = m_lastTransmitUs;
+    stats.maxTransmitUs = m_maxTransmitUs;
+    return stats;
+}
+
+void LedEffectEngine::frameTimerCallback(void* arg)
+{
+    auto* self = static_cast<LedEffectEngine*>(arg);
+    xTaskNotifyGive(self->m_task);
+}
+
+void LedEffectEngine::renderTask(void* arg)
+{
+    auto* self = static_cast<LedEffectEngine*>(arg);
+
+    while (true)
+    {
+        // Каждое срабатывание таймера - один кадр. Если задача не успела к предыдущим, они пропускаются
+        const uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!self->m_running)
+            break;
+        if (ticks > 1)
+            self->m_dropped += ticks - 1;
+
+        const int64_t startUs = esp_timer_get_time();
+        self->render(startUs);
+        const int64_t renderedUs = esp_timer_get_time();
+        updateTime(self->m_lastRenderUs, self->m_maxRenderUs, static_cast<uint32_t>(renderedUs - startUs));
+
+        // Предыдущий кадр не завершился за свой период - ждем его не дольше, чем осталось до следующего кадра
+        const int64_t nextFrameUs = startUs + self->framePeriodUs();
+        if (self->m_txPending && !self->waitTransmit(nextFrameUs))
+        {
+            ++self->m_dropped;
+            continue;
+        }
+
+        if (led_strip_set_pixels(self->m_strip, 0, self->m_config.ledsCount, self->m_frame.data(), LED_STRIP_COLOR_COMPONENT_FMT_RGB) != ESP_OK)
+        {
+            ++self->m_dropped;
+            continue;
+        }
+        self->m_txStartUs = esp_timer_get_time();
+        if (led_strip_refresh_async(self->m_strip) != ESP_OK)
+        {
+            ++self->m_dropped;
+            continue;
+        }
+        self->m_txPending = true;
+        ++self->m_frames;
+
+        // Завершение ждем сразу после запуска: до следующего кадра задаче все равно нечего делать, а время
+        // передачи отсчитывается до фактического завершения, а не до начала следующего кадра. Если передача
+        // длиннее остатка периода, следующий кадр рисуется параллельно с ней и дожидается ее выше
+        self->waitTransmit(nextFrameUs);
+    }
+
+    if (self->m_txPending)
+    {
+        led_strip_wait_refresh_done(self->m_strip, -1);
+        self->m_txPending = false;
+    }
+    __atomic_store_n(&self->m_task, nullptr, __ATOMIC_RELEASE);
+    vTaskDelete(nullptr);
+}
+
+int64_t LedEffectEngine::framePeriodUs() const
+{
+    return 1'000'000 / (m_config.fps ? m_config.fps : 1);
+}
+
+bool LedEffectEngine::waitTransmit(int64_t deadlineUs)
+{
+    const int64_t leftUs = deadlineUs - esp_timer_get_time();
+    const int32_t waitMs = leftUs > 0 ? static_cast<int32_t>(leftUs / 1000) : 0;
+    if (led_strip_wait_refresh_done(m_strip, waitMs) != ESP_OK)
+        return false;
+
+    // Ожидание возвращается по прерыванию завершения; задержка пробуждения задачи входит в измерение
+    updateTime(m_lastTransmitUs, m_maxTransmitUs, static_cast<uint32_t>(esp_timer_get_time() - m_txStartUs));
+    m_txPending = false;
+    return true;
+}
+
+void LedEffectEngine::render(int64_t nowUs)
+{
+    portENTER_CRITICAL(&m_lock);
+    m_frameLayers = m_layers;
+    portEXIT_CRITICAL(&m_lock);
+
+    std::memset(m_frame.data(), 0, m_frame.size());
+    for (const auto& layer : m_frameLayers)
+    {
+        if (layer.effect.type != EnEffect::enNone && layer.effect.alpha != 0)
+            renderLayer(layer, nowUs);
+    }
+}
+
+void LedEffectEngine::renderLayer(const Layer& layer, int64_t nowUs)
+{
+    const Effect& effect = layer.effect;
+    if (effect.start >= m_config.ledsCount)
+        return;
+
+    const uint32_t maxCount = m_config.ledsCount - effect.start;
+    const uint32_t count = (effect.count == 0 || effect.count > maxCount) ? maxCount : effect.count;
+    const uint32_t periodMs = effect.periodMs ? effect.periodMs : 1;
+    const uint32_t elapsedMs = static_cast<uint32_t>((nowUs - layer.startUs) / 1000);
+    const uint32_t phaseMs = elapsedMs % periodMs;
+    const uint32_t alpha = effect.alpha;
+
+    switch (effect.type)
+    {
+    case EnEffect::enSolid:
+        for (uint32_t i = 0; i < count; ++i)
+            blend(effect.start + i, effect.color, alpha);
+        break;
+
+    case EnEffect::enFade:
+    {
+        const uint32_t level = elapsedMs >= periodMs ? 255 : static_cast<uint32_t>(static_cast<uint64_t>(elapsedMs) * 255 / periodMs);
+        const Rgb color = mix(effect.color2, effect.color, level);
+        for (uint32_t i = 0; i < count; ++i)
+            blend(effect.start + i, color, alpha);
+        break;
+    }
+
+    case EnEffect::enBlink:
+        if (phaseMs * 100 < periodMs * effect.dutyPercent)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                blend(effect.start + i, effect.color, alpha);
+        }
+        break;
+
+    case EnEffect::enPulse:
+    {
+        // Треугольник 0 -> 255 -> 0 за период
+        const uint32_t halfMs = periodMs / 2 ? periodMs / 2 : 1;
+        const uint32_t rampMs = phaseMs < halfMs ? phaseMs : periodMs - phaseMs;
+        const uint32_t level = rampMs >= halfMs ? 255 : rampMs * 255 / halfMs;
+        const Rgb color = scale(effect.color, level);
+        for (uint32_t i = 0; i < count; ++i)
+            blend(effect.start + i, color, alpha);
+        break;
+    }
+
+    case EnEffect::enChase:
+    {
+        // Голова отрезка проходит весь диапазон за период, хвост затухает
+        const uint32_t width = effect.width ? effect.width : 1;
+        const uint32_t head = static_cast<uint32_t>(static_cast<uint64_t>(phaseMs) * count / periodMs);
+        for (uint32_t d = 0; d < width && d < count; ++d)
+        {
+            const uint32_t index = (head + count - d) % count;
+            blend(effect.start + index, scale(effect.color, 255 * (width - d) / width), alpha);
+        }
+        break;
+    }
+
+    case EnEffect::enProgress:
+    {
+        // Заполненная часть, дробный последний светодиод, фон
+        const uint32_t filled = count * effect.progress;
+        const uint32_t full = filled / 1000;
+        const uint32_t partial = (filled % 1000) * 255 / 1000;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Rgb color = effect.color2;
+            if (i < full)
+                color = effect.color;
+            else if (i == full)
+                color = mix(effect.color2, effect.color, partial);
+            blend(effect.start + i, color, alpha);
+        }
+        break;
+    }
+
+    case EnEffect::enNone:
+        break;
+    }
+}
+
+void LedEffectEngine::blend(uint32_t index, Rgb color, uint32_t alpha)
+{
+    uint8_t* pixel = &m_frame[index * 3];
+    if (alpha >= 255)
+    {
+        pixel[0] = color.r;
+        pixel[1] = color.g;
+        pixel[2] = color.b;
+        return;
+    }
+    pixel[0] = static_cast<uint8_t>(div255(pixel[0] * (255 - alpha) + color.r * alpha));
+    pixel[1] = static_cast<uint8_t>(div255(pixel[1] * (255 - alpha) + color.g * alpha));
+    pixel[2] = static_cast<uint8_t>(div255(pixel[2] * (255 - alpha) + color.b * alpha));
+}
+
+void LedEffectEngine::updateTime(std::atomic<uint32_t>& last, std::atomic<uint32_t>& max, uint32_t valueUs)
+{
+    last = valueUs;
+    if (valueUs > max)
+        max = valueUs;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "led_strip.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "CorePlacement.h"
+#include <esp_timer.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Движок световых эффектов для адресной ленты.
+// Низкоприоритетная задача с фиксированной частотой кадров накладывает слои эффектов (нижний слой - 0)
+// в кадровый буфер, запускает передачу и ждет ее завершения не дольше, чем до следующего кадра: если передача
+// длиннее, отрисовка следующего кадра идет параллельно с ней (если лента это поддерживает). Если кадр не
+// укладывается в период, он пропускается, а не задерживает следующие.
+class LedEffectEngine
+{
+public:
+    static const size_t LAYERS_COUNT = 4;           // Количество слоев
+
+    enum class EnEffect : uint8_t
+    {
+        enNone,         // Слой прозрачен
+        enSolid,        // Постоянный цвет
+        enFade,         // Плавный переход от color2 к color за periodMs, затем color
+        enBlink,        // Мигание: color dutyPercent периода, остальное время слой прозрачен
+        enPulse,        // "Дыхание": яркость color меняется по треугольнику с периодом periodMs
+        enChase,        // Бегущий отрезок длиной width, проходит диапазон за periodMs
+        enProgress,     // Индикатор выполнения: заполнено progress / 1000 диапазона
+    };
+
+    struct Rgb
+    {
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+    };
+
+    struct Effect
+    {
+        EnEffect type = EnEffect::enNone;
+        Rgb color = {};                 // Основной цвет
+        Rgb color2 = {};                // Начальный цвет (fade) или фон (progress)
+        uint32_t periodMs = 1000;       // Период (blink, pulse, chase) или длительность (fade), мс
+        uint16_t start = 0;             // Первый светодиод диапазона
+        uint16_t count = 0;             // Количество светодиодов (0 - до конца ленты)
+        uint16_t width = 3;             // Длина бегущего отрезка (chase)
+        uint16_t progress = 0;          // Заполнение, промилле (progress)
+        uint8_t dutyPercent = 50;       // Доля периода во включенном состоянии (blink), %
+        uint8_t alpha = 255;            // Непрозрачность слоя: 0 - прозрачен, 255 - полностью закрывает нижние
+    };
+
+    struct Config
+    {
+        uint16_t ledsCount = 1;                     // Количество светодиодов
+        uint16_t fps = 50;                          // Частота кадров
+        uint32_t stackSize = 3072;                  // Размер стека задачи отрисовки, байт
+        UBaseType_t priority = 1;                   // Приоритет задачи отрисовки (ниже задач движения и сети)
+        BaseType_t coreId = CorePlacement::NETWORK_CORE;    // Ядро задачи отрисовки
+    };
+
+    struct Stats
+    {
+        uint32_t frames = 0;            // Передано кадров
+        uint32_t dropped = 0;           // Пропущено кадров (не уложились в период)
+        uint32_t lastRenderUs = 0;      // Время отрисовки кадра (последнее), мкс
+        uint32_t maxRenderUs = 0;       // Время отрисовки кадра (максимальное), мкс
+        uint32_t lastTransmitUs = 0;    // Время от запуска передачи до ее завершения (последнее), мкс
+        uint32_t maxTransmitUs = 0;     // Время от запуска передачи до ее завершения (максимальное), мкс
+                                        // (включает задержку пробуждения задачи отрисовки)
+    };
+
+    /**
+     * @brief Конструктор
+     * @param strip: Лента (для наложения кадра на время передачи - RMT с flags.double_buffer)
+     * @param config: Параметры движка
+     */
+    LedEffectEngine(led_strip_handle_t strip, const Config& config);
+    ~LedEffectEngine();
+
+    LedEffectEngine(const LedEffectEngine&) = delete;
+    LedEffectEngine& operator=(const LedEffectEngine&) = delete;
+
+    /**
+     * @brief Метод для запуска задачи отрисовки
+     * @return true при успешном запуске
+     */
+    bool start();
+
+    /**
+     * @brief Метод для остановки задачи отрисовки (лента сохраняет последний кадр)
+     */
+    void stop();
+
+    /**
+     * @brief Метод для установки эффекта слоя (время эффекта отсчитывается с момента вызова)
+     * @param layer: Номер слоя (0 - нижний)
+     * @param effect: Эффект
+     */
+    void setLayer(uint8_t layer, const Effect& effect);
+
+    /**
+     * @brief Метод для очистки слоя
+     * @param layer: Номер слоя
+     */
+    void clearLayer(uint8_t layer);
+
+    /**
+     * @brief Метод для обновления заполнения индикатора выполнения без перезапуска эффекта
+     * @param layer: Номер слоя
+     * @param progress: Заполнение, промилле (0 - 1000)
+     */
+    void setProgress(uint8_t layer, uint16_t progress);
+
+    /**
+     * @brief Метод для получения статистики кадров
+     * @return Статистика
+     */
+    Stats getStats() const;
+
+private:
+    struct Layer
+    {
+        Effect effect;
+        int64_t startUs = 0;            // Время установки эффекта, мкс
+    };
+
+    static void renderTask(void* arg);
+    static void frameTimerCallback(void* arg);
+
+    /* Период кадра, мкс */
+    int64_t framePeriodUs() const;
+
+    /* Ожидание завершения передачи не дольше deadlineUs с учетом времени передачи, true - передача завершена */
+    bool waitTransmit(int64_t deadlineUs);
+
+    /* Отрисовка всех слоев в кадровый буфер */
+    void render(int64_t nowUs);
+
+    /* Отрисовка одного слоя */
+    void renderLayer(const Layer& layer, int64_t nowUs);
+
+    /* Наложение цвета на пиксель кадрового буфера с непрозрачностью alpha */
+    void blend(uint32_t index, Rgb color, uint32_t alpha);
+
+    /* Учет времени в статистике */
+    static void updateTime(std::atomic<uint32_t>& last, std::atomic<uint32_t>& max, uint32_t valueUs);
+
+private:
+    const led_strip_handle_t m_strip;
+    const Config m_config;
+
+    mutable portMUX_TYPE m_lock = portMUX_INITIALIZER_UNLOCKED;    // Защищает m_layers
+    std::array<Layer, LAYERS_COUNT> m_layers = {};
+    std::array<Layer, LAYERS_COUNT> m_frameLayers = {};           // Копия слоев для текущего кадра
+    std::vector<uint8_t> m_frame;                                   // Кадровый буфер RGB888
+
+    TaskHandle_t m_task = nullptr;
+    esp_timer_handle_t m_frameTimer = nullptr;
+    std::atomic<bool> m_running{false};
+    bool m_txPending = false;                   // Передача запущена и ее завершение не подтверждено
+    int64_t m_txStartUs = 0;                    // Время запуска передачи, мкс
+
+    std::atomic<uint32_t> m_frames{0};
+    std::atomic<uint32_t> m_dropped{0};
+    std::atomic<uint32_t> m_lastRenderUs{0};
+    std::atomic<uint32_t> m_maxRenderUs{0};
+    std::atomic<uint32_t> m_lastTransmitUs{0};
+    std::atomic<uint32_t> m_maxTransmitUs{0};
+};
@@ -19,6 +19,7 @@ RgbLedController::RgbLedController()
         .clk_src = RMT_CLK_SRC_DEFAULT,
         .resolution_hz = 10000000, // 10MHz
         .mem_block_symbols = 64,
+        .timing = {},
         .flags = {},
     };
 
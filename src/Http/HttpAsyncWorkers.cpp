@@ -0,0 +1,198 @@
+#include "HttpAsyncWorkers.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cstdio>
+
+namespace
+{
+    const char* LOG = "HttpAsyncWorkers";   // Канал лога
+}
+
+HttpAsyncWorkers::HttpAsyncWorkers(const Config& config):
+    m_config(config)
+{
+}
+
+HttpAsyncWorkers::~HttpAsyncWorkers()
+{
+    stop();
+}
+
+bool HttpAsyncWorkers::start()
+{
+    if (m_running)
+        return true;
+
+    m_queue = xQueueCreate(m_config.queueSize, sizeof(Job));
+    if (!m_queue)
+    {
+        ESP_LOGE(LOG, "No mem for queue");
+        return false;
+    }
+
+    m_running = true;
+    m_workers.reserve(m_config.workersCount);
+    for (uint8_t i = 0; i < m_config.workersCount; ++i)
+    {
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "httpd_async_%u", i);
+
+        TaskHandle_t handle = nullptr;
+        if (xTaskCreatePinnedToCore(&HttpAsyncWorkers::workerTask, name, m_config.stackSize, this,
+                                    m_config.priority, &handle, m_config.coreId) != pdPASS)
+        {
+            ESP_LOGE(LOG, "Worker %u create failed", i);
+            stop();
+            return false;
+        }
+        m_workers.push_back(handle);
+    }
+
+    ESP_LOGI(LOG, "Started %u workers, queue size = %u", m_config.workersCount, m_config.queueSize);
+    return true;
+}
+
+void HttpAsyncWorkers::stop()
+{
+    if (!m_queue)
+        return;
+
+    m_running = false;
+
+    // Ожидающие запросы завершаем ответом 503 сразу: иначе при полной очереди сигналы завершения ждали бы,
+    // пока задачи обработают часть ожидающих
+    rejectPending();
+
+    // Пустое задание - сигнал завершения для задачи-обработчика.
+    // Кладем в начало очереди, чтобы задачи завершились не дожидаясь обработки остальных запросов
+    const Job stopJob = {};
+    for (size_t i = 0; i < m_workers.size(); ++i)
+        xQueueSendToFront(m_queue, &stopJob, portMAX_DELAY);
+
+    // Ожидаем завершения всех задач (каждая удаляет себя сама и обнуляет свой слот)
+    for (auto& worker : m_workers)
+    {
+        while (__atomic_load_n(&worker, __ATOMIC_ACQUIRE) != nullptr)
+            vTaskDelay(1);
+    }
+    m_workers.clear();
+
+    // Запросы, поставленные submit() до того, как он увидел остановку
+    rejectPending();
+
+    vQueueDelete(m_queue);
+    m_queue = nullptr;
+}
+
+esp_err_t HttpAsyncWorkers::submit(httpd_req_t* req, esp_err_t (*handler)(httpd_req_t* req), void* ctx)
+{
+    // submit() вызывается только из задачи httpd, поэтому проверка наличия места
+    // и последующая постановка в очередь не могут быть разделены другим производителем
+    if (!m_running || uxQueueSpacesAvailable(m_queue) == 0)
+    {
+        ++m_rejected;
+        return sendOverloaded(req);
+    }
+
+    httpd_req_t* asyncReq = nullptr;
+    esp_err_t err = httpd_req_async_handler_begin(req, &asyncReq);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(LOG, "Async begin failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    const Job job = {
+        .req = asyncReq,
+        .handler = handler,
+        .ctx = ctx,
+        .enqueueTimeUs = esp_timer_get_time(),
+    };
+
+    if (xQueueSend(m_queue, &job, 0) != pdTRUE)
+    {
+        ++m_rejected;
+        sendOverloaded(asyncReq);
+        httpd_req_async_handler_complete(asyncReq);
+        return ESP_OK;
+    }
+
+    ++m_accepted;
+    return ESP_OK;
+}
+
+HttpAsyncWorkers::Stats HttpAsyncWorkers::getStats() const
+{
+    return {
+        .accepted = m_accepted.load(),
+        .rejected = m_rejected.load(),
+        .completed = m_completed.load(),
+        .maxQueueWaitUs = m_maxQueueWaitUs.load(),
+        .maxHandlerUs = m_maxHandlerUs.load(),
+    };
+}
+
+void HttpAsyncWorkers::workerTask(void* arg)
+{
+    auto* self = static_cast<HttpAsyncWorkers*>(arg);
+    const TaskHandle_t current = xTaskGetCurrentTaskHandle();
+
+    Job job;
+    while (xQueueReceive(self->m_queue, &job, portMAX_DELAY) == pdTRUE)
+    {
+        if (!job.req)
+            break;
+
+        const int64_t startUs = esp_timer_get_time();
+        updateMax(self->m_maxQueueWaitUs, static_cast<uint32_t>(startUs - job.enqueueTimeUs));
+
+        job.req->user_ctx = job.ctx;
+        if (job.handler(job.req) != ESP_OK)
+            ESP_LOGW(LOG, "Handler failed: %s", job.req->uri);
+
+        httpd_req_async_handler_complete(job.req);
+
+        updateMax(self->m_maxHandlerUs, static_cast<uint32_t>(esp_timer_get_time() - startUs));
+        ++self->m_completed;
+    }
+
+    // Сообщаем stop() о завершении задачи
+    for (auto& worker : self->m_workers)
+    {
+        if (worker == current)
+            __atomic_store_n(&worker, nullptr, __ATOMIC_RELEASE);
+    }
+    vTaskDelete(nullptr);
+}
+
+void HttpAsyncWorkers::rejectPending()
+{
+    Job job;
+    while (xQueueReceive(m_queue, &job, 0) == pdTRUE)
+    {
+        if (!job.req)
+            continue;
+
+        sendOverloaded(job.req);
+        httpd_req_async_handler_complete(job.req);
+    }
+}
+
+esp_err_t HttpAsyncWorkers::sendOverloaded(httpd_req_t* req)
+{
+    char retryAfter[12];
+    snprintf(retryAfter, sizeof(retryAfter), "%lu", static_cast<unsigned long>(m_config.retryAfterSec));
+
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_hdr(req, "Retry-After", retryAfter);
+    httpd_resp_set_type(req, HTTPD_TYPE_TEXT);
+    return httpd_resp_sendstr(req, "Server busy");
+}
+
+void HttpAsyncWorkers::updateMax(std::atomic<uint32_t>& value, uint32_t sample)
+{
+    uint32_t current = value.load(std::memory_order_relaxed);
+    while (sample > current && !value.compare_exchange_weak(current, sample, std::memory_order_relaxed))
+    {
+    }
+}
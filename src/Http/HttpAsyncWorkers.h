@@ -0,0 +1,103 @@
+#pragma once
+
+#include <esp_http_server.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "Helpers/CorePlacement.h"
+#include <atomic>
+#include <vector>
+
+// Пул задач для асинхронной обработки "долгих" HTTP-запросов.
+// Основная задача httpd только ставит запрос в ограниченную очередь и сразу освобождается,
+// поэтому быстрые маршруты (например, стоп) не ждут завершения медленных.
+class HttpAsyncWorkers
+{
+public:
+    struct Config
+    {
+        uint8_t workersCount = 2;                   // Количество задач-обработчиков
+        uint8_t queueSize = 4;                      // Размер очереди ожидающих запросов
+        uint32_t stackSize = 4096;                  // Размер стека задачи-обработчика, байт
+        UBaseType_t priority = 5;                   // Приоритет задач-обработчиков
+        BaseType_t coreId = CorePlacement::NETWORK_CORE;    // Ядро, к которому привязываются задачи
+        uint32_t retryAfterSec = 1;                 // Значение заголовка Retry-After при перегрузке, с
+    };
+
+    struct Stats
+    {
+        uint32_t accepted = 0;                      // Принято в очередь
+        uint32_t rejected = 0;                      // Отклонено с ответом 503
+        uint32_t completed = 0;                     // Обработано
+        uint32_t maxQueueWaitUs = 0;                // Максимальное время ожидания в очереди, мкс
+        uint32_t maxHandlerUs = 0;                  // Максимальное время работы обработчика, мкс
+    };
+
+    /**
+     * @brief Конструктор
+     * @param config: Параметры пула
+     */
+    explicit HttpAsyncWorkers(const Config& config);
+    ~HttpAsyncWorkers();
+
+    HttpAsyncWorkers(const HttpAsyncWorkers&) = delete;
+    HttpAsyncWorkers& operator=(const HttpAsyncWorkers&) = delete;
+
+    /**
+     * @brief Метод для запуска задач-обработчиков
+     * @return true если все задачи созданы
+     */
+    bool start();
+
+    /**
+     * @brief Метод для остановки задач-обработчиков (запросы в очереди завершаются ответом 503)
+     */
+    void stop();
+
+    /**
+     * @brief Метод для передачи запроса в пул (вызывается из задачи httpd)
+     * @param req: Запрос
+     * @param handler: Обработчик, который будет вызван в задаче пула
+     * @param ctx: Значение user_ctx для копии запроса
+     * @return ESP_OK если запрос принят в очередь или на него отправлен ответ 503
+     */
+    esp_err_t submit(httpd_req_t* req, esp_err_t (*handler)(httpd_req_t* req), void* ctx);
+
+    /**
+     * @brief Метод для получения статистики работы пула
+     * @return Статистика
+     */
+    Stats getStats() const;
+
+private:
+    struct Job
+    {
+        httpd_req_t* req;                           // Копия запроса (httpd_req_async_handler_begin)
+        esp_err_t (*handler)(httpd_req_t* req);     // Обработчик
+        void* ctx;                                  // user_ctx обработчика
+        int64_t enqueueTimeUs;                      // Метка времени постановки в очередь, мкс
+    };
+
+    static void workerTask(void* arg);
+
+    /* Завершение ожидающих в очереди запросов ответом 503 */
+    void rejectPending();
+
+    /* Ответ 503 при перегрузке */
+    esp_err_t sendOverloaded(httpd_req_t* req);
+
+    /* Обновление максимума без блокировок */
+    static void updateMax(std::atomic<uint32_t>& value, uint32_t sample);
+
+private:
+    const Config m_config;
+    QueueHandle_t m_queue = nullptr;
+    std::vector<TaskHandle_t> m_workers;
+    std::atomic<bool> m_running{false};
+
+    std::atomic<uint32_t> m_accepted{0};
+    std::atomic<uint32_t> m_rejected{0};
+    std::atomic<uint32_t> m_completed{0};
+    std::atomic<uint32_t> m_maxQueueWaitUs{0};
+    std::atomic<uint32_t> m_maxHandlerUs{0};
+};
@@ -1,12 +1,25 @@
 #include "HttpServer.h"
+#include "Helpers/CorePlacement.h"
 #include <esp_log.h>
-#include <string>
+#include <cstdio>
 
 static const char* HTTP_S_LOG_TAG = "HTTP_SERVER";
+static const size_t POOLS_COUNT_MAX = 16;  // Максимум пулов в /pools
 
-HttpServer::HttpServer(RgbLedControllerPtr led):
+static BlockPool::Config responsePoolConfig(const HttpAsyncWorkers::Config& asyncConfig)
+{
+    BlockPool::Config config;
+    config.name = "http_response";
+    config.blockSize = HttpServer::RESPONSE_BUFFER_SIZE;
+    config.blocksCount = asyncConfig.workersCount + 1;     // Задачи пула и основная задача httpd
+    return config;
+}
+
+HttpServer::HttpServer(RgbLedControllerPtr led, const HttpAsyncWorkers::Config& asyncConfig):
     m_led(led),
-    m_server(nullptr)
+    m_server(nullptr),
+    m_asyncWorkers(asyncConfig),
+    m_responsePool(responsePoolConfig(asyncConfig))
 {
 }
 
@@ -14,6 +27,14 @@ void HttpServer::start()
 {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.lru_purge_enable = true;
+    config.max_uri_handlers = 24;
+    config.core_id = CorePlacement::NETWORK_CORE;
+    config.global_user_ctx = this;
+    config.global_user_ctx_free_fn = [](void*) {};     // Контекст - сам сервер, httpd его не освобождает
+    config.open_fn = &HttpServer::sessionOpen;
+    if (!m_asyncWorkers.start())
+        ESP_LOGE(HTTP_S_LOG_TAG, "Ошибка запуска пула асинхронных обработчиков");
+
     if (httpd_start(&m_server, &config) == ESP_OK)
     {
         register_handlers();
@@ -23,6 +44,64 @@ void HttpServer::start()
     }
 }
 
+esp_err_t HttpServer::registerUri(const httpd_uri_t& uri, bool async)
+{
+    if (!m_server)
+        return ESP_ERR_INVALID_STATE;
+
+    if (!async)
+        return httpd_register_uri_handler(m_server, &uri);
+
+    // Исходный обработчик и контекст сохраняем в маршруте, а в httpd регистрируем прослойку
+    m_asyncRoutes.push_back(std::make_unique<AsyncRoute>(AsyncRoute{this, uri.handler, uri.user_ctx}));
+    httpd_uri_t asyncUri = uri;
+    asyncUri.handler = &HttpServer::asyncDispatch;
+    asyncUri.user_ctx = m_asyncRoutes.back().get();
+
+    const esp_err_t err = httpd_register_uri_handler(m_server, &asyncUri);
+    if (err != ESP_OK)
+        m_asyncRoutes.pop_back();
+    return err;
+}
+
+esp_err_t HttpServer::recvAll(httpd_req_t* req, void* buf, size_t size)
+{
+    // Таймаут (recv_wait_timeout) считается только подряд: медленный, но живой клиент не отключается
+    size_t received = 0;
+    int timeouts = 0;
+    while (received < size)
+    {
+        const int ret = httpd_req_recv(req, static_cast<char*>(buf) + received, size - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT)
+        {
+            if (++timeouts >= RECV_TIMEOUTS_MAX)
+                return ESP_ERR_TIMEOUT;
+            continue;
+        }
+        if (ret <= 0)
+            return ESP_FAIL;
+        received += ret;
+        timeouts = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t HttpServer::asyncDispatch(httpd_req_t* req)
+{
+    auto* route = static_cast<AsyncRoute*>(req->user_ctx);
+    if (route->server->m_onActivity)
+        route->server->m_onActivity();
+    return route->server->m_asyncWorkers.submit(req, route->handler, route->ctx);
+}
+
+esp_err_t HttpServer::sessionOpen(httpd_handle_t handle, int sockfd)
+{
+    auto* self = static_cast<HttpServer*>(httpd_get_global_user_ctx(handle));
+    if (self->m_onActivity)
+        self->m_onActivity();
+    return ESP_OK;
+}
+
 void HttpServer::register_handlers()
 {
     // Главная страница (/)
@@ -33,11 +112,15 @@ void HttpServer::register_handlers()
         .handler = [](httpd_req_t* req) -> esp_err_t
         {
             auto* self = static_cast<HttpServer*>(req->user_ctx);
-            std::string html = "<html><body><h1>ESP32 LED Control</h1>"
-                               "<p>LED STATE: " + std::string(self->m_led.get() ? "ON" : "OFF") + "</p>"
-                               "<a href='/led/on'>LED ON</a><br>"
-                               "<a href='/led/off'>LED OFF</a></body></html>";
-            httpd_resp_sendstr(req, html.c_str());
+            BlockPool::Buffer html = self->m_responsePool.allocBuffer();
+            if (!html)
+                return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No response buffer");
+            snprintf(reinterpret_cast<char*>(html.get()), RESPONSE_BUFFER_SIZE,
+                     "<html><body><h1>ESP32 LED Control</h1>"
+                     "<p>LED STATE: %s</p>"
+                     "<a href='/led/on'>LED ON</a><br>"
+                     "<a href='/led/off'>LED OFF</a></body></html>", self->m_led.get() ? "ON" : "OFF");
+            httpd_resp_sendstr(req, reinterpret_cast<const char*>(html.get()));
             return ESP_OK;
         },
         .user_ctx = this
@@ -79,4 +162,58 @@ void HttpServer::register_handlers()
         .user_ctx = this
     };
     httpd_register_uri_handler(m_server, &led_off);
+
+    // Статистика пула асинхронных обработчиков (/http/async)
+    httpd_uri_t async_stats =
+    {
+        .uri = "/http/async",
+        .method = HTTP_GET,
+        .handler = [](httpd_req_t* req) -> esp_err_t
+        {
+            auto* self = static_cast<HttpServer*>(req->user_ctx);
+            const HttpAsyncWorkers::Stats stats = self->m_asyncWorkers.getStats();
+            char json[160];
+            snprintf(json, sizeof(json),
+                     "{\"accepted\":%lu,\"rejected\":%lu,\"completed\":%lu,\"max_queue_wait_us\":%lu,\"max_handler_us\":%lu}",
+                     static_cast<unsigned long>(stats.accepted), static_cast<unsigned long>(stats.rejected),
+                     static_cast<unsigned long>(stats.completed), static_cast<unsigned long>(stats.maxQueueWaitUs),
+                     static_cast<unsigned long>(stats.maxHandlerUs));
+            httpd_resp_set_type(req, "application/json");
+            httpd_resp_sendstr(req, json);
+            return ESP_OK;
+        },
+        .user_ctx = this
+    };
+    httpd_register_uri_handler(m_server, &async_stats);
+
+    // Статистика пулов блоков (/pools)
+    httpd_uri_t pools_stats =
+    {
+        .uri = "/pools",
+        .method = HTTP_GET,
+        .handler = [](httpd_req_t* req) -> esp_err_t
+        {
+            BlockPool::Stats stats[POOLS_COUNT_MAX];
+            const size_t count = BlockPool::getAllStats(stats, POOLS_COUNT_MAX);
+
+            char json[200];
+            httpd_resp_set_type(req, "application/json");
+            httpd_resp_sendstr_chunk(req, "[");
+            for (size_t i = 0; i < count && i < POOLS_COUNT_MAX; ++i)
+            {
+                snprintf(json, sizeof(json),
+                         "%s{\"name\":\"%s\",\"block_size\":%lu,\"blocks\":%lu,\"used\":%lu,\"peak\":%lu,"
+                         "\"allocs\":%lu,\"failures\":%lu,\"invalid_frees\":%lu}",
+                         i ? "," : "", stats[i].name, static_cast<unsigned long>(stats[i].blockSize),
+                         static_cast<unsigned long>(stats[i].blocksCount), static_cast<unsigned long>(stats[i].used),
+                         static_cast<unsigned long>(stats[i].peakUsed), static_cast<unsigned long>(stats[i].allocs),
+                         static_cast<unsigned long>(stats[i].failures), static_cast<unsigned long>(stats[i].invalidFrees));
+                httpd_resp_sendstr_chunk(req, json);
+            }
+            httpd_resp_sendstr_chunk(req, "]");
+            return httpd_resp_sendstr_chunk(req, nullptr);
+        },
+        .user_ctx = this
+    };
+    httpd_register_uri_handler(m_server, &pools_stats);
 }
\ No newline at end of file
@@ -2,18 +2,75 @@
 
 #include <esp_http_server.h>
 #include "./Helpers/RgbLedController.h"
+#include "HttpAsyncWorkers.h"
+#include "BlockPool.h"
+#include <functional>
+#include <memory>
+#include <vector>
 
 class HttpServer
 {
 public:
-    HttpServer(RgbLedControllerPtr led);
+    HttpServer(RgbLedControllerPtr led, const HttpAsyncWorkers::Config& asyncConfig = {});
 
     void start();
 
+    /**
+     * @brief Метод для установки обработчика активности клиентов (до start()): вызывается из задачи httpd
+     *        при новом соединении и при каждом асинхронном запросе
+     * @param callback: Обработчик (например WifiPowerPolicy::notifyActivity)
+     */
+    void setActivityCallback(std::function<void()> callback) { m_onActivity = std::move(callback); }
+
+    /**
+     * @brief Метод для регистрации обработчика URI (после start())
+     * @param uri: Описание обработчика
+     * @param async: Если true - обработчик выполняется в пуле задач HttpAsyncWorkers,
+     *               не блокируя основную задачу httpd. При переполнении очереди клиент получает 503
+     * @return Результат регистрации
+     */
+    esp_err_t registerUri(const httpd_uri_t& uri, bool async = false);
+
+    /**
+     * @brief Метод для получения пула буферов ответов (RESPONSE_BUFFER_SIZE байт, по одному на задачу-обработчик)
+     * @return Пул буферов
+     */
+    BlockPool& getResponsePool() { return m_responsePool; }
+
+    static const size_t RESPONSE_BUFFER_SIZE = 1024;    // Размер буфера ответа, байт
+    static const int RECV_TIMEOUTS_MAX = 3;             // Таймаутов приема подряд, после которых клиент отключается
+
+    /**
+     * @brief Метод для приема ровно size байт тела запроса
+     * @param req: Запрос
+     * @param buf: Буфер
+     * @param size: Размер, байт
+     * @return ESP_OK, ESP_ERR_TIMEOUT если данные не приходили RECV_TIMEOUTS_MAX таймаутов подряд,
+     *         ESP_FAIL при закрытии или ошибке соединения
+     */
+    static esp_err_t recvAll(httpd_req_t* req, void* buf, size_t size);
+
 private:
+    struct AsyncRoute
+    {
+        HttpServer* server;                         // Сервер, владеющий пулом
+        esp_err_t (*handler)(httpd_req_t* req);     // Исходный обработчик
+        void* ctx;                                  // Исходный user_ctx
+    };
+
     void register_handlers();
 
+    /* Обработчик-прослойка для асинхронных маршрутов (выполняется в задаче httpd) */
+    static esp_err_t asyncDispatch(httpd_req_t* req);
+
+    /* Обработчик нового соединения (выполняется в задаче httpd) */
+    static esp_err_t sessionOpen(httpd_handle_t handle, int sockfd);
+
 private:
     RgbLedControllerPtr m_led;
     httpd_handle_t m_server;
-};
\ No newline at end of file
+    HttpAsyncWorkers m_asyncWorkers;
+    std::vector<std::unique_ptr<AsyncRoute>> m_asyncRoutes;
+    BlockPool m_responsePool;                       // Буферы ответов: не фрагментируют кучу
+    std::function<void()> m_onActivity;             // Активность клиентов
+};
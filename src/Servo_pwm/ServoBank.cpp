@@ -0,0 +1,625 @@
+#include "ServoBank.h"
+#include <esp_log.h>
+#include <esp_attr.h>
+#include <esp_err.h>
+#include <soc/soc.h>
+#include <hal/ledc_ll.h>
+
+namespace
+{
+    const char* LOG = "ServoBank";      // Канал лога
+
+    // Использование таймеров LEDC группами
+    struct TimerUsage
+    {
+        uint32_t users = 0;
+        uint32_t freqHz = 0;
+        ledc_timer_bit_t dutyResolution = LEDC_TIMER_1_BIT;
+    };
+
+    portMUX_TYPE s_timersLock = portMUX_INITIALIZER_UNLOCKED;
+    TimerUsage s_timers[LEDC_SPEED_MODE_MAX][LEDC_TIMER_MAX];
+    bool s_fadeInstalled = false;
+}
+
+ServoBank::ServoBank(const Config& config):
+    m_config(resolveConfig(config))
+{
+    acquireTimer(m_config);
+
+    // Реальная частота может отличаться от заданной из-за целочисленного делителя
+    uint32_t freqHz = ledc_get_freq(m_config.speedMode, m_config.timer);
+    if (freqHz == 0)
+        freqHz = m_config.freqHz;
+    m_freqHz = freqHz;
+    m_dutyScale = (1ULL << m_config.dutyResolution) * freqHz;
+    ESP_LOGI(LOG, "LEDC timer %d: %lu Hz, %d bit", m_config.timer, static_cast<unsigned long>(freqHz), m_config.dutyResolution);
+
+    m_hasFade = m_config.useHardwareFade && installFade();
+    m_mutex = xSemaphoreCreateMutex();
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = &ServoBank::profileTimerCallback,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "servo_profile",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &m_profileTimer));
+
+    m_running = true;
+    if (xTaskCreatePinnedToCore(&ServoBank::servoTask, "servo_bank", config.stackSize, this,
+                                config.priority, &m_task, config.coreId) != pdPASS)
+    {
+        // Без задачи некому обрабатывать завершения перемещений
+        ESP_LOGE(LOG, "Task create failed, smooth moves are disabled");
+        m_running = false;
+        m_hasFade = false;
+    }
+}
+
+ServoBank::~ServoBank()
+{
+    esp_timer_stop(m_profileTimer);
+    if (m_running)
+    {
+        m_running = false;
+        xTaskNotifyGive(m_task);
+
+        // Задача удаляет себя сама и обнуляет дескриптор
+        while (__atomic_load_n(&m_task, __ATOMIC_ACQUIRE) != nullptr)
+            vTaskDelay(1);
+    }
+    esp_timer_delete(m_profileTimer);
+
+    for (size_t i = 0; i < m_servosCount; ++i)
+    {
+        if (m_servos[i].move == EnMove::enFade)
+            ledc_fade_stop(m_config.speedMode, m_servos[i].channel);
+        ledc_stop(m_config.speedMode, m_servos[i].channel, 0);
+    }
+
+    releaseTimer(m_config.speedMode, m_config.timer);
+    vSemaphoreDelete(m_mutex);
+}
+
+int ServoBank::addServo(gpio_num_t pulsePin)
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    const int channel = m_config.firstChannel + static_cast<int>(m_servosCount);
+    if (m_servosCount >= SERVOS_COUNT || channel >= LEDC_CHANNEL_MAX)
+    {
+        xSemaphoreGive(m_mutex);
+        ESP_LOGE(LOG, "No free LEDC channel for GPIO %d", pulsePin);
+        return -1;
+    }
+
+    // Калибровка по умолчанию: линейная по параметрам группы
+    Calibration calibration;
+    calibration.points[0] = {static_cast<int16_t>(-SPEED_MAX), static_cast<uint16_t>(m_config.pulseStopUs - m_config.pulseDeltaUs)};
+    calibration.points[1] = {static_cast<int16_t>(SPEED_MAX), static_cast<uint16_t>(m_config.pulseStopUs + m_config.pulseDeltaUs)};
+    calibration.pointsCount = 2;
+
+    Servo& servo = m_servos[m_servosCount];
+    servo.channel = static_cast<ledc_channel_t>(channel);
+    buildLut(servo, calibration);
+    servo.duty = servo.stopDuty;
+    servo.pendingDuty = servo.stopDuty;
+
+    // Конфигурация канала LEDC
+    ledc_channel_config_t ledc_ch =
+    {
+        .gpio_num = pulsePin,
+        .speed_mode = m_config.speedMode,
+        .channel = servo.channel,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = m_config.timer,
+        .duty = servo.stopDuty,
+        .hpoint = 0,
+        .sleep_mode = LEDC_SLEEP_MODE_NO_ALIVE_NO_PD,
+        .flags = 0
+    };
+    ESP_ERROR_CHECK(ledc_channel_config(&ledc_ch));
+
+    if (m_hasFade)
+    {
+        ledc_cbs_t callbacks = {
+            .fade_cb = &ServoBank::fadeEndCallback,
+        };
+        ESP_ERROR_CHECK(ledc_cb_register(m_config.speedMode, servo.channel, &callbacks, this));
+    }
+
+    const int index = static_cast<int>(m_servosCount++);
+    xSemaphoreGive(m_mutex);
+    return index;
+}
+
+bool ServoBank::setCalibration(size_t index, const Calibration& calibration)
+{
+    if (index >= m_servosCount || calibration.pointsCount < 2 || calibration.pointsCount > CAL_POINTS_COUNT ||
+        calibration.deadbandPermille >= SPEED_MAX)
+    {
+        ESP_LOGE(LOG, "Invalid calibration of servo %u", static_cast<unsigned>(index));
+        return false;
+    }
+    for (size_t i = 1; i < calibration.pointsCount; ++i)
+    {
+        if (calibration.points[i].speedPermille <= calibration.points[i - 1].speedPermille)
+        {
+            ESP_LOGE(LOG, "Calibration points of servo %u are not ascending", static_cast<unsigned>(index));
+            return false;
+        }
+    }
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    Servo& servo = m_servos[index];
+    cancelMove(index);
+    buildLut(servo, calibration);
+    // Выход на нулевую скорость по новой калибровке
+    stageDuty(index, servo.stopDuty);
+    applyLocked(1U << index);
+    xSemaphoreGive(m_mutex);
+    return true;
+}
+
+ledc_timer_bit_t ServoBank::getDutyResolution() const
+{
+    return m_config.dutyResolution;
+}
+
+size_t ServoBank::getServosCount() const
+{
+    return m_servosCount;
+}
+
+void ServoBank::setSpeed(size_t index, int16_t speedPermille)
+{
+    if (index >= m_servosCount)
+        return;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    cancelMove(index);
+    stageDuty(index, calcDuty(m_servos[index], speedPermille));
+    xSemaphoreGive(m_mutex);
+}
+
+void ServoBank::setSpeeds(const int16_t* speedsPermille, size_t count)
+{
+    if (count > m_servosCount)
+        count = m_servosCount;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < count; ++i)
+    {
+        cancelMove(i);
+        stageDuty(i, calcDuty(m_servos[i], speedsPermille[i]));
+    }
+    xSemaphoreGive(m_mutex);
+}
+
+void ServoBank::apply()
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    applyLocked(~0U);
+    xSemaphoreGive(m_mutex);
+}
+
+bool ServoBank::moveTo(size_t index, int16_t speedPermille, uint32_t durationMs, MoveDoneCallback onDone)
+{
+    if (!m_hasFade)
+    {
+        // Программный профиль из одного отрезка
+        const Segment segment = {speedPermille, durationMs};
+        return moveProfile(index, &segment, 1, std::move(onDone));
+    }
+    if (index >= m_servosCount)
+        return false;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    cancelMove(index);
+    // Непримененная уставка канала теряет смысл
+    m_pendingMask &= ~(1U << index);
+
+    Servo& servo = m_servos[index];
+    servo.pendingDuty = servo.duty;
+    const uint32_t duty = calcDuty(servo, speedPermille);
+    if (!isFadeExact(servo.duty, duty, durationMs))
+    {
+        // Аппаратный шаг ограничен - перемещение длилось бы дольше заданного, выполняем программно
+        xSemaphoreGive(m_mutex);
+        const Segment segment = {speedPermille, durationMs};
+        return moveProfile(index, &segment, 1, std::move(onDone));
+    }
+
+    esp_err_t err = ledc_set_fade_with_time(m_config.speedMode, servo.channel, duty, static_cast<int>(durationMs));
+    if (err == ESP_OK)
+        err = ledc_fade_start(m_config.speedMode, servo.channel, LEDC_FADE_NO_WAIT);
+    if (err != ESP_OK)
+    {
+        servo.pendingDuty = servo.duty;
+        xSemaphoreGive(m_mutex);
+        ESP_LOGE(LOG, "Fade start failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    servo.move = EnMove::enFade;
+    servo.onDone = std::move(onDone);
+    servo.duty = duty;
+    servo.pendingDuty = duty;
+    xSemaphoreGive(m_mutex);
+    return true;
+}
+
+bool ServoBank::moveProfile(size_t index, const Segment* segments, size_t count, MoveDoneCallback onDone)
+{
+    if (index >= m_servosCount || count == 0 || count > SEGMENTS_COUNT || !m_running)
+        return false;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    cancelMove(index);
+
+    Servo& servo = m_servos[index];
+    for (size_t i = 0; i < count; ++i)
+        servo.segments[i] = segments[i];
+    servo.segmentsCount = static_cast<uint8_t>(count);
+    servo.segment = 0;
+    servo.segmentFromDuty = servo.pendingDuty;
+    servo.segmentStartUs = esp_timer_get_time();
+    servo.move = EnMove::enProfile;
+    servo.onDone = std::move(onDone);
+
+    if (!m_profileTimerActive)
+    {
+        m_profileTimerActive = true;
+        esp_timer_start_periodic(m_profileTimer, static_cast<uint64_t>(m_config.profileTickMs) * 1000);
+    }
+    xSemaphoreGive(m_mutex);
+
+    // Первый шаг сразу, не дожидаясь таймера
+    xTaskNotifyGive(m_task);
+    return true;
+}
+
+bool ServoBank::isMoving(size_t index) const
+{
+    if (index >= m_servosCount)
+        return false;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    const bool isMoving = m_servos[index].move != EnMove::enNone;
+    xSemaphoreGive(m_mutex);
+    return isMoving;
+}
+
+uint32_t ServoBank::getDuty(size_t index) const
+{
+    return index < m_servosCount ? m_servos[index].duty : 0;
+}
+
+void ServoBank::servoTask(void* arg)
+{
+    auto* self = static_cast<ServoBank*>(arg);
+    std::array<MoveDoneCallback, SERVOS_COUNT> done;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!self->m_running)
+            break;
+
+        xSemaphoreTake(self->m_mutex, portMAX_DELAY);
+
+        // Завершенные аппаратные перемещения
+        const uint32_t fadeDone = self->m_fadeDoneMask.exchange(0);
+        for (size_t i = 0; i < self->m_servosCount; ++i)
+        {
+            Servo& servo = self->m_servos[i];
+            if ((fadeDone & (1U << i)) && servo.move == EnMove::enFade)
+            {
+                servo.move = EnMove::enNone;
+                done[i] = std::move(servo.onDone);
+                servo.onDone = nullptr;
+            }
+        }
+
+        // Программные профили
+        if (self->m_profileTimerActive && !self->stepProfiles(esp_timer_get_time(), done))
+        {
+            esp_timer_stop(self->m_profileTimer);
+            self->m_profileTimerActive = false;
+        }
+        xSemaphoreGive(self->m_mutex);
+
+        // Обработчики вызываются без захвата, из них можно запускать следующие перемещения
+        for (size_t i = 0; i < done.size(); ++i)
+        {
+            if (done[i])
+            {
+                done[i](i);
+                done[i] = nullptr;
+            }
+        }
+    }
+
+    __atomic_store_n(&self->m_task, nullptr, __ATOMIC_RELEASE);
+    vTaskDelete(nullptr);
+}
+
+void ServoBank::profileTimerCallback(void* arg)
+{
+    auto* self = static_cast<ServoBank*>(arg);
+    xTaskNotifyGive(self->m_task);
+}
+
+bool IRAM_ATTR ServoBank::fadeEndCallback(const ledc_cb_param_t* param, void* arg)
+{
+    auto* self = static_cast<ServoBank*>(arg);
+    if (param->event != LEDC_FADE_END_EVT)
+        return false;
+
+    self->m_fadeDoneMask.fetch_or(1U << (param->channel - self->m_config.firstChannel));
+    BaseType_t taskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(self->m_task, &taskWoken);
+    return taskWoken == pdTRUE;
+}
+
+bool ServoBank::isFadeExact(uint32_t fromDuty, uint32_t toDuty, uint32_t durationMs) const
+{
+    const uint64_t delta = fromDuty > toDuty ? fromDuty - toDuty : toDuty - fromDuty;
+    const uint64_t cycles = static_cast<uint64_t>(durationMs) * m_freqHz / 1000;
+    if (delta == 0 || cycles == 0)
+        return true;
+
+    // LEDC меняет скважность на scale единиц раз в cycle периодов. При большом разрешении (20 бит на 50 Гц)
+    // быстрому перемещению нужен шаг больше LEDC_LL_DUTY_SCALE_MAX, драйвер его урезает, и перемещение
+    // растягивается в разы; очень медленному - больше LEDC_LL_DUTY_CYCLE_MAX периодов на шаг
+    return delta <= cycles * LEDC_LL_DUTY_SCALE_MAX && cycles <= delta * LEDC_LL_DUTY_CYCLE_MAX;
+}
+
+ServoBank::Config ServoBank::resolveConfig(const Config& config)
+{
+    Config resolved = config;
+    if (config.dutyResolution < LEDC_TIMER_BIT_MAX)
+        return resolved;
+
+    // Делитель таймера не может быть меньше 1: 2^разрешение <= частота источника / частота ШИМ
+    uint32_t resolution = ledc_find_suitable_duty_resolution(APB_CLK_FREQ, config.freqHz);
+    if (resolution >= LEDC_TIMER_BIT_MAX)
+        resolution = LEDC_TIMER_BIT_MAX - 1;
+    if (resolution < LEDC_TIMER_1_BIT)
+        resolution = LEDC_TIMER_1_BIT;
+    resolved.dutyResolution = static_cast<ledc_timer_bit_t>(resolution);
+    return resolved;
+}
+
+void ServoBank::acquireTimer(const Config& config)
+{
+    TimerUsage& usage = s_timers[config.speedMode][config.timer];
+
+    portENTER_CRITICAL(&s_timersLock);
+    const bool isFirst = usage.users++ == 0;
+    if (isFirst)
+    {
+        usage.freqHz = config.freqHz;
+        usage.dutyResolution = config.dutyResolution;
+    }
+    const bool isCompatible = usage.freqHz == config.freqHz && usage.dutyResolution == config.dutyResolution;
+    portEXIT_CRITICAL(&s_timersLock);
+
+    if (!isCompatible)
+    {
+        ESP_LOGE(LOG, "LEDC timer %d is already used with %lu Hz, %d bit", config.timer,
+                 static_cast<unsigned long>(usage.freqHz), usage.dutyResolution);
+        ESP_ERROR_CHECK(ESP_ERR_INVALID_STATE);
+    }
+    if (!isFirst)
+        return;
+
+    // Конфигурация таймера LEDC
+    ledc_timer_config_t ledc_timer =
+    {
+        .speed_mode = config.speedMode,
+        .duty_resolution = config.dutyResolution,
+        .timer_num = config.timer,
+        .freq_hz = config.freqHz,
+        .clk_cfg = LEDC_AUTO_CLK,
+        .deconfigure = false
+    };
+    ESP_ERROR_CHECK(ledc_timer_config(&ledc_timer));
+}
+
+void ServoBank::releaseTimer(ledc_mode_t speedMode, ledc_timer_t timer)
+{
+    portENTER_CRITICAL(&s_timersLock);
+    const bool isLast = --s_timers[speedMode][timer].users == 0;
+    portEXIT_CRITICAL(&s_timersLock);
+
+    if (isLast)
+        ledc_timer_pause(speedMode, timer);
+}
+
+bool ServoBank::installFade()
+{
+    portENTER_CRITICAL(&s_timersLock);
+    const bool isInstalled = s_fadeInstalled;
+    s_fadeInstalled = true;
+    portEXIT_CRITICAL(&s_timersLock);
+
+    if (isInstalled)
+        return true;
+
+    // Служба общая для всех групп и не удаляется; прерывание - на ядре, создавшем первую группу
+    const esp_err_t err = ledc_fade_func_install(CorePlacement::MOTION_INTR_FLAGS);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGW(LOG, "LEDC fade install failed (%s), software ramps are used", esp_err_to_name(err));
+        portENTER_CRITICAL(&s_timersLock);
+        s_fadeInstalled = false;
+        portEXIT_CRITICAL(&s_timersLock);
+        return false;
+    }
+    return true;
+}
+
+uint32_t ServoBank::calcDuty(const Servo& servo, int16_t speedPermille)
+{
+    if (speedPermille == 0)
+        return servo.stopDuty;
+
+    const auto& lut = speedPermille > 0 ? servo.forwardLut : servo.reverseLut;
+    const uint32_t speed = speedPermille > 0 ? speedPermille : -static_cast<int32_t>(speedPermille);
+    if (speed >= static_cast<uint32_t>(SPEED_MAX))
+        return lut[CAL_LUT_SIZE - 1];
+
+    const uint32_t k = speed / CAL_LUT_STEP;
+    const int32_t frac = static_cast<int32_t>(speed % CAL_LUT_STEP);
+    const int32_t delta = static_cast<int32_t>(lut[k + 1]) - static_cast<int32_t>(lut[k]);
+    // Округление к ближайшему в обе стороны
+    const int32_t step = (delta * frac + (delta >= 0 ? CAL_LUT_STEP / 2 : -CAL_LUT_STEP / 2)) / CAL_LUT_STEP;
+    return static_cast<uint32_t>(static_cast<int32_t>(lut[k]) + step);
+}
+
+uint32_t ServoBank::calibratedDuty(const Calibration& calibration, int32_t speedPermille) const
+{
+    const CalPoint* points = calibration.points.data();
+    const size_t count = calibration.pointsCount;
+
+    // Импульс в нс по кусочно-линейной таблице, за крайними точками - насыщение
+    int64_t pulseNs = 0;
+    if (speedPermille <= points[0].speedPermille)
+        pulseNs = points[0].pulseUs * 1000LL;
+    else if (speedPermille >= points[count - 1].speedPermille)
+        pulseNs = points[count - 1].pulseUs * 1000LL;
+    else
+    {
+        size_t i = 1;
+        while (speedPermille > points[i].speedPermille)
+            ++i;
+        const CalPoint& p0 = points[i - 1];
+        const CalPoint& p1 = points[i];
+        pulseNs = p0.pulseUs * 1000LL + (static_cast<int64_t>(p1.pulseUs) - p0.pulseUs) * 1000LL *
+                  (speedPermille - p0.speedPermille) / (p1.speedPermille - p0.speedPermille);
+    }
+    return static_cast<uint32_t>((static_cast<uint64_t>(pulseNs) * m_dutyScale + 500'000'000) / 1'000'000'000);
+}
+
+void ServoBank::buildLut(Servo& servo, const Calibration& calibration) const
+{
+    // Команда -> скорость по таблице: ненулевая скорость смещается за зону нечувствительности, затем инверсия
+    const auto tableSpeed = [&calibration](int32_t magnitude, bool isForward)
+    {
+        const int32_t deadband = calibration.deadbandPermille;
+        const int32_t speed = deadband + magnitude * (SPEED_MAX - deadband) / SPEED_MAX;
+        return isForward != calibration.inverted ? speed : -speed;
+    };
+
+    servo.stopDuty = calibratedDuty(calibration, 0);
+    // Точка k = 0 - предел справа/слева от нуля (граница зоны нечувствительности)
+    for (size_t k = 0; k < CAL_LUT_SIZE; ++k)
+    {
+        const int32_t magnitude = static_cast<int32_t>(k) * CAL_LUT_STEP;
+        servo.forwardLut[k] = calibratedDuty(calibration, tableSpeed(magnitude, true));
+        servo.reverseLut[k] = calibratedDuty(calibration, tableSpeed(magnitude, false));
+    }
+}
+
+void ServoBank::stageDuty(size_t index, uint32_t duty)
+{
+    Servo& servo = m_servos[index];
+    servo.pendingDuty = duty;
+    if (servo.pendingDuty != servo.duty)
+        m_pendingMask |= 1U << index;
+    else
+        m_pendingMask &= ~(1U << index);
+}
+
+void ServoBank::applyLocked(uint32_t mask)
+{
+    mask &= m_pendingMask;
+    if (!mask)
+        return;
+
+    // Запись скважностей не меняет выход до защелкивания
+    for (size_t i = 0; i < m_servosCount; ++i)
+    {
+        if (mask & (1U << i))
+            ledc_set_duty(m_config.speedMode, m_servos[i].channel, m_servos[i].pendingDuty);
+    }
+
+    // Защелкивание всех каналов подряд без прерываний: окно - единицы мкс против периода в миллисекунды.
+    // Граница периода внутри окна разделит каналы на два соседних периода; ожидание переполнения таймера
+    // исключило бы это ценой задержки до периода на каждом apply(), поэтому синхронность - наилучшая без ожидания
+    portENTER_CRITICAL(&m_lock);
+    for (size_t i = 0; i < m_servosCount; ++i)
+    {
+        if (mask & (1U << i))
+            ledc_update_duty(m_config.speedMode, m_servos[i].channel);
+    }
+    portEXIT_CRITICAL(&m_lock);
+
+    for (size_t i = 0; i < m_servosCount; ++i)
+    {
+        if (mask & (1U << i))
+            m_servos[i].duty = m_servos[i].pendingDuty;
+    }
+    m_pendingMask &= ~mask;
+}
+
+void ServoBank::cancelMove(size_t index)
+{
+    Servo& servo = m_servos[index];
+    if (servo.move == EnMove::enFade)
+    {
+        // Канал остается на скважности, достигнутой к моменту остановки
+        ledc_fade_stop(m_config.speedMode, servo.channel);
+        m_fadeDoneMask.fetch_and(~(1U << index));
+        servo.duty = ledc_get_duty(m_config.speedMode, servo.channel);
+        servo.pendingDuty = servo.duty;
+    }
+    servo.move = EnMove::enNone;
+    servo.onDone = nullptr;
+}
+
+bool ServoBank::stepProfiles(int64_t nowUs, std::array<MoveDoneCallback, SERVOS_COUNT>& done)
+{
+    bool isActive = false;
+    uint32_t profileMask = 0;
+    for (size_t i = 0; i < m_servosCount; ++i)
+    {
+        Servo& servo = m_servos[i];
+        if (servo.move != EnMove::enProfile)
+            continue;
+        profileMask |= 1U << i;
+
+        // Переход через завершенные отрезки (в том числе нулевой длительности)
+        uint32_t toDuty = calcDuty(servo, servo.segments[servo.segment].speedPermille);
+        int64_t elapsedUs = nowUs - servo.segmentStartUs;
+        int64_t durationUs = static_cast<int64_t>(servo.segments[servo.segment].durationMs) * 1000;
+        while (elapsedUs >= durationUs && servo.segment + 1 < servo.segmentsCount)
+        {
+            servo.segmentStartUs += durationUs;
+            servo.segmentFromDuty = toDuty;
+            ++servo.segment;
+            toDuty = calcDuty(servo, servo.segments[servo.segment].speedPermille);
+            elapsedUs = nowUs - servo.segmentStartUs;
+            durationUs = static_cast<int64_t>(servo.segments[servo.segment].durationMs) * 1000;
+        }
+
+        if (elapsedUs >= durationUs)
+        {
+            stageDuty(i, toDuty);
+            servo.move = EnMove::enNone;
+            done[i] = std::move(servo.onDone);
+            servo.onDone = nullptr;
+            continue;
+        }
+
+        const int64_t from = servo.segmentFromDuty;
+        stageDuty(i, static_cast<uint32_t>(from + (static_cast<int64_t>(toDuty) - from) * elapsedUs / durationUs));
+        isActive = true;
+    }
+
+    // Все программные профили защелкиваются на одной границе периода, уставки остальных каналов ждут apply()
+    applyLocked(profileMask);
+    return isActive;
+}
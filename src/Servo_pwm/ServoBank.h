@@ -0,0 +1,249 @@
+#pragma once
+
+#include "driver/ledc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "Helpers/CorePlacement.h"
+#include <esp_timer.h>
+#include <array>
+#include <atomic>
+#include <functional>
+
+// Группа сервоприводов на общем таймере LEDC.
+// Скважности всех каналов рассчитываются целочисленно по заранее вычисленным коэффициентам, сначала записываются
+// во все каналы, а затем защелкиваются подряд в критической секции. Новое значение применяется аппаратно на границе
+// периода ШИМ (переполнении таймера). Защелкивание занимает единицы мкс против периода в 20 мс, поэтому каналы
+// группы почти всегда переключаются на одном периоде, но это не гарантируется: если переполнение придется на окно
+// защелкивания (вероятность - длительность окна / период, порядка 0,05% при 50 Гц), каналы до него переключатся
+// на период раньше остальных.
+// Таймер LEDC разделяется между группами с одинаковыми параметрами и настраивается один раз.
+//
+// Калибровка: у каждого канала своя кусочно-линейная таблица скорость -> импульс, зона нечувствительности
+// и инверсия. При установке калибровки они сводятся в целочисленные таблицы скважностей с шагом CAL_LUT_STEP
+// промилле, расчет скважности - одна линейная интерполяция независимо от сложности калибровки.
+//
+// Плавные перемещения:
+//  - moveTo() - один отрезок на аппаратном плавном изменении скважности LEDC, процессор не участвует
+//    (если шаг LEDC не позволяет уложиться в заданное время - программно, как moveProfile());
+//  - moveProfile() - несколько отрезков, программно: периодический таймер пересчитывает скважности всех
+//    каналов с активным профилем и защелкивает их вместе.
+// Обработчики завершения вызываются из задачи группы. Новая уставка канала (setSpeed(), moveTo(), moveProfile())
+// отменяет его текущее перемещение без вызова обработчика.
+class ServoBank
+{
+public:
+    static const size_t SERVOS_COUNT = LEDC_CHANNEL_MAX;    // Максимальное количество сервоприводов в группе
+    static const size_t SEGMENTS_COUNT = 8;                 // Максимальное количество отрезков профиля
+    static const int16_t SPEED_MAX = 1000;                  // Скорость, соответствующая максимальному импульсу, промилле
+    static const size_t CAL_POINTS_COUNT = 8;               // Максимальное количество точек калибровки
+    static const int16_t CAL_LUT_STEP = 20;                 // Шаг таблиц скважностей, промилле
+    static const size_t CAL_LUT_SIZE = SPEED_MAX / CAL_LUT_STEP + 1;
+
+    using MoveDoneCallback = std::function<void(size_t index)>;
+
+    struct Config
+    {
+        ledc_mode_t speedMode = LEDC_LOW_SPEED_MODE;        // Группа каналов LEDC
+        ledc_timer_t timer = LEDC_TIMER_0;                  // Таймер LEDC (общий для всех каналов группы)
+        ledc_channel_t firstChannel = LEDC_CHANNEL_0;       // Первый канал LEDC, следующие выделяются по порядку
+        ledc_timer_bit_t dutyResolution = LEDC_TIMER_BIT_MAX;// Разрешение скважности (LEDC_TIMER_BIT_MAX - максимальное для частоты)
+        uint32_t freqHz = 50;                               // Частота ШИМ, Гц
+        uint16_t pulseStopUs = 1500;                        // Импульс остановки, мкс
+        uint16_t pulseDeltaUs = 1000;                       // Диапазон импульса в одну из сторон, мкс
+        bool useHardwareFade = true;                        // moveTo() на аппаратном плавном изменении (иначе программно)
+        uint32_t profileTickMs = 20;                        // Период пересчета программных профилей, мс
+        uint32_t stackSize = 3072;                          // Размер стека задачи группы, байт
+        UBaseType_t priority = 5;                           // Приоритет задачи группы
+        BaseType_t coreId = CorePlacement::MOTION_CORE;     // Ядро задачи группы
+    };
+
+    // Отрезок профиля: линейное изменение скорости от конечной скорости предыдущего отрезка
+    struct Segment
+    {
+        int16_t speedPermille = 0;      // Скорость в конце отрезка, промилле
+        uint32_t durationMs = 0;        // Длительность, мс
+    };
+
+    struct CalPoint
+    {
+        int16_t speedPermille;          // Скорость, промилле
+        uint16_t pulseUs;               // Импульс, мкс
+    };
+
+    // Калибровка сервопривода
+    struct Calibration
+    {
+        std::array<CalPoint, CAL_POINTS_COUNT> points = {};    // Точки по возрастанию скорости (за крайними - насыщение)
+        uint8_t pointsCount = 0;        // Количество точек (не менее 2)
+        uint16_t deadbandPermille = 0;  // Зона нечувствительности: ненулевая скорость начинается с этого значения
+        bool inverted = false;          // Инверсия направления
+    };
+
+    /**
+     * @brief Конструктор
+     * @param config: Параметры группы
+     */
+    explicit ServoBank(const Config& config);
+    ~ServoBank();
+
+    ServoBank(const ServoBank&) = delete;
+    ServoBank& operator=(const ServoBank&) = delete;
+
+    /**
+     * @brief Метод для добавления сервопривода (выход - импульс остановки)
+     * @param pulsePin: Номер пина импульсов
+     * @return Индекс сервопривода в группе или -1, если каналы закончились
+     */
+    int addServo(gpio_num_t pulsePin);
+
+    /**
+     * @brief Метод для установки калибровки сервопривода (по умолчанию - линейная из pulseStopUs и pulseDeltaUs)
+     * @param index: Индекс сервопривода
+     * @param calibration: Калибровка
+     * @return true если калибровка корректна и установлена
+     */
+    bool setCalibration(size_t index, const Calibration& calibration);
+
+    /**
+     * @brief Метод для получения разрешения скважности
+     * @return Разрешение, бит
+     */
+    ledc_timer_bit_t getDutyResolution() const;
+
+    /**
+     * @brief Метод для получения количества сервоприводов
+     * @return Количество
+     */
+    size_t getServosCount() const;
+
+    /**
+     * @brief Метод для задания скорости сервопривода (применяется вызовом apply())
+     * @param index: Индекс сервопривода
+     * @param speedPermille: Скорость, промилле (-SPEED_MAX - SPEED_MAX)
+     */
+    void setSpeed(size_t index, int16_t speedPermille);
+
+    /**
+     * @brief Метод для задания скоростей сервоприводов с 0-го (применяется вызовом apply())
+     * @param speedsPermille: Скорости, промилле
+     * @param count: Количество значений
+     */
+    void setSpeeds(const int16_t* speedsPermille, size_t count);
+
+    /**
+     * @brief Метод для одновременного применения заданных скоростей (на ближайшей границе периода ШИМ)
+     */
+    void apply();
+
+    /**
+     * @brief Метод для плавного изменения скорости за заданное время (сразу, без apply())
+     * @param index: Индекс сервопривода
+     * @param speedPermille: Конечная скорость, промилле
+     * @param durationMs: Длительность, мс
+     * @param onDone: Обработчик завершения (может быть пустым)
+     * @return true при успешном запуске
+     */
+    bool moveTo(size_t index, int16_t speedPermille, uint32_t durationMs, MoveDoneCallback onDone = nullptr);
+
+    /**
+     * @brief Метод для запуска программного профиля из нескольких отрезков (сразу, без apply())
+     * @param index: Индекс сервопривода
+     * @param segments: Отрезки
+     * @param count: Количество отрезков (не более SEGMENTS_COUNT)
+     * @param onDone: Обработчик завершения (может быть пустым)
+     * @return true при успешном запуске
+     */
+    bool moveProfile(size_t index, const Segment* segments, size_t count, MoveDoneCallback onDone = nullptr);
+
+    /**
+     * @brief Метод для получения признака активного перемещения
+     * @param index: Индекс сервопривода
+     * @return true если перемещение не завершено
+     */
+    bool isMoving(size_t index) const;
+
+    /**
+     * @brief Метод для получения текущей (примененной) скважности
+     * @param index: Индекс сервопривода
+     * @return Скважность (во время аппаратного перемещения - конечная)
+     */
+    uint32_t getDuty(size_t index) const;
+
+private:
+    enum class EnMove : uint8_t
+    {
+        enNone,         // Нет перемещения
+        enFade,         // Аппаратное плавное изменение
+        enProfile,      // Программный профиль
+    };
+
+    struct Servo
+    {
+        ledc_channel_t channel = LEDC_CHANNEL_0;
+        uint32_t stopDuty = 0;      // Скважность при нулевой скорости
+        std::array<uint32_t, CAL_LUT_SIZE> forwardLut = {};    // Скважности для скоростей k * CAL_LUT_STEP
+        std::array<uint32_t, CAL_LUT_SIZE> reverseLut = {};    // Скважности для скоростей -k * CAL_LUT_STEP
+        uint32_t duty = 0;          // Примененная скважность
+        uint32_t pendingDuty = 0;   // Заданная скважность
+        EnMove move = EnMove::enNone;
+        MoveDoneCallback onDone;
+        std::array<Segment, SEGMENTS_COUNT> segments = {};
+        uint8_t segmentsCount = 0;
+        uint8_t segment = 0;        // Текущий отрезок профиля
+        uint32_t segmentFromDuty = 0;   // Скважность в начале отрезка
+        int64_t segmentStartUs = 0;     // Начало отрезка, мкс
+    };
+
+    static void servoTask(void* arg);
+    static void profileTimerCallback(void* arg);
+    static bool fadeEndCallback(const ledc_cb_param_t* param, void* arg);
+
+    /* Проверка, что аппаратное плавное изменение уложится в заданное время (шаг и период шага в пределах LEDC) */
+    bool isFadeExact(uint32_t fromDuty, uint32_t toDuty, uint32_t durationMs) const;
+
+    /* Выбор максимального разрешения скважности, если оно не задано */
+    static Config resolveConfig(const Config& config);
+
+    /* Захват/освобождение таймера LEDC (настраивается первым пользователем) */
+    static void acquireTimer(const Config& config);
+    static void releaseTimer(ledc_mode_t speedMode, ledc_timer_t timer);
+
+    /* Однократная установка службы плавного изменения LEDC */
+    static bool installFade();
+
+    /* Расчет скважности по скорости через таблицы калибровки */
+    static uint32_t calcDuty(const Servo& servo, int16_t speedPermille);
+
+    /* Расчет скважности по калибровке (при построении таблиц) */
+    uint32_t calibratedDuty(const Calibration& calibration, int32_t speedPermille) const;
+
+    /* Построение таблиц скважностей по калибровке */
+    void buildLut(Servo& servo, const Calibration& calibration) const;
+
+    /* Методы без захвата m_mutex */
+    void stageDuty(size_t index, uint32_t duty);
+    void applyLocked(uint32_t mask);
+    void cancelMove(size_t index);
+
+    /* Шаг программных профилей, возвращает признак оставшихся активных профилей */
+    bool stepProfiles(int64_t nowUs, std::array<MoveDoneCallback, SERVOS_COUNT>& done);
+
+private:
+    const Config m_config;
+    uint32_t m_freqHz = 0;                  // Реальная частота ШИМ, Гц
+    uint64_t m_dutyScale = 0;               // 2^разрешение * частота: скважность = импульс(мкс) * m_dutyScale / 1e6
+    uint32_t m_pendingMask = 0;             // Каналы с непримененной скважностью
+    bool m_hasFade = false;                 // Служба плавного изменения LEDC установлена
+
+    SemaphoreHandle_t m_mutex = nullptr;    // Защищает m_servos и m_pendingMask
+    portMUX_TYPE m_lock = portMUX_INITIALIZER_UNLOCKED;
+    std::array<Servo, SERVOS_COUNT> m_servos = {};
+    size_t m_servosCount = 0;
+
+    TaskHandle_t m_task = nullptr;
+    esp_timer_handle_t m_profileTimer = nullptr;
+    std::atomic<bool> m_running{false};
+    bool m_profileTimerActive = false;
+    std::atomic<uint32_t> m_fadeDoneMask{0};    // Каналы, завершившие аппаратное перемещение (из прерывания)
+};
@@ -3,6 +3,10 @@
 #include "driver/gpio.h"
 #include "driver/mcpwm_prelude.h"
 
+// Генератор импульсов STEP на MCPWM.
+// Создается на ядре движения (CorePlacement::runOnCore()). Обработчики событий MCPWM не регистрируются, поэтому
+// прерывание группы не выделяется и intr_priority = 0; уровень CorePlacement::MOTION_INTR_PRIORITY (вместе с
+// CONFIG_MCPWM_ISR_IRAM_SAFE) задается, когда появится первый обработчик.
 class StepGenerator
 {
     static const uint32_t MAX_TIMER_RESOLUTION = 1'000'000;
@@ -118,6 +118,11 @@ float StepMotorController::getCurrentSpeed() const
     return m_currentSpeed * m_clbK;
 }
 
+bool StepMotorController::isMoving() const
+{
+    return m_state != EnState::enIdle;
+}
+
 uint32_t StepMotorController::angleToSteps(float angle) const
 {
     return static_cast<uint32_t>(std::round(angle / m_clbK));
@@ -97,6 +97,12 @@ public:
      */
     float getCurrentSpeed() const;
 
+    /**
+     * @brief Метод для получения признака движения
+     * @return true если ось разгоняется, движется или тормозит
+     */
+    bool isMoving() const;
+
 private:
     enum class EnControlMode
     {
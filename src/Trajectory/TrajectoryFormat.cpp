@@ -0,0 +1,251 @@
+#include "TrajectoryFormat.h"
+#include <cmath>
+#ifdef ESP_PLATFORM
+#include <esp_rom_crc.h>
+#endif
+
+namespace TrajectoryFormat
+{
+    namespace
+    {
+        // Первый байт отрезка: биты 0-2 - команда, 3-6 - маска записанных полей, 7 - резерв (0)
+        const uint8_t COMMAND_MASK = 0x07;
+        const uint8_t HAS_POS = 1 << 3;
+        const uint8_t HAS_SPEED = 1 << 4;
+        const uint8_t HAS_ACC = 1 << 5;
+        const uint8_t HAS_DEC = 1 << 6;
+        const uint8_t RESERVED_MASK = 1 << 7;
+
+        // Предел положения: заведомо за пределами реальных перемещений, но точно представим в double
+        const int64_t POS_LIMIT = 1'000'000'000'000'000;
+
+        inline uint64_t zigzag(int64_t value)
+        {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        inline int64_t unzigzag(uint64_t value)
+        {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        inline size_t writeVarint(uint64_t value, uint8_t* out)
+        {
+            size_t size = 0;
+            while (value >= 0x80)
+            {
+                out[size++] = static_cast<uint8_t>(value) | 0x80;
+                value >>= 7;
+            }
+            out[size++] = static_cast<uint8_t>(value);
+            return size;
+        }
+
+        // Перевод в фиксированную точку с насыщением
+        inline int32_t toFixed(float value, int32_t scale)
+        {
+            const double scaled = std::round(static_cast<double>(value) * scale);
+            if (!(scaled > INT32_MIN))
+                return INT32_MIN;
+            if (scaled > INT32_MAX)
+                return INT32_MAX;
+            return static_cast<int32_t>(scaled);
+        }
+
+        inline int64_t toFixed(double value, int32_t scale)
+        {
+            const double scaled = std::round(value * scale);
+            if (!(scaled > -POS_LIMIT))
+                return -POS_LIMIT;
+            if (scaled > POS_LIMIT)
+                return POS_LIMIT;
+            return static_cast<int64_t>(scaled);
+        }
+    }
+
+    uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size)
+    {
+#ifdef ESP_PLATFORM
+        return esp_rom_crc32_le(crc, data, size);
+#else
+        // Полубайтовая таблица: достаточно для утилиты на ПК, на устройстве считает ПЗУ
+        static const uint32_t TABLE[16] =
+        {
+            0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+            0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+        };
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = TABLE[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+            crc = TABLE[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+        }
+        return ~crc;
+#endif
+    }
+
+    bool isValidHeader(const Header& header, size_t maxDataSize)
+    {
+        return header.magic == MAGIC
+            && header.version == VERSION
+            && header.reserved[0] == 0 && header.reserved[1] == 0 && header.reserved[2] == 0
+            && header.dataSize <= maxDataSize
+            && header.segmentsCount <= header.dataSize / 2;     // Отрезок занимает не менее 2 байт
+    }
+
+    size_t Encoder::encode(const Segment& segment, uint8_t* out)
+    {
+        const int64_t pos = toFixed(segment.targetPos, POS_SCALE);
+        const int32_t speed = toFixed(segment.targetSpeed, SPEED_SCALE);
+        const int32_t acc = toFixed(segment.acceleration, SPEED_SCALE);
+        const int32_t dec = toFixed(segment.deceleration, SPEED_SCALE);
+
+        uint8_t head = static_cast<uint8_t>(segment.command) & COMMAND_MASK;
+        size_t size = 1;
+        size += writeVarint(segment.dtMs, out + size);
+
+        if (pos != m_pos)
+        {
+            head |= HAS_POS;
+            size += writeVarint(zigzag(pos - m_pos), out + size);
+            m_pos = pos;
+        }
+        if (speed != m_speed)
+        {
+            head |= HAS_SPEED;
+            size += writeVarint(zigzag(static_cast<int64_t>(speed) - m_speed), out + size);
+            m_speed = speed;
+        }
+        if (acc != m_acc)
+        {
+            head |= HAS_ACC;
+            size += writeVarint(zigzag(static_cast<int64_t>(acc) - m_acc), out + size);
+            m_acc = acc;
+        }
+        if (dec != m_dec)
+        {
+            head |= HAS_DEC;
+            size += writeVarint(zigzag(static_cast<int64_t>(dec) - m_dec), out + size);
+            m_dec = dec;
+        }
+
+        out[0] = head;
+        return size;
+    }
+
+    void Encoder::reset()
+    {
+        m_pos = 0;
+        m_speed = 0;
+        m_acc = 0;
+        m_dec = 0;
+    }
+
+    Decoder::Decoder(const uint8_t* data, size_t size):
+        m_data(data),
+        m_size(size)
+    {}
+
+    bool Decoder::next(Segment& segment)
+    {
+        if (m_error || m_offset >= m_size)
+            return false;
+
+        const uint8_t head = m_data[m_offset++];
+        const uint8_t command = head & COMMAND_MASK;
+        uint64_t dtMs = 0;
+        if ((head & RESERVED_MASK) || command >= static_cast<uint8_t>(EnCommand::enCount)
+            || !readVarint(dtMs) || dtMs > UINT32_MAX)
+        {
+            m_error = true;
+            return false;
+        }
+
+        // Разности складываются в 64 битах и проверяются на выход за диапазон полей
+        int64_t delta = 0;
+        if (head & HAS_POS)
+        {
+            if (!readSigned(delta))
+                return false;
+            if (delta < -2 * POS_LIMIT || delta > 2 * POS_LIMIT)
+            {
+                m_error = true;
+                return false;
+            }
+            m_pos += delta;
+            if (m_pos < -POS_LIMIT || m_pos > POS_LIMIT)
+            {
+                m_error = true;
+                return false;
+            }
+        }
+        const struct
+        {
+            uint8_t flag;
+            int32_t* value;
+        } fields[] = {{HAS_SPEED, &m_speed}, {HAS_ACC, &m_acc}, {HAS_DEC, &m_dec}};
+        for (const auto& field : fields)
+        {
+            if (!(head & field.flag))
+                continue;
+            if (!readSigned(delta))
+                return false;
+            const int64_t value = *field.value + delta;
+            if (value < INT32_MIN || value > INT32_MAX)
+            {
+                m_error = true;
+                return false;
+            }
+            *field.value = static_cast<int32_t>(value);
+        }
+
+        segment.command = static_cast<EnCommand>(command);
+        segment.dtMs = static_cast<uint32_t>(dtMs);
+        segment.targetPos = static_cast<double>(m_pos) / POS_SCALE;
+        segment.targetSpeed = static_cast<float>(m_speed) / SPEED_SCALE;
+        segment.acceleration = static_cast<float>(m_acc) / SPEED_SCALE;
+        segment.deceleration = static_cast<float>(m_dec) / SPEED_SCALE;
+        return true;
+    }
+
+    void Decoder::reset()
+    {
+        m_offset = 0;
+        m_error = false;
+        m_pos = 0;
+        m_speed = 0;
+        m_acc = 0;
+        m_dec = 0;
+    }
+
+    bool Decoder::isError() const
+    {
+        return m_error;
+    }
+
+    bool Decoder::readVarint(uint64_t& value)
+    {
+        value = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7)
+        {
+            if (m_offset >= m_size)
+                break;
+            const uint8_t byte = m_data[m_offset++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        // Обрыв данных или слишком длинное значение
+        m_error = true;
+        return false;
+    }
+
+    bool Decoder::readSigned(int64_t& value)
+    {
+        uint64_t raw = 0;
+        if (!readVarint(raw))
+            return false;
+        value = unzigzag(raw);
+        return true;
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Двоичный формат траектории.
+// Файл: заголовок Header, затем отрезки подряд. Значения хранятся в фиксированной точке (TrajectoryFormat::*_SCALE)
+// разностями от предыдущего отрезка, упакованными в varint (zigzag для знаковых). Первый байт отрезка - команда
+// и маска изменившихся полей: неизменные поля не записываются. Отрезок обычно занимает 3-10 байт против 32 байт структуры Segment.
+// Декодер разбирает отрезки прямо из исходного буфера (в том числе из отображенной в память флеш-памяти) без копий.
+//
+// Этот файл и TrajectoryFormat.cpp не зависят от ESP-IDF и собираются также в утилиту tools/trajectory_tool.cpp.
+namespace TrajectoryFormat
+{
+    const uint32_t MAGIC = 0x314A5254;                  // "TRJ1"
+    const uint8_t VERSION = 1;
+
+    const int32_t POS_SCALE = 1000;                     // Единиц положения в 1 град
+    const int32_t SPEED_SCALE = 1000;                   // Единиц скорости/ускорения в 1 град/с (град/с²)
+
+    enum class EnCommand : uint8_t
+    {
+        enSpeed = 0,        // Управление по скорости
+        enPosition = 1,     // Управление по положению
+        enSoftStop = 2,     // Плавный останов
+        enHardStop = 3,     // Мгновенный останов
+        enCount
+    };
+
+    // Заголовок (little-endian)
+    struct __attribute__((packed)) Header
+    {
+        uint32_t magic;                 // Сигнатура MAGIC
+        uint8_t version;                // Версия формата VERSION
+        uint8_t reserved[3];            // Резерв, должен быть 0
+        uint32_t segmentsCount;         // Количество отрезков
+        uint32_t dataSize;              // Размер данных отрезков, байт
+        uint32_t durationMs;            // Суммарная длительность, мс
+        uint32_t crc;                   // CRC-32 данных отрезков (как zlib crc32)
+    };
+
+    // Отрезок траектории: уставка, применяемая через dtMs после предыдущей
+    struct Segment
+    {
+        EnCommand command = EnCommand::enSoftStop;
+        uint32_t dtMs = 0;              // Задержка от предыдущего отрезка, мс
+        double targetPos = 0.;          // Целевое положение, град
+        float targetSpeed = 0.f;        // Целевая скорость, град/с
+        float acceleration = 0.f;       // Ускорение, град/с²
+        float deceleration = 0.f;       // Замедление, град/с²
+    };
+
+    const size_t SEGMENT_MAX_SIZE = 1 + 5 + 10 + 3 * 5;    // Максимальный размер закодированного отрезка, байт
+
+    /**
+     * @brief Функция для расчета CRC-32 (можно продолжать с результата предыдущего вызова)
+     * @param crc: Предыдущее значение (0 для начала)
+     * @param data: Данные
+     * @param size: Размер данных, байт
+     * @return Новое значение
+     */
+    uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size);
+
+    /**
+     * @brief Функция для проверки заголовка
+     * @param header: Заголовок
+     * @param maxDataSize: Максимально допустимый размер данных, байт
+     * @return true если заголовок корректен
+     */
+    bool isValidHeader(const Header& header, size_t maxDataSize);
+
+    // Кодировщик отрезков (хранит предыдущий отрезок для разностей)
+    class Encoder
+    {
+    public:
+        /**
+         * @brief Метод для кодирования отрезка
+         * @param segment: Отрезок
+         * @param out: Буфер не менее SEGMENT_MAX_SIZE байт
+         * @return Размер закодированного отрезка, байт
+         */
+        size_t encode(const Segment& segment, uint8_t* out);
+
+        /**
+         * @brief Метод для начала новой траектории
+         */
+        void reset();
+
+    private:
+        int64_t m_pos = 0;
+        int32_t m_speed = 0;
+        int32_t m_acc = 0;
+        int32_t m_dec = 0;
+    };
+
+    // Декодер отрезков из непрерывного буфера
+    class Decoder
+    {
+    public:
+        /**
+         * @brief Конструктор
+         * @param data: Данные отрезков (буфер должен жить, пока используется декодер)
+         * @param size: Размер данных, байт
+         */
+        Decoder(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Метод для получения следующего отрезка
+         * @param segment: Отрезок
+         * @return true если отрезок получен, false - конец данных или ошибка (см. isError())
+         */
+        bool next(Segment& segment);
+
+        /**
+         * @brief Метод для возврата к началу траектории
+         */
+        void reset();
+
+        /**
+         * @brief Метод для получения признака ошибки формата
+         * @return true если данные повреждены
+         */
+        bool isError() const;
+
+    private:
+        /* Чтение беззнакового/знакового varint */
+        bool readVarint(uint64_t& value);
+        bool readSigned(int64_t& value);
+
+    private:
+        const uint8_t* const m_data;
+        const size_t m_size;
+        size_t m_offset = 0;
+        bool m_error = false;
+
+        int64_t m_pos = 0;
+        int32_t m_speed = 0;
+        int32_t m_acc = 0;
+        int32_t m_dec = 0;
+    };
+}
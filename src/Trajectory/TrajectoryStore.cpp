@@ -0,0 +1,577 @@
+#include "TrajectoryStore.h"
+#include "Http/HttpServer.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    const char* LOG = "TrajectoryStore";    // Канал лога
+
+    const size_t UPLOAD_CHUNK_SIZE = 512;   // Порция загрузки по HTTP, байт
+
+    using TrajectoryFormat::Header;
+
+    // Чтение целого параметра строки запроса
+    bool getQueryInt(httpd_req_t* req, const char* key, long& value)
+    {
+        char query[64];
+        char text[16];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK
+            || httpd_query_key_value(query, key, text, sizeof(text)) != ESP_OK)
+            return false;
+
+        char* end = nullptr;
+        value = strtol(text, &end, 10);
+        return end != text && *end == '\0';
+    }
+}
+
+TrajectoryStore::TrajectoryStore(SegmentHandler handler):
+    TrajectoryStore(std::move(handler), Config{})
+{}
+
+TrajectoryStore::TrajectoryStore(SegmentHandler handler, const Config& config):
+    m_config(config),
+    m_handler(std::move(handler))
+{
+    m_mutex = xSemaphoreCreateMutex();
+
+    m_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, m_config.partitionLabel);
+    if (!m_partition)
+    {
+        ESP_LOGE(LOG, "Partition '%s' not found", m_config.partitionLabel);
+        return;
+    }
+    if (m_config.slotSize == 0 || m_config.slotSize % m_partition->erase_size != 0
+        || m_config.slotSize <= sizeof(Header))
+    {
+        ESP_LOGE(LOG, "Slot size %lu is not a multiple of erase size %lu",
+                 static_cast<unsigned long>(m_config.slotSize), static_cast<unsigned long>(m_partition->erase_size));
+        m_partition = nullptr;
+        return;
+    }
+    ESP_LOGI(LOG, "Partition '%s': %u slots of %lu bytes", m_config.partitionLabel,
+             static_cast<unsigned>(getSlotsCount()), static_cast<unsigned long>(m_config.slotSize));
+}
+
+TrajectoryStore::~TrajectoryStore()
+{
+    stop();
+    abortRecord();
+    vSemaphoreDelete(m_mutex);
+}
+
+size_t TrajectoryStore::getSlotsCount() const
+{
+    return m_partition ? m_partition->size / m_config.slotSize : 0;
+}
+
+TrajectoryStore::SlotInfo TrajectoryStore::getSlotInfo(size_t slot) const
+{
+    SlotInfo info;
+    Header header;
+    if (slot >= getSlotsCount()
+        || esp_partition_read(m_partition, slotOffset(slot), &header, sizeof(header)) != ESP_OK
+        || !TrajectoryFormat::isValidHeader(header, slotCapacity()))
+        return info;
+
+    info.valid = true;
+    info.segmentsCount = header.segmentsCount;
+    info.dataSize = header.dataSize;
+    info.durationMs = header.durationMs;
+    return info;
+}
+
+esp_err_t TrajectoryStore::erase(size_t slot)
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    esp_err_t ret = checkWritable(slot);
+    if (ret == ESP_OK)
+        ret = esp_partition_erase_range(m_partition, slotOffset(slot), m_config.slotSize);
+    xSemaphoreGive(m_mutex);
+    return ret;
+}
+
+esp_err_t TrajectoryStore::beginRecord(size_t slot)
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    esp_err_t ret = checkWritable(slot);
+    if (ret == ESP_OK && m_recordSlot >= 0)
+        ret = ESP_ERR_INVALID_STATE;
+    if (ret == ESP_OK)
+        ret = esp_partition_erase_range(m_partition, slotOffset(slot), m_config.slotSize);
+    if (ret == ESP_OK)
+    {
+        m_recordSlot = static_cast<int>(slot);
+        m_encoder.reset();
+        m_recordBufferUsed = 0;
+        m_recordHeader = {};
+        m_recordHeader.magic = TrajectoryFormat::MAGIC;
+        m_recordHeader.version = TrajectoryFormat::VERSION;
+        m_lastRecordUs = esp_timer_get_time();
+    }
+    xSemaphoreGive(m_mutex);
+    return ret;
+}
+
+esp_err_t TrajectoryStore::record(const Segment& segment)
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    esp_err_t ret = ESP_OK;
+    if (m_recordSlot < 0)
+        ret = ESP_ERR_INVALID_STATE;
+    else if (m_recordBufferUsed + TrajectoryFormat::SEGMENT_MAX_SIZE > RECORD_BUFFER_SIZE)
+        ret = flushRecord();
+
+    if (ret == ESP_OK)
+    {
+        // Кодировщик меняет состояние, только если отрезок поместился в слот
+        TrajectoryFormat::Encoder encoder = m_encoder;
+        const size_t size = encoder.encode(segment, m_recordBuffer + m_recordBufferUsed);
+        if (m_recordHeader.dataSize + m_recordBufferUsed + size > slotCapacity())
+        {
+            ret = ESP_ERR_NO_MEM;
+        }
+        else
+        {
+            m_encoder = encoder;
+            m_recordBufferUsed += size;
+            ++m_recordHeader.segmentsCount;
+            m_recordHeader.durationMs += segment.dtMs;
+            ++m_recorded;
+        }
+    }
+    xSemaphoreGive(m_mutex);
+    return ret;
+}
+
+esp_err_t TrajectoryStore::recordLive(const Segment& segment)
+{
+    const int64_t nowUs = esp_timer_get_time();
+    Segment stamped = segment;
+    stamped.dtMs = static_cast<uint32_t>((nowUs - m_lastRecordUs) / 1000);
+    // Остаток миллисекунды переносится на следующий отрезок, чтобы длительность не накапливала ошибку
+    m_lastRecordUs += static_cast<int64_t>(stamped.dtMs) * 1000;
+    return record(stamped);
+}
+
+esp_err_t TrajectoryStore::endRecord()
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    esp_err_t ret = m_recordSlot < 0 ? ESP_ERR_INVALID_STATE : flushRecord();
+    if (ret == ESP_OK)
+        ret = esp_partition_write(m_partition, slotOffset(m_recordSlot), &m_recordHeader, sizeof(m_recordHeader));
+    if (ret == ESP_OK)
+        ESP_LOGI(LOG, "Recorded slot %d: %lu segments, %lu bytes, %lu ms", m_recordSlot,
+                 static_cast<unsigned long>(m_recordHeader.segmentsCount), static_cast<unsigned long>(m_recordHeader.dataSize),
+                 static_cast<unsigned long>(m_recordHeader.durationMs));
+    else
+        ++m_errors;
+    m_recordSlot = -1;
+    xSemaphoreGive(m_mutex);
+    return ret;
+}
+
+void TrajectoryStore::abortRecord()
+{
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    m_recordSlot = -1;
+    xSemaphoreGive(m_mutex);
+}
+
+esp_err_t TrajectoryStore::play(size_t slot, uint32_t loops)
+{
+    if (slot >= getSlotsCount())
+        return ESP_ERR_INVALID_ARG;
+
+    stop();
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    if (m_recordSlot == static_cast<int>(slot) || m_uploadSlot == static_cast<int>(slot))
+    {
+        xSemaphoreGive(m_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Заголовок читается отдельно, отображается только занятая часть слота
+    Header header;
+    esp_err_t ret = esp_partition_read(m_partition, slotOffset(slot), &header, sizeof(header));
+    if (ret == ESP_OK && !TrajectoryFormat::isValidHeader(header, slotCapacity()))
+        ret = ESP_ERR_NOT_FOUND;
+
+    const void* mapped = nullptr;
+    esp_partition_mmap_handle_t mapHandle = 0;
+    if (ret == ESP_OK)
+        ret = esp_partition_mmap(m_partition, slotOffset(slot), sizeof(header) + header.dataSize,
+                                 ESP_PARTITION_MMAP_DATA, &mapped, &mapHandle);
+
+    const uint8_t* data = static_cast<const uint8_t*>(mapped) + sizeof(header);
+    if (ret == ESP_OK && TrajectoryFormat::crc32(0, data, header.dataSize) != header.crc)
+    {
+        esp_partition_munmap(mapHandle);
+        ret = ESP_ERR_INVALID_CRC;
+    }
+
+    if (ret == ESP_OK)
+    {
+        m_mapHandle = mapHandle;
+        m_playData = data;
+        m_playSize = header.dataSize;
+        m_playLoops = loops;
+        m_playSlot = static_cast<int>(slot);
+        m_running = true;
+        if (xTaskCreatePinnedToCore(&TrajectoryStore::playTask, "trajectory", m_config.stackSize, this,
+                                    m_config.priority, &m_task, m_config.coreId) != pdPASS)
+        {
+            m_running = false;
+            m_playSlot = -1;
+            m_task = nullptr;
+            esp_partition_munmap(mapHandle);
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    xSemaphoreGive(m_mutex);
+
+    if (ret != ESP_OK)
+        ESP_LOGE(LOG, "Play slot %u failed: %s", static_cast<unsigned>(slot), esp_err_to_name(ret));
+    return ret;
+}
+
+void TrajectoryStore::stop()
+{
+    m_running = false;
+    TaskHandle_t task = __atomic_load_n(&m_task, __ATOMIC_ACQUIRE);
+    if (task == nullptr)
+        return;
+
+    // Из обработчика отрезка (задача воспроизведения) ждать самих себя нельзя - достаточно флага
+    if (task == xTaskGetCurrentTaskHandle())
+        return;
+
+    xTaskNotifyGive(task);
+    waitPlayTask();
+}
+
+bool TrajectoryStore::isPlaying() const
+{
+    return m_playSlot >= 0;
+}
+
+void TrajectoryStore::registerHttpHandlers(HttpServer& server)
+{
+    httpd_uri_t getUri =
+    {
+        .uri = "/trajectory",
+        .method = HTTP_GET,
+        .handler = &TrajectoryStore::httpGetHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(getUri) != ESP_OK)
+        ESP_LOGE(LOG, "Register GET /trajectory failed");
+
+    // Загрузка стирает слот и пишет во флеш-память - выполняется в пуле, не блокируя httpd
+    httpd_uri_t uploadUri =
+    {
+        .uri = "/trajectory",
+        .method = HTTP_POST,
+        .handler = &TrajectoryStore::httpUploadHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(uploadUri, true) != ESP_OK)
+        ESP_LOGE(LOG, "Register POST /trajectory failed");
+
+    httpd_uri_t playUri =
+    {
+        .uri = "/trajectory/play",
+        .method = HTTP_POST,
+        .handler = &TrajectoryStore::httpPlayHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(playUri) != ESP_OK)
+        ESP_LOGE(LOG, "Register POST /trajectory/play failed");
+
+    httpd_uri_t stopUri =
+    {
+        .uri = "/trajectory/stop",
+        .method = HTTP_POST,
+        .handler = &TrajectoryStore::httpStopHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(stopUri) != ESP_OK)
+        ESP_LOGE(LOG, "Register POST /trajectory/stop failed");
+}
+
+TrajectoryStore::Stats TrajectoryStore::getStats() const
+{
+    Stats stats;
+    stats.recorded = m_recorded;
+    stats.uploads = m_uploads;
+    stats.played = m_played;
+    stats.loops = m_loops;
+    stats.errors = m_errors;
+    stats.maxLateUs = m_maxLateUs;
+    return stats;
+}
+
+void TrajectoryStore::playTask(void* arg)
+{
+    auto* self = static_cast<TrajectoryStore*>(arg);
+
+    TrajectoryFormat::Decoder decoder(self->m_playData, self->m_playSize);
+    Segment segment;
+    int64_t dueUs = esp_timer_get_time();
+
+    for (uint32_t loop = 0; self->m_running && (self->m_playLoops == 0 || loop < self->m_playLoops); ++loop)
+    {
+        decoder.reset();
+        while (self->m_running && decoder.next(segment))
+        {
+            // Время отрезков отсчитывается от начала, а не от фактического вызова - ошибки не накапливаются
+            dueUs += static_cast<int64_t>(segment.dtMs) * 1000;
+            const int64_t waitUs = dueUs - esp_timer_get_time();
+            if (waitUs > 0)
+            {
+                // С округлением вверх до тика: отрезок не применяется раньше времени
+                const TickType_t ticks = (waitUs + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+                ulTaskNotifyTake(pdTRUE, ticks);
+                if (!self->m_running)
+                    break;
+            }
+            else
+            {
+                const uint32_t lateUs = static_cast<uint32_t>(-waitUs);
+                if (lateUs > self->m_maxLateUs)
+                    self->m_maxLateUs = lateUs;
+            }
+
+            self->m_handler(segment);
+            ++self->m_played;
+        }
+
+        if (decoder.isError())
+        {
+            ESP_LOGE(LOG, "Slot %d is corrupted", self->m_playSlot.load());
+            ++self->m_errors;
+            break;
+        }
+        if (self->m_running)
+            ++self->m_loops;
+    }
+
+    esp_partition_munmap(self->m_mapHandle);
+    self->m_playData = nullptr;
+    self->m_playSlot = -1;
+    self->m_running = false;
+
+    __atomic_store_n(&self->m_task, nullptr, __ATOMIC_RELEASE);
+    vTaskDelete(nullptr);
+}
+
+esp_err_t TrajectoryStore::httpGetHandler(httpd_req_t* req)
+{
+    auto* self = static_cast<TrajectoryStore*>(req->user_ctx);
+    char buf[128];
+
+    httpd_resp_set_type(req, "application/json");
+    snprintf(buf, sizeof(buf), "{\"slotSize\":%lu,\"playing\":%d,\"slots\":[",
+             static_cast<unsigned long>(self->m_config.slotSize), self->m_playSlot.load());
+    httpd_resp_sendstr_chunk(req, buf);
+
+    for (size_t i = 0; i < self->getSlotsCount(); ++i)
+    {
+        const SlotInfo info = self->getSlotInfo(i);
+        snprintf(buf, sizeof(buf), "%s{\"valid\":%s,\"segments\":%lu,\"size\":%lu,\"durationMs\":%lu}", i ? "," : "",
+                 info.valid ? "true" : "false", static_cast<unsigned long>(info.segmentsCount),
+                 static_cast<unsigned long>(info.dataSize), static_cast<unsigned long>(info.durationMs));
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+
+    const Stats stats = self->getStats();
+    snprintf(buf, sizeof(buf), "],\"recorded\":%lu,\"uploads\":%lu,\"played\":%lu,\"loops\":%lu,\"errors\":%lu,\"maxLateUs\":%lu}",
+             static_cast<unsigned long>(stats.recorded), static_cast<unsigned long>(stats.uploads),
+             static_cast<unsigned long>(stats.played), static_cast<unsigned long>(stats.loops),
+             static_cast<unsigned long>(stats.errors), static_cast<unsigned long>(stats.maxLateUs));
+    httpd_resp_sendstr_chunk(req, buf);
+    return httpd_resp_sendstr_chunk(req, nullptr);
+}
+
+esp_err_t TrajectoryStore::httpUploadHandler(httpd_req_t* req)
+{
+    auto* self = static_cast<TrajectoryStore*>(req->user_ctx);
+
+    // POST /trajectory?slot=N, тело - файл траектории (заголовок + отрезки)
+    long slot = 0;
+    if (!getQueryInt(req, "slot", slot) || slot < 0 || static_cast<size_t>(slot) >= self->getSlotsCount())
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid slot");
+
+    const esp_err_t ret = self->upload(req, static_cast<size_t>(slot));
+
+    switch (ret)
+    {
+    case ESP_OK:
+        return httpd_resp_sendstr(req, "OK");
+    case ESP_ERR_INVALID_STATE:
+        httpd_resp_set_status(req, "409 Conflict");
+        return httpd_resp_sendstr(req, "Slot is busy");
+    case ESP_ERR_INVALID_ARG:
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid trajectory");
+    case ESP_ERR_INVALID_CRC:
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "CRC mismatch");
+    case ESP_ERR_TIMEOUT:
+        return httpd_resp_send_err(req, HTTPD_408_REQ_TIMEOUT, "Body timeout");
+    case ESP_FAIL:
+        return ESP_FAIL;
+    default:
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(ret));
+    }
+}
+
+esp_err_t TrajectoryStore::httpPlayHandler(httpd_req_t* req)
+{
+    auto* self = static_cast<TrajectoryStore*>(req->user_ctx);
+
+    // POST /trajectory/play?slot=N[&loops=K], loops=0 - бесконечно
+    long slot = 0;
+    long loops = 1;
+    if (!getQueryInt(req, "slot", slot) || slot < 0)
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid slot");
+    getQueryInt(req, "loops", loops);
+    if (loops < 0)
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid loops");
+
+    const esp_err_t ret = self->play(static_cast<size_t>(slot), static_cast<uint32_t>(loops));
+    if (ret != ESP_OK)
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, esp_err_to_name(ret));
+    return httpd_resp_sendstr(req, "OK");
+}
+
+esp_err_t TrajectoryStore::httpStopHandler(httpd_req_t* req)
+{
+    static_cast<TrajectoryStore*>(req->user_ctx)->stop();
+    return httpd_resp_sendstr(req, "OK");
+}
+
+uint32_t TrajectoryStore::slotOffset(size_t slot) const
+{
+    return static_cast<uint32_t>(slot) * m_config.slotSize;
+}
+
+uint32_t TrajectoryStore::slotCapacity() const
+{
+    return m_config.slotSize - sizeof(Header);
+}
+
+esp_err_t TrajectoryStore::checkWritable(size_t slot) const
+{
+    if (slot >= getSlotsCount())
+        return ESP_ERR_INVALID_ARG;
+    if (m_playSlot == static_cast<int>(slot) || m_recordSlot == static_cast<int>(slot)
+        || m_uploadSlot == static_cast<int>(slot))
+        return ESP_ERR_INVALID_STATE;
+    return ESP_OK;
+}
+
+esp_err_t TrajectoryStore::flushRecord()
+{
+    if (m_recordBufferUsed == 0)
+        return ESP_OK;
+
+    const esp_err_t ret = esp_partition_write(m_partition, slotOffset(m_recordSlot) + sizeof(Header) + m_recordHeader.dataSize,
+                                              m_recordBuffer, m_recordBufferUsed);
+    if (ret != ESP_OK)
+    {
+        ++m_errors;
+        return ret;
+    }
+    m_recordHeader.crc = TrajectoryFormat::crc32(m_recordHeader.crc, m_recordBuffer, m_recordBufferUsed);
+    m_recordHeader.dataSize += m_recordBufferUsed;
+    m_recordBufferUsed = 0;
+    return ESP_OK;
+}
+
+void TrajectoryStore::waitPlayTask()
+{
+    // Задача освобождает отображение, удаляет себя сама и обнуляет дескриптор
+    while (__atomic_load_n(&m_task, __ATOMIC_ACQUIRE) != nullptr)
+        vTaskDelay(1);
+}
+
+esp_err_t TrajectoryStore::upload(httpd_req_t* req, size_t slot)
+{
+    if (req->content_len < sizeof(Header) || req->content_len - sizeof(Header) > slotCapacity())
+        return ESP_ERR_INVALID_ARG;
+
+    // Слот резервируется под m_mutex, прием и запись идут без него: медленный клиент не блокирует
+    // запись, стирание и запуск воспроизведения других слотов
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    esp_err_t ret = checkWritable(slot);
+    if (ret == ESP_OK && m_uploadSlot >= 0)
+        ret = ESP_ERR_INVALID_STATE;
+    if (ret == ESP_OK)
+        m_uploadSlot = static_cast<int>(slot);
+    xSemaphoreGive(m_mutex);
+    if (ret != ESP_OK)
+        return ret;
+
+    ret = receiveUpload(req, slot);
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    m_uploadSlot = -1;
+    xSemaphoreGive(m_mutex);
+    return ret;
+}
+
+esp_err_t TrajectoryStore::receiveUpload(httpd_req_t* req, size_t slot)
+{
+    Header header;
+    esp_err_t ret = HttpServer::recvAll(req, &header, sizeof(header));
+    if (ret != ESP_OK)
+        return ret;
+    if (!TrajectoryFormat::isValidHeader(header, slotCapacity()) || header.dataSize != req->content_len - sizeof(header))
+        return ESP_ERR_INVALID_ARG;
+
+    ret = esp_partition_erase_range(m_partition, slotOffset(slot), m_config.slotSize);
+    if (ret != ESP_OK)
+    {
+        ++m_errors;
+        return ret;
+    }
+
+    // Данные пишутся по мере приема, заголовок - только после проверки CRC
+    uint8_t chunk[UPLOAD_CHUNK_SIZE];
+    uint32_t crc = 0;
+    for (uint32_t written = 0; written < header.dataSize; )
+    {
+        const size_t size = std::min<size_t>(sizeof(chunk), header.dataSize - written);
+        ret = HttpServer::recvAll(req, chunk, size);
+        if (ret != ESP_OK)
+            return ret;
+        ret = esp_partition_write(m_partition, slotOffset(slot) + sizeof(header) + written, chunk, size);
+        if (ret != ESP_OK)
+        {
+            ++m_errors;
+            return ret;
+        }
+        crc = TrajectoryFormat::crc32(crc, chunk, size);
+        written += size;
+    }
+    if (crc != header.crc)
+        return ESP_ERR_INVALID_CRC;
+
+    ret = esp_partition_write(m_partition, slotOffset(slot), &header, sizeof(header));
+    if (ret != ESP_OK)
+    {
+        ++m_errors;
+        return ret;
+    }
+
+    ++m_uploads;
+    ESP_LOGI(LOG, "Uploaded slot %u: %lu segments, %lu bytes", static_cast<unsigned>(slot),
+             static_cast<unsigned long>(header.segmentsCount), static_cast<unsigned long>(header.dataSize));
+    return ESP_OK;
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "TrajectoryFormat.h"
+#include <esp_err.h>
+#include <esp_http_server.h>
+#include <esp_partition.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "Helpers/CorePlacement.h"
+#include <atomic>
+#include <functional>
+
+class HttpServer;
+
+// Хранилище траекторий во флеш-памяти и их воспроизведение.
+// Раздел данных (по умолчанию spiffs, без файловой системы) делится на слоты фиксированного размера, в каждом слоте -
+// одна траектория в формате TrajectoryFormat. Траектория записывается отрезками с устройства (record()) или
+// загружается целиком по HTTP. Заголовок записывается последним, поэтому прерванная запись не выглядит корректной.
+// При воспроизведении слот отображается в адресное пространство (esp_partition_mmap), отрезки разбираются прямо
+// из флеш-памяти и по времени передаются обработчику - без копирования траектории в RAM.
+class TrajectoryStore
+{
+public:
+    using Segment = TrajectoryFormat::Segment;
+
+    // Обработчик отрезка при воспроизведении (вызывается из задачи воспроизведения)
+    using SegmentHandler = std::function<void(const Segment& segment)>;
+
+    struct Config
+    {
+        const char* partitionLabel = "spiffs";      // Метка раздела данных
+        uint32_t slotSize = 0x10000;                // Размер слота, байт (кратен размеру сектора)
+        uint32_t stackSize = 4096;                  // Размер стека задачи воспроизведения, байт
+        UBaseType_t priority = 6;                   // Приоритет задачи воспроизведения
+        BaseType_t coreId = CorePlacement::MOTION_CORE;     // Ядро задачи воспроизведения
+    };
+
+    struct SlotInfo
+    {
+        bool valid = false;             // В слоте корректная траектория
+        uint32_t segmentsCount = 0;     // Количество отрезков
+        uint32_t dataSize = 0;          // Размер данных отрезков, байт
+        uint32_t durationMs = 0;        // Длительность, мс
+    };
+
+    struct Stats
+    {
+        uint32_t recorded = 0;          // Записано отрезков
+        uint32_t uploads = 0;           // Загружено траекторий
+        uint32_t played = 0;            // Воспроизведено отрезков
+        uint32_t loops = 0;             // Завершено проходов траекторий
+        uint32_t errors = 0;            // Ошибок флеш-памяти и формата
+        uint32_t maxLateUs = 0;         // Максимальное опоздание отрезка при воспроизведении, мкс
+    };
+
+    /**
+     * @brief Конструктор
+     * @param handler: Обработчик отрезков при воспроизведении
+     */
+    explicit TrajectoryStore(SegmentHandler handler);
+    TrajectoryStore(SegmentHandler handler, const Config& config);
+    ~TrajectoryStore();
+
+    TrajectoryStore(const TrajectoryStore&) = delete;
+    TrajectoryStore& operator=(const TrajectoryStore&) = delete;
+
+    /**
+     * @brief Метод для получения количества слотов
+     * @return Количество слотов (0 если раздел не найден)
+     */
+    size_t getSlotsCount() const;
+
+    /**
+     * @brief Метод для получения описания слота
+     * @param slot: Номер слота
+     * @return Описание
+     */
+    SlotInfo getSlotInfo(size_t slot) const;
+
+    /**
+     * @brief Метод для стирания слота
+     * @param slot: Номер слота
+     * @return Результат
+     */
+    esp_err_t erase(size_t slot);
+
+    /**
+     * @brief Метод для начала записи траектории (слот стирается)
+     * @param slot: Номер слота
+     * @return Результат
+     */
+    esp_err_t beginRecord(size_t slot);
+
+    /**
+     * @brief Метод для записи отрезка с заданной задержкой segment.dtMs
+     * @param segment: Отрезок
+     * @return Результат (ESP_ERR_NO_MEM - слот заполнен)
+     */
+    esp_err_t record(const Segment& segment);
+
+    /**
+     * @brief Метод для записи отрезка с задержкой, равной времени от предыдущего вызова (запись "вживую")
+     * @param segment: Отрезок (dtMs игнорируется)
+     * @return Результат (ESP_ERR_NO_MEM - слот заполнен)
+     */
+    esp_err_t recordLive(const Segment& segment);
+
+    /**
+     * @brief Метод для завершения записи (запись заголовка)
+     * @return Результат
+     */
+    esp_err_t endRecord();
+
+    /**
+     * @brief Метод для прерывания записи (слот остается некорректным)
+     */
+    void abortRecord();
+
+    /**
+     * @brief Метод для запуска воспроизведения
+     * @param slot: Номер слота
+     * @param loops: Количество проходов (0 - бесконечно)
+     * @return Результат (ESP_ERR_INVALID_CRC - траектория повреждена)
+     */
+    esp_err_t play(size_t slot, uint32_t loops = 1);
+
+    /**
+     * @brief Метод для остановки воспроизведения (обработчик больше не вызывается)
+     */
+    void stop();
+
+    /**
+     * @brief Метод для получения признака воспроизведения
+     * @return true если траектория воспроизводится
+     */
+    bool isPlaying() const;
+
+    /**
+     * @brief Метод для регистрации обработчиков /trajectory (после HttpServer::start())
+     * @param server: HTTP-сервер
+     */
+    void registerHttpHandlers(HttpServer& server);
+
+    /**
+     * @brief Метод для получения статистики
+     * @return Статистика
+     */
+    Stats getStats() const;
+
+private:
+    static const size_t RECORD_BUFFER_SIZE = 512;   // Буфер записи отрезков, байт
+
+    static void playTask(void* arg);
+    static esp_err_t httpGetHandler(httpd_req_t* req);
+    static esp_err_t httpUploadHandler(httpd_req_t* req);
+    static esp_err_t httpPlayHandler(httpd_req_t* req);
+    static esp_err_t httpStopHandler(httpd_req_t* req);
+
+    /* Смещение слота в разделе */
+    uint32_t slotOffset(size_t slot) const;
+
+    /* Емкость данных слота, байт */
+    uint32_t slotCapacity() const;
+
+    /* Проверка, что слот можно перезаписать (под m_mutex) */
+    esp_err_t checkWritable(size_t slot) const;
+
+    /* Запись буфера отрезков во флеш-память (под m_mutex) */
+    esp_err_t flushRecord();
+
+    /* Ожидание завершения задачи воспроизведения */
+    void waitPlayTask();
+
+    /* Загрузка траектории из тела запроса (слот резервируется под m_mutex на время приема) */
+    esp_err_t upload(httpd_req_t* req, size_t slot);
+
+    /* Прием и запись траектории в зарезервированный слот (без m_mutex) */
+    esp_err_t receiveUpload(httpd_req_t* req, size_t slot);
+
+private:
+    const Config m_config;
+    const SegmentHandler m_handler;
+    const esp_partition_t* m_partition = nullptr;
+    SemaphoreHandle_t m_mutex = nullptr;            // Сериализует запись, резервирование загрузки, стирание и запуск
+
+    // Запись
+    int m_recordSlot = -1;                          // Слот записи (-1 - запись не идет)
+    TrajectoryFormat::Encoder m_encoder;
+    uint8_t m_recordBuffer[RECORD_BUFFER_SIZE];
+    size_t m_recordBufferUsed = 0;
+    TrajectoryFormat::Header m_recordHeader = {};   // Заголовок записываемой траектории
+    int64_t m_lastRecordUs = 0;                     // Время предыдущего recordLive(), мкс
+
+    // Загрузка по HTTP
+    int m_uploadSlot = -1;                          // Слот загрузки (-1 - загрузка не идет)
+
+    // Воспроизведение
+    TaskHandle_t m_task = nullptr;
+    std::atomic<bool> m_running{false};
+    std::atomic<int> m_playSlot{-1};                // Воспроизводимый слот (-1 - нет)
+    esp_partition_mmap_handle_t m_mapHandle = 0;
+    const uint8_t* m_playData = nullptr;            // Данные отрезков в отображенной флеш-памяти
+    size_t m_playSize = 0;
+    uint32_t m_playLoops = 0;
+
+    std::atomic<uint32_t> m_recorded{0};
+    std::atomic<uint32_t> m_uploads{0};
+    std::atomic<uint32_t> m_played{0};
+    std::atomic<uint32_t> m_loops{0};
+    std::atomic<uint32_t> m_errors{0};
+    std::atomic<uint32_t> m_maxLateUs{0};
+};
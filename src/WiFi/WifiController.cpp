@@ -1,59 +1,243 @@
 #include "WifiController.h"
 #include <esp_wifi.h>
-#include <nvs_flash.h>
+#include <esp_random.h>
+#include <nvs.h>
 #include <esp_log.h>
+#include <algorithm>
+#include <cstring>
 
 static const char* WIFI_LOG_TAG = "WIFI";
 
-void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+namespace
+{
+    const char* NVS_NAMESPACE = "wifi_fast";    // Пространство имен NVS для быстрого подключения
+    const char* NVS_KEY_CACHE = "cache";
+    const uint8_t CACHE_VERSION = 2;
+}
+
+void WiFiManager::eventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
     auto* self = static_cast<WiFiManager*>(arg);
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START)
     {
-        esp_wifi_connect();
+        self->onStaStart();
+    }
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED)
+    {
+        self->onConnected(static_cast<wifi_event_sta_connected_t*>(event_data));
     }
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
     {
-        ESP_LOGW(WIFI_LOG_TAG, "Wi-Fi отключен, переподключение...");
-        esp_wifi_connect();
+        self->onDisconnected(static_cast<wifi_event_sta_disconnected_t*>(event_data));
     }
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
     {
-        ip_event_got_ip_t* event = (ip_event_got_ip_t*)event_data;
-        ESP_LOGI(WIFI_LOG_TAG, "Получен IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        self->onGotIp(static_cast<ip_event_got_ip_t*>(event_data));
     }
 }
 
+void WiFiManager::reconnectTimerCallback(void* arg)
+{
+    auto* self = static_cast<WiFiManager*>(arg);
+    // Попытка по сохраненным BSSID/каналу при неудаче сразу переходит к полному сканированию (onDisconnected)
+    self->m_state = self->m_staPinned ? EnState::enFastConnecting : EnState::enConnecting;
+    self->m_connectStartUs = esp_timer_get_time();
+    esp_wifi_connect();
+}
+
 WiFiManager::WiFiManager(const char* ssid, const char* password):
+    WiFiManager(ssid, password, ReconnectParams{})
+{}
+
+WiFiManager::WiFiManager(const char* ssid, const char* password, const ReconnectParams& reconnect):
     m_ssid(ssid),
-    m_password(password)
+    m_password(password),
+    m_reconnect(reconnect)
 {}
 
 void WiFiManager::connect()
 {
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
-    {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    
-    ESP_ERROR_CHECK(ret);
+    // NVS инициализируется при старте (ConfigStore::initNvs()), до подключения
     ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    // Цикл событий мог уже создать WifiMonitor::start()
+    const esp_err_t ret = esp_event_loop_create_default();
+    if (ret != ESP_ERR_INVALID_STATE)
+        ESP_ERROR_CHECK(ret);
+    m_netif = esp_netif_create_default_wifi_sta();
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
     esp_event_handler_instance_t instance_any_id;
     esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, this, &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, this, &instance_got_ip));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &eventHandler, this, &instance_any_id));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &eventHandler, this, &instance_got_ip));
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = &WiFiManager::reconnectTimerCallback,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "wifi_reconnect",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &m_reconnectTimer));
+
+    m_cacheValid = m_reconnect.fastConnect && loadCache();
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    applyStaConfig(m_cacheValid);
+    m_connectStartUs = esp_timer_get_time();
+    ESP_ERROR_CHECK(esp_wifi_start());
+    ESP_LOGI(WIFI_LOG_TAG, "Подключение к Wi-Fi: %s%s...", m_ssid, m_cacheValid ? " (быстрое)" : "");
+}
+
+WiFiManager::EnState WiFiManager::getState() const
+{
+    return m_state;
+}
+
+void WiFiManager::forgetFastConnect()
+{
+    m_cacheValid = false;
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK)
+    {
+        nvs_erase_key(handle, NVS_KEY_CACHE);
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+}
+
+void WiFiManager::onStaStart()
+{
+    m_state = m_staPinned ? EnState::enFastConnecting : EnState::enConnecting;
+    esp_wifi_connect();
+}
+
+void WiFiManager::onConnected(const wifi_event_sta_connected_t* event)
+{
+    memcpy(m_connectedBssid, event->bssid, sizeof(m_connectedBssid));
+    m_connectedChannel = event->channel;
+}
+
+void WiFiManager::onDisconnected(const wifi_event_sta_disconnected_t* event)
+{
+    if (m_state == EnState::enFastConnecting)
+    {
+        // Сохраненная точка доступа недоступна, заменена или сменила канал - сразу пробуем полное подключение.
+        // Так же завершается первая неудачная повторная попытка после разрыва: дальше - только полное сканирование
+        ESP_LOGW(WIFI_LOG_TAG, "Быстрое подключение не удалось (причина %d), полное сканирование", event->reason);
+        fallbackToFullConnect();
+        m_state = EnState::enConnecting;
+        esp_wifi_connect();
+        return;
+    }
+
+    ESP_LOGW(WIFI_LOG_TAG, "Wi-Fi отключен (причина %d), переподключение...", event->reason);
+    scheduleReconnect();
+}
+
+void WiFiManager::onGotIp(const ip_event_got_ip_t* event)
+{
+    ESP_LOGI(WIFI_LOG_TAG, "Получен IP: " IPSTR " за %lld мс", IP2STR(&event->ip_info.ip),
+             static_cast<long long>((esp_timer_get_time() - m_connectStartUs) / 1000));
+
+    m_state = EnState::enConnected;
+    m_attempt = 0;
+
+    if (m_reconnect.fastConnect)
+        saveCache();
+}
+
+void WiFiManager::applyStaConfig(bool useCache)
+{
     wifi_config_t wifi_config = {};
-    strcpy((char*)wifi_config.sta.ssid, m_ssid);
-    strcpy((char*)wifi_config.sta.password, m_password);
+    strncpy((char*)wifi_config.sta.ssid, m_ssid, sizeof(wifi_config.sta.ssid));
+    strncpy((char*)wifi_config.sta.password, m_password, sizeof(wifi_config.sta.password));
     wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+
+    if (useCache)
+    {
+        // Подключение к известной точке доступа на известном канале без сканирования
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, m_cache.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = m_cache.channel;
+    }
+    else
+    {
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    m_staPinned = useCache;
+
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
-    ESP_LOGI(WIFI_LOG_TAG, "Подключение к Wi-Fi: %s...", m_ssid);
-}
\ No newline at end of file
+}
+
+void WiFiManager::fallbackToFullConnect()
+{
+    m_cacheValid = false;
+    applyStaConfig(false);
+}
+
+void WiFiManager::scheduleReconnect()
+{
+    // Задержка растет экспоненциально: initial * 2^attempt, но не больше maxDelayMs.
+    // Случайный разброс не дает множеству устройств одновременно переподключаться к точке доступа
+    const uint32_t shift = std::min<uint32_t>(m_attempt, 16);
+    uint64_t delayMs = std::min<uint64_t>(static_cast<uint64_t>(m_reconnect.initialDelayMs) << shift, m_reconnect.maxDelayMs);
+    if (m_reconnect.jitterPercent > 0)
+    {
+        const uint64_t jitterMs = delayMs * std::min<uint8_t>(m_reconnect.jitterPercent, 100) / 100;
+        if (jitterMs > 0)
+            delayMs -= esp_random() % (jitterMs + 1);
+    }
+    ++m_attempt;
+
+    m_state = EnState::enBackoff;
+    esp_timer_stop(m_reconnectTimer);
+    ESP_ERROR_CHECK(esp_timer_start_once(m_reconnectTimer, delayMs * 1000));
+    ESP_LOGI(WIFI_LOG_TAG, "Повторная попытка %lu через %llu мс", static_cast<unsigned long>(m_attempt),
+             static_cast<unsigned long long>(delayMs));
+}
+
+bool WiFiManager::loadCache()
+{
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+        return false;
+
+    size_t size = sizeof(m_cache);
+    const esp_err_t err = nvs_get_blob(handle, NVS_KEY_CACHE, &m_cache, &size);
+    nvs_close(handle);
+
+    return err == ESP_OK && size == sizeof(m_cache) && m_cache.version == CACHE_VERSION && m_cache.channel != 0;
+}
+
+void WiFiManager::saveCache()
+{
+    FastConnectCache cache = {};
+    cache.version = CACHE_VERSION;
+    cache.channel = m_connectedChannel;
+    memcpy(cache.bssid, m_connectedBssid, sizeof(cache.bssid));
+
+    wifi_ap_record_t apInfo;
+    if (cache.channel == 0 && esp_wifi_sta_get_ap_info(&apInfo) == ESP_OK)
+    {
+        cache.channel = apInfo.primary;
+        memcpy(cache.bssid, apInfo.bssid, sizeof(cache.bssid));
+    }
+
+    // Пишем во flash только при изменении параметров
+    if (m_cacheValid && memcmp(&cache, &m_cache, sizeof(cache)) == 0)
+        return;
+
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+        return;
+
+    if (nvs_set_blob(handle, NVS_KEY_CACHE, &cache, sizeof(cache)) == ESP_OK && nvs_commit(handle) == ESP_OK)
+    {
+        m_cache = cache;
+        m_cacheValid = true;
+        ESP_LOGI(WIFI_LOG_TAG, "Параметры быстрого подключения сохранены (канал %u)", cache.channel);
+    }
+    nvs_close(handle);
+}
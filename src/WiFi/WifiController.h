@@ -1,14 +1,98 @@
 #pragma once
 
+#include <esp_wifi.h>
+#include <esp_event.h>
+#include <esp_netif.h>
+#include <esp_timer.h>
+
 // Класс для управления Wi-Fi
 class WiFiManager
 {
 public:
+    // Параметры переподключения (экспоненциальная задержка со случайным разбросом)
+    struct ReconnectParams
+    {
+        uint32_t initialDelayMs = 250;      // Задержка перед первой повторной попыткой, мс
+        uint32_t maxDelayMs = 30'000;       // Максимальная задержка, мс
+        uint8_t jitterPercent = 50;         // Случайное уменьшение задержки, % (0 - без разброса)
+        bool fastConnect = true;            // Подключаться к сохраненным BSSID и каналу без полного сканирования
+    };
+
+    enum class EnState
+    {
+        enIdle,             // Не подключен, подключение не запущено
+        enFastConnecting,   // Подключение по сохраненным BSSID/каналу
+        enConnecting,       // Подключение с полным сканированием и DHCP
+        enConnected,        // Подключен, IP получен
+        enBackoff           // Ожидание перед повторной попыткой
+    };
+
     WiFiManager(const char* ssid, const char* password);
+    WiFiManager(const char* ssid, const char* password, const ReconnectParams& reconnect);
 
+    /**
+     * @brief Метод для запуска подключения (раздел NVS должен быть инициализирован: ConfigStore::initNvs())
+     */
     void connect();
 
+    /**
+     * @brief Метод для получения текущего состояния подключения
+     * @return Состояние
+     */
+    EnState getState() const;
+
+    /**
+     * @brief Метод для сброса сохраненных параметров быстрого подключения
+     */
+    void forgetFastConnect();
+
+private:
+    // Параметры последнего успешного подключения, сохраняемые в NVS.
+    // Адрес не кэшируется: DHCP-клиент сам запрашивает прошлый адрес (CONFIG_LWIP_DHCP_RESTORE_LAST_IP), и сервер
+    // подтверждает аренду одним обменом вместо полного DISCOVER/OFFER - занятый или чужой адрес не используется
+    struct FastConnectCache
+    {
+        uint8_t version;                    // Версия формата
+        uint8_t channel;                    // Канал точки доступа
+        uint8_t bssid[6];                   // BSSID точки доступа
+    };
+
+    static void eventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+    static void reconnectTimerCallback(void* arg);
+
+    /* Обработка событий */
+    void onStaStart();
+    void onConnected(const wifi_event_sta_connected_t* event);
+    void onDisconnected(const wifi_event_sta_disconnected_t* event);
+    void onGotIp(const ip_event_got_ip_t* event);
+
+    /* Применение конфигурации станции (с сохраненными BSSID/каналом или с полным сканированием) */
+    void applyStaConfig(bool useCache);
+
+    /* Переключение с быстрого подключения на полное сканирование и DHCP */
+    void fallbackToFullConnect();
+
+    /* Планирование повторной попытки с задержкой */
+    void scheduleReconnect();
+
+    /* Загрузка/сохранение параметров быстрого подключения */
+    bool loadCache();
+    void saveCache();
+
 private:
     const char* m_ssid;
     const char* m_password;
-};
\ No newline at end of file
+    const ReconnectParams m_reconnect;
+
+    esp_netif_t* m_netif = nullptr;
+    esp_timer_handle_t m_reconnectTimer = nullptr;
+    volatile EnState m_state = EnState::enIdle;
+    uint32_t m_attempt = 0;                 // Номер повторной попытки подряд
+    int64_t m_connectStartUs = 0;           // Начало текущего подключения, мкс
+
+    FastConnectCache m_cache = {};          // Сохраненные параметры (из NVS)
+    bool m_cacheValid = false;
+    bool m_staPinned = false;               // Конфигурация станции привязана к сохраненным BSSID/каналу
+    uint8_t m_connectedBssid[6] = {};       // Параметры текущего подключения
+    uint8_t m_connectedChannel = 0;
+};
@@ -0,0 +1,237 @@
+#include "WifiMonitor.h"
+#include "Http/HttpServer.h"
+#include <esp_log.h>
+#include <esp_netif.h>
+#include <cstdio>
+
+namespace
+{
+    const char* LOG = "WifiMonitor";    // Канал лога
+}
+
+WifiMonitor::WifiMonitor(uint32_t samplePeriodMs):
+    m_samplePeriodMs(samplePeriodMs)
+{
+}
+
+WifiMonitor::~WifiMonitor()
+{
+    if (m_sampleTimer)
+    {
+        esp_timer_stop(m_sampleTimer);
+        esp_timer_delete(m_sampleTimer);
+    }
+    if (m_wifiHandler)
+        esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, m_wifiHandler);
+    if (m_ipHandler)
+        esp_event_handler_instance_unregister(IP_EVENT, ESP_EVENT_ANY_ID, m_ipHandler);
+}
+
+void WifiMonitor::start()
+{
+    m_linkLostUs = esp_timer_get_time();
+    // Цикл событий мог уже создать WiFiManager::connect()
+    const esp_err_t ret = esp_event_loop_create_default();
+    if (ret != ESP_ERR_INVALID_STATE)
+        ESP_ERROR_CHECK(ret);
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &eventHandler, this, &m_wifiHandler));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, ESP_EVENT_ANY_ID, &eventHandler, this, &m_ipHandler));
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = &WifiMonitor::sampleTimerCallback,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "wifi_monitor",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &m_sampleTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(m_sampleTimer, static_cast<uint64_t>(m_samplePeriodMs) * 1000));
+}
+
+void WifiMonitor::registerHttpHandlers(HttpServer& server)
+{
+    httpd_uri_t monitor =
+    {
+        .uri = "/wifi/monitor",
+        .method = HTTP_GET,
+        .handler = &WifiMonitor::httpHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(monitor) != ESP_OK)
+        ESP_LOGE(LOG, "Register /wifi/monitor failed");
+}
+
+WifiMonitor::Counters WifiMonitor::getCounters() const
+{
+    portENTER_CRITICAL(&m_lock);
+    const Counters counters = m_counters;
+    portEXIT_CRITICAL(&m_lock);
+    return counters;
+}
+
+void WifiMonitor::eventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    auto* self = static_cast<WifiMonitor*>(arg);
+    const int64_t now = esp_timer_get_time();
+
+    Event event = {
+        .timeUs = now,
+        .isIpEvent = event_base == IP_EVENT,
+        .id = static_cast<int16_t>(event_id),
+        .reason = -1,
+        .rssi = 0,
+    };
+
+    portENTER_CRITICAL(&self->m_lock);
+    if (event_base == WIFI_EVENT)
+    {
+        switch (event_id)
+        {
+        case WIFI_EVENT_STA_START:
+            self->m_linkLostUs = now;
+            break;
+        case WIFI_EVENT_STA_CONNECTED:
+            ++self->m_counters.connects;
+            break;
+        case WIFI_EVENT_STA_DISCONNECTED:
+        {
+            const auto* data = static_cast<const wifi_event_sta_disconnected_t*>(event_data);
+            event.reason = data->reason;
+            event.rssi = data->rssi;
+            ++self->m_counters.disconnects;
+            self->m_counters.lastReason = data->reason;
+            // Время до IP отсчитываем от первого отключения в серии
+            if (self->m_linkLostUs == 0)
+                self->m_linkLostUs = now;
+            break;
+        }
+        case WIFI_EVENT_STA_BSS_RSSI_LOW:
+            event.rssi = static_cast<int8_t>(static_cast<const wifi_event_bss_rssi_low_t*>(event_data)->rssi);
+            break;
+        default:
+            break;
+        }
+    }
+    else if (event_id == IP_EVENT_STA_GOT_IP)
+    {
+        ++self->m_counters.gotIp;
+        if (self->m_linkLostUs != 0)
+        {
+            const uint32_t timeToIpMs = static_cast<uint32_t>((now - self->m_linkLostUs) / 1000);
+            self->m_counters.lastTimeToIpMs = timeToIpMs;
+            if (timeToIpMs > self->m_counters.maxTimeToIpMs)
+                self->m_counters.maxTimeToIpMs = timeToIpMs;
+            self->m_linkLostUs = 0;
+        }
+    }
+    portEXIT_CRITICAL(&self->m_lock);
+
+    self->pushEvent(event);
+}
+
+void WifiMonitor::sampleTimerCallback(void* arg)
+{
+    auto* self = static_cast<WifiMonitor*>(arg);
+
+    Sample sample = {
+        .timeUs = esp_timer_get_time(),
+        .rssi = 0,
+        .phyMode = 0,
+    };
+
+    int rssi = 0;
+    if (esp_wifi_sta_get_rssi(&rssi) == ESP_OK)
+    {
+        sample.rssi = static_cast<int8_t>(rssi);
+        wifi_phy_mode_t phyMode;
+        if (esp_wifi_sta_get_negotiated_phymode(&phyMode) == ESP_OK)
+            sample.phyMode = static_cast<uint8_t>(phyMode);
+    }
+
+    self->pushSample(sample);
+}
+
+esp_err_t WifiMonitor::httpHandler(httpd_req_t* req)
+{
+    return static_cast<WifiMonitor*>(req->user_ctx)->sendJson(req);
+}
+
+void WifiMonitor::pushEvent(const Event& event)
+{
+    portENTER_CRITICAL(&m_lock);
+    m_events[m_eventsWritten % EVENTS_COUNT] = event;
+    ++m_eventsWritten;
+    portEXIT_CRITICAL(&m_lock);
+}
+
+void WifiMonitor::pushSample(const Sample& sample)
+{
+    portENTER_CRITICAL(&m_lock);
+    m_samples[m_samplesWritten % SAMPLES_COUNT] = sample;
+    ++m_samplesWritten;
+    portEXIT_CRITICAL(&m_lock);
+}
+
+esp_err_t WifiMonitor::sendJson(httpd_req_t* req)
+{
+    char buf[160];
+    const Counters counters = getCounters();
+
+    httpd_resp_set_type(req, "application/json");
+    snprintf(buf, sizeof(buf),
+             "{\"now_us\":%lld,\"connects\":%lu,\"disconnects\":%lu,\"got_ip\":%lu,"
+             "\"last_time_to_ip_ms\":%lu,\"max_time_to_ip_ms\":%lu,\"last_reason\":%d,\"events\":[",
+             static_cast<long long>(esp_timer_get_time()), static_cast<unsigned long>(counters.connects),
+             static_cast<unsigned long>(counters.disconnects), static_cast<unsigned long>(counters.gotIp),
+             static_cast<unsigned long>(counters.lastTimeToIpMs), static_cast<unsigned long>(counters.maxTimeToIpMs),
+             counters.lastReason);
+    httpd_resp_sendstr_chunk(req, buf);
+
+    // Записи копируем по одной, чтобы не держать блокировку во время отправки.
+    // Если запись успела перезаписаться, она пропускается
+    portENTER_CRITICAL(&m_lock);
+    const uint32_t eventsEnd = m_eventsWritten;
+    portEXIT_CRITICAL(&m_lock);
+    const uint32_t eventsBegin = eventsEnd > EVENTS_COUNT ? eventsEnd - EVENTS_COUNT : 0;
+    bool first = true;
+    for (uint32_t i = eventsBegin; i < eventsEnd; ++i)
+    {
+        portENTER_CRITICAL(&m_lock);
+        const bool valid = m_eventsWritten - i <= EVENTS_COUNT;
+        const Event event = m_events[i % EVENTS_COUNT];
+        portEXIT_CRITICAL(&m_lock);
+        if (!valid)
+            continue;
+
+        snprintf(buf, sizeof(buf), "%s{\"t_us\":%lld,\"base\":\"%s\",\"id\":%d,\"reason\":%d,\"rssi\":%d}",
+                 first ? "" : ",", static_cast<long long>(event.timeUs), event.isIpEvent ? "IP" : "WIFI",
+                 event.id, event.reason, event.rssi);
+        httpd_resp_sendstr_chunk(req, buf);
+        first = false;
+    }
+
+    httpd_resp_sendstr_chunk(req, "],\"samples\":[");
+
+    portENTER_CRITICAL(&m_lock);
+    const uint32_t samplesEnd = m_samplesWritten;
+    portEXIT_CRITICAL(&m_lock);
+    const uint32_t samplesBegin = samplesEnd > SAMPLES_COUNT ? samplesEnd - SAMPLES_COUNT : 0;
+    first = true;
+    for (uint32_t i = samplesBegin; i < samplesEnd; ++i)
+    {
+        portENTER_CRITICAL(&m_lock);
+        const bool valid = m_samplesWritten - i <= SAMPLES_COUNT;
+        const Sample sample = m_samples[i % SAMPLES_COUNT];
+        portEXIT_CRITICAL(&m_lock);
+        if (!valid)
+            continue;
+
+        snprintf(buf, sizeof(buf), "%s{\"t_us\":%lld,\"rssi\":%d,\"phy\":%u}",
+                 first ? "" : ",", static_cast<long long>(sample.timeUs), sample.rssi, sample.phyMode);
+        httpd_resp_sendstr_chunk(req, buf);
+        first = false;
+    }
+
+    httpd_resp_sendstr_chunk(req, "]}");
+    return httpd_resp_sendstr_chunk(req, nullptr);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <esp_wifi.h>
+#include <esp_event.h>
+#include <esp_timer.h>
+#include <esp_http_server.h>
+#include "freertos/FreeRTOS.h"
+#include <array>
+
+class HttpServer;
+
+// Монитор качества связи Wi-Fi.
+// Записывает все события WIFI_EVENT/IP_EVENT с метками времени и кодами причин в кольцевой буфер,
+// периодически снимает RSSI и режим PHY и отдает все это по HTTP (/wifi/monitor) в JSON
+// для сопоставления рывков движения и задержек управления с состоянием радиоканала.
+class WifiMonitor
+{
+public:
+    static const size_t EVENTS_COUNT = 64;      // Размер кольцевого буфера событий
+    static const size_t SAMPLES_COUNT = 120;    // Размер кольцевого буфера измерений RSSI
+
+    struct Event
+    {
+        int64_t timeUs;         // Метка времени, мкс
+        bool isIpEvent;         // false - WIFI_EVENT, true - IP_EVENT
+        int16_t id;             // Идентификатор события
+        int16_t reason;         // Код причины отключения (WIFI_EVENT_STA_DISCONNECTED) или -1
+        int8_t rssi;            // RSSI из события или 0
+    };
+
+    struct Sample
+    {
+        int64_t timeUs;         // Метка времени, мкс
+        int8_t rssi;            // RSSI, дБм (0 - нет подключения)
+        uint8_t phyMode;        // Согласованный режим PHY (wifi_phy_mode_t)
+    };
+
+    struct Counters
+    {
+        uint32_t connects = 0;          // Успешных ассоциаций
+        uint32_t disconnects = 0;       // Отключений
+        uint32_t gotIp = 0;             // Получений IP
+        uint32_t lastTimeToIpMs = 0;    // Время от старта/отключения до получения IP (последнее), мс
+        uint32_t maxTimeToIpMs = 0;     // Время от старта/отключения до получения IP (максимальное), мс
+        int16_t lastReason = -1;        // Последний код причины отключения
+    };
+
+    /**
+     * @brief Конструктор
+     * @param samplePeriodMs: Период измерения RSSI, мс
+     */
+    explicit WifiMonitor(uint32_t samplePeriodMs = 1000);
+    ~WifiMonitor();
+
+    WifiMonitor(const WifiMonitor&) = delete;
+    WifiMonitor& operator=(const WifiMonitor&) = delete;
+
+    /**
+     * @brief Метод для запуска мониторинга (до WiFiManager::connect(), чтобы записать подключение и время до
+     *        получения IP; цикл событий по умолчанию создается, если его еще нет)
+     */
+    void start();
+
+    /**
+     * @brief Метод для регистрации обработчика /wifi/monitor (после HttpServer::start())
+     * @param server: HTTP-сервер
+     */
+    void registerHttpHandlers(HttpServer& server);
+
+    /**
+     * @brief Метод для получения счетчиков
+     * @return Счетчики
+     */
+    Counters getCounters() const;
+
+private:
+    static void eventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+    static void sampleTimerCallback(void* arg);
+    static esp_err_t httpHandler(httpd_req_t* req);
+
+    /* Добавление записи в кольцевой буфер */
+    void pushEvent(const Event& event);
+    void pushSample(const Sample& sample);
+
+    /* Формирование JSON-ответа (по частям, без выделения памяти под весь ответ) */
+    esp_err_t sendJson(httpd_req_t* req);
+
+private:
+    const uint32_t m_samplePeriodMs;
+    mutable portMUX_TYPE m_lock = portMUX_INITIALIZER_UNLOCKED;
+
+    esp_timer_handle_t m_sampleTimer = nullptr;
+    esp_event_handler_instance_t m_wifiHandler = nullptr;
+    esp_event_handler_instance_t m_ipHandler = nullptr;
+
+    std::array<Event, EVENTS_COUNT> m_events = {};
+    uint32_t m_eventsWritten = 0;               // Всего записано событий (индекс записи = m_eventsWritten % EVENTS_COUNT)
+    std::array<Sample, SAMPLES_COUNT> m_samples = {};
+    uint32_t m_samplesWritten = 0;
+
+    Counters m_counters;
+    int64_t m_linkLostUs = 0;                   // Начало подключения (старт или отключение), мкс
+};
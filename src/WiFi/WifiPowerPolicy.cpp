@@ -0,0 +1,296 @@
+#include "WifiPowerPolicy.h"
+#include "Http/HttpServer.h"
+#include <esp_log.h>
+#include <esp_netif.h>
+#include <cstdio>
+
+namespace
+{
+    const char* LOG = "WifiPowerPolicy";    // Канал лога
+
+    const char* modeName(wifi_ps_type_t mode)
+    {
+        switch (mode)
+        {
+        case WIFI_PS_NONE:      return "NONE";
+        case WIFI_PS_MIN_MODEM: return "MIN_MODEM";
+        case WIFI_PS_MAX_MODEM: return "MAX_MODEM";
+        default:                return "?";
+        }
+    }
+
+    // JSON-объект статистики задержек (без измерений минимум выводится как 0)
+    void formatDelay(char* buf, size_t size, const WifiPowerPolicy::DelayStats& stats)
+    {
+        snprintf(buf, size, "{\"count\":%lu,\"lost\":%lu,\"minUs\":%lu,\"avgUs\":%lu,\"maxUs\":%lu}",
+                 static_cast<unsigned long>(stats.count), static_cast<unsigned long>(stats.lost),
+                 static_cast<unsigned long>(stats.count ? stats.minUs : 0),
+                 static_cast<unsigned long>(stats.count ? stats.sumUs / stats.count : 0),
+                 static_cast<unsigned long>(stats.maxUs));
+    }
+}
+
+WifiPowerPolicy::WifiPowerPolicy(const Config& config):
+    m_config(config),
+    m_mode(config.idleMode)
+{
+    m_lock = xSemaphoreCreateMutex();
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = &WifiPowerPolicy::idleTimerCallback,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "wifi_ps_idle",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &m_idleTimer));
+}
+
+WifiPowerPolicy::~WifiPowerPolicy()
+{
+    stop();
+    esp_timer_stop(m_idleTimer);
+    esp_timer_delete(m_idleTimer);
+    vSemaphoreDelete(m_lock);
+}
+
+void WifiPowerPolicy::start()
+{
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    m_modeSinceUs = esp_timer_get_time();
+    applyModeLocked(m_demand ? WIFI_PS_NONE : m_config.idleMode);
+    xSemaphoreGive(m_lock);
+
+    if (m_config.rttProbeIntervalMs > 0)
+        startRttProbe();
+}
+
+void WifiPowerPolicy::stop()
+{
+    if (m_ping)
+    {
+        esp_ping_stop(m_ping);
+        esp_ping_delete_session(m_ping);
+        m_ping = nullptr;
+    }
+}
+
+void WifiPowerPolicy::setDemand(EnDemand demand, bool active)
+{
+    // Решение и переключение режима под m_lock: иначе idleTimerCallback может прочитать старую маску
+    // и перевести радио в энергосбережение после того, как потребность уже появилась
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    const uint32_t prev = m_demand;
+    const uint32_t current = active ? (prev | demand) : (prev & ~static_cast<uint32_t>(demand));
+    m_demand = current;
+
+    if (current && !prev)
+    {
+        // Появилась потребность - сразу отключаем энергосбережение
+        esp_timer_stop(m_idleTimer);
+        applyModeLocked(WIFI_PS_NONE);
+    }
+    else if (!current && prev)
+    {
+        // Потребность снята - возвращаемся в энергосбережение с задержкой, чтобы не переключаться слишком часто
+        armIdleTimer();
+    }
+    xSemaphoreGive(m_lock);
+}
+
+void WifiPowerPolicy::notifyActivity()
+{
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    if (!m_demand)
+    {
+        // Кратковременная активность: энергосбережение отключается до истечения задержки простоя
+        applyModeLocked(WIFI_PS_NONE);
+        armIdleTimer();
+    }
+    xSemaphoreGive(m_lock);
+}
+
+void WifiPowerPolicy::recordPacket(uint64_t senderTimestampUs, int64_t rxTimeUs)
+{
+    const int64_t offsetUs = rxTimeUs - static_cast<int64_t>(senderTimestampUs);
+
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    if (!m_hasOffset || offsetUs < m_minOffsetUs)
+    {
+        m_minOffsetUs = offsetUs;
+        m_hasOffset = true;
+    }
+    addSample(m_stats[m_mode].packetDelay, static_cast<uint32_t>(offsetUs - m_minOffsetUs));
+    xSemaphoreGive(m_lock);
+}
+
+wifi_ps_type_t WifiPowerPolicy::getMode() const
+{
+    return m_mode;
+}
+
+WifiPowerPolicy::ModeStats WifiPowerPolicy::getStats(wifi_ps_type_t mode) const
+{
+    if (mode >= MODES_COUNT)
+        return {};
+
+    xSemaphoreTake(m_lock, portMAX_DELAY);
+    ModeStats stats = m_stats[mode];
+    if (mode == m_mode)
+        stats.timeInModeUs += esp_timer_get_time() - m_modeSinceUs;
+    xSemaphoreGive(m_lock);
+    return stats;
+}
+
+void WifiPowerPolicy::registerHttpHandlers(HttpServer& server)
+{
+    httpd_uri_t power =
+    {
+        .uri = "/wifi/power",
+        .method = HTTP_GET,
+        .handler = &WifiPowerPolicy::httpHandler,
+        .user_ctx = this
+    };
+    if (server.registerUri(power) != ESP_OK)
+        ESP_LOGE(LOG, "Register /wifi/power failed");
+}
+
+esp_err_t WifiPowerPolicy::httpHandler(httpd_req_t* req)
+{
+    auto* self = static_cast<WifiPowerPolicy*>(req->user_ctx);
+    char buf[160];
+    char rtt[96];
+    char packetDelay[96];
+
+    xSemaphoreTake(self->m_lock, portMAX_DELAY);
+    const wifi_ps_type_t mode = self->m_mode;
+    const uint32_t demand = self->m_demand;
+    xSemaphoreGive(self->m_lock);
+
+    httpd_resp_set_type(req, "application/json");
+    snprintf(buf, sizeof(buf), "{\"mode\":\"%s\",\"demand\":%lu,\"modes\":[", modeName(mode),
+             static_cast<unsigned long>(demand));
+    httpd_resp_sendstr_chunk(req, buf);
+
+    // Время в текущем режиме включает незавершенный интервал (getStats)
+    for (size_t i = 0; i < MODES_COUNT; ++i)
+    {
+        const ModeStats stats = self->getStats(static_cast<wifi_ps_type_t>(i));
+        formatDelay(rtt, sizeof(rtt), stats.rtt);
+        formatDelay(packetDelay, sizeof(packetDelay), stats.packetDelay);
+        snprintf(buf, sizeof(buf), "%s{\"mode\":\"%s\",\"timeMs\":%llu,\"rtt\":", i ? "," : "",
+                 modeName(static_cast<wifi_ps_type_t>(i)), static_cast<unsigned long long>(stats.timeInModeUs / 1000));
+        httpd_resp_sendstr_chunk(req, buf);
+        httpd_resp_sendstr_chunk(req, rtt);
+        httpd_resp_sendstr_chunk(req, ",\"packetDelay\":");
+        httpd_resp_sendstr_chunk(req, packetDelay);
+        httpd_resp_sendstr_chunk(req, "}");
+    }
+
+    httpd_resp_sendstr_chunk(req, "]}");
+    return httpd_resp_sendstr_chunk(req, nullptr);
+}
+
+void WifiPowerPolicy::idleTimerCallback(void* arg)
+{
+    auto* self = static_cast<WifiPowerPolicy*>(arg);
+
+    // Потребность могла появиться между срабатыванием таймера и захватом m_lock - проверяем под ним
+    xSemaphoreTake(self->m_lock, portMAX_DELAY);
+    if (!self->m_demand)
+        self->applyModeLocked(self->m_config.idleMode);
+    xSemaphoreGive(self->m_lock);
+}
+
+void WifiPowerPolicy::pingSuccess(esp_ping_handle_t hdl, void* args)
+{
+    auto* self = static_cast<WifiPowerPolicy*>(args);
+    uint32_t elapsedMs = 0;
+    esp_ping_get_profile(hdl, ESP_PING_PROF_TIMEGAP, &elapsedMs, sizeof(elapsedMs));
+
+    xSemaphoreTake(self->m_lock, portMAX_DELAY);
+    addSample(self->m_stats[self->m_mode].rtt, elapsedMs * 1000);
+    xSemaphoreGive(self->m_lock);
+}
+
+void WifiPowerPolicy::pingTimeout(esp_ping_handle_t hdl, void* args)
+{
+    auto* self = static_cast<WifiPowerPolicy*>(args);
+
+    xSemaphoreTake(self->m_lock, portMAX_DELAY);
+    ++self->m_stats[self->m_mode].rtt.lost;
+    xSemaphoreGive(self->m_lock);
+}
+
+void WifiPowerPolicy::applyModeLocked(wifi_ps_type_t mode)
+{
+    if (mode == m_mode && m_applied)
+        return;
+
+    if (mode != m_mode)
+    {
+        const int64_t now = esp_timer_get_time();
+        m_stats[m_mode].timeInModeUs += now - m_modeSinceUs;
+        m_modeSinceUs = now;
+        m_mode = mode;
+    }
+
+    const esp_err_t err = esp_wifi_set_ps(mode);
+    m_applied = err == ESP_OK;
+    if (err != ESP_OK)
+        ESP_LOGW(LOG, "Set PS %s failed: %s", modeName(mode), esp_err_to_name(err));
+    else
+        ESP_LOGD(LOG, "PS mode = %s", modeName(mode));
+}
+
+void WifiPowerPolicy::armIdleTimer()
+{
+    esp_timer_stop(m_idleTimer);
+    esp_timer_start_once(m_idleTimer, static_cast<uint64_t>(m_config.idleDelayMs) * 1000);
+}
+
+void WifiPowerPolicy::addSample(DelayStats& stats, uint32_t valueUs)
+{
+    ++stats.count;
+    stats.sumUs += valueUs;
+    if (valueUs < stats.minUs)
+        stats.minUs = valueUs;
+    if (valueUs > stats.maxUs)
+        stats.maxUs = valueUs;
+}
+
+void WifiPowerPolicy::startRttProbe()
+{
+    if (m_ping)
+        return;
+
+    esp_netif_ip_info_t ipInfo = {};
+    esp_netif_t* netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (!netif || esp_netif_get_ip_info(netif, &ipInfo) != ESP_OK || ipInfo.gw.addr == 0)
+    {
+        ESP_LOGW(LOG, "No gateway, RTT probe disabled");
+        return;
+    }
+
+    esp_ping_config_t pingConfig = ESP_PING_DEFAULT_CONFIG();
+    pingConfig.target_addr.u_addr.ip4.addr = ipInfo.gw.addr;
+    pingConfig.target_addr.type = IPADDR_TYPE_V4;
+    pingConfig.count = ESP_PING_COUNT_INFINITE;
+    pingConfig.interval_ms = m_config.rttProbeIntervalMs;
+    pingConfig.data_size = 32;
+
+    esp_ping_callbacks_t callbacks = {
+        .cb_args = this,
+        .on_ping_success = &WifiPowerPolicy::pingSuccess,
+        .on_ping_timeout = &WifiPowerPolicy::pingTimeout,
+        .on_ping_end = nullptr,
+    };
+
+    if (esp_ping_new_session(&pingConfig, &callbacks, &m_ping) != ESP_OK)
+    {
+        ESP_LOGW(LOG, "Ping session create failed");
+        m_ping = nullptr;
+        return;
+    }
+    esp_ping_start(m_ping);
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <esp_wifi.h>
+#include <esp_timer.h>
+#include <esp_http_server.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "ping/ping_sock.h"
+
+class HttpServer;
+
+// Политика энергосбережения Wi-Fi.
+// Пока есть потребность в малой задержке (ось движется, подключен клиент управления) радио работает
+// без энергосбережения (WIFI_PS_NONE), в простое - возвращается в режим modem-sleep.
+// Для каждого режима накапливается статистика RTT и задержки пакетов, чтобы оценивать компромисс
+// (отдается по HTTP: /wifi/power).
+class WifiPowerPolicy
+{
+public:
+    // Источники потребности в малой задержке (битовая маска)
+    enum EnDemand : uint32_t
+    {
+        enMotion = 1u << 0,             // Ось движется
+        enControlClient = 1u << 1,      // Подключен клиент управления
+        enUser = 1u << 2,               // Запрошено пользователем
+    };
+
+    struct Config
+    {
+        wifi_ps_type_t idleMode = WIFI_PS_MIN_MODEM;    // Режим в простое
+        uint32_t idleDelayMs = 2000;                    // Задержка перехода в энергосбережение после снятия потребности, мс
+        uint32_t rttProbeIntervalMs = 1000;             // Период ping шлюза для измерения RTT, мс (0 - не измерять)
+    };
+
+    // Статистика задержек (RTT или задержка пакетов)
+    struct DelayStats
+    {
+        uint32_t count = 0;             // Количество измерений
+        uint32_t lost = 0;              // Потерянных (только RTT)
+        uint32_t minUs = UINT32_MAX;    // Минимум, мкс
+        uint32_t maxUs = 0;             // Максимум, мкс
+        uint64_t sumUs = 0;             // Сумма для расчета среднего, мкс
+    };
+
+    struct ModeStats
+    {
+        DelayStats rtt;                 // RTT до шлюза
+        DelayStats packetDelay;         // Задержка пакетов управления относительно наилучшей
+        uint64_t timeInModeUs = 0;      // Суммарное время в режиме, мкс
+    };
+
+    static const size_t MODES_COUNT = WIFI_PS_MAX_MODEM + 1;
+
+    explicit WifiPowerPolicy(const Config& config);
+    ~WifiPowerPolicy();
+
+    WifiPowerPolicy(const WifiPowerPolicy&) = delete;
+    WifiPowerPolicy& operator=(const WifiPowerPolicy&) = delete;
+
+    /**
+     * @brief Метод для запуска политики (после подключения Wi-Fi)
+     */
+    void start();
+
+    /**
+     * @brief Метод для остановки политики (измерение RTT прекращается, режим не меняется)
+     */
+    void stop();
+
+    /**
+     * @brief Метод для установки/снятия потребности в малой задержке
+     * @param demand: Источник потребности
+     * @param active: Состояние
+     */
+    void setDemand(EnDemand demand, bool active);
+
+    /**
+     * @brief Метод для учета кратковременной активности (например HTTP-запроса): энергосбережение
+     *        отключается на idleDelayMs, если нет постоянной потребности
+     */
+    void notifyActivity();
+
+    /**
+     * @brief Метод для учета принятого пакета управления
+     * @param senderTimestampUs: Метка времени отправителя, мкс
+     * @param rxTimeUs: Метка времени приема, мкс
+     * @note Часы отправителя и приемника не синхронизированы, поэтому учитывается задержка
+     *       относительно наименьшей наблюдаемой разности (вариация задержки в одну сторону)
+     */
+    void recordPacket(uint64_t senderTimestampUs, int64_t rxTimeUs);
+
+    /**
+     * @brief Метод для получения текущего режима энергосбережения
+     * @return Режим
+     */
+    wifi_ps_type_t getMode() const;
+
+    /**
+     * @brief Метод для получения статистики по режиму
+     * @param mode: Режим
+     * @return Статистика
+     */
+    ModeStats getStats(wifi_ps_type_t mode) const;
+
+    /**
+     * @brief Метод для регистрации обработчика /wifi/power (после HttpServer::start())
+     * @param server: HTTP-сервер
+     */
+    void registerHttpHandlers(HttpServer& server);
+
+private:
+    static void idleTimerCallback(void* arg);
+    static esp_err_t httpHandler(httpd_req_t* req);
+    static void pingSuccess(esp_ping_handle_t hdl, void* args);
+    static void pingTimeout(esp_ping_handle_t hdl, void* args);
+
+    /* Применение режима (под m_lock, с учетом времени пребывания в предыдущем) */
+    void applyModeLocked(wifi_ps_type_t mode);
+
+    /* Перезапуск таймера перехода в энергосбережение (под m_lock) */
+    void armIdleTimer();
+
+    /* Добавление измерения */
+    static void addSample(DelayStats& stats, uint32_t valueUs);
+
+    /* Запуск измерения RTT до шлюза */
+    void startRttProbe();
+
+private:
+    const Config m_config;
+
+    SemaphoreHandle_t m_lock = nullptr;         // Защищает потребность, режим и статистику
+    esp_timer_handle_t m_idleTimer = nullptr;
+    esp_ping_handle_t m_ping = nullptr;
+
+    uint32_t m_demand = 0;                      // Маска EnDemand
+    wifi_ps_type_t m_mode = WIFI_PS_MIN_MODEM;
+    bool m_applied = false;                     // Режим m_mode установлен в драйвере
+    int64_t m_modeSinceUs = 0;                  // Время входа в текущий режим, мкс
+    ModeStats m_stats[MODES_COUNT];
+
+    bool m_hasOffset = false;
+    int64_t m_minOffsetUs = 0;                  // Наименьшая разность (прием - отправка), мкс
+};
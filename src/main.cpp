@@ -1,44 +1,318 @@
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
 
 #include "StepMotor/StepMotorController.h"
+#include "Config/ConfigStore.h"
+#include "Trajectory/TrajectoryStore.h"
+#include "Diagnostics/TaskProfiler.h"
+#include "Diagnostics/PcSampler.h"
+#include "Helpers/CorePlacement.h"
+#include "Helpers/LedEffectEngine.h"
+#include "led_strip.h"
+#ifdef WIFI_SSID
+#include "WiFi/WifiController.h"
+#include "WiFi/WifiPowerPolicy.h"
+#include "WiFi/WifiMonitor.h"
+#include "Http/HttpServer.h"
+#include "Control/UdpControl.h"
+#include <cstring>
+#endif
+#include <memory>
+#ifdef BENCHMARK_BUILD
+#include "Benchmarks/Benchmarks.h"
+#endif
 
 namespace
 {
     const char* LOG = "Main";
 
-    // Пиновка
-    const gpio_num_t GPIO_EN = GPIO_NUM_15;
-    const gpio_num_t GPIO_DIR = GPIO_NUM_2;
-    const gpio_num_t GPIO_STEP = GPIO_NUM_4;
+    const int STATUS_LED_PIN = 48;      // RGB светодиод на плате ESP32-S3-DevKitC (на esp32dev пина нет)
+
+    const UBaseType_t SEGMENT_QUEUE_LENGTH = 8;     // Очередь отрезков траектории к основному циклу
+    const uint32_t SEGMENT_SEND_TIMEOUT_MS = 100;   // Ожидание места в очереди задачей воспроизведения, мс
+    const uint32_t LOOP_PERIOD_MS = 10;             // Период основного цикла, мс
+
+    // Лента индикации: RMT с двойным буфером, кадр рисуется во время передачи предыдущего
+    led_strip_handle_t createStatusStrip(uint32_t ledsCount)
+    {
+        led_strip_config_t stripConfig = {
+            .strip_gpio_num = STATUS_LED_PIN,
+            .max_leds = ledsCount,
+            .led_model = LED_MODEL_WS2812,
+            .color_component_format = LED_STRIP_COLOR_COMPONENT_FMT_GRB,
+            .flags = {},
+        };
+        led_strip_rmt_config_t rmtConfig = {
+            .clk_src = RMT_CLK_SRC_DEFAULT,
+            .resolution_hz = 10000000,
+            .mem_block_symbols = 64,
+            .timing = {},
+            .flags = {},
+        };
+        rmtConfig.flags.double_buffer = 1;
+
+        led_strip_handle_t strip = nullptr;
+        const esp_err_t err = led_strip_new_rmt_device(&stripConfig, &rmtConfig, &strip);
+        if (err != ESP_OK)
+        {
+            ESP_LOGW(LOG, "Status LED strip is not available: %s", esp_err_to_name(err));
+            return nullptr;
+        }
+        return strip;
+    }
+
+    // Индикация состояния: слой 0 - Wi-Fi, слой 1 - движение оси.
+    // Эффект слоя устанавливается только при смене состояния, иначе его время начиналось бы заново
+    class StatusLeds
+    {
+    public:
+        static const int NO_STATE = -1;
+
+        explicit StatusLeds(LedEffectEngine& engine):
+            m_engine(engine)
+        {}
+
+        void setMoving(bool isMoving)
+        {
+            if (isMoving == m_isMoving)
+                return;
+            m_isMoving = isMoving;
+
+            LedEffectEngine::Effect effect;
+            if (isMoving)
+            {
+                effect.type = LedEffectEngine::EnEffect::enChase;
+                effect.color = {0, 64, 255};
+                effect.periodMs = 800;
+                effect.alpha = 192;
+            }
+            m_engine.setLayer(1, effect);
+        }
+
+        // state - состояние подключения (WiFiManager::EnState), NO_STATE - сеть не используется
+        void setWifiState(int state, bool isConnected, bool isConnecting)
+        {
+            if (state == m_wifiState)
+                return;
+            m_wifiState = state;
+
+            LedEffectEngine::Effect effect;
+            if (isConnected)
+            {
+                effect.type = LedEffectEngine::EnEffect::enSolid;
+                effect.color = {0, 24, 0};
+            }
+            else if (isConnecting)
+            {
+                effect.type = LedEffectEngine::EnEffect::enBlink;
+                effect.color = {48, 32, 0};
+                effect.periodMs = 500;
+            }
+            else if (state != NO_STATE)
+            {
+                effect.type = LedEffectEngine::EnEffect::enPulse;
+                effect.color = {64, 0, 0};
+                effect.periodMs = 2000;
+            }
+            m_engine.setLayer(0, effect);
+        }
+
+    private:
+        LedEffectEngine& m_engine;
+        bool m_isMoving = false;
+        int m_wifiState = NO_STATE;
+    };
+
+    // Передача уставки контроллеру (отрезки траекторий и уставки UDP имеют одинаковые поля и команды)
+    template<typename Setpoint>
+    void applySetpoint(StepMotorController& motor, const Setpoint& setpoint)
+    {
+        using EnCommand = decltype(setpoint.command);
+        switch (setpoint.command)
+        {
+        case EnCommand::enSpeed:
+            motor.setTargetSpeed(setpoint.targetSpeed, setpoint.acceleration, setpoint.deceleration);
+            break;
+        case EnCommand::enPosition:
+            motor.setTargetPosition(setpoint.targetPos, setpoint.targetSpeed, setpoint.acceleration,
+                                    setpoint.deceleration);
+            break;
+        case EnCommand::enSoftStop:
+            motor.softStop();
+            break;
+        default:
+            motor.hardStop();
+            break;
+        }
+    }
 }
 
 extern "C" void app_main()
 {
     ESP_LOGI(LOG, "Starting StepMotorController test");
 
+    // Конфигурация: NVS -> кэш в RAM, до Wi-Fi и периферии
+    ESP_ERROR_CHECK(ConfigStore::initNvs());
+    ConfigStore::Config configStoreConfig;
+    configStoreConfig.reservedPins = 1ULL << STATUS_LED_PIN;
+    static ConfigStore config(configStoreConfig);
+    config.load();
+
+    using EnParam = ConfigStore::EnParam;
+
+#ifdef BENCHMARK_BUILD
+    // Сборка env:benchmark: замеры на пинах из конфигурации вместо рабочего цикла
+    {
+        MicroBench bench("device");
+        Benchmarks::runAlgorithms(bench);
+
+        Benchmarks::HardwareConfig hardware;
+        hardware.stepPin = config.getInt(EnParam::enMotorStepPin);
+        hardware.servoPin = config.getInt(EnParam::enServoPin);
+        hardware.rmtLedPin = 48;    // RGB светодиод на плате
+        hardware.spiLedPin = 48;
+        Benchmarks::runHardware(bench, hardware);
+        return;
+    }
+#endif
+
+    // Снимки загрузки задач, запаса стеков и куч (в .bss: снимки занимают несколько КБ)
+    static TaskProfiler profiler;
+    profiler.start();
+
     // Инициализация контроллера
     StepMotorController::InitParams params = {
-        .enPin = GPIO_EN,
-        .dirPin = GPIO_DIR,
-        .stepPin = GPIO_STEP,
-        .stepMode = StepMotorController::EnStepMode::en1_1,
-        .enableInverse = false,
+        .enPin = static_cast<gpio_num_t>(config.getInt(EnParam::enMotorEnPin)),
+        .dirPin = static_cast<gpio_num_t>(config.getInt(EnParam::enMotorDirPin)),
+        .stepPin = static_cast<gpio_num_t>(config.getInt(EnParam::enMotorStepPin)),
+        .stepMode = static_cast<StepMotorController::EnStepMode>(config.getInt(EnParam::enMotorStepMode)),
+        .enableInverse = config.getBool(EnParam::enMotorEnableInverse),
+        .directionInverse = config.getBool(EnParam::enMotorDirInverse),
     };
 
-    StepMotorController motor(params);
+    // Периферия движения создается на ядре движения: туда будут назначены ее прерывания, когда появятся обработчики
+    std::unique_ptr<StepMotorController> motorPtr;
+    ESP_ERROR_CHECK(CorePlacement::runOnCore(CorePlacement::MOTION_CORE, [&]()
+    {
+        motorPtr = std::make_unique<StepMotorController>(params);
+    }));
+    StepMotorController& motor = *motorPtr;
     motor.setEnabled(true);
 
     ESP_LOGI(LOG, "Min speed: %.2f grad/s", motor.getMinSpeed());
     ESP_LOGI(LOG, "Max speed: %.2f grad/s", motor.getMaxSpeed());
 
-    // Тест: разгон до 100 град/с с ускорением 500 град/с²
-    motor.setTargetSpeed(100.0, 500.0, 500.0);
+    // Воспроизведение траекторий из флеш-памяти. Контроллер не потокобезопасен, его методы вызывает только основной
+    // цикл: задача воспроизведения (на ядре движения) кладет отрезки в очередь, цикл применяет их как уставки
+    QueueHandle_t segmentQueue = xQueueCreate(SEGMENT_QUEUE_LENGTH, sizeof(TrajectoryStore::Segment));
+    ESP_ERROR_CHECK(segmentQueue ? ESP_OK : ESP_ERR_NO_MEM);
+    TrajectoryStore trajectories([segmentQueue](const TrajectoryStore::Segment& segment)
+    {
+        if (xQueueSend(segmentQueue, &segment, pdMS_TO_TICKS(SEGMENT_SEND_TIMEOUT_MS)) != pdTRUE)
+            ESP_LOGW(LOG, "Trajectory segment dropped: control loop is not draining the queue");
+    });
+
+#ifdef WIFI_SSID
+    // Сеть (сборка с -DWIFI_SSID, -DWIFI_PASSWORD и -DUDP_KEY): Wi-Fi, HTTP, уставки по UDP.
+    // Политика энергосбережения радио получает потребность от движения оси и клиента UDP и кратковременную
+    // активность от HTTP. Монитор запускается до подключения: в журнал попадают ассоциация и время до получения IP
+    static WifiMonitor wifiMonitor;
+    wifiMonitor.start();
+    static WiFiManager wifi(WIFI_SSID, WIFI_PASSWORD);
+    wifi.connect();
+
+    static WifiPowerPolicy powerPolicy(WifiPowerPolicy::Config{});
+    bool powerPolicyStarted = false;
+
+    static HttpServer http(nullptr);
+    http.setActivityCallback([]()
+    {
+        powerPolicy.notifyActivity();
+    });
+    http.start();
+    config.registerHttpHandlers(http);
+    trajectories.registerHttpHandlers(http);
+    profiler.registerHttpHandlers(http);
+    // Выборки PC включаются запросом POST /sampler/start; до этого таймеры и буферы не создаются
+    static PcSampler sampler;
+    sampler.registerHttpHandlers(http);
+    wifiMonitor.registerHttpHandlers(http);
+    powerPolicy.registerHttpHandlers(http);
+
+    static_assert(sizeof(UDP_KEY) - 1 == UdpControl::KEY_SIZE, "UDP_KEY must be 32 characters");
+    UdpControl::Config udpConfig;
+    memcpy(udpConfig.key, UDP_KEY, UdpControl::KEY_SIZE);
+    static UdpControl udp(udpConfig);
+    if (!udp.start())
+        ESP_LOGE(LOG, "UDP control start failed");
+#endif
 
-    // Основной цикл - вызываем update() периодически
+    // Эффекты ленты индикации: частота и длина ленты из конфигурации
+    std::unique_ptr<LedEffectEngine> effects;
+    std::unique_ptr<StatusLeds> status;
+    if (led_strip_handle_t strip = createStatusStrip(config.getInt(EnParam::enLedsCount)))
+    {
+        LedEffectEngine::Config effectsConfig;
+        effectsConfig.ledsCount = static_cast<uint16_t>(config.getInt(EnParam::enLedsCount));
+        effectsConfig.fps = static_cast<uint16_t>(config.getInt(EnParam::enLedFps));
+        effects = std::make_unique<LedEffectEngine>(strip, effectsConfig);
+        if (effects->start())
+            status = std::make_unique<StatusLeds>(*effects);
+    }
+
+    // Периферия создана по конфигурации: сбой после этого места не приводит к откату к значениям по умолчанию
+    config.markApplied();
+
+    // Тест: разгон до 100 град/с с ускорением из конфигурации
+    const double accel = config.getFloat(EnParam::enMotorAccel);
+    motor.setTargetSpeed(100.0, accel, accel);
+
+    // Основной цикл - единственный владелец контроллера: уставки UDP и отрезки траекторий применяются здесь
     while (1)
     {
         //motor.update();
-        //vTaskDelay(pdMS_TO_TICKS(10)); // Вызов каждые 10 мс
+#ifdef WIFI_SSID
+        // Политика запускается после подключения: ей нужен адрес шлюза для измерения RTT
+        if (!powerPolicyStarted && wifi.getState() == WiFiManager::EnState::enConnected)
+        {
+            powerPolicy.start();
+            powerPolicyStarted = true;
+        }
+
+        // Пакеты перестали приходить - плавный останов; уставка, пришедшая после таймаута, применяется следом
+        if (udp.takeTimeout())
+            motor.softStop();
+
+        UdpControl::Setpoint setpoint;
+        if (udp.takeSetpoint(setpoint))
+        {
+            applySetpoint(motor, setpoint);
+            if (powerPolicyStarted)
+                powerPolicy.recordPacket(setpoint.senderTimestampUs, setpoint.rxTimeUs);
+        }
+
+        if (powerPolicyStarted)
+        {
+            powerPolicy.setDemand(WifiPowerPolicy::enMotion, motor.isMoving());
+            powerPolicy.setDemand(WifiPowerPolicy::enControlClient, udp.isClientActive());
+        }
+
+        if (status)
+        {
+            using EnState = WiFiManager::EnState;
+            const EnState wifiState = wifi.getState();
+            status->setWifiState(static_cast<int>(wifiState), wifiState == EnState::enConnected,
+                                 wifiState == EnState::enConnecting || wifiState == EnState::enFastConnecting);
+        }
+#endif
+        if (status)
+            status->setMoving(motor.isMoving());
+
+        // Пауза цикла - ожидание отрезка траектории: отрезок применяется сразу после прихода, а не в следующем периоде
+        TrajectoryStore::Segment segment;
+        for (TickType_t wait = pdMS_TO_TICKS(LOOP_PERIOD_MS); xQueueReceive(segmentQueue, &segment, wait) == pdTRUE;
+             wait = 0)
+            applySetpoint(motor, segment);
     }
 }
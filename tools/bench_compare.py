@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Сравнение двух запусков микробенчмарков (строки "MICROBENCH {json}" из лога порта или bench_host).
+
+Использование:
+    bench_compare.py <baseline.txt> <current.txt> [--metric p50] [--threshold 10]
+
+Код возврата 1, если метрика хотя бы одного замера выросла больше чем на threshold процентов.
+"""
+
+import argparse
+import json
+import sys
+
+PREFIX = "MICROBENCH "
+
+
+def load(path):
+    results = {}
+    unit = None
+    with open(path, encoding="utf-8", errors="replace") as file:
+        for line in file:
+            pos = line.find(PREFIX)
+            if pos < 0:
+                continue
+            try:
+                record = json.loads(line[pos + len(PREFIX):])
+            except json.JSONDecodeError:
+                continue
+            if "name" not in record:
+                unit = record.get("unit", unit)
+                continue
+            if "skipped" in record:
+                continue
+            results[(record["suite"], record["name"])] = record
+    return unit, results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--metric", default="p50", choices=["min", "p50", "p90", "p99", "max", "mean"])
+    parser.add_argument("--threshold", type=float, default=10.0, help="допустимый рост, %%")
+    args = parser.parse_args()
+
+    base_unit, base = load(args.baseline)
+    cur_unit, cur = load(args.current)
+    if base_unit != cur_unit:
+        print(f"Units differ: {base_unit} vs {cur_unit}", file=sys.stderr)
+        return 2
+
+    regressions = 0
+    print(f"{'benchmark':40} {'baseline':>12} {'current':>12} {'change':>8}")
+    for key in sorted(base.keys() | cur.keys()):
+        name = "/".join(key)
+        if key not in base or key not in cur:
+            print(f"{name:40} {'-' if key not in base else base[key][args.metric]:>12} "
+                  f"{'-' if key not in cur else cur[key][args.metric]:>12}")
+            continue
+        old = base[key][args.metric]
+        new = cur[key][args.metric]
+        change = (new - old) / old * 100 if old else 0.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  REGRESSION"
+            regressions += 1
+        print(f"{name:40} {old:>12.1f} {new:>12.1f} {change:>+7.1f}%{mark}")
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,40 @@
+// Микробенчмарки на ПК: для проверки регрессий до прошивки платы.
+// Алгоритмические замеры (HSV, кодек траекторий) - те же, что на плате. Замеры с периферией (StepGenerator,
+// сервоприводы, ленты RMT/SPI, дрожание контура) идут через заменители драйверов tools/host: они показывают
+// накладные расходы кода вокруг драйвера, но не время шины и прерываний - сравнивать их можно только
+// с предыдущим запуском на ПК.
+//
+// Сборка (Linux; исходники ленты - на C):
+//   gcc -std=gnu11 -O2 -c -Itools/host/include -Icomponents/led_strip/include -Icomponents/led_strip/interface
+//       components/led_strip/src/*.c
+//   g++ -std=c++17 -O2 -pthread -Itools/host/include -Isrc -Icomponents/microbench/include
+//       -Icomponents/led_strip/include tools/bench_host.cpp src/Benchmarks/AlgorithmBenchmarks.cpp
+//       src/Benchmarks/HardwareBenchmarks.cpp src/Trajectory/TrajectoryFormat.cpp src/StepMotor/StepGenerator.cpp
+//       src/Servo_pwm/ServoControl.cpp src/Servo_pwm/ServoBank.cpp src/Helpers/CorePlacement.cpp
+//       components/microbench/src/MicroBench.cpp led_strip_*.o tools/host/src/freertos.cpp
+//       tools/host/src/esp_system.cpp tools/host/src/mcpwm.cpp tools/host/src/gptimer.cpp tools/host/src/ledc.cpp
+//       tools/host/src/rmt.cpp tools/host/src/spi_master.cpp -o bench_host
+//
+// Запуск: ./bench_host - все замеры; ./bench_host algo - только алгоритмические
+// Сравнение с эталоном:
+//   ./bench_host > current.txt && python3 tools/bench_compare.py baseline.txt current.txt
+
+#include "Benchmarks/Benchmarks.h"
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    MicroBench bench("host");
+    Benchmarks::runAlgorithms(bench);
+    if (argc > 1 && strcmp(argv[1], "algo") == 0)
+        return 0;
+
+    // Пины - как в конфигурации по умолчанию и на плате (лента индикации на 48)
+    Benchmarks::HardwareConfig hardware;
+    hardware.stepPin = 4;
+    hardware.servoPin = 5;
+    hardware.rmtLedPin = 48;
+    hardware.spiLedPin = 48;
+    Benchmarks::runHardware(bench, hardware);
+    return 0;
+}
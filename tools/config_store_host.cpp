@@ -0,0 +1,423 @@
+// Проверка ConfigStore на ПК с моделью NVS (tools/host/src/nvs.cpp): значения по умолчанию на пустом хранилище,
+// пакетная запись с задержкой коммита и ее верхняя граница, сохранение между перезагрузками и потеря незаписанных
+// изменений без flush(), повтор после ошибки коммита, проверка пинов и их совпадений, отбрасывание сохраненного
+// набора с конфликтом пинов, откат к значениям по умолчанию после сбоя до markApplied(), миграция схемы и
+// POST /config: все пары проверяются до применения.
+//
+// Сборка (Linux):
+//   g++ -std=c++17 -O2 -pthread -Itools/host/include -Isrc -Isrc/Http -Icomponents/led_strip/include
+//       -Icomponents/block_pool/include tools/config_store_host.cpp src/Config/ConfigStore.cpp src/Http/HttpServer.cpp
+//       src/Http/HttpAsyncWorkers.cpp src/Helpers/CorePlacement.cpp components/block_pool/src/BlockPool.cpp
+//       tools/host/src/nvs.cpp tools/host/src/freertos.cpp tools/host/src/esp_system.cpp
+//       tools/host/src/esp_http_server.cpp -o config_store_host
+//
+// Запуск: ./config_store_host [файл хранилища, по умолчанию только память]
+
+#include "Config/ConfigStore.h"
+#include "Http/HttpServer.h"
+#include "HostHttpd.h"
+#include "HostNvs.h"
+#include "HostSystem.h"
+#include "HostCheck.h"
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace
+{
+    using EnParam = ConfigStore::EnParam;
+
+    const int RESERVED_PIN = 48;        // Как лента индикации в main.cpp
+
+    ConfigStore::Config testConfig(uint32_t commitDelayMs = 50, uint32_t maxCommitDelayMs = 300)
+    {
+        ConfigStore::Config config;
+        config.commitDelayMs = commitDelayMs;
+        config.maxCommitDelayMs = maxCommitDelayMs;
+        config.reservedPins = 1ULL << RESERVED_PIN;
+        return config;
+    }
+
+    void sleepMs(uint32_t ms)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+
+    // Перезагрузка: незаписанные изменения теряются, причина сброса - для следующей загрузки
+    void reboot(esp_reset_reason_t reason = ESP_RST_SW)
+    {
+        HostNvs::reboot();
+        HostSystem::setResetReason(reason);
+        HOST_CHECK(ConfigStore::initNvs() == ESP_OK);
+    }
+
+    void fresh()
+    {
+        HostNvs::reset();
+        HostSystem::setResetReason(ESP_RST_POWERON);
+        HOST_CHECK(ConfigStore::initNvs() == ESP_OK);
+    }
+
+    // Запись параметра в NVS в обход ConfigStore (как прошивкой с другим набором параметров)
+    void writeStored(const char* key, int32_t value)
+    {
+        nvs_handle_t handle;
+        HOST_CHECK(nvs_open("config", NVS_READWRITE, &handle) == ESP_OK);
+        HOST_CHECK(nvs_set_i32(handle, key, value) == ESP_OK);
+        HOST_CHECK(nvs_commit(handle) == ESP_OK);
+        nvs_close(handle);
+    }
+
+    int32_t readStored(const char* key)
+    {
+        nvs_handle_t handle;
+        int32_t value = INT32_MIN;
+        if (nvs_open("config", NVS_READONLY, &handle) == ESP_OK)
+        {
+            nvs_get_i32(handle, key, &value);
+            nvs_close(handle);
+        }
+        return value;
+    }
+
+    void testDefaults()
+    {
+        fresh();
+        ConfigStore store(testConfig());
+        store.load();
+        HOST_CHECK(!store.isFallback());
+        HOST_CHECK(store.getInt(EnParam::enMotorEnPin) == 15);
+        HOST_CHECK(store.getInt(EnParam::enMotorDirPin) == 2);
+        HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 4);
+        HOST_CHECK(store.getInt(EnParam::enServoPin) == -1);
+        HOST_CHECK(store.getFloat(EnParam::enMotorAccel) == 500.0f);
+        HOST_CHECK(!store.getBool(EnParam::enServoInverted));
+
+        // Записана только версия схемы
+        const HostNvs::Stats stats = HostNvs::stats();
+        HOST_CHECK_MSG(stats.commits == 1 && stats.writes == 1, "commits %u, writes %u", stats.commits, stats.writes);
+        store.markApplied();
+    }
+
+    void testBatching()
+    {
+        fresh();
+        ConfigStore store(testConfig(50, 300));
+        store.load();
+        const uint32_t base = HostNvs::stats().commits;
+
+        // Серия изменений чаще задержки - один коммит после паузы
+        for (int i = 0; i < 10; ++i)
+        {
+            HOST_CHECK(store.setInt(EnParam::enLedFps, 10 + i));
+            sleepMs(10);
+        }
+        HOST_CHECK(HostNvs::stats().commits == base);
+        sleepMs(200);
+        HOST_CHECK_MSG(HostNvs::stats().commits == base + 1, "commits %u", HostNvs::stats().commits - base);
+        HOST_CHECK(store.getStats().writes == 10 && store.getStats().commits == 1);
+
+        // Запись того же значения не планирует коммит
+        HOST_CHECK(store.setInt(EnParam::enLedFps, 19));
+        sleepMs(150);
+        HOST_CHECK(HostNvs::stats().commits == base + 1);
+
+        // Непрерывные изменения записываются не реже maxCommitDelayMs
+        const uint32_t before = HostNvs::stats().commits;
+        for (int i = 0; i < 50; ++i)
+        {
+            store.setInt(EnParam::enLedFps, 100 + i % 2);
+            sleepMs(20);
+        }
+        const uint32_t commits = HostNvs::stats().commits - before;
+        HOST_CHECK_MSG(commits >= 2 && commits <= 5, "%u commits in 1 s with 300 ms limit", commits);
+        store.markApplied();
+    }
+
+    void testPersistence()
+    {
+        fresh();
+        {
+            ConfigStore store(testConfig());
+            store.load();
+            HOST_CHECK(store.setInt(EnParam::enMotorStepPin, 5));
+            HOST_CHECK(store.setFloat(EnParam::enMotorAccel, 1234.5f));
+            HOST_CHECK(store.setBool(EnParam::enMotorDirInverse, true));
+            HOST_CHECK(store.flush() == ESP_OK);
+            store.markApplied();
+        }
+
+        // Значение без flush() теряется при перезагрузке до коммита
+        ConfigStore pending(testConfig(10000, 60000));
+        pending.load();
+        HOST_CHECK(pending.setInt(EnParam::enLedsCount, 300));
+        pending.markApplied();
+        reboot();
+
+        {
+            ConfigStore store(testConfig());
+            store.load();
+            HOST_CHECK(!store.isFallback());
+            HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 5);
+            HOST_CHECK(store.getFloat(EnParam::enMotorAccel) == 1234.5f);
+            HOST_CHECK(store.getBool(EnParam::enMotorDirInverse));
+            HOST_CHECK(store.getInt(EnParam::enLedsCount) == 1);
+            store.markApplied();
+        }
+    }
+
+    void testCommitFailure()
+    {
+        fresh();
+        ConfigStore store(testConfig(10000, 60000));
+        store.load();
+        HOST_CHECK(store.setInt(EnParam::enServoStopUs, 1400));
+
+        // Неудачный коммит оставляет изменения незаписанными, следующий записывает их
+        HostNvs::failCommits(1);
+        HOST_CHECK(store.flush() != ESP_OK);
+        HOST_CHECK(store.getStats().errors == 1);
+        HOST_CHECK(store.flush() == ESP_OK);
+        HOST_CHECK(readStored("s_stop_us") == 1400);
+        store.markApplied();
+    }
+
+    void testPinValidation()
+    {
+        fresh();
+        ConfigStore store(testConfig());
+        store.load();
+
+        // Обязательные пины двигателя: не -1, не пины без выхода
+        HOST_CHECK(!store.setInt(EnParam::enMotorStepPin, -1));
+        HOST_CHECK(!store.setInt(EnParam::enMotorDirPin, -1));
+        HOST_CHECK(!store.setInt(EnParam::enMotorStepPin, 22));
+        HOST_CHECK(!store.setInt(EnParam::enMotorStepPin, 49));
+        HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 4);
+
+        // Необязательные могут отсутствовать
+        HOST_CHECK(store.setInt(EnParam::enMotorEnPin, -1));
+        HOST_CHECK(!store.setInt(EnParam::enServoPin, 24));
+        HOST_CHECK(store.setInt(EnParam::enServoPin, 6));
+
+        // Совпадение с другим пином и с занятым
+        HOST_CHECK(!store.setInt(EnParam::enMotorDirPin, 4));
+        HOST_CHECK(!store.setInt(EnParam::enServoPin, 2));
+        HOST_CHECK(!store.setInt(EnParam::enMotorStepPin, RESERVED_PIN));
+        HOST_CHECK(store.setInt(EnParam::enMotorEnPin, 15));
+        HOST_CHECK(!store.setFromString("m_en_pin", "6"));
+        HOST_CHECK(store.getInt(EnParam::enMotorEnPin) == 15);
+
+        HOST_CHECK(store.setFromString("m_step_pin", "7"));
+        HOST_CHECK(!store.setFromString("m_step_pin", "7x"));
+        HOST_CHECK(!store.setFromString("m_step_mode", "3"));
+        HOST_CHECK(!store.setFromString("nope", "1"));
+        HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 7);
+        store.markApplied();
+    }
+
+    void testStoredValues()
+    {
+        // Недопустимое значение отдельного ключа заменяется значением по умолчанию, остальные сохраняются
+        fresh();
+        writeStored("m_step_pin", 23);
+        writeStored("led_fps", 25);
+        {
+            ConfigStore store(testConfig());
+            store.load();
+            HOST_CHECK(!store.isFallback());
+            HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 4);
+            HOST_CHECK(store.getInt(EnParam::enLedFps) == 25);
+            store.markApplied();
+        }
+
+        // Допустимые по отдельности, но совпадающие пины: весь набор отбрасывается и перезаписывается
+        fresh();
+        writeStored("m_dir_pin", 9);
+        writeStored("m_step_pin", 9);
+        writeStored("led_fps", 25);
+        {
+            ConfigStore store(testConfig());
+            store.load();
+            HOST_CHECK(store.isFallback());
+            HOST_CHECK(store.getInt(EnParam::enMotorDirPin) == 2);
+            HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 4);
+            HOST_CHECK(store.getInt(EnParam::enLedFps) == 50);
+            store.markApplied();
+        }
+        reboot();
+        HOST_CHECK(readStored("m_dir_pin") == 2 && readStored("m_step_pin") == 4 && readStored("led_fps") == 50);
+    }
+
+    void testBootGuard()
+    {
+        fresh();
+        {
+            ConfigStore store(testConfig());
+            store.load();
+            HOST_CHECK(store.setInt(EnParam::enMotorStepPin, 5));
+            HOST_CHECK(store.flush() == ESP_OK);
+            store.markApplied();
+        }
+
+        // Паника после markApplied() - сохраненная конфигурация остается
+        reboot(ESP_RST_PANIC);
+        {
+            ConfigStore store(testConfig());
+            store.load();
+            HOST_CHECK(!store.isFallback());
+            HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 5);
+            // Сбой до markApplied()
+        }
+
+        // Обычный программный сброс до применения - не повод отбрасывать конфигурацию
+        reboot(ESP_RST_SW);
+        {
+            ConfigStore store(testConfig());
+            store.load();
+            HOST_CHECK(!store.isFallback());
+            HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 5);
+        }
+
+        // Сторожевой таймер до применения - значения по умолчанию, записанные в NVS
+        reboot(ESP_RST_TASK_WDT);
+        {
+            ConfigStore store(testConfig());
+            store.load();
+            HOST_CHECK(store.isFallback());
+            HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 4);
+            store.markApplied();
+        }
+        HOST_CHECK(readStored("m_step_pin") == 4);
+
+        // Следующая загрузка после успешного применения - без отката
+        reboot(ESP_RST_PANIC);
+        {
+            ConfigStore store(testConfig());
+            store.load();
+            HOST_CHECK(!store.isFallback());
+            store.markApplied();
+        }
+        HostSystem::setResetReason(ESP_RST_POWERON);
+    }
+
+    void testMigration()
+    {
+        fresh();
+        {
+            nvs_handle_t handle;
+            HOST_CHECK(nvs_open("config", NVS_READWRITE, &handle) == ESP_OK);
+            HOST_CHECK(nvs_set_u16(handle, "_schema", 0) == ESP_OK);
+            HOST_CHECK(nvs_set_i32(handle, "led_count", 60) == ESP_OK);
+            HOST_CHECK(nvs_commit(handle) == ESP_OK);
+            nvs_close(handle);
+        }
+
+        int calls = 0;
+        uint16_t from = UINT16_MAX;
+        ConfigStore store(testConfig());
+        store.load([&](ConfigStore& migrated, uint16_t fromVersion)
+        {
+            ++calls;
+            from = fromVersion;
+            // Схема 0 хранила количество светодиодов вдвое меньшим
+            migrated.setInt(EnParam::enLedsCount, migrated.getInt(EnParam::enLedsCount) * 2);
+        });
+        HOST_CHECK(calls == 1 && from == 0);
+        HOST_CHECK(store.getInt(EnParam::enLedsCount) == 120);
+        HOST_CHECK(store.flush() == ESP_OK);
+        store.markApplied();
+
+        // Миграция выполняется один раз
+        reboot();
+        ConfigStore again(testConfig());
+        calls = 0;
+        again.load([&](ConfigStore&, uint16_t)
+        {
+            ++calls;
+        });
+        HOST_CHECK(calls == 0);
+        HOST_CHECK(again.getInt(EnParam::enLedsCount) == 120);
+        again.markApplied();
+    }
+
+    int post(httpd_handle_t server, const std::string& body, std::string* response = nullptr)
+    {
+        HostHttpd::Exchange exchange;
+        exchange.method = HTTP_POST;
+        exchange.uri = "/config";
+        exchange.body = body;
+        HostHttpd::dispatch(server, exchange);
+        HOST_CHECK(exchange.responses == 1);
+        if (response)
+            *response = exchange.response;
+        return exchange.statusCode();
+    }
+
+    void testHttp()
+    {
+        fresh();
+        ConfigStore store(testConfig(10000, 60000));
+        store.load();
+        store.markApplied();
+
+        HttpServer http(nullptr);
+        http.start();
+        store.registerHttpHandlers(http);
+        const httpd_handle_t server = HostHttpd::lastServer();
+        HOST_CHECK(server != nullptr);
+        if (!server)
+            return;
+
+        std::string response;
+        HOST_CHECK(post(server, "m_step_pin=5&led_fps=60&m_accel=250.5", &response) == 200);
+        HOST_CHECK(store.getInt(EnParam::enMotorStepPin) == 5 && store.getInt(EnParam::enLedFps) == 60);
+        HOST_CHECK(store.getFloat(EnParam::enMotorAccel) == 250.5f);
+        HOST_CHECK(response.find("\"m_step_pin\":5") != std::string::npos);
+        HOST_CHECK(response.find("\"fallback\":false") != std::string::npos);
+        HOST_CHECK(response.find("\"pending\":true") != std::string::npos);
+
+        // Ошибка в любой паре - ничего не применяется, в том числе допустимые пары перед ней
+        HOST_CHECK(post(server, "led_fps=70&m_step_pin=22") == 400);
+        HOST_CHECK(post(server, "led_fps=70&s_inv=maybe") == 400);
+        HOST_CHECK(post(server, "led_fps=70&bogus=1") == 400);
+        HOST_CHECK(post(server, "led_fps=70&m_dir_pin") == 400);
+        HOST_CHECK(post(server, "led_fps=70&m_dir_pin=5") == 400);        // Совпадает с m_step_pin
+        HOST_CHECK(post(server, "flush=1") == 400);
+        HOST_CHECK(post(server, "") == 400);
+        HOST_CHECK(store.getInt(EnParam::enLedFps) == 60 && store.getInt(EnParam::enMotorDirPin) == 2);
+        HOST_CHECK(!store.getBool(EnParam::enServoInverted));
+
+        // Обмен пинов проверяется для набора целиком
+        HOST_CHECK(post(server, "m_dir_pin=5&m_step_pin=2&s_inv=true") == 200);
+        HOST_CHECK(store.getInt(EnParam::enMotorDirPin) == 5 && store.getInt(EnParam::enMotorStepPin) == 2);
+        HOST_CHECK(store.getBool(EnParam::enServoInverted));
+
+        // flush=1 записывает сразу
+        const uint32_t commits = HostNvs::stats().commits;
+        HOST_CHECK(post(server, "led_fps=75&flush=1", &response) == 200);
+        HOST_CHECK(HostNvs::stats().commits == commits + 1);
+        HOST_CHECK(readStored("led_fps") == 75 && readStored("m_dir_pin") == 5);
+        HOST_CHECK(response.find("\"pending\":false") != std::string::npos);
+
+        // Тело длиннее буфера
+        HOST_CHECK(post(server, "led_fps=" + std::string(600, '1')) == 400);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        HostNvs::setFile(argv[1]);
+
+    testDefaults();
+    testBatching();
+    testPersistence();
+    testCommitFailure();
+    testPinValidation();
+    testStoredValues();
+    testBootGuard();
+    testMigration();
+    testHttp();
+    return HostCheck::result();
+}
@@ -0,0 +1,42 @@
+// Проверки в тестах на ПК (tools/*.cpp): провал печатается с местом и условием, счетчик провалов - код
+// возврата main через HostCheck::result()
+#pragma once
+
+#include <cstdio>
+
+namespace HostCheck
+{
+    inline int& failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline int result()
+    {
+        if (failures() == 0)
+            printf("OK\n");
+        else
+            printf("FAILED: %d check(s)\n", failures());
+        return failures() == 0 ? 0 : 1;
+    }
+}
+
+#define HOST_CHECK(condition) do                                                            \
+    {                                                                                       \
+        if (!(condition))                                                                   \
+        {                                                                                   \
+            printf("CHECK FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition);             \
+            ++HostCheck::failures();                                                        \
+        }                                                                                   \
+    } while (0)
+
+#define HOST_CHECK_MSG(condition, format, ...) do                                           \
+    {                                                                                       \
+        if (!(condition))                                                                   \
+        {                                                                                   \
+            printf("CHECK FAILED %s:%d: %s: " format "\n", __FILE__, __LINE__, #condition,  \
+                   ##__VA_ARGS__);                                                          \
+            ++HostCheck::failures();                                                        \
+        }                                                                                   \
+    } while (0)
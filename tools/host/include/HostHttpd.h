@@ -0,0 +1,67 @@
+// Заменитель esp_http_server для тестов на ПК: запрос с телом и строкой запроса, перехват ответа и вызов
+// зарегистрированного обработчика
+#pragma once
+
+#include "esp_http_server.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace HostHttpd
+{
+    // Обмен "запрос - ответ". Живет до завершения ответа (в том числе асинхронного)
+    struct Exchange
+    {
+        httpd_method_t method = HTTP_GET;
+        std::string uri;                            // Путь со строкой запроса ("/a?b=1")
+        std::string body;                           // Тело запроса
+        int recvTimeouts = 0;                       // Сколько раз httpd_req_recv вернет таймаут до данных (-1 - всегда)
+        size_t recvChunk = SIZE_MAX;                // Максимум байт за один вызов httpd_req_recv
+
+        // Ответ
+        std::string status = "200 OK";
+        std::string type;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string response;
+        int responses = 0;                          // Завершенных ответов (у корректного обработчика - ровно 1)
+        int recvCalls = 0;                          // Вызовов httpd_req_recv
+        bool asyncBegun = false;                    // Вызван httpd_req_async_handler_begin
+        bool asyncCompleted = false;                // Вызван httpd_req_async_handler_complete
+        int64_t finishedUs = 0;                     // Время завершения ответа (esp_timer_get_time)
+
+        size_t bodyPos = 0;
+        std::mutex lock;
+        std::condition_variable cv;
+
+        /**
+         * @brief Метод для ожидания завершения ответа
+         * @param timeoutMs: Таймаут, мс
+         * @return true если ответ завершен (и асинхронная копия запроса освобождена)
+         */
+        bool waitFinished(uint32_t timeoutMs);
+
+        /**
+         * @brief Метод для получения кода ответа из строки статуса
+         * @return Код ответа (200, 503, ...)
+         */
+        int statusCode() const { return atoi(status.c_str()); }
+    };
+
+    /**
+     * @brief Функция для вызова обработчика, зарегистрированного на сервере (в вызывающем потоке)
+     * @param server: Сервер (httpd_start)
+     * @param exchange: Обмен
+     * @return Результат обработчика; ESP_ERR_NOT_FOUND и ответ 404 если обработчика нет
+     */
+    esp_err_t dispatch(httpd_handle_t server, Exchange& exchange);
+
+    /**
+     * @brief Функция для получения последнего запущенного сервера (когда httpd_start вызывает проверяемый класс)
+     * @return Сервер или nullptr
+     */
+    httpd_handle_t lastServer();
+}
@@ -0,0 +1,59 @@
+// Модель LEDC для проверок на ПК (tools/host/src/ledc.cpp).
+// Запись скважности (ledc_set_duty) не меняет выход до защелкивания (ledc_update_duty); все операции с каналами
+// пишутся в журнал с признаком критической секции. Плавное изменение завершается через заданное время из
+// отдельного потока (как из прерывания), шаг считается так же, как в драйвере, и урезается до LEDC_LL_DUTY_SCALE_MAX
+#pragma once
+
+#include "driver/ledc.h"
+#include <cstdint>
+#include <vector>
+
+namespace HostLedc
+{
+    enum class EnOp : uint8_t
+    {
+        enSetDuty,
+        enUpdateDuty,
+        enFadeStart,
+        enFadeStop,
+    };
+
+    struct Op
+    {
+        EnOp op;
+        int channel;
+        uint32_t duty;          // Записанная скважность (enSetDuty, enFadeStart - конечная)
+        bool inCritical;        // Вызов из критической секции
+    };
+
+    struct FadeStats
+    {
+        uint32_t started = 0;   // Запущено плавных изменений
+        uint32_t clamped = 0;   // Из них с урезанным шагом (длились бы дольше заданного)
+    };
+
+    /**
+     * @brief Функция для сброса модели (каналы, журнал, статистика)
+     */
+    void reset();
+
+    /**
+     * @brief Функция для получения журнала операций с каналами
+     */
+    std::vector<Op> ops();
+
+    /**
+     * @brief Функция для очистки журнала операций
+     */
+    void clearOps();
+
+    /**
+     * @brief Функция для получения скважности на выходе канала (защелкнутой или текущей плавного изменения)
+     */
+    uint32_t outputDuty(int channel);
+
+    /**
+     * @brief Функция для получения статистики плавных изменений
+     */
+    FadeStats fadeStats();
+}
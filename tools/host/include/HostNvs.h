@@ -0,0 +1,47 @@
+// Модель NVS для проверок на ПК (tools/host/src/nvs.cpp).
+// Записи через дескриптор видны сразу, но в "флеш" (файл) попадают только при nvs_commit: reboot() теряет
+// незакоммиченные изменения, как отключение питания. Файл - текст "пространство ключ тип значение" по строке
+// на запись, его можно оставить между запусками. Считаются коммиты и записи ключей (износ), коммиты можно
+// заставить завершаться ошибкой
+#pragma once
+
+#include "nvs_flash.h"
+#include <cstdint>
+#include <string>
+
+namespace HostNvs
+{
+    struct Stats
+    {
+        uint32_t commits = 0;           // Успешных nvs_commit с изменениями
+        uint32_t writes = 0;            // Записанных во "флеш" значений
+        uint32_t failedCommits = 0;     // Коммитов, завершенных ошибкой
+    };
+
+    /**
+     * @brief Функция для выбора файла хранилища (пустая строка - только память); загружается nvs_flash_init
+     * @param path: Путь к файлу
+     */
+    void setFile(const std::string& path);
+
+    /**
+     * @brief Функция для перезагрузки: незакоммиченные изменения теряются, хранилище читается из файла заново
+     */
+    void reboot();
+
+    /**
+     * @brief Функция для сброса хранилища (и файла) и статистики
+     */
+    void reset();
+
+    /**
+     * @brief Функция для провала следующих коммитов
+     * @param count: Сколько коммитов вернут ESP_FAIL
+     */
+    void failCommits(int count);
+
+    /**
+     * @brief Функция для получения статистики
+     */
+    Stats stats();
+}
@@ -0,0 +1,40 @@
+// Модель RMT для проверок на ПК (tools/host/src/rmt.cpp): менеджеры синхронизации передачи (состав каналов и
+// число перезапусков) и прогон кодировщика через память канала порциями, как при передаче
+#pragma once
+
+#include "driver/rmt_tx.h"
+#include "driver/rmt_encoder.h"
+#include <cstdint>
+#include <vector>
+
+namespace HostRmt
+{
+    struct SyncManager
+    {
+        std::vector<rmt_channel_handle_t> channels;     // Каналы в порядке регистрации
+        uint32_t resets = 0;                            // Вызовов rmt_sync_reset
+        bool deleted = false;
+    };
+
+    /**
+     * @brief Функция для сброса модели
+     */
+    void reset();
+
+    /**
+     * @brief Функция для получения всех созданных менеджеров синхронизации в порядке создания
+     */
+    std::vector<SyncManager> syncManagers();
+
+    /**
+     * @brief Функция для кодирования одной транзакции: кодировщик вызывается, пока не завершит, каждый раз
+     *        с освободившейся половиной памяти канала (пинг-понг), как из прерывания передачи
+     * @param encoder: Кодировщик
+     * @param data: Данные транзакции
+     * @param size: Размер данных, байт
+     * @param memSymbols: Память канала, символов
+     * @return Все символы транзакции подряд (пусто, если кодировщик перестал продвигаться)
+     */
+    std::vector<rmt_symbol_word_t> encode(rmt_encoder_handle_t encoder, const void* data, size_t size,
+                                          size_t memSymbols = 48);
+}
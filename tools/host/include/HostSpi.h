@@ -0,0 +1,37 @@
+// Модель ведущего SPI для проверок на ПК (tools/host/src/spi_master.cpp).
+// Очередь транзакций устройства передается на линию одна за другой с заданной частотой: транзакция начинается не
+// раньше постановки в очередь и конца предыдущей, результат (spi_device_get_trans_result) выдается по окончании
+// передачи с ожиданием в реальном времени. Передача каждой транзакции пишется в журнал: данные на момент постановки
+// в очередь (их читает DMA), времена и признак изменения буфера до окончания передачи
+#pragma once
+
+#include "driver/spi_master.h"
+#include <cstdint>
+#include <vector>
+
+namespace HostSpi
+{
+    struct Transfer
+    {
+        std::vector<uint8_t> data;      // Переданные байты
+        int64_t queuedUs;               // Постановка в очередь
+        int64_t startUs;                // Начало передачи на линии
+        int64_t endUs;                  // Конец передачи
+        bool changedInFlight;           // Буфер изменен до конца передачи (DMA мог прочитать новые данные)
+    };
+
+    /**
+     * @brief Функция для сброса модели (журнал всех шин)
+     */
+    void reset();
+
+    /**
+     * @brief Функция для получения журнала переданных транзакций шины в порядке передачи
+     */
+    std::vector<Transfer> transfers(spi_host_device_t host);
+
+    /**
+     * @brief Функция для получения всех переданных байт шины подряд (как поток на линии)
+     */
+    std::vector<uint8_t> wire(spi_host_device_t host);
+}
@@ -0,0 +1,13 @@
+// Управление заменителем esp_system на ПК (tools/host/src/esp_system.cpp)
+#pragma once
+
+#include "esp_system.h"
+
+namespace HostSystem
+{
+    /**
+     * @brief Функция для задания причины сброса, которую вернет esp_reset_reason (по умолчанию ESP_RST_POWERON)
+     * @param reason: Причина сброса
+     */
+    void setResetReason(esp_reset_reason_t reason);
+}
@@ -0,0 +1,13 @@
+// Заменитель driver/gpio.h для сборки на ПК (tools/host)
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_NC             (-1)
+#define SOC_GPIO_PIN_COUNT      49
+#define GPIO_IS_VALID_GPIO(pin)         ((pin) >= 0 && (pin) < SOC_GPIO_PIN_COUNT && !((pin) >= 22 && (pin) <= 25))
+#define GPIO_IS_VALID_OUTPUT_GPIO(pin)  GPIO_IS_VALID_GPIO(pin)
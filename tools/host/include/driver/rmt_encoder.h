@@ -0,0 +1,48 @@
+// Заменитель driver/rmt_encoder.h для сборки на ПК (tools/host): простой кодировщик (HostRmt::encode())
+#pragma once
+
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef enum
+{
+    RMT_ENCODING_RESET = 0,
+    RMT_ENCODING_COMPLETE = (1 << 0),
+    RMT_ENCODING_MEM_FULL = (1 << 1),
+    RMT_ENCODING_WITH_EOF = (1 << 2),
+} rmt_encode_state_t;
+
+typedef struct rmt_encoder_t rmt_encoder_t;
+typedef rmt_encoder_t* rmt_encoder_handle_t;
+
+struct rmt_encoder_t
+{
+    size_t (*encode)(rmt_encoder_t* encoder, rmt_channel_handle_t tx_channel, const void* primary_data,
+                     size_t data_size, rmt_encode_state_t* ret_state);
+    esp_err_t (*reset)(rmt_encoder_t* encoder);
+    esp_err_t (*del)(rmt_encoder_t* encoder);
+};
+
+typedef size_t (*rmt_encode_simple_cb_t)(const void* data, size_t data_size, size_t symbols_written,
+                                         size_t symbols_free, rmt_symbol_word_t* symbols, bool* done, void* arg);
+
+typedef struct
+{
+    rmt_encode_simple_cb_t callback;
+    void* arg;
+    size_t min_chunk_size;
+} rmt_simple_encoder_config_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t* config, rmt_encoder_handle_t* ret_encoder);
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder);
+esp_err_t rmt_encoder_reset(rmt_encoder_handle_t encoder);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+// Заменитель driver/rmt_types.h для сборки на ПК (tools/host)
+#pragma once
+
+#include <stdint.h>
+
+typedef struct rmt_channel_t* rmt_channel_handle_t;
+typedef struct rmt_sync_manager_t* rmt_sync_manager_handle_t;
+
+typedef int rmt_clock_source_t;
+
+#define RMT_CLK_SRC_DEFAULT 0
+
+// Символ RMT: два уровня с длительностями в тиках разрешения канала
+typedef union
+{
+    struct
+    {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_symbol_word_t;
@@ -0,0 +1,10 @@
+// Заменитель ESP-IDF для сборки на ПК (tools/host): атрибуты размещения в памяти не действуют
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define EXT_RAM_BSS_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+#define FORCE_INLINE_ATTR static inline __attribute__((always_inline))
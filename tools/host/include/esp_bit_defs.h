@@ -0,0 +1,5 @@
+// Заменитель ESP-IDF для сборки на ПК (tools/host)
+#pragma once
+
+#define BIT(nr)     (1UL << (nr))
+#define BIT64(nr)   (1ULL << (nr))
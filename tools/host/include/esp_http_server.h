@@ -0,0 +1,120 @@
+// Заменитель esp_http_server для сборки на ПК (tools/host): обработчики вызываются из потока теста через
+// HostHttpd::dispatch() (как из единственной задачи httpd), ответ и тело запроса - в HostHttpd::Exchange
+#pragma once
+
+#include "esp_err.h"
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTPD_MAX_URI_LEN       512
+#define HTTPD_TYPE_TEXT         "text/html"
+#define HTTPD_TYPE_JSON         "application/json"
+#define HTTPD_TYPE_OCTET        "application/octet-stream"
+#define HTTPD_RESP_USE_STRLEN   -1
+
+#define HTTPD_SOCK_ERR_FAIL     -1
+#define HTTPD_SOCK_ERR_INVALID  -2
+#define HTTPD_SOCK_ERR_TIMEOUT  -3
+
+#define ESP_ERR_HTTPD_BASE          0xb000
+#define ESP_ERR_HTTPD_RESULT_TRUNC  (ESP_ERR_HTTPD_BASE + 6)
+
+typedef void* httpd_handle_t;
+
+typedef enum
+{
+    HTTP_DELETE = 0,
+    HTTP_GET = 1,
+    HTTP_HEAD = 2,
+    HTTP_POST = 3,
+    HTTP_PUT = 4,
+} httpd_method_t;
+
+typedef enum
+{
+    HTTPD_500_INTERNAL_SERVER_ERROR = 0,
+    HTTPD_501_METHOD_NOT_IMPLEMENTED,
+    HTTPD_505_VERSION_NOT_SUPPORTED,
+    HTTPD_400_BAD_REQUEST,
+    HTTPD_401_UNAUTHORIZED,
+    HTTPD_403_FORBIDDEN,
+    HTTPD_404_NOT_FOUND,
+    HTTPD_405_METHOD_NOT_ALLOWED,
+    HTTPD_408_REQ_TIMEOUT,
+    HTTPD_411_LENGTH_REQUIRED,
+    HTTPD_414_URI_TOO_LONG,
+    HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE,
+} httpd_err_code_t;
+
+typedef struct httpd_req
+{
+    httpd_handle_t handle;
+    int method;
+    const char uri[HTTPD_MAX_URI_LEN + 1];
+    size_t content_len;
+    void* aux;                      // HostHttpd::Exchange
+    void* user_ctx;
+    void* sess_ctx;
+    void (*free_ctx)(void* ctx);
+    bool ignore_sess_ctx_changes;
+} httpd_req_t;
+
+typedef struct httpd_uri
+{
+    const char* uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t* req);
+    void* user_ctx;
+} httpd_uri_t;
+
+typedef struct
+{
+    unsigned task_priority;
+    size_t stack_size;
+    int core_id;
+    uint16_t server_port;
+    uint16_t ctrl_port;
+    uint16_t max_open_sockets;
+    uint16_t max_uri_handlers;
+    bool lru_purge_enable;
+    void* global_user_ctx;
+    void (*global_user_ctx_free_fn)(void* ctx);
+    esp_err_t (*open_fn)(httpd_handle_t handle, int sockfd);
+    void (*close_fn)(httpd_handle_t handle, int sockfd);
+} httpd_config_t;
+
+void* httpd_get_global_user_ctx(httpd_handle_t handle);
+
+#ifdef __cplusplus
+#define HTTPD_DEFAULT_CONFIG() httpd_config_t{5, 4096, 0x7fffffff, 80, 32768, 7, 8, false}
+#endif
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config);
+esp_err_t httpd_stop(httpd_handle_t handle);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri);
+
+esp_err_t httpd_resp_send(httpd_req_t* req, const char* buf, ssize_t len);
+esp_err_t httpd_resp_sendstr(httpd_req_t* req, const char* str);
+esp_err_t httpd_resp_send_chunk(httpd_req_t* req, const char* buf, ssize_t len);
+esp_err_t httpd_resp_sendstr_chunk(httpd_req_t* req, const char* str);
+esp_err_t httpd_resp_set_status(httpd_req_t* req, const char* status);
+esp_err_t httpd_resp_set_hdr(httpd_req_t* req, const char* field, const char* value);
+esp_err_t httpd_resp_set_type(httpd_req_t* req, const char* type);
+esp_err_t httpd_resp_send_err(httpd_req_t* req, httpd_err_code_t error, const char* message);
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t* req, httpd_req_t** out);
+esp_err_t httpd_req_async_handler_complete(httpd_req_t* req);
+
+int httpd_req_recv(httpd_req_t* req, char* buf, size_t len);
+size_t httpd_req_get_url_query_len(httpd_req_t* req);
+esp_err_t httpd_req_get_url_query_str(httpd_req_t* req, char* buf, size_t len);
+esp_err_t httpd_query_key_value(const char* query, const char* key, char* value, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,8 @@
+// Заменитель ESP-IDF для сборки на ПК (tools/host)
+#pragma once
+
+#define ESP_INTR_FLAG_LEVEL1    (1 << 1)
+#define ESP_INTR_FLAG_LEVEL2    (1 << 2)
+#define ESP_INTR_FLAG_LEVEL3    (1 << 3)
+#define ESP_INTR_FLAG_SHARED    (1 << 8)
+#define ESP_INTR_FLAG_IRAM      (1 << 10)
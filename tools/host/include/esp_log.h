@@ -0,0 +1,47 @@
+// Заменитель ESP-IDF для сборки на ПК (tools/host): лог в stderr, уровень - переменная окружения HOST_LOG
+// (E, W, I, D; по умолчанию W)
+#pragma once
+
+#include "esp_err.h"
+#include <stdio.h>
+
+typedef enum
+{
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool host_log_enabled(esp_log_level_t level);
+
+static inline void esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+    (void)tag;
+    (void)level;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#define HOST_LOG(level, letter, tag, format, ...) do                                        \
+    {                                                                                       \
+        if (host_log_enabled(level))                                                        \
+            fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__);               \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
+#define ESP_EARLY_LOGE ESP_LOGE
+#define ESP_EARLY_LOGW ESP_LOGW
+#define ESP_DRAM_LOGE ESP_LOGE
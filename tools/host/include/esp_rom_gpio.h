@@ -0,0 +1,14 @@
+// Заменитель ESP-IDF для сборки на ПК (tools/host): матрица GPIO не моделируется
+#pragma once
+
+#include "esp_rom_sys.h"    // В ESP-IDF esp_rom_delay_us() приходит транзитивно
+#include <stdint.h>
+#include <stdbool.h>
+
+static inline void esp_rom_gpio_connect_out_signal(uint32_t gpio_num, uint32_t signal_idx, bool out_inv, bool oen_inv)
+{
+    (void)gpio_num;
+    (void)signal_idx;
+    (void)out_inv;
+    (void)oen_inv;
+}
@@ -0,0 +1,14 @@
+// Заменитель ESP-IDF для сборки на ПК (tools/host)
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void esp_rom_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
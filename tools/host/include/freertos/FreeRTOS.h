@@ -0,0 +1,64 @@
+// Заменитель FreeRTOS (ESP-IDF) для сборки на ПК (tools/host): задачи - потоки POSIX, тик 1 мс.
+// Критические секции - один общий рекурсивный мьютекс (как запрет прерываний на одноядерной системе)
+#pragma once
+
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  1
+#define pdFAIL                  0
+#define portMAX_DELAY           0xffffffffu
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define configMAX_PRIORITIES    25
+#define configMAX_TASK_NAME_LEN 16
+#define portNUM_PROCESSORS      2
+#define tskNO_AFFINITY          0x7fffffff
+
+typedef struct
+{
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void vPortEnterCritical(portMUX_TYPE* mux);
+void vPortExitCritical(portMUX_TYPE* mux);
+BaseType_t xPortGetCoreID(void);
+BaseType_t xPortInIsrContext(void);
+
+// Только на ПК: глубина критической секции текущего потока (проверки заменителей периферии)
+int xPortHostCriticalNesting(void);
+
+static inline void portYIELD_FROM_ISR_host(BaseType_t woken)
+{
+    (void)woken;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#define portENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux)     vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)      vPortExitCritical(mux)
+#define portENTER_CRITICAL_SAFE(mux)    vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_SAFE(mux)     vPortExitCritical(mux)
+#define taskENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portYIELD_FROM_ISR(...)         ((void)0)
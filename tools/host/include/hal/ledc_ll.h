@@ -0,0 +1,6 @@
+// Заменитель hal/ledc_ll.h для сборки на ПК (tools/host): пределы плавного изменения ESP32/ESP32-S3 (10 бит)
+#pragma once
+
+#define LEDC_LL_DUTY_NUM_MAX    1023
+#define LEDC_LL_DUTY_CYCLE_MAX  1023
+#define LEDC_LL_DUTY_SCALE_MAX  1023
@@ -0,0 +1,10 @@
+// Заменитель lwIP для сборки на ПК (tools/host): сокеты POSIX
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#define closesocket(s) close(s)
@@ -0,0 +1,6 @@
+// Заменитель конфигурации ESP-IDF для сборки на ПК (tools/host): двухъядерный кристалл без PSRAM
+#pragma once
+
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_FREERTOS_NUMBER_OF_CORES 2
+#define CONFIG_LOG_MAXIMUM_LEVEL 3
@@ -0,0 +1,4 @@
+// Заменитель soc/soc.h для сборки на ПК (tools/host)
+#pragma once
+
+#define APB_CLK_FREQ    (80 * 1000000)
@@ -0,0 +1,4 @@
+// Заменитель soc/soc_caps.h для сборки на ПК (tools/host): возможности ESP32-S3, которые учитывает код
+#pragma once
+
+#define SOC_RMT_SUPPORT_TX_SYNCHRO  1
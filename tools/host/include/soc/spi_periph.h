@@ -0,0 +1,19 @@
+// Заменитель soc/spi_periph.h для сборки на ПК (tools/host)
+#pragma once
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint8_t spid_out;
+} spi_signal_conn_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const spi_signal_conn_t spi_periph_signal[];
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""Сборка и запуск всех проверок на ПК (tools/*.cpp с заменителями ESP-IDF из tools/host).
+
+Использование (из корня репозитория):
+    tools/host/run_all.py [--build-dir _host_build] [--only имя ...] [--bench]
+
+Команды сборки повторяют заголовки файлов проверок. Замеры (bench_host) по умолчанию только собираются:
+с --bench они запускаются, а вывод сохраняется в <build-dir>/bench_host.txt для tools/bench_compare.py.
+Код возврата 1, если хотя бы одна проверка не собралась или завершилась с ошибкой.
+"""
+
+import argparse
+import glob
+import os
+import subprocess
+import sys
+
+CXX = ["g++", "-std=c++17", "-O2", "-pthread"]
+CC = ["gcc", "-std=gnu11", "-O2"]
+
+HOST = ["tools/host/src/freertos.cpp", "tools/host/src/esp_system.cpp"]
+LED_STRIP_INCLUDES = ["-Itools/host/include", "-Icomponents/led_strip/include", "-Icomponents/led_strip/interface"]
+
+# Имя, исходники и флаги, аргументы запуска (None - только сборка)
+CHECKS = [
+    ("pool_stress", ["-Icomponents/block_pool/include", "tools/pool_stress.cpp",
+                     "components/block_pool/src/BlockPool.cpp"], []),
+    ("trajectory_tool", ["-Isrc", "tools/trajectory_tool.cpp", "src/Trajectory/TrajectoryFormat.cpp"], None),
+    ("servo_bank_host", ["-Itools/host/include", "-Isrc", "tools/servo_bank_host.cpp", "src/Servo_pwm/ServoBank.cpp",
+                         "tools/host/src/ledc.cpp"] + HOST, []),
+    ("http_async_load", ["-Itools/host/include", "-Isrc", "tools/http_async_load.cpp", "src/Http/HttpAsyncWorkers.cpp",
+                         "tools/host/src/esp_http_server.cpp"] + HOST, []),
+    ("udp_control_loopback", ["-Itools/host/include", "-Isrc", "tools/udp_control_loopback.cpp",
+                              "src/Control/UdpControl.cpp", "tools/host/src/sha256.cpp"] + HOST, []),
+    ("config_store_host", ["-Itools/host/include", "-Isrc", "-Isrc/Http", "-Icomponents/led_strip/include",
+                           "-Icomponents/block_pool/include", "tools/config_store_host.cpp",
+                           "src/Config/ConfigStore.cpp", "src/Http/HttpServer.cpp", "src/Http/HttpAsyncWorkers.cpp",
+                           "src/Helpers/CorePlacement.cpp", "components/block_pool/src/BlockPool.cpp",
+                           "tools/host/src/nvs.cpp", "tools/host/src/esp_http_server.cpp"] + HOST, []),
+    ("led_strip_host", LED_STRIP_INCLUDES + ["-Icomponents/led_strip/src", "-Icomponents/microbench/include",
+                                             "tools/led_strip_host.cpp", "components/microbench/src/MicroBench.cpp",
+                                             "tools/host/src/spi_master.cpp", "tools/host/src/rmt.cpp"] + HOST, []),
+    ("bench_host", ["-Itools/host/include", "-Isrc", "-Icomponents/microbench/include",
+                    "-Icomponents/led_strip/include", "tools/bench_host.cpp", "src/Benchmarks/AlgorithmBenchmarks.cpp",
+                    "src/Benchmarks/HardwareBenchmarks.cpp", "src/Trajectory/TrajectoryFormat.cpp",
+                    "src/StepMotor/StepGenerator.cpp", "src/Servo_pwm/ServoControl.cpp", "src/Servo_pwm/ServoBank.cpp",
+                    "src/Helpers/CorePlacement.cpp", "components/microbench/src/MicroBench.cpp",
+                    "tools/host/src/mcpwm.cpp", "tools/host/src/gptimer.cpp", "tools/host/src/ledc.cpp",
+                    "tools/host/src/rmt.cpp", "tools/host/src/spi_master.cpp"] + HOST, None),
+]
+
+# Проверки, которым нужны объектные файлы компонента ленты (исходники на C)
+NEEDS_LED_STRIP = {"led_strip_host", "bench_host"}
+
+
+def run(command, **kwargs):
+    result = subprocess.run(command, **kwargs)
+    return result.returncode == 0
+
+
+def build_led_strip(build_dir):
+    objects_dir = os.path.join(build_dir, "led_strip")
+    os.makedirs(objects_dir, exist_ok=True)
+    objects = []
+    for source in sorted(glob.glob("components/led_strip/src/*.c")):
+        obj = os.path.join(objects_dir, os.path.basename(source)[:-2] + ".o")
+        if not run(CC + ["-c"] + LED_STRIP_INCLUDES + [source, "-o", obj]):
+            return None
+        objects.append(obj)
+    return objects
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--build-dir", default="_host_build")
+    parser.add_argument("--only", nargs="+", metavar="NAME", help="только перечисленные проверки")
+    parser.add_argument("--bench", action="store_true", help="запустить также замеры bench_host")
+    args = parser.parse_args()
+
+    if not os.path.isdir("tools/host"):
+        print("Run from the repository root", file=sys.stderr)
+        return 2
+    os.makedirs(args.build_dir, exist_ok=True)
+
+    checks = [check for check in CHECKS if not args.only or check[0] in args.only]
+    led_strip_objects = []
+    if any(name in NEEDS_LED_STRIP for name, _, _ in checks):
+        led_strip_objects = build_led_strip(args.build_dir)
+
+    results = []
+    for name, sources, run_args in checks:
+        binary = os.path.join(args.build_dir, name)
+        extra = led_strip_objects if name in NEEDS_LED_STRIP else []
+        print(f"=== {name}", flush=True)
+        if extra is None or not run(CXX + sources + extra + ["-o", binary]):
+            results.append((name, "BUILD FAILED"))
+            continue
+        if name == "bench_host" and args.bench:
+            with open(os.path.join(args.build_dir, "bench_host.txt"), "w", encoding="utf-8") as output:
+                ok = run([binary], stdout=output)
+        elif run_args is None:
+            results.append((name, "built"))
+            continue
+        else:
+            ok = run([binary] + run_args)
+        results.append((name, "OK" if ok else "FAILED"))
+
+    print()
+    for name, status in results:
+        print(f"{name:24} {status}")
+    return 0 if all(status in ("OK", "built") for _, status in results) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
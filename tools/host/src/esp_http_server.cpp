@@ -0,0 +1,304 @@
+// Заменитель esp_http_server для сборки на ПК: таблица обработчиков и обмен запроса с ответом в памяти
+
+#include "HostHttpd.h"
+#include "esp_timer.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <list>
+
+namespace
+{
+    struct Server
+    {
+        std::mutex lock;
+        std::list<httpd_uri_t> uris;
+        httpd_config_t config = {};
+    };
+
+    std::atomic<httpd_handle_t> g_lastServer{nullptr};
+
+    HostHttpd::Exchange& exchangeOf(httpd_req_t* req)
+    {
+        return *static_cast<HostHttpd::Exchange*>(req->aux);
+    }
+
+    httpd_req_t* newRequest(const httpd_req_t& from)
+    {
+        auto* req = new httpd_req_t(from);
+        return req;
+    }
+
+    void finish(httpd_req_t* req)
+    {
+        HostHttpd::Exchange& exchange = exchangeOf(req);
+        std::lock_guard<std::mutex> lock(exchange.lock);
+        ++exchange.responses;
+        exchange.finishedUs = esp_timer_get_time();
+        exchange.cv.notify_all();
+    }
+
+    void append(httpd_req_t* req, const char* buf, ssize_t len)
+    {
+        HostHttpd::Exchange& exchange = exchangeOf(req);
+        std::lock_guard<std::mutex> lock(exchange.lock);
+        if (buf)
+            exchange.response.append(buf, len == HTTPD_RESP_USE_STRLEN ? strlen(buf) : static_cast<size_t>(len));
+    }
+
+    const char* statusOf(httpd_err_code_t error)
+    {
+        switch (error)
+        {
+        case HTTPD_400_BAD_REQUEST: return "400 Bad Request";
+        case HTTPD_404_NOT_FOUND: return "404 Not Found";
+        case HTTPD_408_REQ_TIMEOUT: return "408 Request Timeout";
+        default: return "500 Internal Server Error";
+        }
+    }
+}
+
+bool HostHttpd::Exchange::waitFinished(uint32_t timeoutMs)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    return cv.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                       [this] { return responses != 0 && (!asyncBegun || asyncCompleted); });
+}
+
+esp_err_t HostHttpd::dispatch(httpd_handle_t handle, Exchange& exchange)
+{
+    auto* server = static_cast<Server*>(handle);
+
+    // Каждый обмен - новое соединение
+    if (server->config.open_fn && server->config.open_fn(handle, 0) != ESP_OK)
+        return ESP_FAIL;
+
+    const std::string path = exchange.uri.substr(0, exchange.uri.find('?'));
+
+    httpd_req_t req = {};
+    req.handle = handle;
+    req.method = exchange.method;
+    strncpy(const_cast<char*>(req.uri), exchange.uri.c_str(), HTTPD_MAX_URI_LEN);
+    req.content_len = exchange.body.size();
+    req.aux = &exchange;
+
+    esp_err_t (*handler)(httpd_req_t*) = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(server->lock);
+        for (const httpd_uri_t& uri : server->uris)
+        {
+            if (uri.method == exchange.method && path == uri.uri)
+            {
+                handler = uri.handler;
+                req.user_ctx = uri.user_ctx;
+                break;
+            }
+        }
+    }
+    if (!handler)
+    {
+        httpd_resp_send_err(&req, HTTPD_404_NOT_FOUND, "Not found");
+        return ESP_ERR_NOT_FOUND;
+    }
+    return handler(&req);
+}
+
+httpd_handle_t HostHttpd::lastServer()
+{
+    return g_lastServer;
+}
+
+extern "C" {
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config)
+{
+    auto* server = new Server;
+    server->config = *config;
+    *handle = server;
+    g_lastServer = server;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+    auto* server = static_cast<Server*>(handle);
+    if (server->config.global_user_ctx)
+    {
+        if (server->config.global_user_ctx_free_fn)
+            server->config.global_user_ctx_free_fn(server->config.global_user_ctx);
+        else
+            free(server->config.global_user_ctx);
+    }
+    httpd_handle_t expected = server;
+    g_lastServer.compare_exchange_strong(expected, nullptr);
+    delete server;
+    return ESP_OK;
+}
+
+void* httpd_get_global_user_ctx(httpd_handle_t handle)
+{
+    return static_cast<Server*>(handle)->config.global_user_ctx;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri)
+{
+    auto* server = static_cast<Server*>(handle);
+    std::lock_guard<std::mutex> lock(server->lock);
+    if (server->uris.size() >= server->config.max_uri_handlers)
+        return ESP_ERR_NO_MEM;
+    for (const httpd_uri_t& item : server->uris)
+    {
+        if (item.method == uri->method && strcmp(item.uri, uri->uri) == 0)
+            return ESP_ERR_INVALID_STATE;
+    }
+    server->uris.push_back(*uri);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t* req, const char* buf, ssize_t len)
+{
+    append(req, buf, len);
+    finish(req);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_sendstr(httpd_req_t* req, const char* str)
+{
+    return httpd_resp_send(req, str, HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t* req, const char* buf, ssize_t len)
+{
+    if (!buf || len == 0)
+    {
+        finish(req);
+        return ESP_OK;
+    }
+    append(req, buf, len);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_sendstr_chunk(httpd_req_t* req, const char* str)
+{
+    return httpd_resp_send_chunk(req, str, str ? HTTPD_RESP_USE_STRLEN : 0);
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t* req, const char* status)
+{
+    HostHttpd::Exchange& exchange = exchangeOf(req);
+    std::lock_guard<std::mutex> lock(exchange.lock);
+    exchange.status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t* req, const char* field, const char* value)
+{
+    HostHttpd::Exchange& exchange = exchangeOf(req);
+    std::lock_guard<std::mutex> lock(exchange.lock);
+    exchange.headers.emplace_back(field, value);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t* req, const char* type)
+{
+    HostHttpd::Exchange& exchange = exchangeOf(req);
+    std::lock_guard<std::mutex> lock(exchange.lock);
+    exchange.type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t* req, httpd_err_code_t error, const char* message)
+{
+    httpd_resp_set_status(req, statusOf(error));
+    httpd_resp_set_type(req, HTTPD_TYPE_TEXT);
+    return httpd_resp_sendstr(req, message ? message : "");
+}
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t* req, httpd_req_t** out)
+{
+    HostHttpd::Exchange& exchange = exchangeOf(req);
+    {
+        std::lock_guard<std::mutex> lock(exchange.lock);
+        if (exchange.asyncBegun)
+            return ESP_ERR_INVALID_STATE;
+        exchange.asyncBegun = true;
+    }
+    *out = newRequest(*req);
+    return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t* req)
+{
+    HostHttpd::Exchange& exchange = exchangeOf(req);
+    {
+        std::lock_guard<std::mutex> lock(exchange.lock);
+        exchange.asyncCompleted = true;
+        exchange.cv.notify_all();
+    }
+    delete req;
+    return ESP_OK;
+}
+
+int httpd_req_recv(httpd_req_t* req, char* buf, size_t len)
+{
+    HostHttpd::Exchange& exchange = exchangeOf(req);
+    std::lock_guard<std::mutex> lock(exchange.lock);
+    ++exchange.recvCalls;
+    if (exchange.recvTimeouts != 0)
+    {
+        if (exchange.recvTimeouts > 0)
+            --exchange.recvTimeouts;
+        return HTTPD_SOCK_ERR_TIMEOUT;
+    }
+    const size_t size = std::min({len, exchange.recvChunk, exchange.body.size() - exchange.bodyPos});
+    memcpy(buf, exchange.body.data() + exchange.bodyPos, size);
+    exchange.bodyPos += size;
+    return static_cast<int>(size);
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t* req)
+{
+    const char* query = strchr(req->uri, '?');
+    return query ? strlen(query + 1) : 0;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t* req, char* buf, size_t len)
+{
+    const char* query = strchr(req->uri, '?');
+    if (!query)
+        return ESP_ERR_NOT_FOUND;
+    if (strlen(query + 1) >= len)
+        return ESP_ERR_HTTPD_RESULT_TRUNC;
+    strcpy(buf, query + 1);
+    return ESP_OK;
+}
+
+esp_err_t httpd_query_key_value(const char* query, const char* key, char* value, size_t len)
+{
+    const size_t keyLen = strlen(key);
+    const char* pos = query;
+    while (pos && *pos)
+    {
+        const char* end = strchr(pos, '&');
+        const size_t itemLen = end ? static_cast<size_t>(end - pos) : strlen(pos);
+        if (itemLen > keyLen && strncmp(pos, key, keyLen) == 0 && pos[keyLen] == '=')
+        {
+            const size_t valueLen = itemLen - keyLen - 1;
+            if (valueLen >= len)
+            {
+                memcpy(value, pos + keyLen + 1, len - 1);
+                value[len - 1] = '\0';
+                return ESP_ERR_HTTPD_RESULT_TRUNC;
+            }
+            memcpy(value, pos + keyLen + 1, valueLen);
+            value[valueLen] = '\0';
+            return ESP_OK;
+        }
+        pos = end ? end + 1 : nullptr;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+}
@@ -0,0 +1,232 @@
+// Заменитель ESP-IDF для сборки на ПК: имена ошибок, уровень лога, случайные числа, esp_timer, задержка ROM,
+// причина сброса
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "HostSystem.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+
+struct esp_timer
+{
+    esp_timer_create_args_t args = {};
+    std::mutex lock;
+    std::condition_variable cv;
+    std::thread thread;
+    bool active = false;
+    bool quit = false;
+    uint64_t periodUs = 0;                  // 0 - однократный
+    int64_t deadlineUs = 0;
+};
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point START = Clock::now();
+    std::mutex g_randomLock;
+    std::mt19937 g_random{std::random_device{}()};
+    esp_reset_reason_t g_resetReason = ESP_RST_POWERON;
+
+    esp_log_level_t logLevel()
+    {
+        static const esp_log_level_t level = []
+        {
+            const char* env = getenv("HOST_LOG");
+            switch (env ? env[0] : 'W')
+            {
+            case 'N': return ESP_LOG_NONE;
+            case 'E': return ESP_LOG_ERROR;
+            case 'I': return ESP_LOG_INFO;
+            case 'D': return ESP_LOG_DEBUG;
+            case 'V': return ESP_LOG_VERBOSE;
+            default: return ESP_LOG_WARN;
+            }
+        }();
+        return level;
+    }
+
+    void timerThread(esp_timer* timer)
+    {
+        std::unique_lock<std::mutex> lock(timer->lock);
+        while (!timer->quit)
+        {
+            if (!timer->active)
+            {
+                timer->cv.wait(lock);
+                continue;
+            }
+
+            const int64_t waitUs = timer->deadlineUs - esp_timer_get_time();
+            if (waitUs > 0)
+            {
+                timer->cv.wait_for(lock, std::chrono::microseconds(waitUs));
+                continue;
+            }
+
+            if (timer->periodUs)
+            {
+                timer->deadlineUs += timer->periodUs;
+                // Пропущенные срабатывания не накапливаются (skip_unhandled_events)
+                if (timer->deadlineUs < esp_timer_get_time())
+                    timer->deadlineUs = esp_timer_get_time() + timer->periodUs;
+            }
+            else
+                timer->active = false;
+
+            lock.unlock();
+            timer->args.callback(timer->args.arg);
+            lock.lock();
+        }
+    }
+
+    esp_err_t startTimer(esp_timer_handle_t timer, uint64_t timeoutUs, uint64_t periodUs)
+    {
+        std::lock_guard<std::mutex> lock(timer->lock);
+        if (timer->active)
+            return ESP_ERR_INVALID_STATE;
+        timer->active = true;
+        timer->periodUs = periodUs;
+        timer->deadlineUs = esp_timer_get_time() + static_cast<int64_t>(timeoutUs);
+        timer->cv.notify_all();
+        return ESP_OK;
+    }
+}
+
+void HostSystem::setResetReason(esp_reset_reason_t reason)
+{
+    g_resetReason = reason;
+}
+
+extern "C" {
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return g_resetReason;
+}
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_INVALID_MAC: return "ESP_ERR_INVALID_MAC";
+    case ESP_ERR_NOT_FINISHED: return "ESP_ERR_NOT_FINISHED";
+    case ESP_ERR_NOT_ALLOWED: return "ESP_ERR_NOT_ALLOWED";
+    case 0x1102: return "ESP_ERR_NVS_NOT_FOUND";
+    default: return "ESP_ERR_UNKNOWN";
+    }
+}
+
+bool host_log_enabled(esp_log_level_t level)
+{
+    return level <= logLevel();
+}
+
+uint32_t esp_random(void)
+{
+    std::lock_guard<std::mutex> lock(g_randomLock);
+    return static_cast<uint32_t>(g_random());
+}
+
+void esp_fill_random(void* buf, size_t len)
+{
+    auto* bytes = static_cast<uint8_t*>(buf);
+    for (size_t i = 0; i < len; ++i)
+        bytes[i] = static_cast<uint8_t>(esp_random());
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - START).count();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out_handle)
+{
+    if (!args || !args->callback || !out_handle)
+        return ESP_ERR_INVALID_ARG;
+    auto* timer = new esp_timer;
+    timer->args = *args;
+    timer->thread = std::thread(&timerThread, timer);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return startTimer(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return startTimer(timer, period, period);
+}
+
+esp_err_t esp_timer_restart(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    std::lock_guard<std::mutex> lock(timer->lock);
+    if (!timer->active)
+        return ESP_ERR_INVALID_STATE;
+    if (timer->periodUs)
+        timer->periodUs = timeout_us;
+    timer->deadlineUs = esp_timer_get_time() + static_cast<int64_t>(timeout_us);
+    timer->cv.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    std::lock_guard<std::mutex> lock(timer->lock);
+    if (!timer->active)
+        return ESP_ERR_INVALID_STATE;
+    timer->active = false;
+    timer->cv.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    {
+        std::lock_guard<std::mutex> lock(timer->lock);
+        if (timer->active)
+            return ESP_ERR_INVALID_STATE;
+        timer->quit = true;
+        timer->cv.notify_all();
+    }
+    // Удаление из собственного обратного вызова на ПК не поддерживается
+    timer->thread.join();
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    std::lock_guard<std::mutex> lock(timer->lock);
+    return timer->active;
+}
+
+}
@@ -0,0 +1,373 @@
+// Заменитель FreeRTOS (ESP-IDF) для сборки на ПК: задачи - потоки POSIX, семафоры и очереди - мьютекс и
+// условная переменная, тик 1 мс. Приоритеты и привязка к ядрам только запоминаются.
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include <pthread.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct tskTaskControlBlock
+{
+    TaskFunction_t fn = nullptr;
+    void* arg = nullptr;
+    std::string name;
+    UBaseType_t priority = 0;
+    BaseType_t coreId = 0;
+    std::mutex lock;
+    std::condition_variable cv;
+    uint32_t notifications = 0;
+};
+
+struct HostSemaphore
+{
+    std::mutex lock;
+    std::condition_variable cv;
+    UBaseType_t count = 0;
+    UBaseType_t maxCount = 1;
+    pthread_t owner = {};           // Рекурсивный мьютекс: владелец и глубина
+    UBaseType_t depth = 0;
+};
+
+struct HostQueue
+{
+    std::mutex lock;
+    std::condition_variable cv;
+    size_t length = 0;
+    size_t itemSize = 0;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point START = Clock::now();
+    std::recursive_mutex g_critical;
+    thread_local int t_criticalNesting = 0;     // Глубина критической секции текущего потока
+    thread_local tskTaskControlBlock* t_current = nullptr;
+
+    // Ожидание условия с таймаутом в тиках (portMAX_DELAY - без ограничения)
+    template<typename Predicate>
+    bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t ticks, Predicate ready)
+    {
+        if (ticks == portMAX_DELAY)
+        {
+            cv.wait(lock, ready);
+            return true;
+        }
+        return cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+    }
+
+    void* taskEntry(void* param)
+    {
+        auto* task = static_cast<tskTaskControlBlock*>(param);
+        t_current = task;
+        task->fn(task->arg);
+        // Задача FreeRTOS не должна возвращаться из функции
+        fprintf(stderr, "Task %s returned without vTaskDelete\n", task->name.c_str());
+        abort();
+    }
+
+    bool push(HostQueue* queue, const void* item, TickType_t ticks, bool front)
+    {
+        std::unique_lock<std::mutex> lock(queue->lock);
+        if (!waitFor(queue->cv, lock, ticks, [&] { return queue->items.size() < queue->length; }))
+            return false;
+        std::vector<uint8_t> data(static_cast<const uint8_t*>(item), static_cast<const uint8_t*>(item) + queue->itemSize);
+        if (front)
+            queue->items.push_front(std::move(data));
+        else
+            queue->items.push_back(std::move(data));
+        queue->cv.notify_all();
+        return true;
+    }
+}
+
+extern "C" {
+
+void vPortEnterCritical(portMUX_TYPE*)
+{
+    g_critical.lock();
+    ++t_criticalNesting;
+}
+
+void vPortExitCritical(portMUX_TYPE*)
+{
+    --t_criticalNesting;
+    g_critical.unlock();
+}
+
+int xPortHostCriticalNesting(void)
+{
+    return t_criticalNesting;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return xTaskGetCoreID(nullptr);
+}
+
+BaseType_t xPortInIsrContext(void)
+{
+    return pdFALSE;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t, void* arg, UBaseType_t priority,
+                                   TaskHandle_t* handle, BaseType_t coreId)
+{
+    auto* task = new tskTaskControlBlock;
+    task->fn = fn;
+    task->arg = arg;
+    task->name = name ? name : "";
+    task->priority = priority;
+    task->coreId = coreId == tskNO_AFFINITY ? 0 : coreId;
+    // Дескриптор публикуется до запуска, как в FreeRTOS (задача может сразу обратиться к нему)
+    if (handle)
+        *handle = task;
+
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, &taskEntry, task) != 0)
+    {
+        if (handle)
+            *handle = nullptr;
+        delete task;
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg, UBaseType_t priority,
+                       TaskHandle_t* handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != nullptr && task != t_current)
+    {
+        fprintf(stderr, "vTaskDelete of another task is not supported on host\n");
+        abort();
+    }
+    // Описатель задачи не освобождается: на него могут ссылаться ожидающие уведомления
+    pthread_exit(nullptr);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return static_cast<TickType_t>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - START).count());
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    // Основной поток и потоки, созданные не через xTaskCreate, получают описатель при первом обращении
+    if (!t_current)
+    {
+        t_current = new tskTaskControlBlock;
+        t_current->name = "main";
+        t_current->priority = 1;
+    }
+    return t_current;
+}
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task)
+{
+    return (task ? task : xTaskGetCurrentTaskHandle())->coreId;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    return (task ? task : xTaskGetCurrentTaskHandle())->priority;
+}
+
+const char* pcTaskGetName(TaskHandle_t task)
+{
+    return (task ? task : xTaskGetCurrentTaskHandle())->name.c_str();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    std::lock_guard<std::mutex> lock(task->lock);
+    ++task->notifications;
+    task->cv.notify_all();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken)
+{
+    xTaskNotifyGive(task);
+    if (woken)
+        *woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks)
+{
+    tskTaskControlBlock* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->lock);
+    if (!waitFor(task->cv, lock, ticks, [&] { return task->notifications != 0; }))
+        return 0;
+    const uint32_t value = task->notifications;
+    task->notifications = clearOnExit ? 0 : value - 1;
+    return value;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    auto* sem = new HostSemaphore;
+    sem->maxCount = maxCount;
+    sem->count = initialCount;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(sem->lock);
+    if (!waitFor(sem->cv, lock, ticks, [&] { return sem->count != 0; }))
+        return pdFALSE;
+    --sem->count;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    std::lock_guard<std::mutex> lock(sem->lock);
+    if (sem->count >= sem->maxCount)
+        return pdFALSE;
+    ++sem->count;
+    sem->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken)
+{
+    if (woken)
+        *woken = pdTRUE;
+    return xSemaphoreGive(sem);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    {
+        std::lock_guard<std::mutex> lock(sem->lock);
+        if (sem->depth != 0 && pthread_equal(sem->owner, pthread_self()))
+        {
+            ++sem->depth;
+            return pdTRUE;
+        }
+    }
+    if (!xSemaphoreTake(sem, ticks))
+        return pdFALSE;
+    std::lock_guard<std::mutex> lock(sem->lock);
+    sem->owner = pthread_self();
+    sem->depth = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+    {
+        std::lock_guard<std::mutex> lock(sem->lock);
+        if (sem->depth == 0 || !pthread_equal(sem->owner, pthread_self()))
+            return pdFALSE;
+        if (--sem->depth != 0)
+            return pdTRUE;
+    }
+    return xSemaphoreGive(sem);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    auto* queue = new HostQueue;
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return push(queue, item, ticks, false) ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return push(queue, item, ticks, false) ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return push(queue, item, ticks, true) ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken)
+{
+    if (woken)
+        *woken = pdTRUE;
+    return push(queue, item, 0, false) ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitFor(queue->cv, lock, ticks, [&] { return !queue->items.empty(); }))
+        return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->cv.notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->lock);
+    return static_cast<UBaseType_t>(queue->items.size());
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->lock);
+    return static_cast<UBaseType_t>(queue->length - queue->items.size());
+}
+
+}
@@ -0,0 +1,119 @@
+// Заменитель драйвера GPTimer для сборки на ПК: прерывание по совпадению - вызов из потока таймера
+
+#include "driver/gptimer.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+struct gptimer_t
+{
+    uint32_t resolutionHz;
+    gptimer_alarm_cb_t onAlarm = nullptr;
+    void* userData = nullptr;
+    gptimer_alarm_config_t alarm = {};
+    bool enabled = false;
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
+
+namespace
+{
+    void timerThread(gptimer_handle_t timer)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto period = std::chrono::nanoseconds(timer->alarm.alarm_count * 1'000'000'000ULL / timer->resolutionHz);
+        auto next = Clock::now() + period;
+        uint64_t count = 0;
+        while (timer->running)
+        {
+            std::this_thread::sleep_until(next);
+            if (!timer->running)
+                break;
+            count += timer->alarm.alarm_count;
+            const gptimer_alarm_event_data_t event = {count, timer->alarm.alarm_count};
+            if (timer->onAlarm)
+                timer->onAlarm(timer, &event, timer->userData);
+            if (!timer->alarm.flags.auto_reload_on_alarm)
+                break;
+            next += period;
+        }
+    }
+}
+
+extern "C" {
+
+esp_err_t gptimer_new_timer(const gptimer_config_t* config, gptimer_handle_t* ret_timer)
+{
+    if (!config || !ret_timer || config->resolution_hz == 0)
+        return ESP_ERR_INVALID_ARG;
+    *ret_timer = new gptimer_t;
+    (*ret_timer)->resolutionHz = config->resolution_hz;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_del_timer(gptimer_handle_t timer)
+{
+    if (!timer || timer->enabled)
+        return ESP_ERR_INVALID_STATE;
+    if (timer->thread.joinable())
+        timer->thread.join();
+    delete timer;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer, const gptimer_event_callbacks_t* cbs, void* user_data)
+{
+    if (!timer || !cbs)
+        return ESP_ERR_INVALID_ARG;
+    if (timer->enabled)
+        return ESP_ERR_INVALID_STATE;
+    timer->onAlarm = cbs->on_alarm;
+    timer->userData = user_data;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer, const gptimer_alarm_config_t* config)
+{
+    if (!timer || !config || config->alarm_count == 0 || config->reload_count != 0)
+        return ESP_ERR_INVALID_ARG;
+    timer->alarm = *config;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t timer)
+{
+    if (!timer || timer->enabled)
+        return ESP_ERR_INVALID_STATE;
+    timer->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_disable(gptimer_handle_t timer)
+{
+    if (!timer || !timer->enabled || timer->running)
+        return ESP_ERR_INVALID_STATE;
+    timer->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_start(gptimer_handle_t timer)
+{
+    if (!timer || !timer->enabled || timer->running || timer->alarm.alarm_count == 0)
+        return ESP_ERR_INVALID_STATE;
+    if (timer->thread.joinable())
+        timer->thread.join();
+    timer->running = true;
+    timer->thread = std::thread(&timerThread, timer);
+    return ESP_OK;
+}
+
+esp_err_t gptimer_stop(gptimer_handle_t timer)
+{
+    if (!timer || !timer->running)
+        return ESP_ERR_INVALID_STATE;
+    timer->running = false;
+    timer->thread.join();
+    return ESP_OK;
+}
+
+}
@@ -0,0 +1,257 @@
+// Заменитель драйвера LEDC для сборки на ПК: каналы и журнал операций в памяти (HostLedc.h)
+
+#include "HostLedc.h"
+#include "hal/ledc_ll.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    struct Channel
+    {
+        uint32_t staged = 0;            // Записанная скважность
+        uint32_t output = 0;            // Скважность на выходе
+        ledc_cb_t fadeCb = nullptr;
+        void* fadeArg = nullptr;
+        uint32_t fadeFrom = 0;
+        uint32_t fadeTo = 0;
+        int64_t fadeStartUs = 0;
+        int64_t fadeDurationUs = 0;     // Длительность с учетом урезанного шага, 0 - нет плавного изменения
+        uint32_t fadeGeneration = 0;    // Отменяет поток завершения остановленного изменения
+    };
+
+    struct Timer
+    {
+        uint32_t freqHz = 0;
+        uint32_t resolution = 0;
+    };
+
+    std::mutex g_lock;
+    Channel g_channels[LEDC_CHANNEL_MAX];
+    Timer g_timers[LEDC_TIMER_MAX];
+    ledc_timer_t g_channelTimer[LEDC_CHANNEL_MAX];
+    std::vector<HostLedc::Op> g_ops;
+    HostLedc::FadeStats g_fadeStats;
+
+    void logOp(HostLedc::EnOp op, int channel, uint32_t duty)
+    {
+        g_ops.push_back({op, channel, duty, xPortHostCriticalNesting() > 0});
+    }
+
+    // Текущая скважность плавного изменения (под g_lock)
+    uint32_t fadeDuty(const Channel& channel, int64_t nowUs)
+    {
+        const int64_t elapsedUs = nowUs - channel.fadeStartUs;
+        if (elapsedUs >= channel.fadeDurationUs)
+            return channel.fadeTo;
+        const int64_t from = channel.fadeFrom;
+        return static_cast<uint32_t>(from + (static_cast<int64_t>(channel.fadeTo) - from) * elapsedUs /
+                                     channel.fadeDurationUs);
+    }
+}
+
+namespace HostLedc
+{
+    void reset()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        for (Channel& channel : g_channels)
+        {
+            const uint32_t generation = channel.fadeGeneration + 1;
+            channel = Channel{};
+            channel.fadeGeneration = generation;
+        }
+        for (Timer& timer : g_timers)
+            timer = Timer{};
+        g_ops.clear();
+        g_fadeStats = {};
+    }
+
+    std::vector<Op> ops()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        return g_ops;
+    }
+
+    void clearOps()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        g_ops.clear();
+    }
+
+    uint32_t outputDuty(int channel)
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        const Channel& state = g_channels[channel];
+        return state.fadeDurationUs ? fadeDuty(state, esp_timer_get_time()) : state.output;
+    }
+
+    FadeStats fadeStats()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        return g_fadeStats;
+    }
+}
+
+extern "C" {
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t* config)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    g_timers[config->timer_num] = {config->freq_hz, static_cast<uint32_t>(config->duty_resolution)};
+    return ESP_OK;
+}
+
+esp_err_t ledc_timer_pause(ledc_mode_t, ledc_timer_t)
+{
+    return ESP_OK;
+}
+
+uint32_t ledc_get_freq(ledc_mode_t, ledc_timer_t timer)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    return g_timers[timer].freqHz;
+}
+
+uint32_t ledc_find_suitable_duty_resolution(uint32_t src_clk_freq, uint32_t timer_freq)
+{
+    // Как в драйвере: наибольшее разрешение, при котором делитель не меньше 1, не больше ширины счетчика (20 бит)
+    uint32_t resolution = 0;
+    for (uint64_t div = src_clk_freq / timer_freq; div > 1; div >>= 1)
+        ++resolution;
+    return resolution > 20 ? 20 : resolution;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t* config)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    Channel& channel = g_channels[config->channel];
+    channel.staged = config->duty;
+    channel.output = config->duty;
+    g_channelTimer[config->channel] = config->timer_sel;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t, ledc_channel_t channel, uint32_t duty)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    g_channels[channel].staged = duty;
+    logOp(HostLedc::EnOp::enSetDuty, channel, duty);
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t, ledc_channel_t channel)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    g_channels[channel].output = g_channels[channel].staged;
+    logOp(HostLedc::EnOp::enUpdateDuty, channel, g_channels[channel].staged);
+    return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t, ledc_channel_t channel)
+{
+    return HostLedc::outputDuty(channel);
+}
+
+esp_err_t ledc_stop(ledc_mode_t, ledc_channel_t channel, uint32_t)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    g_channels[channel].output = 0;
+    return ESP_OK;
+}
+
+esp_err_t ledc_fade_func_install(int)
+{
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_fade_with_time(ledc_mode_t, ledc_channel_t channel, uint32_t target_duty, int max_fade_time_ms)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    Channel& state = g_channels[channel];
+    const Timer& timer = g_timers[g_channelTimer[channel]];
+
+    // Шаг как в драйвере: scale единиц за период, урезается до LEDC_LL_DUTY_SCALE_MAX
+    const uint64_t delta = state.output > target_duty ? state.output - target_duty : target_duty - state.output;
+    const uint64_t cycles = static_cast<uint64_t>(max_fade_time_ms) * timer.freqHz / 1000;
+    int64_t durationUs = static_cast<int64_t>(max_fade_time_ms) * 1000;
+    if (delta > 0 && cycles > 0 && delta / cycles > LEDC_LL_DUTY_SCALE_MAX)
+    {
+        durationUs = static_cast<int64_t>((delta + LEDC_LL_DUTY_SCALE_MAX - 1) / LEDC_LL_DUTY_SCALE_MAX) *
+                     1000000 / timer.freqHz;
+        ++g_fadeStats.clamped;
+    }
+
+    state.fadeFrom = state.output;
+    state.fadeTo = target_duty;
+    state.fadeDurationUs = durationUs > 0 ? durationUs : 1;
+    return ESP_OK;
+}
+
+esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel, ledc_fade_mode_t)
+{
+    uint32_t generation;
+    int64_t durationUs;
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        Channel& state = g_channels[channel];
+        state.fadeStartUs = esp_timer_get_time();
+        generation = ++state.fadeGeneration;
+        durationUs = state.fadeDurationUs;
+        ++g_fadeStats.started;
+        logOp(HostLedc::EnOp::enFadeStart, channel, state.fadeTo);
+    }
+
+    // Завершение - из отдельного потока, как из прерывания LEDC
+    std::thread([speed_mode, channel, generation, durationUs]()
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(durationUs));
+        ledc_cb_t callback;
+        void* arg;
+        ledc_cb_param_t param = {LEDC_FADE_END_EVT, static_cast<uint32_t>(speed_mode),
+                                 static_cast<uint32_t>(channel), 0};
+        {
+            std::lock_guard<std::mutex> guard(g_lock);
+            Channel& state = g_channels[channel];
+            if (state.fadeGeneration != generation)
+                return;
+            state.output = state.fadeTo;
+            state.staged = state.fadeTo;
+            state.fadeDurationUs = 0;
+            callback = state.fadeCb;
+            arg = state.fadeArg;
+            param.duty = state.output;
+        }
+        if (callback)
+            callback(&param, arg);
+    }).detach();
+    return ESP_OK;
+}
+
+esp_err_t ledc_fade_stop(ledc_mode_t, ledc_channel_t channel)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    Channel& state = g_channels[channel];
+    if (state.fadeDurationUs)
+    {
+        state.output = fadeDuty(state, esp_timer_get_time());
+        state.staged = state.output;
+        state.fadeDurationUs = 0;
+    }
+    ++state.fadeGeneration;
+    logOp(HostLedc::EnOp::enFadeStop, channel, state.output);
+    return ESP_OK;
+}
+
+esp_err_t ledc_cb_register(ledc_mode_t, ledc_channel_t channel, ledc_cbs_t* cbs, void* user_arg)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    g_channels[channel].fadeCb = cbs->fade_cb;
+    g_channels[channel].fadeArg = user_arg;
+    return ESP_OK;
+}
+
+}
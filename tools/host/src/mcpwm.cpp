@@ -0,0 +1,193 @@
+// Заменитель драйвера MCPWM для сборки на ПК: объекты с проверкой порядка вызовов, без вывода импульсов
+
+#include "driver/mcpwm_prelude.h"
+#include <mutex>
+
+namespace
+{
+    const int GROUPS_COUNT = 2;
+    const int TIMERS_PER_GROUP = 3;
+    const int OPERATORS_PER_GROUP = 3;
+
+    std::mutex g_lock;
+    int g_timers[GROUPS_COUNT];
+    int g_operators[GROUPS_COUNT];
+}
+
+struct mcpwm_timer_t
+{
+    int group;
+    uint32_t periodTicks;
+    bool enabled = false;
+    bool running = false;
+};
+
+struct mcpwm_oper_t
+{
+    int group;
+    mcpwm_timer_handle_t timer = nullptr;
+    int comparators = 0;
+    int generators = 0;
+};
+
+struct mcpwm_cmpr_t
+{
+    mcpwm_oper_handle_t oper;
+    uint32_t compareTicks = 0;
+};
+
+struct mcpwm_gen_t
+{
+    mcpwm_oper_handle_t oper;
+};
+
+extern "C" {
+
+esp_err_t mcpwm_new_timer(const mcpwm_timer_config_t* config, mcpwm_timer_handle_t* ret_timer)
+{
+    // Верхняя граница периода не проверяется: она зависит от версии драйвера
+    if (!config || !ret_timer || config->group_id < 0 || config->group_id >= GROUPS_COUNT || config->resolution_hz == 0
+        || config->period_ticks == 0)
+        return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard(g_lock);
+    if (g_timers[config->group_id] >= TIMERS_PER_GROUP)
+        return ESP_ERR_NOT_FOUND;
+    ++g_timers[config->group_id];
+    *ret_timer = new mcpwm_timer_t{config->group_id, config->period_ticks};
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_del_timer(mcpwm_timer_handle_t timer)
+{
+    if (!timer || timer->enabled)
+        return ESP_ERR_INVALID_STATE;
+    std::lock_guard<std::mutex> guard(g_lock);
+    --g_timers[timer->group];
+    delete timer;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_enable(mcpwm_timer_handle_t timer)
+{
+    if (!timer || timer->enabled)
+        return ESP_ERR_INVALID_STATE;
+    timer->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_disable(mcpwm_timer_handle_t timer)
+{
+    if (!timer || !timer->enabled)
+        return ESP_ERR_INVALID_STATE;
+    timer->enabled = false;
+    timer->running = false;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_start_stop(mcpwm_timer_handle_t timer, mcpwm_timer_start_stop_cmd_t command)
+{
+    if (!timer || !timer->enabled)
+        return ESP_ERR_INVALID_STATE;
+    timer->running = command == MCPWM_TIMER_START_NO_STOP;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_set_period(mcpwm_timer_handle_t timer, uint32_t period_ticks)
+{
+    if (!timer || period_ticks == 0)
+        return ESP_ERR_INVALID_ARG;
+    timer->periodTicks = period_ticks;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_operator(const mcpwm_operator_config_t* config, mcpwm_oper_handle_t* ret_oper)
+{
+    if (!config || !ret_oper || config->group_id < 0 || config->group_id >= GROUPS_COUNT)
+        return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard(g_lock);
+    if (g_operators[config->group_id] >= OPERATORS_PER_GROUP)
+        return ESP_ERR_NOT_FOUND;
+    ++g_operators[config->group_id];
+    *ret_oper = new mcpwm_oper_t{config->group_id};
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_del_operator(mcpwm_oper_handle_t oper)
+{
+    if (!oper || oper->comparators || oper->generators)
+        return ESP_ERR_INVALID_STATE;
+    std::lock_guard<std::mutex> guard(g_lock);
+    --g_operators[oper->group];
+    delete oper;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_operator_connect_timer(mcpwm_oper_handle_t oper, mcpwm_timer_handle_t timer)
+{
+    if (!oper || !timer || oper->group != timer->group)
+        return ESP_ERR_INVALID_ARG;
+    oper->timer = timer;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_comparator(mcpwm_oper_handle_t oper, const mcpwm_comparator_config_t* config,
+                               mcpwm_cmpr_handle_t* ret_cmpr)
+{
+    if (!oper || !config || !ret_cmpr)
+        return ESP_ERR_INVALID_ARG;
+    if (oper->comparators >= 2)
+        return ESP_ERR_NOT_FOUND;
+    ++oper->comparators;
+    *ret_cmpr = new mcpwm_cmpr_t{oper};
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_del_comparator(mcpwm_cmpr_handle_t cmpr)
+{
+    if (!cmpr)
+        return ESP_ERR_INVALID_ARG;
+    --cmpr->oper->comparators;
+    delete cmpr;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_comparator_set_compare_value(mcpwm_cmpr_handle_t cmpr, uint32_t cmp_ticks)
+{
+    if (!cmpr || (cmpr->oper->timer && cmp_ticks >= cmpr->oper->timer->periodTicks))
+        return ESP_ERR_INVALID_ARG;
+    cmpr->compareTicks = cmp_ticks;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_generator(mcpwm_oper_handle_t oper, const mcpwm_generator_config_t* config,
+                              mcpwm_gen_handle_t* ret_gen)
+{
+    if (!oper || !config || !ret_gen || config->gen_gpio_num < 0)
+        return ESP_ERR_INVALID_ARG;
+    if (oper->generators >= 2)
+        return ESP_ERR_NOT_FOUND;
+    ++oper->generators;
+    *ret_gen = new mcpwm_gen_t{oper};
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_del_generator(mcpwm_gen_handle_t gen)
+{
+    if (!gen)
+        return ESP_ERR_INVALID_ARG;
+    --gen->oper->generators;
+    delete gen;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_generator_set_action_on_timer_event(mcpwm_gen_handle_t gen, mcpwm_gen_timer_event_action_t ev_act)
+{
+    return gen && ev_act.event != MCPWM_TIMER_EVENT_INVALID ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t mcpwm_generator_set_action_on_compare_event(mcpwm_gen_handle_t gen, mcpwm_gen_compare_event_action_t ev_act)
+{
+    return gen && ev_act.comparator && ev_act.comparator->oper == gen->oper ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+}
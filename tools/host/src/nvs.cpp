@@ -0,0 +1,336 @@
+// Заменитель NVS для сборки на ПК: рабочая копия в памяти, "флеш" - файл, записываемый при коммите (HostNvs.h)
+
+#include "HostNvs.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+    enum class EnType : uint8_t
+    {
+        enI32,
+        enU32,
+        enU16,
+        enBlob,
+    };
+
+    struct Entry
+    {
+        EnType type;
+        std::string data;       // Значение в представлении памяти (little-endian) или содержимое blob
+    };
+
+    struct Handle
+    {
+        std::string ns;
+        nvs_open_mode_t mode;
+    };
+
+    using Key = std::pair<std::string, std::string>;    // Пространство имен и ключ
+
+    const char* TYPE_NAMES[] = {"i32", "u32", "u16", "blob"};
+
+    std::mutex g_lock;
+    std::string g_path;
+    bool g_initialized = false;
+    std::map<Key, Entry> g_flash;           // Закоммиченное
+    std::map<Key, Entry> g_working;         // Видимое через дескрипторы
+    std::map<std::string, std::set<std::string>> g_dirty;   // Измененные ключи по пространствам имен
+    std::map<nvs_handle_t, Handle> g_handles;
+    nvs_handle_t g_nextHandle = 1;
+    int g_failCommits = 0;
+    HostNvs::Stats g_stats;
+
+    void loadFile()
+    {
+        g_flash.clear();
+        std::ifstream file(g_path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream in(line);
+            std::string ns, key, typeName, value;
+            if (!(in >> ns >> key >> typeName))
+                continue;
+            in >> value;
+            for (uint8_t type = 0; type < 4; ++type)
+            {
+                if (typeName != TYPE_NAMES[type])
+                    continue;
+                Entry entry{static_cast<EnType>(type), {}};
+                for (size_t i = 0; i + 1 < value.size(); i += 2)
+                    entry.data.push_back(static_cast<char>(std::stoi(value.substr(i, 2), nullptr, 16)));
+                g_flash[{ns, key}] = entry;
+            }
+        }
+    }
+
+    void saveFile()
+    {
+        if (g_path.empty())
+            return;
+        // Запись во временный файл и переименование: файл всегда целый
+        const std::string tmp = g_path + ".tmp";
+        {
+            std::ofstream file(tmp, std::ios::trunc);
+            for (const auto& item : g_flash)
+            {
+                file << item.first.first << ' ' << item.first.second << ' ' << TYPE_NAMES[static_cast<int>(item.second.type)] << ' ';
+                for (unsigned char c : item.second.data)
+                {
+                    char hex[3];
+                    snprintf(hex, sizeof(hex), "%02x", c);
+                    file << hex;
+                }
+                file << '\n';
+            }
+        }
+        std::rename(tmp.c_str(), g_path.c_str());
+    }
+
+    esp_err_t setValue(nvs_handle_t handle, const char* key, EnType type, const void* value, size_t size)
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        auto it = g_handles.find(handle);
+        if (it == g_handles.end())
+            return ESP_ERR_NVS_INVALID_HANDLE;
+        if (it->second.mode == NVS_READONLY)
+            return ESP_ERR_NVS_READ_ONLY;
+        if (!key || strlen(key) >= NVS_KEY_NAME_MAX_SIZE)
+            return ESP_ERR_NVS_INVALID_NAME;
+        g_working[{it->second.ns, key}] = Entry{type, std::string(static_cast<const char*>(value), size)};
+        g_dirty[it->second.ns].insert(key);
+        return ESP_OK;
+    }
+
+    esp_err_t getValue(nvs_handle_t handle, const char* key, EnType type, void* value, size_t* size)
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        auto it = g_handles.find(handle);
+        if (it == g_handles.end())
+            return ESP_ERR_NVS_INVALID_HANDLE;
+        auto entry = g_working.find({it->second.ns, key});
+        // Как в NVS: запись другого типа не находится
+        if (entry == g_working.end() || entry->second.type != type)
+            return ESP_ERR_NVS_NOT_FOUND;
+        if (type == EnType::enBlob)
+        {
+            const size_t stored = entry->second.data.size();
+            if (value && *size < stored)
+                return ESP_ERR_NVS_INVALID_LENGTH;
+            *size = stored;
+            if (!value)
+                return ESP_OK;
+        }
+        memcpy(value, entry->second.data.data(), entry->second.data.size());
+        return ESP_OK;
+    }
+}
+
+namespace HostNvs
+{
+    void setFile(const std::string& path)
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        g_path = path;
+    }
+
+    void reboot()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        g_initialized = false;
+        g_handles.clear();
+        g_dirty.clear();
+        g_working.clear();
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        g_initialized = false;
+        g_handles.clear();
+        g_dirty.clear();
+        g_working.clear();
+        g_flash.clear();
+        g_failCommits = 0;
+        g_stats = {};
+        if (!g_path.empty())
+            std::remove(g_path.c_str());
+    }
+
+    void failCommits(int count)
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        g_failCommits = count;
+    }
+
+    Stats stats()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        return g_stats;
+    }
+}
+
+extern "C" {
+
+esp_err_t nvs_flash_init(void)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    if (!g_initialized)
+    {
+        if (!g_path.empty())
+            loadFile();
+        g_working = g_flash;
+        g_initialized = true;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    g_flash.clear();
+    g_working.clear();
+    g_dirty.clear();
+    saveFile();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    if (!g_initialized)
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    if (!name || strlen(name) >= NVS_KEY_NAME_MAX_SIZE)
+        return ESP_ERR_NVS_INVALID_NAME;
+    // Пространство имен только для чтения, в которое ничего не записано, не существует
+    if (open_mode == NVS_READONLY)
+    {
+        auto it = g_working.lower_bound({name, ""});
+        if (it == g_working.end() || it->first.first != name)
+            return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_handle = g_nextHandle++;
+    g_handles[*out_handle] = Handle{name, open_mode};
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    g_handles.erase(handle);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    auto it = g_handles.find(handle);
+    if (it == g_handles.end())
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    std::set<std::string>& dirty = g_dirty[it->second.ns];
+    if (dirty.empty())
+        return ESP_OK;
+    if (g_failCommits > 0)
+    {
+        --g_failCommits;
+        ++g_stats.failedCommits;
+        return ESP_FAIL;
+    }
+    for (const std::string& key : dirty)
+    {
+        const Key id{it->second.ns, key};
+        auto entry = g_working.find(id);
+        if (entry == g_working.end())
+            g_flash.erase(id);
+        else
+            g_flash[id] = entry->second;
+        ++g_stats.writes;
+    }
+    dirty.clear();
+    ++g_stats.commits;
+    saveFile();
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    auto it = g_handles.find(handle);
+    if (it == g_handles.end())
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    if (it->second.mode == NVS_READONLY)
+        return ESP_ERR_NVS_READ_ONLY;
+    if (g_working.erase({it->second.ns, key}) == 0)
+        return ESP_ERR_NVS_NOT_FOUND;
+    g_dirty[it->second.ns].insert(key);
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    auto it = g_handles.find(handle);
+    if (it == g_handles.end())
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    if (it->second.mode == NVS_READONLY)
+        return ESP_ERR_NVS_READ_ONLY;
+    for (auto entry = g_working.begin(); entry != g_working.end();)
+    {
+        if (entry->first.first == it->second.ns)
+        {
+            g_dirty[it->second.ns].insert(entry->first.second);
+            entry = g_working.erase(entry);
+        }
+        else
+            ++entry;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char* key, int32_t value)
+{
+    return setValue(handle, key, EnType::enI32, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value)
+{
+    return setValue(handle, key, EnType::enU32, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_u16(nvs_handle_t handle, const char* key, uint16_t value)
+{
+    return setValue(handle, key, EnType::enU16, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length)
+{
+    return setValue(handle, key, EnType::enBlob, value, length);
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char* key, int32_t* out_value)
+{
+    return getValue(handle, key, EnType::enI32, out_value, nullptr);
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value)
+{
+    return getValue(handle, key, EnType::enU32, out_value, nullptr);
+}
+
+esp_err_t nvs_get_u16(nvs_handle_t handle, const char* key, uint16_t* out_value)
+{
+    return getValue(handle, key, EnType::enU16, out_value, nullptr);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length)
+{
+    return getValue(handle, key, EnType::enBlob, out_value, length);
+}
+
+}
@@ -0,0 +1,225 @@
+// Заменитель драйвера RMT для сборки на ПК: менеджер синхронизации передачи, простой кодировщик, канал передачи
+// (HostRmt.h)
+
+#include "HostRmt.h"
+#include <mutex>
+
+struct rmt_sync_manager_t
+{
+    size_t index;                                   // Номер в журнале менеджеров
+};
+
+// Память канала во время кодирования: свободное место текущей порции и все записанные символы транзакции
+struct rmt_channel_t
+{
+    size_t memFree = 0;
+    std::vector<rmt_symbol_word_t> symbols;
+    size_t memSymbols = 48;                         // Память канала, символов
+    bool enabled = false;
+};
+
+namespace
+{
+    struct SimpleEncoder
+    {
+        rmt_encoder_t base;
+        rmt_simple_encoder_config_t config;
+        size_t written = 0;                         // Символов транзакции, отданных обратным вызовом
+        bool done = false;
+    };
+
+    size_t simpleEncode(rmt_encoder_t* encoder, rmt_channel_handle_t channel, const void* data, size_t size,
+                        rmt_encode_state_t* ret_state)
+    {
+        auto* self = reinterpret_cast<SimpleEncoder*>(encoder);
+        const size_t minChunk = self->config.min_chunk_size ? self->config.min_chunk_size : 1;
+        size_t encoded = 0;
+        std::vector<rmt_symbol_word_t> buffer;
+        while (channel->memFree > 0 && !self->done)
+        {
+            // Меньше min_chunk_size символов драйвер отдает через свой буфер и докладывает в память по частям
+            const size_t offered = channel->memFree < minChunk ? minChunk : channel->memFree;
+            buffer.assign(offered, rmt_symbol_word_t{});
+            const size_t count = self->config.callback(data, size, self->written, offered, buffer.data(), &self->done,
+                                                       self->config.arg);
+            if (count == 0 && !self->done)
+                break;
+            channel->symbols.insert(channel->symbols.end(), buffer.begin(), buffer.begin() + count);
+            self->written += count;
+            encoded += count;
+            channel->memFree = count >= channel->memFree ? 0 : channel->memFree - count;
+        }
+        *ret_state = self->done ? RMT_ENCODING_COMPLETE : RMT_ENCODING_MEM_FULL;
+        if (self->done)
+        {
+            self->written = 0;
+            self->done = false;
+        }
+        return encoded;
+    }
+
+    esp_err_t simpleReset(rmt_encoder_t* encoder)
+    {
+        auto* self = reinterpret_cast<SimpleEncoder*>(encoder);
+        self->written = 0;
+        self->done = false;
+        return ESP_OK;
+    }
+
+    esp_err_t simpleDel(rmt_encoder_t* encoder)
+    {
+        delete reinterpret_cast<SimpleEncoder*>(encoder);
+        return ESP_OK;
+    }
+}
+
+namespace
+{
+    std::mutex g_lock;
+    std::vector<HostRmt::SyncManager> g_syncManagers;
+}
+
+namespace
+{
+    // Прогон кодировщика до завершения транзакции: первый вызов заполняет всю память, следующие - освободившуюся половину
+    bool runEncoder(rmt_encoder_handle_t encoder, rmt_channel_t& channel, const void* data, size_t size)
+    {
+        channel.symbols.clear();
+        channel.memFree = channel.memSymbols;
+        for (;;)
+        {
+            rmt_encode_state_t state = RMT_ENCODING_RESET;
+            const size_t before = channel.symbols.size();
+            encoder->encode(encoder, &channel, data, size, &state);
+            if (state & RMT_ENCODING_COMPLETE)
+                return true;
+            if (channel.symbols.size() == before)
+                return false;
+            channel.memFree = channel.memSymbols / 2;
+        }
+    }
+}
+
+namespace HostRmt
+{
+    void reset()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        g_syncManagers.clear();
+    }
+
+    std::vector<SyncManager> syncManagers()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        return g_syncManagers;
+    }
+
+    std::vector<rmt_symbol_word_t> encode(rmt_encoder_handle_t encoder, const void* data, size_t size, size_t memSymbols)
+    {
+        rmt_channel_t channel;
+        channel.memSymbols = memSymbols;
+        if (!runEncoder(encoder, channel, data, size))
+            return {};
+        return channel.symbols;
+    }
+}
+
+extern "C" {
+
+esp_err_t rmt_new_sync_manager(const rmt_sync_manager_config_t* config, rmt_sync_manager_handle_t* ret_synchro)
+{
+    if (!config || !ret_synchro || config->array_size < 2)
+        return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard(g_lock);
+    HostRmt::SyncManager manager;
+    manager.channels.assign(config->tx_channel_array, config->tx_channel_array + config->array_size);
+    g_syncManagers.push_back(std::move(manager));
+    *ret_synchro = new rmt_sync_manager_t{g_syncManagers.size() - 1};
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_sync_manager(rmt_sync_manager_handle_t synchro)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    g_syncManagers[synchro->index].deleted = true;
+    delete synchro;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t* config, rmt_encoder_handle_t* ret_encoder)
+{
+    if (!config || !config->callback || !ret_encoder)
+        return ESP_ERR_INVALID_ARG;
+    auto* encoder = new SimpleEncoder{{simpleEncode, simpleReset, simpleDel}, *config};
+    *ret_encoder = &encoder->base;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder)
+{
+    return encoder->del(encoder);
+}
+
+esp_err_t rmt_encoder_reset(rmt_encoder_handle_t encoder)
+{
+    return encoder->reset(encoder);
+}
+
+esp_err_t rmt_sync_reset(rmt_sync_manager_handle_t synchro)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    ++g_syncManagers[synchro->index].resets;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t* config, rmt_channel_handle_t* ret_chan)
+{
+    if (!config || !ret_chan || config->resolution_hz == 0 || config->mem_block_symbols < 2)
+        return ESP_ERR_INVALID_ARG;
+    *ret_chan = new rmt_channel_t;
+    (*ret_chan)->memSymbols = config->mem_block_symbols;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel)
+{
+    if (!channel || channel->enabled)
+        return ESP_ERR_INVALID_STATE;
+    delete channel;
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel)
+{
+    if (!channel || channel->enabled)
+        return ESP_ERR_INVALID_STATE;
+    channel->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_disable(rmt_channel_handle_t channel)
+{
+    if (!channel || !channel->enabled)
+        return ESP_ERR_INVALID_STATE;
+    channel->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t rmt_transmit(rmt_channel_handle_t channel, rmt_encoder_handle_t encoder, const void* payload, size_t payload_bytes,
+                       const rmt_transmit_config_t* config)
+{
+    if (!channel || !encoder || !config)
+        return ESP_ERR_INVALID_ARG;
+    if (!channel->enabled)
+        return ESP_ERR_INVALID_STATE;
+    // Передача завершается сразу: кодировщик отрабатывает всю транзакцию в вызывающем потоке
+    return runEncoder(encoder, *channel, payload, payload_bytes) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t channel, int timeout_ms)
+{
+    (void)timeout_ms;
+    return channel ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+}
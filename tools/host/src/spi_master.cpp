@@ -0,0 +1,167 @@
+// Заменитель драйвера ведущего SPI для сборки на ПК: очередь транзакций с моделью времени передачи (HostSpi.h)
+
+#include "HostSpi.h"
+#include "soc/spi_periph.h"
+#include "esp_timer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct spi_device_t
+{
+    spi_host_device_t host;
+    int clockHz;
+    int queueSize;
+    int64_t lineFreeUs = 0;                     // Конец передачи последней транзакции в очереди
+
+    struct Pending
+    {
+        spi_transaction_t* trans;
+        HostSpi::Transfer transfer;
+    };
+    std::deque<Pending> queue;
+};
+
+namespace
+{
+    struct Bus
+    {
+        bool initialized = false;
+        spi_device_t* device = nullptr;
+        std::vector<HostSpi::Transfer> log;
+    };
+
+    std::mutex g_lock;
+    Bus g_buses[SPI_HOST_MAX];
+}
+
+extern "C" const spi_signal_conn_t spi_periph_signal[SPI_HOST_MAX] = {{0}, {1}, {2}};
+
+namespace HostSpi
+{
+    void reset()
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        for (Bus& bus : g_buses)
+            bus.log.clear();
+    }
+
+    std::vector<Transfer> transfers(spi_host_device_t host)
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        return g_buses[host].log;
+    }
+
+    std::vector<uint8_t> wire(spi_host_device_t host)
+    {
+        std::vector<uint8_t> bytes;
+        for (const Transfer& transfer : transfers(host))
+            bytes.insert(bytes.end(), transfer.data.begin(), transfer.data.end());
+        return bytes;
+    }
+}
+
+extern "C" {
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t*, spi_dma_chan_t)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    if (host_id >= SPI_HOST_MAX || g_buses[host_id].initialized)
+        return ESP_ERR_INVALID_STATE;
+    g_buses[host_id].initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host_id)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    if (!g_buses[host_id].initialized || g_buses[host_id].device)
+        return ESP_ERR_INVALID_STATE;
+    g_buses[host_id].initialized = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t* dev_config,
+                             spi_device_handle_t* handle)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    Bus& bus = g_buses[host_id];
+    if (!bus.initialized || bus.device)
+        return ESP_ERR_INVALID_STATE;
+    bus.device = new spi_device_t{host_id, dev_config->clock_speed_hz, dev_config->queue_size};
+    *handle = bus.device;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    if (!handle->queue.empty())
+        return ESP_ERR_INVALID_STATE;
+    g_buses[handle->host].device = nullptr;
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t)
+{
+    std::lock_guard<std::mutex> guard(g_lock);
+    if (static_cast<int>(handle->queue.size()) >= handle->queueSize)
+        return ESP_ERR_TIMEOUT;
+
+    HostSpi::Transfer transfer;
+    const size_t bytes = (trans_desc->length + 7) / 8;
+    const auto* data = static_cast<const uint8_t*>(trans_desc->tx_buffer);
+    transfer.data.assign(data, data + bytes);
+    transfer.queuedUs = esp_timer_get_time();
+    transfer.startUs = std::max(transfer.queuedUs, handle->lineFreeUs);
+    transfer.endUs = transfer.startUs + static_cast<int64_t>(trans_desc->length) * 1000000 / handle->clockHz;
+    transfer.changedInFlight = false;
+    handle->lineFreeUs = transfer.endUs;
+    handle->queue.push_back({trans_desc, std::move(transfer)});
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc,
+                                      TickType_t ticks_to_wait)
+{
+    int64_t endUs;
+    {
+        std::lock_guard<std::mutex> guard(g_lock);
+        if (handle->queue.empty())
+            return ESP_ERR_TIMEOUT;
+        endUs = handle->queue.front().transfer.endUs;
+    }
+
+    // Тик модели FreeRTOS - 1 мс
+    const int64_t waitUs = endUs - esp_timer_get_time();
+    if (waitUs > 0)
+    {
+        if (ticks_to_wait != portMAX_DELAY && static_cast<int64_t>(ticks_to_wait) * 1000 < waitUs)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ticks_to_wait));
+            return ESP_ERR_TIMEOUT;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(waitUs));
+    }
+
+    std::lock_guard<std::mutex> guard(g_lock);
+    spi_device_t::Pending pending = std::move(handle->queue.front());
+    handle->queue.pop_front();
+    pending.transfer.changedInFlight = memcmp(pending.trans->tx_buffer, pending.transfer.data.data(),
+                                              pending.transfer.data.size()) != 0;
+    g_buses[handle->host].log.push_back(std::move(pending.transfer));
+    *trans_desc = pending.trans;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_actual_freq(spi_device_handle_t handle, int* freq_khz)
+{
+    *freq_khz = handle->clockHz / 1000;
+    return ESP_OK;
+}
+
+}
@@ -0,0 +1,224 @@
+// Нагрузочная проверка HttpAsyncWorkers на ПК с заменителем esp_http_server (tools/host).
+// Поток теста играет роль единственной задачи httpd: запросы приходят по расписанию (пуассоновский поток),
+// быстрый маршрут (/stop) отвечает сразу, медленный (/move) занимает обработчик на SLOW_MS. Сравниваются
+// задержки быстрого маршрута при обработке медленного в задаче httpd и в пуле, проверяются ответ 503 при
+// перегрузке, граница задержки принятых медленных запросов, ровно один ответ на запрос и освобождение копий
+// запросов, а также ответ 503 на запросы, оставшиеся в очереди при stop().
+//
+// Сборка (Linux):
+//   g++ -std=c++17 -O2 -pthread -Itools/host/include -Isrc tools/http_async_load.cpp src/Http/HttpAsyncWorkers.cpp
+//       tools/host/src/freertos.cpp tools/host/src/esp_system.cpp tools/host/src/esp_http_server.cpp
+//       -o http_async_load
+//
+// Запуск: ./http_async_load [длительность прогона, мс]
+
+#include "Http/HttpAsyncWorkers.h"
+#include "HostHttpd.h"
+#include "HostCheck.h"
+#include "esp_timer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const uint32_t SLOW_MS = 40;                // Время медленного обработчика, мс
+    const double FAST_RATE = 200.;              // Быстрые запросы, в секунду
+
+    HttpAsyncWorkers* g_workers = nullptr;      // Пул для прослойки асинхронного маршрута
+
+    esp_err_t stopHandler(httpd_req_t* req)
+    {
+        return httpd_resp_sendstr(req, "stopped");
+    }
+
+    esp_err_t moveHandler(httpd_req_t* req)
+    {
+        vTaskDelay(pdMS_TO_TICKS(SLOW_MS));
+        return httpd_resp_sendstr(req, "moved");
+    }
+
+    // Прослойка как в HttpServer::asyncDispatch
+    esp_err_t asyncMoveHandler(httpd_req_t* req)
+    {
+        return g_workers->submit(req, &moveHandler, req->user_ctx);
+    }
+
+    struct Arrival
+    {
+        int64_t atUs;                           // Время прихода от начала прогона
+        bool slow;
+    };
+
+    struct RunResult
+    {
+        std::vector<int64_t> fastUs;
+        std::vector<int64_t> slowUs;            // Принятые медленные
+        size_t rejected = 0;
+        size_t badResponses = 0;                // Не ровно один ответ или копия запроса не освобождена
+    };
+
+    std::vector<Arrival> makeArrivals(double slowRate, uint32_t durationMs, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<Arrival> arrivals;
+        for (const auto& [rate, slow] : {std::make_pair(FAST_RATE, false), std::make_pair(slowRate, true)})
+        {
+            std::exponential_distribution<double> gap(rate / 1e6);
+            for (double t = gap(rng); t < durationMs * 1000.; t += gap(rng))
+                arrivals.push_back({static_cast<int64_t>(t), slow});
+        }
+        std::sort(arrivals.begin(), arrivals.end(), [](const Arrival& a, const Arrival& b) { return a.atUs < b.atUs; });
+        return arrivals;
+    }
+
+    int64_t percentile(std::vector<int64_t> values, double p)
+    {
+        if (values.empty())
+            return 0;
+        std::sort(values.begin(), values.end());
+        return values[static_cast<size_t>(p * (values.size() - 1))];
+    }
+
+    // Прогон: поток теста - задача httpd, запросы обрабатываются строго по одному в порядке прихода
+    RunResult run(httpd_handle_t server, const std::vector<Arrival>& arrivals)
+    {
+        std::vector<std::unique_ptr<HostHttpd::Exchange>> exchanges;
+        std::vector<int64_t> startUs;
+        const int64_t baseUs = esp_timer_get_time();
+        for (const Arrival& arrival : arrivals)
+        {
+            while (esp_timer_get_time() < baseUs + arrival.atUs)
+            {
+            }
+            auto exchange = std::make_unique<HostHttpd::Exchange>();
+            exchange->uri = arrival.slow ? "/move" : "/stop";
+            HostHttpd::dispatch(server, *exchange);
+            exchanges.push_back(std::move(exchange));
+            startUs.push_back(baseUs + arrival.atUs);
+        }
+
+        RunResult result;
+        for (size_t i = 0; i < exchanges.size(); ++i)
+        {
+            HostHttpd::Exchange& exchange = *exchanges[i];
+            if (!exchange.waitFinished(5000) || exchange.responses != 1)
+            {
+                ++result.badResponses;
+                continue;
+            }
+            const int64_t latencyUs = exchange.finishedUs - startUs[i];
+            if (!arrivals[i].slow)
+                result.fastUs.push_back(latencyUs);
+            else if (exchange.statusCode() == 503)
+                ++result.rejected;
+            else
+                result.slowUs.push_back(latencyUs);
+        }
+        return result;
+    }
+
+    void print(const char* name, const RunResult& result)
+    {
+        printf("%-28s fast p50=%6lld p99=%6lld max=%6lld us | slow accepted=%3zu p99=%6lld max=%6lld us | 503=%zu\n",
+               name, static_cast<long long>(percentile(result.fastUs, 0.5)),
+               static_cast<long long>(percentile(result.fastUs, 0.99)),
+               static_cast<long long>(percentile(result.fastUs, 1.)), result.slowUs.size(),
+               static_cast<long long>(percentile(result.slowUs, 0.99)),
+               static_cast<long long>(percentile(result.slowUs, 1.)), result.rejected);
+    }
+
+    httpd_handle_t startServer(bool async)
+    {
+        httpd_handle_t server = nullptr;
+        httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+        httpd_start(&server, &config);
+        const httpd_uri_t stop = {.uri = "/stop", .method = HTTP_GET, .handler = &stopHandler, .user_ctx = nullptr};
+        const httpd_uri_t move = {.uri = "/move", .method = HTTP_GET,
+                                  .handler = async ? &asyncMoveHandler : &moveHandler, .user_ctx = nullptr};
+        httpd_register_uri_handler(server, &stop);
+        httpd_register_uri_handler(server, &move);
+        return server;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t durationMs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+
+    HttpAsyncWorkers::Config config;
+    config.workersCount = 2;
+    config.queueSize = 4;
+    const double capacity = config.workersCount * 1000. / SLOW_MS;     // Медленных запросов в секунду
+
+    // Медленный обработчик в задаче httpd: быстрый маршрут ждет его завершения
+    httpd_handle_t syncServer = startServer(false);
+    const RunResult sync = run(syncServer, makeArrivals(capacity * 0.25, durationMs, 1));
+    httpd_stop(syncServer);
+    print("sync, 25% load", sync);
+    HOST_CHECK(sync.badResponses == 0);
+
+    HttpAsyncWorkers workers(config);
+    g_workers = &workers;
+    HOST_CHECK(workers.start());
+    httpd_handle_t server = startServer(true);
+
+    // Нагрузка в пределах производительности пула: отказов нет, быстрый маршрут не ждет медленных
+    const RunResult normal = run(server, makeArrivals(capacity * 0.5, durationMs, 2));
+    print("async, 50% load", normal);
+    HOST_CHECK(normal.badResponses == 0);
+    HOST_CHECK(normal.rejected == 0);
+    HOST_CHECK_MSG(percentile(normal.fastUs, 0.99) < SLOW_MS * 1000 / 4, "fast p99 %lld us",
+                   static_cast<long long>(percentile(normal.fastUs, 0.99)));
+
+    // Перегрузка: лишние запросы получают 503 сразу, задержка принятых ограничена длиной очереди
+    const RunResult overload = run(server, makeArrivals(capacity * 3., durationMs, 3));
+    print("async, 300% load", overload);
+    HOST_CHECK(overload.badResponses == 0);
+    HOST_CHECK(overload.rejected > 0);
+    HOST_CHECK_MSG(percentile(overload.fastUs, 0.99) < SLOW_MS * 1000 / 4, "fast p99 %lld us",
+                   static_cast<long long>(percentile(overload.fastUs, 0.99)));
+    const int64_t slowBoundUs = (config.queueSize / config.workersCount + 1) * SLOW_MS * 1000 * 3 / 2;
+    HOST_CHECK_MSG(percentile(overload.slowUs, 1.) < slowBoundUs, "slow max %lld us, bound %lld us",
+                   static_cast<long long>(percentile(overload.slowUs, 1.)), static_cast<long long>(slowBoundUs));
+
+    // Счетчик обработанных увеличивается после освобождения копии запроса
+    const int64_t statsDeadlineUs = esp_timer_get_time() + 1'000'000;
+    while (workers.getStats().completed != workers.getStats().accepted && esp_timer_get_time() < statsDeadlineUs)
+        vTaskDelay(1);
+    const HttpAsyncWorkers::Stats stats = workers.getStats();
+    HOST_CHECK(stats.accepted == normal.slowUs.size() + overload.slowUs.size());
+    HOST_CHECK(stats.rejected == overload.rejected);
+    HOST_CHECK(stats.completed == stats.accepted);
+
+    // Остановка с заполненной очередью: занятые задачи дорабатывают, ожидающие получают 503
+    std::vector<std::unique_ptr<HostHttpd::Exchange>> pending;
+    for (size_t i = 0; i < config.workersCount + config.queueSize; ++i)
+    {
+        pending.push_back(std::make_unique<HostHttpd::Exchange>());
+        pending.back()->uri = "/move";
+        HostHttpd::dispatch(server, *pending.back());
+        // Первые запросы забираются задачами, остальные остаются в очереди
+        if (i + 1 == config.workersCount)
+            vTaskDelay(pdMS_TO_TICKS(SLOW_MS / 4));
+    }
+    workers.stop();
+    size_t stopped = 0;
+    for (const auto& exchange : pending)
+    {
+        HOST_CHECK(exchange->waitFinished(1000) && exchange->responses == 1 && exchange->asyncCompleted);
+        stopped += exchange->statusCode() == 503;
+    }
+    HOST_CHECK_MSG(stopped == config.queueSize, "503 on stop: %zu", stopped);
+
+    // После остановки запросы отклоняются
+    HostHttpd::Exchange late;
+    late.uri = "/move";
+    HostHttpd::dispatch(server, late);
+    HOST_CHECK(late.waitFinished(100) && late.statusCode() == 503 && !late.asyncBegun);
+
+    httpd_stop(server);
+    return HostCheck::result();
+}
@@ -0,0 +1,1092 @@
+// Проверка компонента led_strip на ПК: группа лент на заглушках бэкенда (порядок запуска и ожидания, синхронизация
+// каналов RMT, таймаут и частичный запуск), бэкенд SPI на модели ведущего SPI (tools/host/src/spi_master.cpp):
+// кодирование на линии (таблица и запись словами - бит в бит с прежним побитовым кодированием) и защита буфера,
+// который читает DMA незавершенной передачи; буфер в PSRAM: стыки порций
+// побитно совпадают с кодированием всего кадра, промежуток между порциями на линии сравнивается со временем сброса
+// (защелкивания) WS2812. Кодировщик RMT (модель памяти канала в tools/host/src/rmt.cpp): символы из таблицы на байт
+// совпадают с прежним кодировщиком байтов (длительности из плавающей точки) для всех моделей и разрешений.
+// Выходное преобразование (яркость, гамма, баланс белого): таблицы 8 и 16 бит против расчета в double, уровни на линии
+// SPI (обычный буфер и PSRAM) и в символах RMT, смена яркости без новых пикселей, среднее сглаживания по 256 кадрам.
+// HSV: общее ядро без деления бит в бит с прежним преобразованием (8 бит - полный перебор, 16 бит - сетка и случайные
+// значения), круг оттенков 1536 против расчета в double, пакетная запись против попиксельной.
+//
+// Сборка (Linux; исходники компонента - на C):
+//   gcc -std=gnu11 -O2 -c -Itools/host/include -Icomponents/led_strip/include -Icomponents/led_strip/interface
+//       components/led_strip/src/led_strip_api.c components/led_strip/src/led_strip_common.c
+//       components/led_strip/src/led_strip_group.c components/led_strip/src/led_strip_spi_dev.c
+//       components/led_strip/src/led_strip_rmt_encoder.c
+//   g++ -std=c++17 -O2 -pthread -Itools/host/include -Icomponents/led_strip/include -Icomponents/led_strip/interface
+//       -Icomponents/led_strip/src -Icomponents/microbench/include components/microbench/src/MicroBench.cpp
+//       tools/led_strip_host.cpp led_strip_api.o led_strip_common.o led_strip_group.o led_strip_spi_dev.o
+//       led_strip_rmt_encoder.o
+//       tools/host/src/spi_master.cpp tools/host/src/rmt.cpp tools/host/src/freertos.cpp
+//       tools/host/src/esp_system.cpp -o led_strip_host
+//
+// Запуск: ./led_strip_host - проверки; ./led_strip_host bench - замеры кодирования и HSV (вывод для tools/bench_compare.py)
+
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_rmt_encoder.h"
+#include "led_strip_common.h"
+#include "HostSpi.h"
+#include "HostRmt.h"
+#include "HostCheck.h"
+#include "MicroBench.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Заглушка бэкенда: события запуска и ожидания пишутся в общий журнал
+    struct MockStrip
+    {
+        led_strip_t base = {};
+        std::string name;
+        bool inFlight = false;
+        int waitTimeouts = 0;                   // Сколько следующих ожиданий вернут ESP_ERR_TIMEOUT
+        esp_err_t refreshResult = ESP_OK;       // Результат следующего запуска
+        bool joined = false;                    // Канал в менеджере синхронизации RMT
+    };
+
+    std::vector<std::string> g_events;
+
+    MockStrip* mock(led_strip_t* strip)
+    {
+        return reinterpret_cast<MockStrip*>(reinterpret_cast<char*>(strip) - offsetof(MockStrip, base));
+    }
+
+    esp_err_t mockRefreshAsync(led_strip_t* strip)
+    {
+        MockStrip* self = mock(strip);
+        if (self->refreshResult != ESP_OK)
+            return self->refreshResult;
+        g_events.push_back("start " + self->name);
+        self->inFlight = true;
+        return ESP_OK;
+    }
+
+    esp_err_t mockWaitRefreshDone(led_strip_t* strip, int32_t)
+    {
+        MockStrip* self = mock(strip);
+        if (!self->inFlight)
+            return ESP_OK;
+        if (self->waitTimeouts > 0)
+        {
+            --self->waitTimeouts;
+            return ESP_ERR_TIMEOUT;
+        }
+        g_events.push_back("done " + self->name);
+        self->inFlight = false;
+        return ESP_OK;
+    }
+
+    esp_err_t mockRmtSyncJoin(led_strip_t* strip, bool join, rmt_channel_handle_t* ret_chan)
+    {
+        MockStrip* self = mock(strip);
+        self->joined = join;
+        g_events.push_back((join ? "join " : "leave ") + self->name);
+        if (ret_chan)
+            *ret_chan = reinterpret_cast<rmt_channel_handle_t>(self);
+        return ESP_OK;
+    }
+
+    void initMock(MockStrip& strip, const char* name, bool rmtSync)
+    {
+        strip.name = name;
+        strip.base.refresh_async = mockRefreshAsync;
+        strip.base.wait_refresh_done = mockWaitRefreshDone;
+        strip.base.rmt_sync_join = rmtSync ? mockRmtSyncJoin : nullptr;
+    }
+
+    bool eventsEqual(const std::vector<std::string>& expected)
+    {
+        if (g_events == expected)
+            return true;
+        printf("  events:");
+        for (const std::string& event : g_events)
+            printf(" [%s]", event.c_str());
+        printf("\n");
+        return false;
+    }
+
+    void testGroupValidation()
+    {
+        MockStrip a, b, blocking;
+        initMock(a, "A", false);
+        initMock(b, "B", false);
+        blocking.name = "blocking";
+        led_strip_group_handle_t group = nullptr;
+
+        led_strip_handle_t duplicated[] = {&a.base, &b.base, &a.base};
+        HOST_CHECK(led_strip_new_group(duplicated, 3, &group) == ESP_ERR_INVALID_ARG);
+        led_strip_handle_t withBlocking[] = {&a.base, &blocking.base};
+        HOST_CHECK(led_strip_new_group(withBlocking, 2, &group) == ESP_ERR_NOT_SUPPORTED);
+        HOST_CHECK(led_strip_new_group(duplicated, 0, &group) == ESP_ERR_INVALID_ARG);
+        HOST_CHECK(led_strip_new_group(duplicated, LED_STRIP_GROUP_MAX_STRIPS + 1, &group) == ESP_ERR_INVALID_ARG);
+        HOST_CHECK(group == nullptr);
+    }
+
+    void testGroupOrdering()
+    {
+        HostRmt::reset();
+        g_events.clear();
+        MockStrip a, b, c;
+        initMock(a, "A", true);
+        initMock(b, "B", false);
+        initMock(c, "C", true);
+        led_strip_handle_t strips[] = {&a.base, &b.base, &c.base};
+        led_strip_group_handle_t group = nullptr;
+        HOST_CHECK(led_strip_new_group(strips, 3, &group) == ESP_OK);
+
+        // Каналы RMT группы - в одном менеджере синхронизации в порядке лент, остальные ленты в нем не участвуют
+        std::vector<HostRmt::SyncManager> managers = HostRmt::syncManagers();
+        HOST_CHECK(managers.size() == 1);
+        if (managers.size() == 1)
+        {
+            HOST_CHECK((managers[0].channels == std::vector<rmt_channel_handle_t>{
+                reinterpret_cast<rmt_channel_handle_t>(&a), reinterpret_cast<rmt_channel_handle_t>(&c)}));
+        }
+        HOST_CHECK(eventsEqual({"join A", "join C"}));
+
+        // Запуск в порядке лент; следующий кадр начинается только после завершения всех лент предыдущего
+        g_events.clear();
+        HOST_CHECK(led_strip_group_refresh_async(group) == ESP_OK);
+        HOST_CHECK(eventsEqual({"start A", "start B", "start C"}));
+        g_events.clear();
+        HOST_CHECK(led_strip_group_refresh_async(group) == ESP_OK);
+        HOST_CHECK(eventsEqual({"done A", "done B", "done C", "start A", "start B", "start C"}));
+        HOST_CHECK(HostRmt::syncManagers()[0].resets == 1);
+
+        // Ожидание без запущенного кадра ничего не делает
+        HOST_CHECK(led_strip_group_wait_refresh_done(group, -1) == ESP_OK);
+        g_events.clear();
+        HOST_CHECK(led_strip_group_wait_refresh_done(group, -1) == ESP_OK);
+        HOST_CHECK(eventsEqual({}));
+        HOST_CHECK(HostRmt::syncManagers()[0].resets == 2);
+
+        HOST_CHECK(led_strip_del_group(group) == ESP_OK);
+        HOST_CHECK(eventsEqual({"leave A", "leave C"}));
+        HOST_CHECK(HostRmt::syncManagers()[0].deleted);
+        HOST_CHECK(!a.joined && !c.joined);
+    }
+
+    void testGroupTimeoutAndPartialStart()
+    {
+        HostRmt::reset();
+        g_events.clear();
+        MockStrip a, b;
+        initMock(a, "A", true);
+        initMock(b, "B", true);
+        led_strip_handle_t strips[] = {&a.base, &b.base};
+        led_strip_group_handle_t group = nullptr;
+        HOST_CHECK(led_strip_new_group(strips, 2, &group) == ESP_OK);
+
+        // Таймаут одной ленты: группа остается занятой, менеджер синхронизации не перезапускается до конца кадра
+        HOST_CHECK(led_strip_group_refresh_async(group) == ESP_OK);
+        b.waitTimeouts = 1;
+        g_events.clear();
+        HOST_CHECK(led_strip_group_wait_refresh_done(group, 0) == ESP_ERR_TIMEOUT);
+        HOST_CHECK(HostRmt::syncManagers()[0].resets == 0);
+        HOST_CHECK(led_strip_group_wait_refresh_done(group, 0) == ESP_OK);
+        HOST_CHECK(eventsEqual({"done A", "done B"}));
+        HOST_CHECK(HostRmt::syncManagers()[0].resets == 1);
+
+        // Запуск второй ленты не удался: уже запущенная первая все равно дожидается
+        b.refreshResult = ESP_FAIL;
+        g_events.clear();
+        HOST_CHECK(led_strip_group_refresh_async(group) == ESP_FAIL);
+        HOST_CHECK(eventsEqual({"start A"}));
+        b.refreshResult = ESP_OK;
+        HOST_CHECK(led_strip_group_wait_refresh_done(group, -1) == ESP_OK);
+        HOST_CHECK(eventsEqual({"start A", "done A"}));
+        HOST_CHECK(led_strip_del_group(group) == ESP_OK);
+    }
+
+    // Кодирование SPI бит за битом: 1 -> 110, 0 -> 100, старшим битом вперед
+    std::vector<uint8_t> encodeSpi(const std::vector<uint8_t>& colors)
+    {
+        std::vector<uint8_t> out;
+        uint32_t acc = 0;
+        int bits = 0;
+        for (uint8_t color : colors)
+        {
+            for (int bit = 7; bit >= 0; --bit)
+            {
+                acc = (acc << 3) | ((color >> bit) & 1 ? 0x6 : 0x4);
+                bits += 3;
+                while (bits >= 8)
+                {
+                    bits -= 8;
+                    out.push_back(static_cast<uint8_t>(acc >> bits));
+                }
+            }
+        }
+        return out;
+    }
+
+    // Прежнее кодирование SPI (до таблицы): биты ставятся по одному в обнуленные 3 байта
+    void oldSpiBit(uint8_t data, uint8_t* buf)
+    {
+        *(buf + 2) |= data & BIT(0) ? BIT(2) | BIT(1) : BIT(2);
+        *(buf + 2) |= data & BIT(1) ? BIT(5) | BIT(4) : BIT(5);
+        *(buf + 2) |= data & BIT(2) ? BIT(7) : 0x00;
+        *(buf + 1) |= BIT(0);
+        *(buf + 1) |= data & BIT(3) ? BIT(3) | BIT(2) : BIT(3);
+        *(buf + 1) |= data & BIT(4) ? BIT(6) | BIT(5) : BIT(6);
+        *(buf + 0) |= data & BIT(5) ? BIT(1) | BIT(0) : BIT(1);
+        *(buf + 0) |= data & BIT(6) ? BIT(4) | BIT(3) : BIT(4);
+        *(buf + 0) |= data & BIT(7) ? BIT(7) | BIT(6) : BIT(7);
+    }
+
+    std::vector<uint8_t> oldEncodeSpi(const std::vector<uint8_t>& colors)
+    {
+        std::vector<uint8_t> out(colors.size() * 3, 0);
+        for (size_t i = 0; i < colors.size(); ++i)
+            oldSpiBit(colors[i], &out[i * 3]);
+        return out;
+    }
+
+    led_strip_handle_t newSpiStrip(spi_host_device_t host, uint32_t leds, led_color_component_format_t format,
+                                   bool inPsram = false, bool partialRefresh = false)
+    {
+        led_strip_config_t config = {};
+        config.strip_gpio_num = 8;
+        config.max_leds = leds;
+        config.led_model = LED_MODEL_WS2812;
+        config.color_component_format = format;
+        config.flags.pixel_buf_in_psram = inPsram;
+        config.flags.partial_refresh = partialRefresh;
+        led_strip_spi_config_t spiConfig = {};
+        spiConfig.spi_bus = host;
+        spiConfig.flags.with_dma = true;
+        led_strip_handle_t strip = nullptr;
+        HOST_CHECK(led_strip_new_spi_device(&config, &spiConfig, &strip) == ESP_OK);
+        return strip;
+    }
+
+    void testSpiBufferGuard()
+    {
+        HostSpi::reset();
+        const uint32_t leds = 8;
+        led_strip_handle_t strip = newSpiStrip(SPI2_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB);
+        if (!strip)
+            return;
+
+        // Кадр 1: все красные (GRB на линии), передача запускается без ожидания
+        std::vector<uint8_t> frame1;
+        for (uint32_t i = 0; i < leds; ++i)
+        {
+            HOST_CHECK(led_strip_set_pixel(strip, i, 0x80, 0x00, 0x00) == ESP_OK);
+            frame1.insert(frame1.end(), {0x00, 0x80, 0x00});
+        }
+        HOST_CHECK(led_strip_refresh_async(strip) == ESP_OK);
+
+        // Запись пикселей до конца передачи сначала дожидается ее - DMA передает неизмененный кадр
+        std::vector<uint8_t> frame2 = frame1;
+        HOST_CHECK(led_strip_set_pixel(strip, 0, 0x00, 0x00, 0xff) == ESP_OK);
+        frame2[0] = 0x00;
+        frame2[1] = 0x00;
+        frame2[2] = 0xff;
+        std::vector<HostSpi::Transfer> transfers = HostSpi::transfers(SPI2_HOST);
+        HOST_CHECK(transfers.size() == 1);
+
+        HOST_CHECK(led_strip_refresh_async(strip) == ESP_OK);
+        const uint8_t rgb[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+        HOST_CHECK(led_strip_set_pixels(strip, 1, 2, rgb, LED_STRIP_COLOR_COMPONENT_FMT_RGB) == ESP_OK);
+        std::vector<uint8_t> frame3 = frame2;
+        frame3.erase(frame3.begin() + 3, frame3.begin() + 9);
+        frame3.insert(frame3.begin() + 3, {0x02, 0x01, 0x03, 0x05, 0x04, 0x06});
+        HOST_CHECK(led_strip_refresh(strip) == ESP_OK);
+
+        transfers = HostSpi::transfers(SPI2_HOST);
+        HOST_CHECK(transfers.size() == 3);
+        if (transfers.size() == 3)
+        {
+            for (const HostSpi::Transfer& transfer : transfers)
+                HOST_CHECK(!transfer.changedInFlight);
+            HOST_CHECK(transfers[0].data == encodeSpi(frame1));
+            HOST_CHECK(transfers[1].data == encodeSpi(frame2));
+            HOST_CHECK(transfers[2].data == encodeSpi(frame3));
+        }
+        HOST_CHECK(led_strip_del(strip) == ESP_OK);
+    }
+
+    void testSpiGroup()
+    {
+        HostSpi::reset();
+        HostRmt::reset();
+        led_strip_handle_t strips[] = {newSpiStrip(SPI2_HOST, 64, LED_STRIP_COLOR_COMPONENT_FMT_GRB),
+                                       newSpiStrip(SPI3_HOST, 64, LED_STRIP_COLOR_COMPONENT_FMT_GRB)};
+        if (!strips[0] || !strips[1])
+            return;
+        led_strip_group_handle_t group = nullptr;
+        HOST_CHECK(led_strip_new_group(strips, 2, &group) == ESP_OK);
+        HOST_CHECK(HostRmt::syncManagers().empty());
+        HOST_CHECK(led_strip_group_refresh(group) == ESP_OK);
+
+        // Передачи на разных шинах идут одновременно: кадр группы длится как одна лента, а не сумма
+        const std::vector<HostSpi::Transfer> first = HostSpi::transfers(SPI2_HOST);
+        const std::vector<HostSpi::Transfer> second = HostSpi::transfers(SPI3_HOST);
+        HOST_CHECK(first.size() == 1 && second.size() == 1);
+        if (first.size() == 1 && second.size() == 1)
+            HOST_CHECK_MSG(second[0].startUs < first[0].endUs, "second starts at %lld us, first ends at %lld us",
+                           static_cast<long long>(second[0].startUs), static_cast<long long>(first[0].endUs));
+
+        HOST_CHECK(led_strip_del_group(group) == ESP_OK);
+        HOST_CHECK(led_strip_del(strips[0]) == ESP_OK);
+        HOST_CHECK(led_strip_del(strips[1]) == ESP_OK);
+    }
+
+    // Кадр, переданный последним обновлением
+    std::vector<uint8_t> lastFrame(spi_host_device_t host)
+    {
+        const std::vector<HostSpi::Transfer> transfers = HostSpi::transfers(host);
+        return transfers.empty() ? std::vector<uint8_t>() : transfers.back().data;
+    }
+
+    void testSpiLut()
+    {
+        // Эталон совпадает с прежним кодированием для всех значений байта
+        std::vector<uint8_t> all(256);
+        for (int i = 0; i < 256; ++i)
+            all[i] = static_cast<uint8_t>(i);
+        HOST_CHECK(oldEncodeSpi(all) == encodeSpi(all));
+
+        HostSpi::reset();
+        const uint32_t leds = 86;                   // 258 байт цвета - все значения
+        led_strip_handle_t strip = newSpiStrip(SPI2_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB);
+        if (!strip)
+            return;
+        std::vector<uint8_t> frame(leds * 3);
+        for (size_t i = 0; i < frame.size(); ++i)
+            frame[i] = static_cast<uint8_t>(i * 97);
+
+        // По одному пикселю (побайтовая запись из таблицы)
+        for (uint32_t i = 0; i < leds; ++i)
+            HOST_CHECK(led_strip_set_pixel(strip, i, frame[i * 3 + 1], frame[i * 3], frame[i * 3 + 2]) == ESP_OK);
+        HOST_CHECK(led_strip_refresh(strip) == ESP_OK);
+        HOST_CHECK(lastFrame(SPI2_HOST) == oldEncodeSpi(frame));
+
+        // Диапазоном в формате ленты (запись словами): все выравнивания начала и длины
+        std::mt19937 random(31);
+        for (uint32_t start = 0; start < 4; ++start)
+        {
+            for (uint32_t count = 1; count <= 9; ++count)
+            {
+                std::vector<uint8_t> pixels(count * 3);
+                for (uint8_t& byte : pixels)
+                    byte = static_cast<uint8_t>(random());
+                HOST_CHECK(led_strip_set_pixels(strip, start, count, pixels.data(), LED_STRIP_COLOR_COMPONENT_FMT_GRB) ==
+                           ESP_OK);
+                std::copy(pixels.begin(), pixels.end(), frame.begin() + start * 3);
+                HOST_CHECK(led_strip_refresh(strip) == ESP_OK);
+                HOST_CHECK_MSG(lastFrame(SPI2_HOST) == oldEncodeSpi(frame), "start %u, count %u", start, count);
+            }
+        }
+
+        HOST_CHECK(led_strip_clear(strip) == ESP_OK);
+        HOST_CHECK(lastFrame(SPI2_HOST) == oldEncodeSpi(std::vector<uint8_t>(frame.size(), 0)));
+        HOST_CHECK(led_strip_del(strip) == ESP_OK);
+
+        // Очистка лент длиной не кратной блоку записи
+        for (uint32_t count : {1u, 5u, 21u, 22u, 23u})
+        {
+            strip = newSpiStrip(SPI2_HOST, count, LED_STRIP_COLOR_COMPONENT_FMT_GRB);
+            if (!strip)
+                return;
+            HOST_CHECK(led_strip_set_pixel(strip, count - 1, 0xff, 0xff, 0xff) == ESP_OK);
+            HOST_CHECK(led_strip_clear(strip) == ESP_OK);
+            HOST_CHECK_MSG(lastFrame(SPI2_HOST) == oldEncodeSpi(std::vector<uint8_t>(count * 3, 0)), "%u LEDs", count);
+            HOST_CHECK(led_strip_del(strip) == ESP_OK);
+        }
+    }
+
+    // Замеры кодирования кадра из 1000 пикселей: прежнее побитовое, по пикселю из таблицы, диапазоном словами
+    void benchSpi()
+    {
+        const uint32_t leds = 1000;
+        led_strip_handle_t strip = newSpiStrip(SPI2_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB);
+        if (!strip)
+            return;
+        std::vector<uint8_t> pixels(leds * 3);
+        for (size_t i = 0; i < pixels.size(); ++i)
+            pixels[i] = static_cast<uint8_t>(i * 97);
+        std::vector<uint8_t> encoded(pixels.size() * 3);
+
+        MicroBench bench("led_strip_host");
+        MicroBench::Config config;
+        config.samples = 200;
+        bench.run("spi_encode_bitwise_1000", config, [&]()
+        {
+            for (uint32_t i = 0; i < leds; ++i)
+            {
+                uint8_t* dst = &encoded[i * 9];
+                memset(dst, 0, 9);
+                oldSpiBit(pixels[i * 3], dst);
+                oldSpiBit(pixels[i * 3 + 1], dst + 3);
+                oldSpiBit(pixels[i * 3 + 2], dst + 6);
+            }
+            MicroBench::keep(encoded);
+        });
+        bench.run("spi_set_pixel_1000", config, [&]()
+        {
+            for (uint32_t i = 0; i < leds; ++i)
+                led_strip_set_pixel(strip, i, pixels[i * 3 + 1], pixels[i * 3], pixels[i * 3 + 2]);
+        });
+        bench.run("spi_set_pixels_1000", config, [&]()
+        {
+            led_strip_set_pixels(strip, 0, leds, pixels.data(), LED_STRIP_COLOR_COMPONENT_FMT_GRB);
+        });
+        led_strip_del(strip);
+    }
+
+    // Прежний кодировщик RMT: длительности битов в мкс по модели, тики - отбрасыванием дробной части произведения
+    struct OldRmtTiming
+    {
+        double t0h, t0l, t1h, t1l;
+        uint32_t resetUs;
+    };
+
+    std::vector<rmt_symbol_word_t> oldRmtEncode(led_model_t model, uint32_t resolution, const std::vector<uint8_t>& data)
+    {
+        static const OldRmtTiming TIMINGS[] = {
+            {0.3, 0.9, 0.9, 0.3, 280},          // LED_MODEL_WS2812
+            {0.3, 0.9, 0.6, 0.6, 280},          // LED_MODEL_SK6812
+            {0.5, 2.0, 1.2, 1.3, 50},           // LED_MODEL_WS2811
+            {0.3, 0.95, 0.75, 0.5, 280},        // LED_MODEL_WS2816
+        };
+        const OldRmtTiming& timing = TIMINGS[model];
+        rmt_symbol_word_t bit0 = {}, bit1 = {};
+        bit0.level0 = 1;
+        bit0.duration0 = static_cast<uint16_t>(timing.t0h * resolution / 1000000);
+        bit0.duration1 = static_cast<uint16_t>(timing.t0l * resolution / 1000000);
+        bit1.level0 = 1;
+        bit1.duration0 = static_cast<uint16_t>(timing.t1h * resolution / 1000000);
+        bit1.duration1 = static_cast<uint16_t>(timing.t1l * resolution / 1000000);
+
+        std::vector<rmt_symbol_word_t> symbols;
+        for (uint8_t byte : data)
+        {
+            for (int bit = 7; bit >= 0; --bit)
+                symbols.push_back((byte >> bit) & 1 ? bit1 : bit0);
+        }
+        rmt_symbol_word_t reset = {};
+        reset.duration0 = resolution / 1000000 * timing.resetUs / 2;
+        reset.duration1 = reset.duration0;
+        symbols.push_back(reset);
+        return symbols;
+    }
+
+    bool symbolsEqual(const std::vector<rmt_symbol_word_t>& a, const std::vector<rmt_symbol_word_t>& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].val != b[i].val)
+            {
+                printf("  symbol %zu: 0x%08x != 0x%08x\n", i, a[i].val, b[i].val);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void testRmtSymbolTable()
+    {
+        std::vector<uint8_t> data(256);
+        for (int i = 0; i < 256; ++i)
+            data[i] = static_cast<uint8_t>(i);
+        std::mt19937 random(36);
+        for (int i = 0; i < 61; ++i)
+            data.push_back(static_cast<uint8_t>(random()));
+
+        for (led_model_t model : {LED_MODEL_WS2812, LED_MODEL_SK6812, LED_MODEL_WS2811, LED_MODEL_WS2816})
+        {
+            for (uint32_t resolution : {10000000u, 20000000u, 40000000u, 80000000u})
+            {
+                led_strip_encoder_config_t config = {};
+                config.resolution = resolution;
+                config.led_model = model;
+                config.component_fmt = model == LED_MODEL_WS2816 ? LED_STRIP_COLOR_COMPONENT_FMT_GRB_16 :
+                                       LED_STRIP_COLOR_COMPONENT_FMT_GRB;
+                rmt_encoder_handle_t encoder = nullptr;
+                HOST_CHECK(rmt_new_led_strip_encoder(&config, &encoder) == ESP_OK);
+                if (!encoder)
+                    continue;
+                const std::vector<rmt_symbol_word_t> expected = oldRmtEncode(model, resolution, data);
+
+                // Память канала ESP32-S3 (48 символов) и размер, не кратный символам байта (через буфер драйвера)
+                for (size_t memSymbols : {48u, 13u})
+                {
+                    HOST_CHECK_MSG(symbolsEqual(HostRmt::encode(encoder, data.data(), data.size(), memSymbols), expected),
+                                   "model %d, %u Hz, memory %zu", model, resolution, memSymbols);
+                }
+                // Кодировщик повторно используется для следующего кадра
+                HOST_CHECK(symbolsEqual(HostRmt::encode(encoder, data.data(), data.size()), expected));
+                rmt_del_encoder(encoder);
+            }
+        }
+    }
+
+    const size_t PSRAM_CHUNK_BYTES = 512;           // Порция кодирования (LED_STRIP_SPI_PSRAM_CHUNK_BYTES), байт цвета
+    const int64_t WS2812_RESET_US = 50;             // Наименьшее время сброса WS2812 по документации, мкс
+
+    // Случайный кадр: байты цвета в порядке ленты (GRB) и то же через led_strip_set_pixel
+    std::vector<uint8_t> fillRandom(led_strip_handle_t strip, uint32_t leds, std::mt19937& random)
+    {
+        std::vector<uint8_t> frame;
+        for (uint32_t i = 0; i < leds; ++i)
+        {
+            const uint8_t r = random(), g = random(), b = random();
+            HOST_CHECK(led_strip_set_pixel(strip, i, r, g, b) == ESP_OK);
+            frame.insert(frame.end(), {g, r, b});
+        }
+        return frame;
+    }
+
+    void testPsramChunks()
+    {
+        std::mt19937 random(40);
+        // 3 байта на пиксель: порции по 512 байт режут пиксели посередине
+        for (uint32_t leds : {1u, 170u, 171u, 341u, 1000u})
+        {
+            HostSpi::reset();
+            led_strip_handle_t strip = newSpiStrip(SPI2_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB, true);
+            if (!strip)
+                return;
+            const std::vector<uint8_t> frame = fillRandom(strip, leds, random);
+            HOST_CHECK(led_strip_refresh(strip) == ESP_OK);
+
+            // Поток на линии - склейка порций - совпадает с кодированием всего кадра бит в бит
+            const std::vector<HostSpi::Transfer> transfers = HostSpi::transfers(SPI2_HOST);
+            HOST_CHECK(transfers.size() == (frame.size() + PSRAM_CHUNK_BYTES - 1) / PSRAM_CHUNK_BYTES);
+            HOST_CHECK_MSG(HostSpi::wire(SPI2_HOST) == encodeSpi(frame), "%u LEDs", leds);
+
+            // Промежуток на линии между порциями и запас: насколько раньше конца текущей порции поставлена следующая.
+            // На устройстве к промежутку добавляется запуск следующей транзакции в прерывании драйвера (порядка 10-20 мкс)
+            int64_t maxGapUs = 0;
+            int64_t minMarginUs = INT64_MAX;
+            for (size_t i = 1; i < transfers.size(); ++i)
+            {
+                HOST_CHECK(!transfers[i - 1].changedInFlight);
+                maxGapUs = std::max(maxGapUs, transfers[i].startUs - transfers[i - 1].endUs);
+                minMarginUs = std::min(minMarginUs, transfers[i - 1].endUs - transfers[i].queuedUs);
+            }
+            HOST_CHECK_MSG(maxGapUs < WS2812_RESET_US, "%u LEDs: gap %lld us", leds, static_cast<long long>(maxGapUs));
+            if (transfers.size() > 1)
+            {
+                printf("PSRAM %u LEDs: %zu chunks, max gap %lld us, min margin %lld us (reset %lld us)\n", leds,
+                       transfers.size(), static_cast<long long>(maxGapUs), static_cast<long long>(minMarginUs),
+                       static_cast<long long>(WS2812_RESET_US));
+            }
+            HOST_CHECK(led_strip_del(strip) == ESP_OK);
+        }
+
+        // 6 байт на пиксель (WS2816) и частичное обновление: передается только измененное начало ленты
+        HostSpi::reset();
+        const uint32_t leds = 400;
+        led_strip_handle_t strip = newSpiStrip(SPI2_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB_16, true, true);
+        if (!strip)
+            return;
+        std::vector<uint8_t> frame(leds * 6, 0);
+        HOST_CHECK(led_strip_refresh(strip) == ESP_OK);
+        HostSpi::reset();
+        const uint32_t dirty = 300;
+        for (uint32_t i = 0; i < dirty; ++i)
+        {
+            const uint16_t r = random(), g = random(), b = random();
+            HOST_CHECK(led_strip_set_pixel(strip, i, r, g, b) == ESP_OK);
+            const uint8_t bytes[] = {static_cast<uint8_t>(g >> 8), static_cast<uint8_t>(g),
+                                     static_cast<uint8_t>(r >> 8), static_cast<uint8_t>(r),
+                                     static_cast<uint8_t>(b >> 8), static_cast<uint8_t>(b)};
+            std::copy(bytes, bytes + 6, frame.begin() + i * 6);
+        }
+        HOST_CHECK(led_strip_refresh(strip) == ESP_OK);
+        HOST_CHECK(HostSpi::wire(SPI2_HOST) == encodeSpi(std::vector<uint8_t>(frame.begin(), frame.begin() + dirty * 6)));
+        HOST_CHECK(led_strip_del(strip) == ESP_OK);
+    }
+
+    // Байты цвета из потока SPI: бит k байта - бит (3 * k + 1) 24-битного слова
+    std::vector<uint8_t> decodeSpi(const std::vector<uint8_t>& wire)
+    {
+        std::vector<uint8_t> colors;
+        for (size_t i = 0; i + 2 < wire.size(); i += 3)
+        {
+            const uint32_t bits = (wire[i] << 16) | (wire[i + 1] << 8) | wire[i + 2];
+            uint8_t value = 0;
+            for (int k = 0; k < 8; ++k)
+                value |= ((bits >> (3 * k + 1)) & 1) << k;
+            colors.push_back(value);
+        }
+        return colors;
+    }
+
+    // Байты цвета из символов RMT (WS2812: у единицы высокий уровень длиннее низкого), без символа сброса
+    std::vector<uint8_t> decodeRmt(const std::vector<rmt_symbol_word_t>& symbols)
+    {
+        std::vector<uint8_t> colors;
+        for (size_t i = 0; i + 8 < symbols.size(); i += 8)
+        {
+            uint8_t value = 0;
+            for (int bit = 0; bit < 8; ++bit)
+                value = (value << 1) | (symbols[i + bit].duration0 > symbols[i + bit].duration1 ? 1 : 0);
+            colors.push_back(value);
+        }
+        return colors;
+    }
+
+    // Точный уровень на выходе: полная шкала * (x / max)^gamma * яркость * баланс
+    double referenceLevel(uint32_t value, uint32_t maxValue, const led_strip_transform_config_t& config, uint8_t scale)
+    {
+        const double gamma = config.gamma > 0 ? config.gamma : 1.0;
+        return maxValue * std::pow(static_cast<double>(value) / maxValue, gamma) * config.brightness / 255.0 *
+               (scale ? scale : 255) / 255.0;
+    }
+
+    led_strip_transform_config_t transformConfig(uint8_t brightness, float gamma, uint8_t r, uint8_t g, uint8_t b)
+    {
+        led_strip_transform_config_t config = {};
+        config.brightness = brightness;
+        config.gamma = gamma;
+        config.r_scale = r;
+        config.g_scale = g;
+        config.b_scale = b;
+        return config;
+    }
+
+    void testTransformLut()
+    {
+        const led_strip_transform_config_t configs[] = {
+            transformConfig(255, 1.0f, 0, 0, 0), transformConfig(128, 1.0f, 0, 0, 0), transformConfig(255, 2.2f, 0, 0, 0),
+            transformConfig(10, 2.2f, 0, 0, 0), transformConfig(200, 2.8f, 0, 0, 0), transformConfig(255, 0.5f, 0, 0, 0),
+        };
+        for (const led_strip_transform_config_t& config : configs)
+        {
+            for (uint8_t scale : {255, 200, 37})
+            {
+                uint32_t lut[257];
+                led_strip_build_transform_lut(&config, scale, 1, lut);
+                uint32_t prev = 0;
+                double maxError = 0;
+                for (uint32_t v = 0; v < 256; ++v)
+                {
+                    const uint8_t src[] = {static_cast<uint8_t>(v)};
+                    const uint32_t level = led_strip_transform_level(lut, src, 1, 0x80);
+                    HOST_CHECK(level >= prev && level <= 0xFF && lut[v] <= (0xFFu << 16));
+                    maxError = std::max(maxError, std::fabs(level - referenceLevel(v, 0xFF, config, scale)));
+                    // Без яркости, гаммы и баланса - тождество
+                    if (config.brightness == 255 && config.gamma == 1.0f && scale == 255)
+                        HOST_CHECK_MSG(level == v, "8-bit identity %u -> %u", v, level);
+                    prev = level;
+                }
+                // Округление до ближайшего: не дальше половины шага (и погрешность float в таблице)
+                HOST_CHECK_MSG(maxError < 0.5 + 1e-3, "8-bit brightness %u gamma %.1f scale %u: error %.4f",
+                               config.brightness, config.gamma, scale, maxError);
+
+                led_strip_build_transform_lut(&config, scale, 2, lut);
+                prev = 0;
+                maxError = 0;
+                for (uint32_t v = 0; v < 0x10000; ++v)
+                {
+                    const uint8_t src[] = {static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v)};
+                    const uint32_t level = led_strip_transform_level(lut, src, 2, 0x80);
+                    HOST_CHECK(level >= prev && level <= 0xFFFF);
+                    maxError = std::max(maxError, std::fabs(level - referenceLevel(v, 0xFFFF, config, scale)));
+                    if (config.brightness == 255 && config.gamma == 1.0f && scale == 255)
+                        HOST_CHECK_MSG(level == v, "16-bit identity %u -> %u", v, level);
+                    prev = level;
+                }
+                // Между узлами - линейная интерполяция: на выпуклой кривой (гамма от 1) ее погрешность меньше шага.
+                // Гамма меньше 1 в первом отрезке у нуля интерполируется грубо - проверяется только монотонность
+                if (config.gamma >= 1.0f)
+                    HOST_CHECK_MSG(maxError < 1.0, "16-bit brightness %u gamma %.1f scale %u: error %.4f",
+                               config.brightness, config.gamma, scale, maxError);
+            }
+        }
+    }
+
+    // Ожидаемые байты кадра GRB с преобразованием (уровни по таблицам компонента, как в кодировщике)
+    std::vector<uint8_t> transformFrame(const std::vector<uint8_t>& grb, const led_strip_transform_config_t& config)
+    {
+        uint32_t luts[3][257];
+        led_strip_build_transform_lut(&config, config.g_scale ? config.g_scale : 255, 1, luts[0]);
+        led_strip_build_transform_lut(&config, config.r_scale ? config.r_scale : 255, 1, luts[1]);
+        led_strip_build_transform_lut(&config, config.b_scale ? config.b_scale : 255, 1, luts[2]);
+        std::vector<uint8_t> out;
+        for (size_t i = 0; i < grb.size(); ++i)
+        {
+            const uint32_t level = led_strip_transform_level(luts[i % 3], &grb[i], 1, 0x80);
+            // Компонент на своем месте: расхождение с точным расчетом своего баланса - не больше шага
+            const uint8_t scales[] = {config.g_scale, config.r_scale, config.b_scale};
+            HOST_CHECK(std::fabs(level - referenceLevel(grb[i], 0xFF, config, scales[i % 3])) < 0.51);
+            out.push_back(static_cast<uint8_t>(level));
+        }
+        return out;
+    }
+
+    // Поток на линии после передачи с номером mark (в PSRAM - склейка порций)
+    std::vector<uint8_t> wireSince(spi_host_device_t host, size_t mark)
+    {
+        const std::vector<HostSpi::Transfer> transfers = HostSpi::transfers(host);
+        std::vector<uint8_t> wire;
+        for (size_t i = mark; i < transfers.size(); ++i)
+            wire.insert(wire.end(), transfers[i].data.begin(), transfers[i].data.end());
+        return wire;
+    }
+
+    std::vector<uint8_t> refreshWire(led_strip_handle_t strip, spi_host_device_t host)
+    {
+        const size_t mark = HostSpi::transfers(host).size();
+        HOST_CHECK(led_strip_refresh(strip) == ESP_OK);
+        return wireSince(host, mark);
+    }
+
+    void testTransformOutput()
+    {
+        const uint32_t leds = 200;
+        const led_strip_transform_config_t warm = transformConfig(128, 2.2f, 255, 200, 100);
+        const led_strip_transform_config_t dim = transformConfig(40, 2.2f, 255, 200, 100);
+        std::mt19937 random(37);
+
+        for (bool inPsram : {false, true})
+        {
+            HostSpi::reset();
+            led_strip_handle_t strip = newSpiStrip(SPI2_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB, inPsram);
+            if (!strip)
+                return;
+            // Пиксели до включения преобразования сохраняются (обычный буфер переходит на некодированную копию)
+            const std::vector<uint8_t> frame = fillRandom(strip, leds, random);
+            HOST_CHECK(led_strip_set_transform(strip, &warm) == ESP_OK);
+            HOST_CHECK_MSG(decodeSpi(refreshWire(strip, SPI2_HOST)) == transformFrame(frame, warm), "psram %d", inPsram);
+
+            // Смена яркости - без новых пикселей
+            HOST_CHECK(led_strip_set_transform(strip, &dim) == ESP_OK);
+            HOST_CHECK_MSG(decodeSpi(refreshWire(strip, SPI2_HOST)) == transformFrame(frame, dim), "psram %d", inPsram);
+
+            // Пакетная запись и асинхронное обновление идут через то же преобразование
+            std::vector<uint8_t> next(frame.size());
+            for (uint8_t& byte : next)
+                byte = random();
+            HOST_CHECK(led_strip_set_pixels(strip, 0, leds, next.data(), LED_STRIP_COLOR_COMPONENT_FMT_GRB) == ESP_OK);
+            HOST_CHECK(decodeSpi(refreshWire(strip, SPI2_HOST)) == transformFrame(next, dim));
+
+            // Без преобразования - значения как заданы
+            HOST_CHECK(led_strip_set_transform(strip, nullptr) == ESP_OK);
+            HOST_CHECK(refreshWire(strip, SPI2_HOST) == encodeSpi(next));
+            const size_t mark = HostSpi::transfers(SPI2_HOST).size();
+            HOST_CHECK(led_strip_clear(strip) == ESP_OK);
+            HOST_CHECK(wireSince(SPI2_HOST, mark) == encodeSpi(std::vector<uint8_t>(next.size(), 0)));
+            HOST_CHECK(led_strip_del(strip) == ESP_OK);
+        }
+
+        // Кодировщик RMT дает те же уровни, компоненты на своих местах
+        led_strip_encoder_config_t config = {};
+        config.resolution = 10000000;
+        config.led_model = LED_MODEL_WS2812;
+        config.component_fmt = LED_STRIP_COLOR_COMPONENT_FMT_GRB;
+        rmt_encoder_handle_t encoder = nullptr;
+        HOST_CHECK(rmt_new_led_strip_encoder(&config, &encoder) == ESP_OK);
+        if (!encoder)
+            return;
+        std::vector<uint8_t> frame(leds * 3);
+        for (uint8_t& byte : frame)
+            byte = random();
+        HOST_CHECK(rmt_led_strip_encoder_set_transform(encoder, &warm) == ESP_OK);
+        for (size_t memSymbols : {48u, 13u})
+            HOST_CHECK(decodeRmt(HostRmt::encode(encoder, frame.data(), frame.size(), memSymbols)) == transformFrame(frame, warm));
+        HOST_CHECK(rmt_led_strip_encoder_set_transform(encoder, nullptr) == ESP_OK);
+        HOST_CHECK(decodeRmt(HostRmt::encode(encoder, frame.data(), frame.size())) == frame);
+        rmt_del_encoder(encoder);
+    }
+
+    void testTransformDither()
+    {
+        // Уровни с дробной частью: среднее за 256 кадров - точное значение, соседние кадры отличаются не больше чем на шаг
+        HostSpi::reset();
+        const uint32_t leds = 16;
+        led_strip_handle_t strip = newSpiStrip(SPI2_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB);
+        if (!strip)
+            return;
+        led_strip_transform_config_t config = transformConfig(100, 2.2f, 0, 0, 0);
+        config.flags.temporal_dither = true;
+        HOST_CHECK(led_strip_set_transform(strip, &config) == ESP_OK);
+        std::vector<uint8_t> frame;
+        for (uint32_t i = 0; i < leds; ++i)
+        {
+            const uint8_t r = 20 + i * 15, g = 255 - i * 9, b = i * 3;
+            HOST_CHECK(led_strip_set_pixel(strip, i, r, g, b) == ESP_OK);
+            frame.insert(frame.end(), {g, r, b});
+        }
+        std::vector<uint32_t> sums(frame.size(), 0);
+        std::vector<uint8_t> prev;
+        bool varies = false;
+        for (int n = 0; n < 256; ++n)
+        {
+            HOST_CHECK(led_strip_refresh(strip) == ESP_OK);
+            const std::vector<uint8_t> levels = decodeSpi(lastFrame(SPI2_HOST));
+            for (size_t i = 0; i < levels.size() && i < sums.size(); ++i)
+            {
+                sums[i] += levels[i];
+                if (!prev.empty())
+                {
+                    HOST_CHECK(std::abs(levels[i] - prev[i]) <= 1);
+                    varies |= levels[i] != prev[i];
+                }
+            }
+            prev = levels;
+        }
+        HOST_CHECK(varies);
+        double maxError = 0;
+        for (size_t i = 0; i < frame.size(); ++i)
+            maxError = std::max(maxError, std::fabs(sums[i] / 256.0 - referenceLevel(frame[i], 0xFF, config, 0)));
+        HOST_CHECK_MSG(maxError < 2.0 / 256, "dither mean error %.5f", maxError);
+        HOST_CHECK(led_strip_del(strip) == ESP_OK);
+    }
+
+    // Прежнее преобразование HSV (до общего ядра): деления и выбор сектора через switch
+    void oldHsvToRgb(uint32_t hue, uint32_t saturation, uint32_t value, uint32_t maxLevel, uint32_t rgb[3])
+    {
+        const uint32_t rgbMax = value;
+        const uint32_t rgbMin = rgbMax * (maxLevel - saturation) / maxLevel;
+        const uint32_t i = hue / 60;
+        const uint32_t diff = hue % 60;
+        const uint32_t rgbAdj = (rgbMax - rgbMin) * diff / 60;
+        switch (i)
+        {
+        case 0: rgb[0] = rgbMax; rgb[1] = rgbMin + rgbAdj; rgb[2] = rgbMin; break;
+        case 1: rgb[0] = rgbMax - rgbAdj; rgb[1] = rgbMax; rgb[2] = rgbMin; break;
+        case 2: rgb[0] = rgbMin; rgb[1] = rgbMax; rgb[2] = rgbMin + rgbAdj; break;
+        case 3: rgb[0] = rgbMin; rgb[1] = rgbMax - rgbAdj; rgb[2] = rgbMax; break;
+        case 4: rgb[0] = rgbMin + rgbAdj; rgb[1] = rgbMin; rgb[2] = rgbMax; break;
+        default: rgb[0] = rgbMax; rgb[1] = rgbMin; rgb[2] = rgbMax - rgbAdj; break;
+        }
+    }
+
+    bool hsvEqual(uint32_t hue, uint32_t saturation, uint32_t value, bool wide)
+    {
+        uint32_t expected[3], actual[3];
+        oldHsvToRgb(hue, saturation, value, wide ? 65535 : 255, expected);
+        if (wide)
+            led_strip_hsv_to_rgb_16(hue, saturation, value, actual);
+        else
+            led_strip_hsv_to_rgb(hue, saturation, value, actual);
+        if (expected[0] == actual[0] && expected[1] == actual[1] && expected[2] == actual[2])
+            return true;
+        printf("  hsv(%u, %u, %u): %u %u %u != %u %u %u\n", hue, saturation, value, actual[0], actual[1], actual[2],
+               expected[0], expected[1], expected[2]);
+        return false;
+    }
+
+    void testHsvExact()
+    {
+        // 8 бит: все насыщенности и яркости, оттенки до 719 (за 360 прежний код уходил в последний сектор)
+        uint32_t failures = 0;
+        for (uint32_t hue = 0; hue < 720; ++hue)
+        {
+            for (uint32_t saturation = 0; saturation < 256; ++saturation)
+            {
+                for (uint32_t value = 0; value < 256; ++value)
+                {
+                    if (failures < 5 && !hsvEqual(hue, saturation, value, false))
+                        ++failures;
+                }
+            }
+        }
+        HOST_CHECK_MSG(failures == 0, "8-bit HSV");
+
+        // 16 бит: края и шаг сетки, не кратный степеням двойки, плюс случайные значения
+        std::vector<uint32_t> grid = {0, 1, 2, 59, 60, 61, 255, 256, 32767, 32768, 65533, 65534, 65535};
+        for (uint32_t v = 997; v < 65535; v += 997)
+            grid.push_back(v);
+        failures = 0;
+        for (uint32_t hue = 0; hue < 720; ++hue)
+        {
+            for (uint32_t saturation : grid)
+            {
+                for (uint32_t value : grid)
+                {
+                    if (failures < 5 && !hsvEqual(hue, saturation, value, true))
+                        ++failures;
+                }
+            }
+        }
+        std::mt19937 random(38);
+        for (int i = 0; i < 5000000 && failures < 5; ++i)
+        {
+            if (!hsvEqual(random() % 720, random() & 0xFFFF, random() & 0xFFFF, true))
+                ++failures;
+        }
+        HOST_CHECK_MSG(failures == 0, "16-bit HSV");
+    }
+
+    void testHsv1536()
+    {
+        // Круг 1536: сектор и положение в нем из битов оттенка, против расчета в double. Минимум и сдвиг в секторе
+        // отбрасывают дробную часть, как прежнее преобразование, поэтому расхождение - меньше двух шагов
+        static const int SECTOR_RGB[6][3] = {{0, 2, 1}, {3, 0, 1}, {1, 0, 2}, {1, 3, 0}, {2, 1, 0}, {0, 1, 3}};
+        double maxError = 0;
+        for (uint32_t hue = 0; hue < 1536; ++hue)
+        {
+            for (uint32_t saturation = 0; saturation < 256; saturation += 5)
+            {
+                for (uint32_t value = 0; value < 256; ++value)
+                {
+                    const double rgbMin = value * (255.0 - saturation) / 255.0;
+                    const double adj = (value - rgbMin) * (hue & 0xFF) / 256.0;
+                    const double levels[4] = {static_cast<double>(value), rgbMin, rgbMin + adj, value - adj};
+                    uint32_t rgb[3], wrapped[3];
+                    led_strip_hsv1536_to_rgb(hue, saturation, value, rgb);
+                    led_strip_hsv1536_to_rgb(hue + 1536, saturation, value, wrapped);
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        maxError = std::max(maxError, std::fabs(rgb[c] - levels[SECTOR_RGB[hue >> 8][c]]));
+                        HOST_CHECK(rgb[c] <= value && rgb[c] == wrapped[c]);
+                    }
+                }
+            }
+        }
+        HOST_CHECK_MSG(maxError < 2.0, "1536 wheel error %.3f", maxError);
+        printf("HSV 1536 wheel: max error %.3f\n", maxError);
+    }
+
+    void testHsvBatch()
+    {
+        // Пакетная запись дает тот же кадр на линии, что и попиксельная
+        const uint32_t leds = 100;
+        std::mt19937 random(138);
+        std::vector<led_color_hsv_t> pixels(leds);
+        for (led_color_hsv_t& pixel : pixels)
+        {
+            pixel.hue = random() % 1536;
+            pixel.saturation = random();
+            pixel.value = random();
+        }
+        HostSpi::reset();
+        led_strip_handle_t batch = newSpiStrip(SPI2_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB);
+        led_strip_handle_t single = newSpiStrip(SPI3_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB);
+        if (!batch || !single)
+            return;
+        for (led_strip_hue_scale_t scale : {LED_STRIP_HUE_360, LED_STRIP_HUE_1536})
+        {
+            HOST_CHECK(led_strip_set_pixels_hsv(batch, 0, leds, pixels.data(), scale) == ESP_OK);
+            for (uint32_t i = 0; i < leds; ++i)
+            {
+                if (scale == LED_STRIP_HUE_360)
+                {
+                    HOST_CHECK(led_strip_set_pixel_hsv(single, i, pixels[i].hue % 360, pixels[i].saturation,
+                                                       pixels[i].value) == ESP_OK);
+                    continue;
+                }
+                uint32_t rgb[3];
+                led_strip_hsv1536_to_rgb(pixels[i].hue, pixels[i].saturation, pixels[i].value, rgb);
+                HOST_CHECK(led_strip_set_pixel(single, i, rgb[0], rgb[1], rgb[2]) == ESP_OK);
+            }
+            if (scale == LED_STRIP_HUE_360)
+            {
+                for (led_color_hsv_t& pixel : pixels)
+                    pixel.hue %= 360;
+                HOST_CHECK(led_strip_set_pixels_hsv(batch, 0, leds, pixels.data(), scale) == ESP_OK);
+            }
+            HOST_CHECK(refreshWire(batch, SPI2_HOST) == refreshWire(single, SPI3_HOST));
+        }
+        HOST_CHECK(led_strip_set_pixels_hsv(batch, leds - 1, 2, pixels.data(), LED_STRIP_HUE_360) == ESP_ERR_INVALID_ARG);
+        HOST_CHECK(led_strip_del(batch) == ESP_OK);
+        HOST_CHECK(led_strip_del(single) == ESP_OK);
+    }
+
+    // Замеры HSV на 1000 пикселей: прежнее преобразование, общее ядро, круг 1536, запись в ленту попиксельно и пакетом
+    void benchHsv()
+    {
+        const uint32_t leds = 1000;
+        std::mt19937 random(1038);
+        std::vector<led_color_hsv_t> pixels(leds);
+        for (led_color_hsv_t& pixel : pixels)
+        {
+            pixel.hue = random() % 360;
+            pixel.saturation = random();
+            pixel.value = random();
+        }
+        std::vector<uint8_t> rgbBuf(leds * 3);
+
+        MicroBench bench("led_strip_host");
+        MicroBench::Config config;
+        config.samples = 200;
+        bench.run("hsv_old_1000", config, [&]()
+        {
+            uint32_t rgb[3];
+            for (uint32_t i = 0; i < leds; ++i)
+            {
+                oldHsvToRgb(pixels[i].hue, pixels[i].saturation, pixels[i].value, 255, rgb);
+                std::copy(rgb, rgb + 3, &rgbBuf[i * 3]);
+            }
+            MicroBench::keep(rgbBuf);
+        });
+        bench.run("hsv_kernel_1000", config, [&]()
+        {
+            uint32_t rgb[3];
+            for (uint32_t i = 0; i < leds; ++i)
+            {
+                led_strip_hsv_to_rgb(pixels[i].hue, pixels[i].saturation, pixels[i].value, rgb);
+                std::copy(rgb, rgb + 3, &rgbBuf[i * 3]);
+            }
+            MicroBench::keep(rgbBuf);
+        });
+        bench.run("hsv_kernel_1536_1000", config, [&]()
+        {
+            uint32_t rgb[3];
+            for (uint32_t i = 0; i < leds; ++i)
+            {
+                led_strip_hsv1536_to_rgb(pixels[i].hue * 4, pixels[i].saturation, pixels[i].value, rgb);
+                std::copy(rgb, rgb + 3, &rgbBuf[i * 3]);
+            }
+            MicroBench::keep(rgbBuf);
+        });
+
+        HostSpi::reset();
+        led_strip_handle_t strip = newSpiStrip(SPI2_HOST, leds, LED_STRIP_COLOR_COMPONENT_FMT_GRB);
+        if (!strip)
+            return;
+        bench.run("spi_set_pixel_hsv_1000", config, [&]()
+        {
+            for (uint32_t i = 0; i < leds; ++i)
+                led_strip_set_pixel_hsv(strip, i, pixels[i].hue, pixels[i].saturation, pixels[i].value);
+        });
+        bench.run("spi_set_pixels_hsv_1000", config, [&]()
+        {
+            led_strip_set_pixels_hsv(strip, 0, leds, pixels.data(), LED_STRIP_HUE_360);
+        });
+        led_strip_del(strip);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+    {
+        benchSpi();
+        benchHsv();
+        return 0;
+    }
+
+    testGroupValidation();
+    testGroupOrdering();
+    testGroupTimeoutAndPartialStart();
+    testSpiBufferGuard();
+    testSpiLut();
+    testSpiGroup();
+    testPsramChunks();
+    testRmtSymbolTable();
+    testTransformLut();
+    testTransformOutput();
+    testTransformDither();
+    testHsvExact();
+    testHsv1536();
+    testHsvBatch();
+    return HostCheck::result();
+}
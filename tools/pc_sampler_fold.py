@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Символизация гистограммы PcSampler (GET /sampler) и вывод в свернутом формате для flame graph.
+
+Адреса переводятся в функции addr2line по ELF-файлу той же сборки прошивки. Встроенные (inline) функции
+раскрываются в цепочку кадров, поэтому строка стека - "ядро;внешняя функция;...;встроенная функция количество".
+Результат подается в flamegraph.pl, speedscope или inferno.
+
+Использование:
+    pc_sampler_fold.py --elf .pio/build/<env>/firmware.elf http://<ip>/sampler > samples.folded
+    pc_sampler_fold.py --elf firmware.elf sampler.json --merge-cores --top 20
+
+Запуск и остановка выборок:
+    curl -X POST "http://<ip>/sampler/start?rate=2000"
+    curl -X POST http://<ip>/sampler/stop
+"""
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+import urllib.request
+from collections import Counter
+
+ADDRESS = re.compile(r"^0x[0-9a-fA-F]+$")
+
+
+def load(source):
+    if source.startswith(("http://", "https://")):
+        with urllib.request.urlopen(source, timeout=30) as response:
+            return json.load(response)
+    with open(source, encoding="utf-8") as file:
+        return json.load(file)
+
+
+def symbolize(addr2line, elf, addresses):
+    """Адрес -> список кадров от внешней функции к встроенной."""
+    if not addresses:
+        return {}
+    result = subprocess.run([addr2line, "-e", elf, "-a", "-f", "-i", "-C"], input="\n".join(addresses) + "\n",
+                            capture_output=True, text=True, check=True)
+
+    # Вывод -a: строка адреса, за ней пары "функция / файл:строка" (несколько пар для встроенных функций)
+    frames = {}
+    current = None
+    lines = result.stdout.splitlines()
+    i = 0
+    while i < len(lines):
+        line = lines[i].strip()
+        if ADDRESS.match(line):
+            current = int(line, 16)
+            frames[current] = []
+            i += 1
+            continue
+        if current is not None:
+            frames[current].append(None if line == "??" else line)
+        i += 2
+
+    stacks = {}
+    for address in addresses:
+        names = [name for name in frames.get(int(address, 16), []) if name]
+        # addr2line выдает сначала самую внутреннюю встроенную функцию
+        stacks[address] = list(reversed(names)) if names else [address]
+    return stacks
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="URL /sampler или сохраненный JSON")
+    parser.add_argument("--elf", required=True, help="ELF-файл прошивки")
+    parser.add_argument("--addr2line", default="xtensa-esp32s3-elf-addr2line",
+                        help="addr2line из тулчейна платы (ESP32: xtensa-esp32-elf-addr2line)")
+    parser.add_argument("--merge-cores", action="store_true", help="не разделять стеки по ядрам")
+    parser.add_argument("--top", type=int, default=0, help="вместо свернутых стеков напечатать N самых частых функций")
+    args = parser.parse_args()
+
+    data = load(args.source)
+    entries = data.get("pcs", [])
+    stacks = symbolize(args.addr2line, args.elf, [entry[0] for entry in entries])
+
+    folded = Counter()
+    for entry in entries:
+        frames = stacks[entry[0]]
+        for core, count in enumerate(entry[1:]):
+            if count:
+                root = [] if args.merge_cores else ["core%d" % core]
+                folded[";".join(root + frames)] += count
+
+    # Выборки, попавшие во время обработки другого прерывания, - отдельным кадром
+    for core, stats in enumerate(data.get("cores", [])):
+        if stats.get("isr"):
+            root = [] if args.merge_cores else ["core%d" % core]
+            folded[";".join(root + ["[interrupt]"])] += stats["isr"]
+
+    total = sum(folded.values())
+    dropped = sum(stats.get("dropped", 0) for stats in data.get("cores", []))
+    print("# samples=%d dropped=%d overflow=%d rateHz=%s" % (total, dropped, data.get("overflow", 0),
+                                                              data.get("rateHz")), file=sys.stderr)
+
+    if args.top:
+        leaves = Counter()
+        for stack, count in folded.items():
+            leaves[stack.rsplit(";", 1)[-1]] += count
+        for name, count in leaves.most_common(args.top):
+            print("%6.2f%% %8d  %s" % (100.0 * count / total if total else 0.0, count, name))
+        return 0
+
+    for stack, count in sorted(folded.items()):
+        print("%s %d" % (stack, count))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
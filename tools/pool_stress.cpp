@@ -0,0 +1,298 @@
+// Нагрузочная проверка BlockPool на ПК: длинная случайная последовательность выделений и освобождений.
+// Одна и та же последовательность прогоняется через набор пулов по классам размеров и через модель общей кучи
+// (first-fit со слиянием соседних свободных участков) того же объема. Печатаются отказы, отказы при достаточном
+// суммарном свободном объеме (следствие фрагментации), внешняя фрагментация (1 - наибольший свободный участок /
+// весь свободный объем) и внутренняя фрагментация пулов (доля блоков, не занятая данными).
+// Содержимое каждого блока заполняется меткой и проверяется при освобождении; проверяется также обнаружение
+// повторного и чужого освобождения.
+//
+// Сборка (Linux):
+//   g++ -std=c++17 -O2 -Icomponents/block_pool/include tools/pool_stress.cpp components/block_pool/src/BlockPool.cpp
+//       -o pool_stress
+//
+// Запуск: ./pool_stress [операций] [зерно]
+
+#include "BlockPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct SizeClass
+    {
+        size_t blockSize;
+        size_t blocksCount;
+    };
+
+    // Классы размеров, близкие к прошивке: мелкие запросы, буферы ответов, снимки профилировщика
+    const SizeClass CLASSES[] =
+    {
+        {64, 112},
+        {256, 40},
+        {1024, 16},
+        {2048, 6},
+    };
+
+    // Модель общей кучи: список свободных участков по адресам, first-fit, слияние соседей при освобождении
+    class FirstFitHeap
+    {
+    public:
+        explicit FirstFitHeap(size_t size)
+        {
+            m_free[0] = size;
+        }
+
+        bool allocate(size_t size, size_t& offset)
+        {
+            size = (size + 7) / 8 * 8 + HEADER_SIZE;
+            for (auto it = m_free.begin(); it != m_free.end(); ++it)
+            {
+                if (it->second < size)
+                    continue;
+                offset = it->first;
+                const size_t rest = it->second - size;
+                m_free.erase(it);
+                if (rest > 0)
+                    m_free[offset + size] = rest;
+                m_used[offset] = size;
+                return true;
+            }
+            return false;
+        }
+
+        void release(size_t offset)
+        {
+            auto used = m_used.find(offset);
+            size_t size = used->second;
+            m_used.erase(used);
+
+            auto next = m_free.lower_bound(offset);
+            if (next != m_free.end() && offset + size == next->first)
+            {
+                size += next->second;
+                next = m_free.erase(next);
+            }
+            if (next != m_free.begin())
+            {
+                auto prev = std::prev(next);
+                if (prev->first + prev->second == offset)
+                {
+                    prev->second += size;
+                    return;
+                }
+            }
+            m_free[offset] = size;
+        }
+
+        size_t getFree() const
+        {
+            size_t total = 0;
+            for (const auto& block : m_free)
+                total += block.second;
+            return total;
+        }
+
+        size_t getLargest() const
+        {
+            size_t largest = 0;
+            for (const auto& block : m_free)
+                largest = std::max(largest, block.second);
+            return largest;
+        }
+
+        static const size_t HEADER_SIZE = 8;   // Служебный заголовок участка, как у кучи ESP-IDF
+
+    private:
+        std::map<size_t, size_t> m_free;        // Смещение -> размер свободного участка
+        std::map<size_t, size_t> m_used;        // Смещение -> размер занятого участка
+    };
+
+    struct Allocation
+    {
+        size_t size;
+        int poolIndex;                          // Индекс пула (-1 - пулы не смогли выделить)
+        void* block;
+        bool inHeap;                            // Выделено в модели кучи
+        size_t heapOffset;
+        uint8_t tag;
+    };
+
+    // Размер запроса: в основном мелкие, реже буферы ответов и кадры
+    size_t randomSize(std::mt19937& rng)
+    {
+        const uint32_t kind = rng() % 100;
+        if (kind < 70)
+            return 8 + rng() % 57;
+        if (kind < 90)
+            return 65 + rng() % 192;
+        if (kind < 98)
+            return 257 + rng() % 768;
+        return 1025 + rng() % 1024;
+    }
+
+    float ratio(size_t part, size_t total)
+    {
+        return total ? static_cast<float>(part) / total : 0.f;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t opsCount = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    const uint32_t seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+    std::mt19937 rng(seed);
+
+    std::vector<std::unique_ptr<BlockPool>> pools;
+    size_t arenaSize = 0;
+    for (const SizeClass& sizeClass : CLASSES)
+    {
+        BlockPool::Config config;
+        config.name = "stress";
+        config.blockSize = sizeClass.blockSize;
+        config.blocksCount = sizeClass.blocksCount;
+        pools.push_back(std::make_unique<BlockPool>(config));
+        arenaSize += pools.back()->getBlockSize() * sizeClass.blocksCount;
+    }
+    FirstFitHeap heap(arenaSize);
+
+    std::vector<Allocation> live;
+    size_t poolFailures = 0;
+    size_t heapFailures = 0;
+    size_t heapFragFailures = 0;        // Отказы кучи при достаточном суммарном свободном объеме
+    float worstHeapFrag = 0.f;
+    size_t worstPoolWaste = 0;
+    size_t worstPoolBlocksBytes = 0;
+    size_t corruptions = 0;
+
+    for (size_t op = 0; op < opsCount; ++op)
+    {
+        // Доля освобождений растет с заполнением: нагрузка колеблется у высокого уровня занятости
+        const bool doAlloc = live.empty() || rng() % 1000 >= std::min<size_t>(900, live.size() * 6);
+        if (doAlloc)
+        {
+            Allocation allocation = {};
+            allocation.size = randomSize(rng);
+            allocation.tag = static_cast<uint8_t>(op);
+            allocation.poolIndex = -1;
+            for (size_t i = 0; i < pools.size(); ++i)
+            {
+                if (allocation.size > pools[i]->getBlockSize())
+                    continue;
+                allocation.block = pools[i]->allocate(allocation.size);
+                if (allocation.block)
+                {
+                    allocation.poolIndex = static_cast<int>(i);
+                    memset(allocation.block, allocation.tag, allocation.size);
+                }
+                break;
+            }
+            if (allocation.poolIndex < 0)
+                ++poolFailures;
+
+            allocation.inHeap = heap.allocate(allocation.size, allocation.heapOffset);
+            if (!allocation.inHeap)
+            {
+                ++heapFailures;
+                if (heap.getFree() >= allocation.size + FirstFitHeap::HEADER_SIZE)
+                    ++heapFragFailures;
+            }
+
+            if (allocation.poolIndex >= 0 || allocation.inHeap)
+                live.push_back(allocation);
+        }
+        else
+        {
+            const size_t index = rng() % live.size();
+            const Allocation allocation = live[index];
+            live[index] = live.back();
+            live.pop_back();
+
+            if (allocation.poolIndex >= 0)
+            {
+                const auto* data = static_cast<const uint8_t*>(allocation.block);
+                for (size_t i = 0; i < allocation.size; ++i)
+                {
+                    if (data[i] != allocation.tag)
+                    {
+                        ++corruptions;
+                        break;
+                    }
+                }
+                pools[allocation.poolIndex]->release(allocation.block);
+            }
+            if (allocation.inHeap)
+                heap.release(allocation.heapOffset);
+        }
+
+        if (op % 64 == 0)
+        {
+            const size_t free = heap.getFree();
+            worstHeapFrag = std::max(worstHeapFrag, 1.f - ratio(heap.getLargest(), free));
+
+            size_t waste = 0;
+            size_t blocksBytes = 0;
+            for (const Allocation& allocation : live)
+            {
+                if (allocation.poolIndex < 0)
+                    continue;
+                blocksBytes += pools[allocation.poolIndex]->getBlockSize();
+                waste += pools[allocation.poolIndex]->getBlockSize() - allocation.size;
+            }
+            if (ratio(waste, blocksBytes) > ratio(worstPoolWaste, worstPoolBlocksBytes))
+            {
+                worstPoolWaste = waste;
+                worstPoolBlocksBytes = blocksBytes;
+            }
+        }
+    }
+
+    // Обнаружение ошибок освобождения: чужой указатель, середина блока, повторное освобождение
+    size_t invalidBefore = pools[0]->getStats().invalidFrees;
+    uint8_t foreign[16];
+    pools[0]->release(foreign);
+    void* block = pools[0]->allocate();
+    bool invalidDetected = block != nullptr;
+    if (block)
+    {
+        pools[0]->release(static_cast<uint8_t*>(block) + 1);
+        pools[0]->release(block);
+        pools[0]->release(block);
+        invalidDetected = pools[0]->getStats().invalidFrees == invalidBefore + 3;
+    }
+    else
+    {
+        invalidDetected = pools[0]->getStats().invalidFrees == invalidBefore + 1;
+    }
+
+    for (const Allocation& allocation : live)
+    {
+        if (allocation.poolIndex >= 0)
+            pools[allocation.poolIndex]->release(allocation.block);
+    }
+
+    printf("ops=%zu seed=%u arena=%zu bytes\n", opsCount, seed, arenaSize);
+    printf("heap (first-fit model): failures=%zu fragmentation_failures=%zu worst_external_frag=%.1f%% "
+           "final_external_frag=%.1f%%\n",
+           heapFailures, heapFragFailures, worstHeapFrag * 100.f, (1.f - ratio(heap.getLargest(), heap.getFree())) * 100.f);
+    printf("pools: failures=%zu worst_internal_frag=%.1f%% corruptions=%zu invalid_frees_detected=%s\n",
+           poolFailures, ratio(worstPoolWaste, worstPoolBlocksBytes) * 100.f, corruptions, invalidDetected ? "yes" : "NO");
+
+    bool leaks = false;
+    for (const std::unique_ptr<BlockPool>& pool : pools)
+    {
+        const BlockPool::Stats stats = pool->getStats();
+        printf("  pool %4u x %3u: peak=%u allocs=%u failures=%u used_at_end=%u\n",
+               static_cast<unsigned>(stats.blockSize), static_cast<unsigned>(stats.blocksCount),
+               static_cast<unsigned>(stats.peakUsed), static_cast<unsigned>(stats.allocs),
+               static_cast<unsigned>(stats.failures), static_cast<unsigned>(stats.used));
+        leaks |= stats.used != 0;
+    }
+
+    return (corruptions == 0 && invalidDetected && !leaks) ? 0 : 1;
+}
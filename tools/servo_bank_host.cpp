@@ -0,0 +1,268 @@
+// Проверка ServoBank на ПК с моделью LEDC (tools/host/src/ledc.cpp): расчет скважностей, отображение скорость ->
+// скважность по калибровке (зона нечувствительности, инверсия, несколько точек), порядок записи и защелкивания
+// каналов при apply(), выбор аппаратного или программного плавного перемещения.
+//
+// Сборка (Linux):
+//   g++ -std=c++17 -O2 -pthread -Itools/host/include -Isrc tools/servo_bank_host.cpp src/Servo_pwm/ServoBank.cpp
+//       tools/host/src/ledc.cpp tools/host/src/freertos.cpp tools/host/src/esp_system.cpp -o servo_bank_host
+//
+// Запуск: ./servo_bank_host
+
+#include "Servo_pwm/ServoBank.h"
+#include "HostLedc.h"
+#include "HostCheck.h"
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    using EnOp = HostLedc::EnOp;
+
+    // Точная скважность импульса по параметрам таймера
+    uint32_t exactDuty(double pulseUs, uint32_t resolution, uint32_t freqHz)
+    {
+        return static_cast<uint32_t>(std::llround(pulseUs * static_cast<double>(1u << resolution) * freqHz / 1e6));
+    }
+
+    bool waitFor(const std::atomic<bool>& flag, uint32_t timeoutMs)
+    {
+        for (uint32_t i = 0; i < timeoutMs && !flag; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return flag;
+    }
+
+    void testDutyComputation()
+    {
+        HostLedc::reset();
+        ServoBank::Config config;
+        ServoBank bank(config);
+        HOST_CHECK(bank.getDutyResolution() == LEDC_TIMER_20_BIT);
+
+        HOST_CHECK(bank.addServo(4) == 0);
+        HOST_CHECK(HostLedc::outputDuty(LEDC_CHANNEL_0) == exactDuty(1500, 20, 50));
+
+        // Линейная калибровка по умолчанию: ошибка интерполяции таблицы не больше единицы скважности
+        for (int speed = -ServoBank::SPEED_MAX; speed <= ServoBank::SPEED_MAX; speed += 7)
+        {
+            bank.setSpeed(0, static_cast<int16_t>(speed));
+            bank.apply();
+            const uint32_t expected = exactDuty(1500 + speed, 20, 50);
+            const int32_t error = static_cast<int32_t>(HostLedc::outputDuty(LEDC_CHANNEL_0)) - static_cast<int32_t>(expected);
+            HOST_CHECK_MSG(error >= -1 && error <= 1, "speed %d: duty %u, expected %u", speed,
+                           HostLedc::outputDuty(LEDC_CHANNEL_0), expected);
+        }
+
+        // Насыщение за пределами диапазона
+        bank.setSpeed(0, 2 * ServoBank::SPEED_MAX);
+        bank.apply();
+        HOST_CHECK(HostLedc::outputDuty(LEDC_CHANNEL_0) == exactDuty(2500, 20, 50));
+    }
+
+    // Импульс по калибровке для команды скорости (непрерывно, без таблиц), мкс
+    double referencePulse(const ServoBank::Calibration& calibration, int32_t command)
+    {
+        const auto* points = calibration.points.data();
+        const size_t count = calibration.pointsCount;
+        double speed = 0;
+        if (command != 0)
+        {
+            const double magnitude = std::abs(command) > ServoBank::SPEED_MAX ? ServoBank::SPEED_MAX : std::abs(command);
+            speed = calibration.deadbandPermille + magnitude * (ServoBank::SPEED_MAX - calibration.deadbandPermille) /
+                    ServoBank::SPEED_MAX;
+            if ((command > 0) == calibration.inverted)
+                speed = -speed;
+        }
+        if (speed <= points[0].speedPermille)
+            return points[0].pulseUs;
+        if (speed >= points[count - 1].speedPermille)
+            return points[count - 1].pulseUs;
+        size_t i = 1;
+        while (speed > points[i].speedPermille)
+            ++i;
+        return points[i - 1].pulseUs + (static_cast<double>(points[i].pulseUs) - points[i - 1].pulseUs) *
+               (speed - points[i - 1].speedPermille) / (points[i].speedPermille - points[i - 1].speedPermille);
+    }
+
+    uint32_t dutyOf(ServoBank& bank, size_t index, int16_t speed)
+    {
+        bank.setSpeed(index, speed);
+        bank.apply();
+        return bank.getDuty(index);
+    }
+
+    void testCalibration()
+    {
+        HostLedc::reset();
+        ServoBank bank(ServoBank::Config{});
+        bank.addServo(4);
+        bank.addServo(5);
+
+        // Несимметричная калибровка с изломом и зоной нечувствительности
+        ServoBank::Calibration calibration;
+        calibration.points[0] = {-1000, 1000};
+        calibration.points[1] = {-300, 1400};
+        calibration.points[2] = {0, 1520};
+        calibration.points[3] = {500, 1700};
+        calibration.points[4] = {1000, 2100};
+        calibration.pointsCount = 5;
+        calibration.deadbandPermille = 100;
+        HOST_CHECK(bank.setCalibration(0, calibration));
+
+        ServoBank::Calibration inverted = calibration;
+        inverted.inverted = true;
+        HOST_CHECK(bank.setCalibration(1, inverted));
+
+        // Установка калибровки выводит канал на импульс остановки
+        HOST_CHECK(bank.getDuty(0) == exactDuty(1520, 20, 50));
+
+        const double dutyPerUs = static_cast<double>(1u << 20) * 50 / 1e6;
+        uint32_t prevDuty = 0;
+        for (int speed = -ServoBank::SPEED_MAX; speed <= ServoBank::SPEED_MAX; ++speed)
+        {
+            const uint32_t duty = dutyOf(bank, 0, static_cast<int16_t>(speed));
+            const double expected = referencePulse(calibration, speed) * dutyPerUs;
+
+            // В узлах таблиц (кратно CAL_LUT_STEP) - точно до округления; между узлами таблица линейна, и излом
+            // калибровки дает отклонение не больше разности наклонов на половине шага
+            const double tolerance = speed % ServoBank::CAL_LUT_STEP == 0 ? 1.0 : 0.25 * dutyPerUs * ServoBank::CAL_LUT_STEP;
+            HOST_CHECK_MSG(std::fabs(duty - expected) <= tolerance, "speed %d: duty %u, expected %.1f", speed, duty,
+                           expected);
+
+            // Монотонность: большей команде - не меньший импульс (кроме скачка через зону нечувствительности)
+            if (speed != -ServoBank::SPEED_MAX && speed != 0 && speed != 1)
+                HOST_CHECK_MSG(duty >= prevDuty, "speed %d: duty %u < %u", speed, duty, prevDuty);
+            prevDuty = duty;
+
+            // Инверсия - зеркальная команда
+            HOST_CHECK_MSG(dutyOf(bank, 1, static_cast<int16_t>(speed)) == dutyOf(bank, 0, static_cast<int16_t>(-speed)),
+                           "speed %d: inverted duty differs", speed);
+        }
+
+        // Зона нечувствительности: наименьшая ненулевая команда сразу дает ее границу
+        const double deadbandPulse = referencePulse(calibration, 1);
+        HOST_CHECK(std::fabs(dutyOf(bank, 0, 1) - deadbandPulse * dutyPerUs) <= 0.25 * dutyPerUs * ServoBank::CAL_LUT_STEP);
+        HOST_CHECK(dutyOf(bank, 0, 0) == exactDuty(1520, 20, 50));
+
+        // Некорректные калибровки отклоняются, действующая сохраняется
+        ServoBank::Calibration bad = calibration;
+        bad.pointsCount = 1;
+        HOST_CHECK(!bank.setCalibration(0, bad));
+        bad = calibration;
+        bad.points[2].speedPermille = -300;
+        HOST_CHECK(!bank.setCalibration(0, bad));
+        bad = calibration;
+        bad.deadbandPermille = ServoBank::SPEED_MAX;
+        HOST_CHECK(!bank.setCalibration(0, bad));
+        HOST_CHECK(!bank.setCalibration(2, calibration));
+        HOST_CHECK(dutyOf(bank, 0, 1000) == exactDuty(2100, 20, 50));
+    }
+
+    void testLatchOrder()
+    {
+        HostLedc::reset();
+        ServoBank::Config config;
+        ServoBank bank(config);
+        const size_t count = 4;
+        for (size_t i = 0; i < count; ++i)
+            HOST_CHECK(bank.addServo(static_cast<gpio_num_t>(4 + i)) == static_cast<int>(i));
+
+        const int16_t speeds[count] = {-1000, -250, 250, 1000};
+        HostLedc::clearOps();
+        bank.setSpeeds(speeds, count);
+
+        // До apply() выход не меняется и каналы не трогаются
+        HOST_CHECK(HostLedc::ops().empty());
+        for (size_t i = 0; i < count; ++i)
+            HOST_CHECK(HostLedc::outputDuty(static_cast<int>(i)) == exactDuty(1500, 20, 50));
+
+        bank.apply();
+
+        // Сначала запись во все каналы вне критической секции, затем защелкивание подряд внутри нее
+        const std::vector<HostLedc::Op> ops = HostLedc::ops();
+        HOST_CHECK(ops.size() == 2 * count);
+        for (size_t i = 0; i < ops.size() && i < 2 * count; ++i)
+        {
+            const bool isLatch = i >= count;
+            HOST_CHECK_MSG(ops[i].op == (isLatch ? EnOp::enUpdateDuty : EnOp::enSetDuty), "op %zu", i);
+            HOST_CHECK_MSG(ops[i].channel == static_cast<int>(i % count), "op %zu: channel %d", i, ops[i].channel);
+            HOST_CHECK_MSG(ops[i].inCritical == isLatch, "op %zu: critical %d", i, ops[i].inCritical);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            HOST_CHECK(HostLedc::outputDuty(static_cast<int>(i)) == bank.getDuty(i));
+            const int32_t error = static_cast<int32_t>(bank.getDuty(i)) - static_cast<int32_t>(exactDuty(1500 + speeds[i], 20, 50));
+            HOST_CHECK_MSG(error >= -1 && error <= 1, "servo %zu: error %d", i, error);
+        }
+
+        // Неизменившиеся каналы повторно не защелкиваются
+        HostLedc::clearOps();
+        bank.setSpeeds(speeds, count);
+        bank.setSpeed(2, 500);
+        bank.apply();
+        const std::vector<HostLedc::Op> partial = HostLedc::ops();
+        HOST_CHECK(partial.size() == 2);
+        for (const HostLedc::Op& op : partial)
+            HOST_CHECK(op.channel == 2);
+    }
+
+    // Перемещение moveTo(): возвращает длительность, мс, или -1, если не завершилось
+    int64_t timedMove(ServoBank& bank, size_t index, int16_t speed, uint32_t durationMs)
+    {
+        std::atomic<bool> done{false};
+        const int64_t startUs = esp_timer_get_time();
+        HOST_CHECK(bank.moveTo(index, speed, durationMs, [&done](size_t) { done = true; }));
+        HOST_CHECK(bank.isMoving(index));
+        if (!waitFor(done, durationMs * 4 + 200))
+            return -1;
+        return (esp_timer_get_time() - startUs) / 1000;
+    }
+
+    void testFadeSelection()
+    {
+        HostLedc::reset();
+
+        // 20 бит на 50 Гц: полный ход за 500 мс требует шага ~2100 > LEDC_LL_DUTY_SCALE_MAX - программный профиль
+        {
+            ServoBank bank(ServoBank::Config{});
+            bank.addServo(4);
+            const int64_t elapsedMs = timedMove(bank, 0, 1000, 500);
+            HOST_CHECK(HostLedc::fadeStats().started == 0);
+            HOST_CHECK_MSG(elapsedMs >= 480 && elapsedMs < 700, "software move took %lld ms",
+                           static_cast<long long>(elapsedMs));
+            HOST_CHECK(bank.getDuty(0) == exactDuty(2500, 20, 50));
+
+            // Медленнее (шаг ~874) - аппаратно, в заданное время
+            const int64_t fadeMs = timedMove(bank, 0, 0, 1200);
+            HOST_CHECK(HostLedc::fadeStats().started == 1);
+            HOST_CHECK(HostLedc::fadeStats().clamped == 0);
+            HOST_CHECK_MSG(fadeMs >= 1150 && fadeMs < 1400, "hardware move took %lld ms",
+                           static_cast<long long>(fadeMs));
+            HOST_CHECK(HostLedc::outputDuty(LEDC_CHANNEL_0) == exactDuty(1500, 20, 50));
+        }
+
+        // 14 бит: шаг хода до максимума за 500 мс ~33 - аппаратно
+        {
+            ServoBank::Config config;
+            config.timer = LEDC_TIMER_1;
+            config.firstChannel = LEDC_CHANNEL_4;
+            config.dutyResolution = LEDC_TIMER_14_BIT;
+            ServoBank bank(config);
+            bank.addServo(8);
+            const int64_t elapsedMs = timedMove(bank, 0, 1000, 500);
+            HOST_CHECK(HostLedc::fadeStats().started == 2);
+            HOST_CHECK(HostLedc::fadeStats().clamped == 0);
+            HOST_CHECK_MSG(elapsedMs >= 480 && elapsedMs < 700, "hardware move took %lld ms",
+                           static_cast<long long>(elapsedMs));
+        }
+    }
+}
+
+int main()
+{
+    testDutyComputation();
+    testCalibration();
+    testLatchOrder();
+    testFadeSelection();
+    return HostCheck::result();
+}
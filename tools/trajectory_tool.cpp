@@ -0,0 +1,226 @@
+// Утилита для ПК: кодирование траектории из CSV в двоичный формат TrajectoryFormat и обратно.
+//
+// Сборка (Linux):
+//   g++ -std=c++17 -O2 -Isrc tools/trajectory_tool.cpp src/Trajectory/TrajectoryFormat.cpp -o trajectory_tool
+//
+// Использование:
+//   trajectory_tool encode <in.csv> <out.trj>     - кодирование с проверкой обратным декодированием
+//   trajectory_tool decode <in.trj> [out.csv]     - декодирование (по умолчанию в stdout)
+//
+// Загрузка на устройство:
+//   curl --data-binary @out.trj "http://<ip>/trajectory?slot=0"
+//   curl -X POST "http://<ip>/trajectory/play?slot=0&loops=10"
+//
+// Строка CSV: command,dtMs,targetPos,targetSpeed,acceleration,deceleration
+// command - speed | position | softstop | hardstop. Пустые строки и строки с '#' пропускаются.
+
+#include "Trajectory/TrajectoryFormat.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using namespace TrajectoryFormat;
+
+    const char* COMMAND_NAMES[] = {"speed", "position", "softstop", "hardstop"};
+
+    bool parseCommand(const char* text, EnCommand& command)
+    {
+        for (size_t i = 0; i < sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]); ++i)
+        {
+            if (strcmp(text, COMMAND_NAMES[i]) == 0)
+            {
+                command = static_cast<EnCommand>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool readCsv(const char* path, std::vector<Segment>& segments)
+    {
+        FILE* file = fopen(path, "r");
+        if (!file)
+        {
+            perror(path);
+            return false;
+        }
+
+        char line[256];
+        size_t lineNumber = 0;
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), file))
+        {
+            ++lineNumber;
+            const char* start = line + strspn(line, " \t");
+            if (*start == '#' || *start == '\n' || *start == '\r' || *start == '\0')
+                continue;
+
+            char name[16];
+            unsigned long dtMs = 0;
+            Segment segment;
+            if (sscanf(start, "%15[^,],%lu,%lf,%f,%f,%f", name, &dtMs, &segment.targetPos, &segment.targetSpeed,
+                       &segment.acceleration, &segment.deceleration) != 6
+                || !parseCommand(name, segment.command) || dtMs > UINT32_MAX)
+            {
+                fprintf(stderr, "%s:%zu: invalid segment\n", path, lineNumber);
+                ok = false;
+                break;
+            }
+            segment.dtMs = static_cast<uint32_t>(dtMs);
+            segments.push_back(segment);
+        }
+        fclose(file);
+        return ok;
+    }
+
+    bool readFile(const char* path, std::vector<uint8_t>& data)
+    {
+        FILE* file = fopen(path, "rb");
+        if (!file)
+        {
+            perror(path);
+            return false;
+        }
+        uint8_t buf[4096];
+        size_t size = 0;
+        while ((size = fread(buf, 1, sizeof(buf), file)) > 0)
+            data.insert(data.end(), buf, buf + size);
+        fclose(file);
+        return true;
+    }
+
+    bool writeFile(const char* path, const std::vector<uint8_t>& data)
+    {
+        FILE* file = fopen(path, "wb");
+        if (!file)
+        {
+            perror(path);
+            return false;
+        }
+        const bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+        return fclose(file) == 0 && ok;
+    }
+
+    // Разбор файла траектории: проверка заголовка и CRC, декодирование всех отрезков
+    bool decodeFile(const std::vector<uint8_t>& file, std::vector<Segment>& segments)
+    {
+        Header header;
+        if (file.size() < sizeof(header))
+        {
+            fprintf(stderr, "File is too short\n");
+            return false;
+        }
+        memcpy(&header, file.data(), sizeof(header));
+        const uint8_t* data = file.data() + sizeof(header);
+        const size_t size = file.size() - sizeof(header);
+        if (!isValidHeader(header, size) || header.dataSize != size)
+        {
+            fprintf(stderr, "Invalid header\n");
+            return false;
+        }
+        if (crc32(0, data, size) != header.crc)
+        {
+            fprintf(stderr, "CRC mismatch\n");
+            return false;
+        }
+
+        Decoder decoder(data, size);
+        Segment segment;
+        while (decoder.next(segment))
+            segments.push_back(segment);
+        if (decoder.isError() || segments.size() != header.segmentsCount)
+        {
+            fprintf(stderr, "Corrupted segment %zu\n", segments.size());
+            return false;
+        }
+        return true;
+    }
+
+    int encode(const char* inPath, const char* outPath)
+    {
+        std::vector<Segment> segments;
+        if (!readCsv(inPath, segments))
+            return 1;
+
+        Header header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+
+        std::vector<uint8_t> file(sizeof(header));
+        Encoder encoder;
+        uint8_t buf[SEGMENT_MAX_SIZE];
+        for (const Segment& segment : segments)
+        {
+            const size_t size = encoder.encode(segment, buf);
+            file.insert(file.end(), buf, buf + size);
+            header.durationMs += segment.dtMs;
+        }
+        header.segmentsCount = static_cast<uint32_t>(segments.size());
+        header.dataSize = static_cast<uint32_t>(file.size() - sizeof(header));
+        header.crc = crc32(0, file.data() + sizeof(header), header.dataSize);
+        memcpy(file.data(), &header, sizeof(header));
+
+        // Проверка: декодированная траектория совпадает с исходной с точностью до фиксированной точки
+        std::vector<Segment> decoded;
+        if (!decodeFile(file, decoded))
+            return 1;
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            const Segment& a = segments[i];
+            const Segment& b = decoded[i];
+            const double posTolerance = 0.5 / POS_SCALE + std::fabs(a.targetPos) * 1e-15;
+            const double speedTolerance = 0.5 / SPEED_SCALE + 1e-6;
+            if (a.command != b.command || a.dtMs != b.dtMs
+                || std::fabs(a.targetPos - b.targetPos) > posTolerance
+                || std::fabs(a.targetSpeed - b.targetSpeed) > speedTolerance * (1 + std::fabs(a.targetSpeed) * 1e-4)
+                || std::fabs(a.acceleration - b.acceleration) > speedTolerance * (1 + std::fabs(a.acceleration) * 1e-4)
+                || std::fabs(a.deceleration - b.deceleration) > speedTolerance * (1 + std::fabs(a.deceleration) * 1e-4))
+            {
+                fprintf(stderr, "Round-trip mismatch at segment %zu (value out of range?)\n", i);
+                return 1;
+            }
+        }
+
+        if (!writeFile(outPath, file))
+            return 1;
+        printf("%u segments, %u bytes (%.2f bytes/segment), %u ms\n", header.segmentsCount, header.dataSize,
+               segments.empty() ? 0. : static_cast<double>(header.dataSize) / segments.size(), header.durationMs);
+        return 0;
+    }
+
+    int decode(const char* inPath, const char* outPath)
+    {
+        std::vector<uint8_t> file;
+        std::vector<Segment> segments;
+        if (!readFile(inPath, file) || !decodeFile(file, segments))
+            return 1;
+
+        FILE* out = outPath ? fopen(outPath, "w") : stdout;
+        if (!out)
+        {
+            perror(outPath);
+            return 1;
+        }
+        fprintf(out, "# command,dtMs,targetPos,targetSpeed,acceleration,deceleration\n");
+        for (const Segment& segment : segments)
+            fprintf(out, "%s,%u,%.3f,%.3f,%.3f,%.3f\n", COMMAND_NAMES[static_cast<size_t>(segment.command)], segment.dtMs,
+                    segment.targetPos, segment.targetSpeed, segment.acceleration, segment.deceleration);
+        return (outPath && fclose(out) != 0) ? 1 : 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 4 && strcmp(argv[1], "encode") == 0)
+        return encode(argv[2], argv[3]);
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "decode") == 0)
+        return decode(argv[2], argc == 4 ? argv[3] : nullptr);
+
+    fprintf(stderr, "Usage:\n  %s encode <in.csv> <out.trj>\n  %s decode <in.trj> [out.csv]\n", argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,296 @@
+// Проверка UdpControl на ПК через loopback: открытие сеанса, прием уставок, отбрасывание устаревших, чужих и
+// повторенных пакетов (в том числе после срабатывания сторожевого таймера и после "перезагрузки" - нового
+// экземпляра), и замер задержки "отправка пакета -> уставка у контроллера".
+//
+// Сборка (Linux):
+//   g++ -std=c++17 -O2 -pthread -Itools/host/include -Isrc tools/udp_control_loopback.cpp
+//       src/Control/UdpControl.cpp tools/host/src/freertos.cpp tools/host/src/esp_system.cpp
+//       tools/host/src/sha256.cpp -o udp_control_loopback
+//
+// Запуск: ./udp_control_loopback [пакетов для замера задержки]
+
+#include "Control/UdpControl.h"
+#include "HostCheck.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    const uint16_t PORT = 43333;
+    const uint32_t WATCHDOG_MS = 100;
+
+    using Packet = UdpControl::SetpointPacket;
+
+    // Отправитель: сокет, подключенный к порту устройства на loopback
+    class Sender
+    {
+    public:
+        Sender()
+        {
+            m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(PORT);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            connect(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            timeval timeout = {.tv_sec = 1, .tv_usec = 0};
+            setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        }
+
+        ~Sender()
+        {
+            close(m_socket);
+        }
+
+        template<typename T>
+        void send(const T& packet)
+        {
+            ::send(m_socket, &packet, sizeof(packet), 0);
+        }
+
+        // Запрос сеанса; 0 - ответа нет или он не прошел проверку
+        uint32_t openSession(const UdpControl& signer)
+        {
+            UdpControl::HelloPacket hello = {
+                .magic = UdpControl::HELLO_MAGIC,
+                .version = UdpControl::PACKET_VERSION,
+                .reserved = {},
+                .clientNonce = static_cast<uint32_t>(rand()),
+                .mac = {},
+            };
+            signer.sign(hello);
+            send(hello);
+
+            UdpControl::SessionPacket reply = {};
+            if (recv(m_socket, &reply, sizeof(reply), 0) != sizeof(reply))
+                return 0;
+            if (reply.magic != UdpControl::SESSION_MAGIC || reply.clientNonce != hello.clientNonce
+                || !signer.verify(reply))
+                return 0;
+            return reply.session;
+        }
+
+    private:
+        int m_socket = -1;
+    };
+
+    UdpControl::Config makeConfig()
+    {
+        UdpControl::Config config;
+        config.port = PORT;
+        config.watchdogTimeoutMs = WATCHDOG_MS;
+        for (size_t i = 0; i < UdpControl::KEY_SIZE; ++i)
+            config.key[i] = static_cast<uint8_t>(i * 7 + 1);
+        return config;
+    }
+
+    Packet makePacket(const UdpControl& signer, uint32_t session, uint32_t seq, double targetPos)
+    {
+        Packet packet = {
+            .magic = UdpControl::PACKET_MAGIC,
+            .version = UdpControl::PACKET_VERSION,
+            .command = UdpControl::EnCommand::enPosition,
+            .reserved = 0,
+            .session = session,
+            .seq = seq,
+            .timestampUs = static_cast<uint64_t>(esp_timer_get_time()),
+            .targetPos = targetPos,
+            .targetSpeed = 90.f,
+            .acceleration = 360.f,
+            .deceleration = 360.f,
+            .mac = {},
+        };
+        signer.sign(packet);
+        return packet;
+    }
+
+    // Ожидание новой уставки контроллером (опрос, как в цикле движения)
+    bool waitSetpoint(UdpControl& control, UdpControl::Setpoint& setpoint, int64_t timeoutUs = 200'000)
+    {
+        const int64_t deadline = esp_timer_get_time() + timeoutUs;
+        while (esp_timer_get_time() < deadline)
+        {
+            if (control.takeSetpoint(setpoint))
+                return true;
+        }
+        return false;
+    }
+
+    // Ожидание, пока задача приема обработает все отправленные датаграммы
+    void waitReceived(const UdpControl& control, uint32_t received)
+    {
+        const int64_t deadline = esp_timer_get_time() + 500'000;
+        while (control.getStats().received < received && esp_timer_get_time() < deadline)
+            vTaskDelay(1);
+    }
+
+    // Эталонный HMAC-SHA256 (RFC 2104) для сверки подписи UdpControl
+    void referenceHmac(const uint8_t* key, size_t keyLen, const uint8_t* data, size_t len, uint8_t out[32])
+    {
+        uint8_t pad[64] = {};
+        memcpy(pad, key, keyLen);
+        for (uint8_t& byte : pad)
+            byte ^= 0x36;
+        uint8_t inner[32];
+        mbedtls_sha256_context ctx;
+        mbedtls_sha256_init(&ctx);
+        mbedtls_sha256_starts(&ctx, 0);
+        mbedtls_sha256_update(&ctx, pad, sizeof(pad));
+        mbedtls_sha256_update(&ctx, data, len);
+        mbedtls_sha256_finish(&ctx, inner);
+
+        for (uint8_t& byte : pad)
+            byte ^= 0x36 ^ 0x5c;
+        mbedtls_sha256_starts(&ctx, 0);
+        mbedtls_sha256_update(&ctx, pad, sizeof(pad));
+        mbedtls_sha256_update(&ctx, inner, sizeof(inner));
+        mbedtls_sha256_finish(&ctx, out);
+    }
+
+    void checkSha256()
+    {
+        // FIPS 180-4: "abc"
+        const uint8_t expected[32] = {
+            0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+            0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+        };
+        uint8_t digest[32];
+        mbedtls_sha256_context ctx;
+        mbedtls_sha256_init(&ctx);
+        mbedtls_sha256_starts(&ctx, 0);
+        mbedtls_sha256_update(&ctx, reinterpret_cast<const uint8_t*>("abc"), 3);
+        mbedtls_sha256_finish(&ctx, digest);
+        HOST_CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+
+        // RFC 4231, случай 1: ключ 0x0b x 20, "Hi There"
+        const uint8_t expectedMac[32] = {
+            0xb0, 0x34, 0x4c, 0x61, 0xd8, 0xdb, 0x38, 0x53, 0x5c, 0xa8, 0xaf, 0xce, 0xaf, 0x0b, 0xf1, 0x2b,
+            0x88, 0x1d, 0xc2, 0x00, 0xc9, 0x83, 0x3d, 0xa7, 0x26, 0xe9, 0x37, 0x6c, 0x2e, 0x32, 0xcf, 0xf7,
+        };
+        uint8_t key[20];
+        memset(key, 0x0b, sizeof(key));
+        referenceHmac(key, sizeof(key), reinterpret_cast<const uint8_t*>("Hi There"), 8, digest);
+        HOST_CHECK(memcmp(digest, expectedMac, sizeof(digest)) == 0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t latencyPackets = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+
+    checkSha256();
+
+    const UdpControl::Config config = makeConfig();
+    auto control = std::make_unique<UdpControl>(config);
+    if (!control->start())
+    {
+        printf("start failed (port %u busy?)\n", PORT);
+        return 1;
+    }
+    Sender sender;
+
+    // Подпись UdpControl совпадает с эталонным HMAC по полному ключу
+    Packet signedPacket = makePacket(*control, 1, 1, 0.);
+    uint8_t mac[32];
+    referenceHmac(config.key, UdpControl::KEY_SIZE, reinterpret_cast<const uint8_t*>(&signedPacket),
+                  offsetof(Packet, mac), mac);
+    HOST_CHECK(memcmp(mac, signedPacket.mac, UdpControl::MAC_SIZE) == 0);
+
+    // Без сеанса уставки не принимаются
+    uint32_t received = 0;
+    sender.send(makePacket(*control, 1, 1, 10.));
+    waitReceived(*control, ++received);
+    HOST_CHECK(control->getStats().badSession == 1);
+
+    const uint32_t session = sender.openSession(*control);
+    ++received;
+    HOST_CHECK(session != 0);
+
+    // Прием и отбрасывание устаревших
+    UdpControl::Setpoint setpoint;
+    sender.send(makePacket(*control, session, 1, 10.));
+    HOST_CHECK(waitSetpoint(*control, setpoint) && setpoint.seq == 1 && setpoint.targetPos == 10.);
+    HOST_CHECK(!control->takeTimeout());
+    const Packet captured = makePacket(*control, session, 5, 50.);
+    sender.send(captured);
+    HOST_CHECK(waitSetpoint(*control, setpoint) && setpoint.seq == 5);
+    sender.send(makePacket(*control, session, 3, 30.));
+    received += 3;
+    waitReceived(*control, received);
+    HOST_CHECK(!control->takeSetpoint(setpoint));
+    HOST_CHECK(control->getStats().stale == 1);
+
+    // Неверная подпись и размер
+    Packet forged = makePacket(*control, session, 6, 60.);
+    forged.targetPos = 600.;
+    sender.send(forged);
+    const uint8_t shortDatagram[8] = {};
+    sender.send(shortDatagram);
+    received += 2;
+    waitReceived(*control, received);
+    HOST_CHECK(control->getStats().badMac == 1 && control->getStats().badSize == 1);
+
+    // Сторожевой таймер выставляет один запрос останова, но повтор перехваченного пакета после паузы не принимается
+    vTaskDelay(pdMS_TO_TICKS(WATCHDOG_MS * 2));
+    HOST_CHECK(control->getStats().timeouts == 1 && !control->isClientActive());
+    HOST_CHECK(control->takeTimeout() && !control->takeTimeout());
+    sender.send(captured);
+    waitReceived(*control, ++received);
+    HOST_CHECK(!control->takeSetpoint(setpoint));
+    HOST_CHECK(control->getStats().stale == 2);
+
+    // Новый сеанс (перезапуск отправителя): номера снова с 1, пакеты прошлого сеанса отбрасываются
+    const uint32_t nextSession = sender.openSession(*control);
+    ++received;
+    HOST_CHECK(nextSession != 0 && nextSession != session);
+    sender.send(makePacket(*control, nextSession, 1, 11.));
+    HOST_CHECK(waitSetpoint(*control, setpoint) && setpoint.targetPos == 11.);
+    HOST_CHECK(control->isClientActive());
+    sender.send(makePacket(*control, session, 100, 100.));
+    received += 2;
+    waitReceived(*control, received);
+    HOST_CHECK(!control->takeSetpoint(setpoint));
+
+    // "Перезагрузка": новый экземпляр не принимает пакеты, записанные до нее
+    control.reset();
+    control = std::make_unique<UdpControl>(config);
+    HOST_CHECK(control->start());
+    sender.send(captured);
+    waitReceived(*control, 1);
+    HOST_CHECK(!control->takeSetpoint(setpoint));
+    HOST_CHECK(control->getStats().badSession == 1);
+
+    // Задержка "отправка -> уставка у контроллера" (контроллер опрашивает слот в цикле)
+    const uint32_t latencySession = sender.openSession(*control);
+    HOST_CHECK(latencySession != 0);
+    std::vector<int64_t> latencies;
+    latencies.reserve(latencyPackets);
+    for (uint32_t seq = 1; seq <= latencyPackets; ++seq)
+    {
+        const Packet packet = makePacket(*control, latencySession, seq, seq);
+        const int64_t sentUs = esp_timer_get_time();
+        sender.send(packet);
+        if (!waitSetpoint(*control, setpoint) || setpoint.seq != seq)
+        {
+            HOST_CHECK_MSG(false, "setpoint %u lost", static_cast<unsigned>(seq));
+            break;
+        }
+        latencies.push_back(esp_timer_get_time() - sentUs);
+    }
+    control->stop();
+
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+        const UdpControl::Stats stats = control->getStats();
+        printf("packets=%zu latency_us: min=%lld p50=%lld p99=%lld max=%lld (rx->take last=%u max=%u)\n",
+               latencies.size(), static_cast<long long>(latencies.front()), static_cast<long long>(percentile(0.5)),
+               static_cast<long long>(percentile(0.99)), static_cast<long long>(latencies.back()),
+               static_cast<unsigned>(stats.lastLatencyUs), static_cast<unsigned>(stats.maxLatencyUs));
+    }
+    return HostCheck::result();
+}